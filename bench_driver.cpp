@@ -0,0 +1,324 @@
+// Generic latency benchmark for a model compiled by tcompiler.
+//
+//   ./tcompiler model.onnx --target-triple=<triple> --emit-header=model.h -o model.o
+//   clang++ -O2 -std=c++17 -I. -DTC_MODEL_HEADER='"model.h"' -c ../bench_driver.cpp -o bench_driver.o
+//   clang++ bench_driver.o model.o -L${MLIR_LIBRARY_PATH} -lmlir_c_runner_utils -o bench_model
+//   ./bench_model [--warmup N] [--iters N] [--inflight N] [--dump PREFIX] [input0.bin input1.bin ...]
+//
+// Input files hold raw row-major data in the order of TC_MODEL_INPUTS. A single dynamic
+// dimension per input is inferred from the file size. Inputs without a file must be fully
+// static and are filled with 1.0.
+//
+// Models compiled with --dest-passing get their output buffers allocated once, before the
+// timed loop. Dynamic output dimensions take the size of the first dynamic input dimension
+// (the batch in the usual <?x...> case).
+//
+// --inflight N keeps N requests queued through tc_<model>_invoke_async() instead of calling
+// the model in a loop, latency is then measured from submission to the completion callback.
+// It needs a header written with --async-api and libtc_runtime.a on the link line.
+
+#ifndef TC_MODEL_HEADER
+#error "compile with -DTC_MODEL_HEADER='\"model.h\"' (header written by tcompiler --emit-header)"
+#endif
+
+#include TC_MODEL_HEADER
+
+#ifndef TC_MODEL_DEST_PASSING
+#define TC_MODEL_DEST_PASSING 0
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void fail(const std::string& msg)
+{
+    fprintf(stderr, "error: %s\n", msg.c_str());
+    exit(1);
+}
+
+static void fillOnes(void* data, const tc_tensor_info& info, int64_t count)
+{
+    for (int64_t i = 0; i < count; ++i)
+    {
+        char* p = static_cast<char*>(data) + i * info.elem_size;
+        switch (info.dtype)
+        {
+            case TC_DTYPE_FLOAT:   { float   v = 1.0f; memcpy(p, &v, sizeof(v)); break; }
+            case TC_DTYPE_DOUBLE:  { double  v = 1.0;  memcpy(p, &v, sizeof(v)); break; }
+            case TC_DTYPE_FLOAT16: { uint16_t v = 0x3C00; memcpy(p, &v, sizeof(v)); break; }
+            default:               { memset(p, 0, info.elem_size); p[0] = 1; break; }
+        }
+    }
+}
+
+// resolves the shape of one input, reads its file if given
+static void loadInput(tc_buffer& buf, const tc_tensor_info& info, const char* path)
+{
+    buf.rank = info.rank;
+
+    int64_t static_count = 1;
+    int     dynamic_dim  = -1;
+
+    for (int d = 0; d < info.rank; ++d)
+    {
+        if (info.dims[d] < 0)
+        {
+            if (dynamic_dim >= 0)
+                fail(std::string("input '") + info.name + "' has more than one dynamic dimension");
+            dynamic_dim = d;
+            continue;
+        }
+        buf.sizes[d]  = info.dims[d];
+        static_count *= info.dims[d];
+    }
+
+    if (!path)
+    {
+        if (dynamic_dim >= 0)
+            fail(std::string("input '") + info.name + "' has a dynamic shape, pass it as a file");
+
+        buf.data = malloc(static_count * info.elem_size);
+        fillOnes(buf.data, info, static_count);
+        return;
+    }
+
+    FILE* f = fopen(path, "rb");
+    if (!f) fail(std::string("cannot open ") + path);
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    int64_t count = file_size / static_cast<long>(info.elem_size);
+
+    if (dynamic_dim >= 0)
+    {
+        if (static_count == 0 || count % static_count != 0)
+            fail(std::string(path) + ": size does not match shape of '" + info.name + "'");
+        buf.sizes[dynamic_dim] = count / static_count;
+    }
+
+    else if (count != static_count)
+    {
+        fail(std::string(path) + ": expected " + std::to_string(static_count) +
+             " elements for '" + info.name + "', got " + std::to_string(count));
+    }
+
+    buf.data = malloc(std::max<int64_t>(count, 1) * info.elem_size);
+    if (fread(buf.data, info.elem_size, count, f) != static_cast<size_t>(count))
+        fail(std::string("cannot read ") + path);
+
+    fclose(f);
+}
+
+// size of the first dynamic input dimension, -1 if all inputs are static
+static int64_t dynamicExtent(const tc_buffer* inputs)
+{
+    for (int i = 0; i < TC_MODEL_NUM_INPUTS; ++i)
+        for (int d = 0; d < TC_MODEL_INPUTS[i].rank; ++d)
+            if (TC_MODEL_INPUTS[i].dims[d] < 0) return inputs[i].sizes[d];
+    return -1;
+}
+
+// preallocated buffer for destination-passing models, `allocated` stays NULL
+static void allocOutput(tc_buffer& buf, const tc_tensor_info& info, int64_t extent)
+{
+    buf.rank = info.rank;
+
+    int64_t count = 1;
+    for (int d = 0; d < info.rank; ++d)
+    {
+        buf.sizes[d] = info.dims[d] < 0 ? extent : info.dims[d];
+        if (buf.sizes[d] < 0)
+            fail(std::string("cannot size dynamic output '") + info.name + "' from static inputs");
+        count *= buf.sizes[d];
+    }
+
+    buf.data = calloc(std::max<int64_t>(count, 1), info.elem_size);
+}
+
+static int64_t elementCount(const tc_buffer& buf)
+{
+    int64_t n = 1;
+    for (int d = 0; d < buf.rank; ++d) n *= buf.sizes[d];
+    return n;
+}
+
+// frees buffers returned by the model. The invoke wrapper leaves `allocated` NULL for
+// results that are globals, inputs or repeats of an earlier result, and for
+// destination-passing models
+static void releaseOutputs(tc_buffer* outputs)
+{
+    for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i)
+    {
+        free(outputs[i].allocated);
+        outputs[i].allocated = nullptr;
+    }
+}
+
+#ifdef TC_MODEL_INVOKE_ASYNC
+// one of the --inflight requests, with its own outputs
+struct Slot
+{
+    tc_buffer   outputs[TC_MODEL_NUM_OUTPUTS > 0 ? TC_MODEL_NUM_OUTPUTS : 1] = {};
+    tc_request* req = nullptr;
+    std::chrono::steady_clock::time_point start;
+    double      latency_us = 0.0;
+};
+
+// runs on a runtime thread, before tc_request_wait() returns
+static void onDone(int, void* user_data)
+{
+    auto* slot = static_cast<Slot*>(user_data);
+    slot->latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - slot->start).count();
+}
+
+static void runInflight(int inflight, int iters, const tc_buffer* inputs, std::vector<double>& samples_us)
+{
+    std::vector<Slot> slots(inflight);
+    if (TC_MODEL_DEST_PASSING)
+        for (auto& slot : slots)
+            for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i)
+                allocOutput(slot.outputs[i], TC_MODEL_OUTPUTS[i], dynamicExtent(inputs));
+
+    int submitted = 0;
+    auto submit = [&](Slot& slot)
+    {
+        slot.start = std::chrono::steady_clock::now();
+        slot.req   = TC_MODEL_INVOKE_ASYNC(inputs, slot.outputs, onDone, &slot);
+        if (!slot.req) fail("cannot queue a request");
+        ++submitted;
+    };
+
+    for (auto& slot : slots)
+        if (submitted < iters) submit(slot);
+
+    // requests are collected in submission order, each slot is refilled as soon as it is done
+    for (size_t k = 0; samples_us.size() < static_cast<size_t>(iters); k = (k + 1) % slots.size())
+    {
+        Slot& slot = slots[k];
+        if (!slot.req) continue;
+
+        int status = tc_request_wait(slot.req);
+        tc_request_release(slot.req);
+        slot.req = nullptr;
+
+        if (status != 0) fail("model returned a non-dense output");
+        samples_us.push_back(slot.latency_us);
+
+        if (!TC_MODEL_DEST_PASSING) releaseOutputs(slot.outputs);
+        if (submitted < iters) submit(slot);
+    }
+
+    if (TC_MODEL_DEST_PASSING)
+        for (auto& slot : slots)
+            for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i) free(slot.outputs[i].data);
+}
+#endif
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+int main(int argc, char** argv)
+{
+    int warmup = 10;
+    int iters  = 100;
+    int inflight = 0;
+    const char* dump_prefix = nullptr;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if      (arg == "--warmup" && i + 1 < argc) warmup = atoi(argv[++i]);
+        else if (arg == "--iters"  && i + 1 < argc) iters  = atoi(argv[++i]);
+        else if (arg == "--inflight" && i + 1 < argc) inflight = atoi(argv[++i]);
+        else if (arg == "--dump"   && i + 1 < argc) dump_prefix = argv[++i];
+        else files.push_back(argv[i]);
+    }
+
+    if (iters < 1) fail("--iters must be positive");
+    if (inflight < 0) fail("--inflight must not be negative");
+#ifndef TC_MODEL_INVOKE_ASYNC
+    if (inflight > 0) fail("--inflight needs a header written with --async-api");
+#endif
+    if (files.size() > TC_MODEL_NUM_INPUTS)
+        fail("too many input files, model has " + std::to_string(TC_MODEL_NUM_INPUTS) + " inputs");
+
+    tc_buffer inputs[TC_MODEL_NUM_INPUTS  > 0 ? TC_MODEL_NUM_INPUTS  : 1] = {};
+    tc_buffer outputs[TC_MODEL_NUM_OUTPUTS > 0 ? TC_MODEL_NUM_OUTPUTS : 1] = {};
+
+    for (int i = 0; i < TC_MODEL_NUM_INPUTS; ++i)
+        loadInput(inputs[i], TC_MODEL_INPUTS[i], i < static_cast<int>(files.size()) ? files[i] : nullptr);
+
+    if (TC_MODEL_DEST_PASSING)
+        for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i)
+            allocOutput(outputs[i], TC_MODEL_OUTPUTS[i], dynamicExtent(inputs));
+
+    for (int i = 0; i < warmup; ++i)
+    {
+        if (TC_MODEL_INVOKE(inputs, outputs) != 0) fail("model returned a non-dense output");
+        releaseOutputs(outputs);
+    }
+
+    std::vector<double> samples_us;
+    samples_us.reserve(iters);
+
+    auto total_start = std::chrono::steady_clock::now();
+#ifdef TC_MODEL_INVOKE_ASYNC
+    if (inflight > 0) runInflight(inflight, iters, inputs, samples_us);
+#endif
+    for (int i = 0; inflight == 0 && i < iters; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int status = TC_MODEL_INVOKE(inputs, outputs);
+        auto end = std::chrono::steady_clock::now();
+
+        if (status != 0) fail("model returned a non-dense output");
+        samples_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+        if (i + 1 < iters) releaseOutputs(outputs);
+    }
+    double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - total_start).count();
+
+    if (dump_prefix && inflight == 0)
+    {
+        for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i)
+        {
+            std::string path = std::string(dump_prefix) + std::to_string(i) + ".bin";
+            FILE* f = fopen(path.c_str(), "wb");
+            if (!f) fail("cannot write " + path);
+            fwrite(outputs[i].data, TC_MODEL_OUTPUTS[i].elem_size, elementCount(outputs[i]), f);
+            fclose(f);
+        }
+    }
+    releaseOutputs(outputs);
+
+    std::sort(samples_us.begin(), samples_us.end());
+    double mean = 0.0;
+    for (double s : samples_us) mean += s;
+    mean /= samples_us.size();
+
+    printf("model      : %s\n", TC_MODEL_NAME);
+    printf("iterations : %d (warmup %d)\n", iters, warmup);
+    if (inflight > 0) printf("in flight  : %d requests\n", inflight);
+    printf("latency us : min %.2f  mean %.2f  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+           samples_us.front(), mean,
+           percentile(samples_us, 50), percentile(samples_us, 90), percentile(samples_us, 99),
+           samples_us.back());
+    printf("throughput : %.1f inferences/s\n", iters / total_s);
+
+    for (int i = 0; i < TC_MODEL_NUM_INPUTS; ++i) free(inputs[i].data);
+    if (TC_MODEL_DEST_PASSING)
+        for (int i = 0; i < TC_MODEL_NUM_OUTPUTS; ++i) free(outputs[i].data);
+    return 0;
+}
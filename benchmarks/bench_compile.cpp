@@ -0,0 +1,392 @@
+#include "synthetic_graphs.hpp"
+
+#include "frontend/onnx_loader.hpp"
+#include "frontend/graph_serializer.hpp"
+#include "graph/scheduler.hpp"
+#include "backend/codegen.hpp"
+
+#include "mlir/IR/MLIRContext.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Host.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <string>
+
+#include <sys/resource.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Compile-throughput benchmarks over synthetic graphs
+//
+//   ./tc_bench --benchmark_format=json --benchmark_out=bench.json
+//
+// every benchmark is parameterized by (graph kind, node count), see GraphKind
+
+using namespace tc;
+using namespace tc::bench;
+
+namespace
+{
+
+    const std::vector<int64_t> kKinds = {
+        static_cast<int64_t>(GraphKind::Chain),
+        static_cast<int64_t>(GraphKind::FanOut),
+        static_cast<int64_t>(GraphKind::Residual),
+        static_cast<int64_t>(GraphKind::ConvStack),
+    };
+
+    // bytes currently allocated on the heap, 0 where it can't be queried
+    size_t heapInUse()
+    {
+#if defined(__GLIBC__)
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    size_t heapDelta(size_t before)
+    {
+        size_t now = heapInUse();
+        return now > before ? now - before : 0;
+    }
+
+    int64_t peakRssKb()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+
+    GraphKind kindOf(const benchmark::State& state)
+    {
+        return static_cast<GraphKind>(state.range(0));
+    }
+
+    void setCounters(benchmark::State& state, const Graph& graph, size_t heap_bytes)
+    {
+        auto nodes = static_cast<double>(graph.getNodes().size());
+
+        state.SetLabel(graphKindToString(kindOf(state)));
+        state.counters["nodes"]       = nodes;
+        state.counters["nodes_per_s"] = benchmark::Counter(nodes, benchmark::Counter::kIsIterationInvariantRate);
+        state.counters["heap_bytes"]  = static_cast<double>(heap_bytes);
+        state.counters["peak_rss_kb"] = static_cast<double>(peakRssKb());
+    }
+
+    // same graph with its nodes added consumers-first, so no order can be cached while
+    // it is built
+    std::shared_ptr<Graph> reversedCopy(const Graph& graph)
+    {
+        auto copy = std::make_shared<Graph>(graph.getName());
+        for (const auto& t : graph.getTensors())
+            if (t) copy->addTensor(t);
+        for (const auto& name : graph.getInputs())  copy->addInput(name);
+        for (const auto& name : graph.getOutputs()) copy->addOutput(name);
+
+        const auto& nodes = graph.getNodes();
+        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+            copy->addNode(*it);
+        return copy;
+    }
+
+    CodeGenOptions benchOptions()
+    {
+        CodeGenOptions opts;
+        opts.target_triple = llvm::sys::getDefaultTargetTriple();
+        return opts;
+    }
+
+} // namespace
+
+
+
+
+static void BM_OnnxLoad(benchmark::State& state)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+
+    auto path = std::filesystem::temp_directory_path() /
+        ("tc_bench_" + graphKindToString(kindOf(state)) + "_" + std::to_string(state.range(1)) + ".onnx");
+    writeOnnxModel(*graph, path);
+
+    OnnxLoader loader;
+
+    size_t heap_bytes = 0;
+    for (auto _ : state)
+    {
+        size_t before = heapInUse();
+        auto loaded = loader.load(path);
+        heap_bytes = heapDelta(before);
+        benchmark::DoNotOptimize(loaded.get());
+    }
+
+    setCounters(state, *graph, heap_bytes);
+    state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+
+    std::filesystem::remove(path);
+}
+
+
+// reload of a graph saved in the binary .tcg format
+static void BM_GraphFileLoad(benchmark::State& state)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+
+    auto path = std::filesystem::temp_directory_path() /
+        ("tc_bench_" + graphKindToString(kindOf(state)) + "_" + std::to_string(state.range(1)) + ".tcg");
+    writeGraphFile(*graph, path);
+
+    size_t heap_bytes = 0;
+    for (auto _ : state)
+    {
+        size_t before = heapInUse();
+        auto loaded = readGraphFile(path);
+        heap_bytes = heapDelta(before);
+        benchmark::DoNotOptimize(loaded.get());
+    }
+
+    setCounters(state, *graph, heap_bytes);
+    state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+
+    std::filesystem::remove(path);
+}
+
+
+// metadata-only wire scan, should not grow with the size of the weights
+static void BM_ReadModelInfo(benchmark::State& state)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+
+    auto path = std::filesystem::temp_directory_path() /
+        ("tc_bench_info_" + graphKindToString(kindOf(state)) + "_" + std::to_string(state.range(1)) + ".onnx");
+    writeOnnxModel(*graph, path);
+
+    for (auto _ : state)
+    {
+        auto info = OnnxLoader::readModelInfo(path);
+        benchmark::DoNotOptimize(info.graph_name.data());
+    }
+
+    setCounters(state, *graph, 0);
+    state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+
+    std::filesystem::remove(path);
+}
+
+
+// served from the order cached while the graph was built
+static void BM_TopologicalSort(benchmark::State& state)
+{
+    size_t before = heapInUse();
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+    size_t heap_bytes = heapDelta(before);
+
+    for (auto _ : state)
+    {
+        auto sorted = graph->topologicalSort();
+        benchmark::DoNotOptimize(sorted.data());
+    }
+
+    setCounters(state, *graph, heap_bytes);
+}
+
+
+// first call on a graph whose order has to be computed from scratch
+static void BM_TopologicalSortCold(benchmark::State& state)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+
+    // the previous copy is released while the timer is paused as well
+    std::shared_ptr<Graph> reversed;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        reversed = reversedCopy(*graph);
+        state.ResumeTiming();
+
+        auto sorted = reversed->topologicalSort();
+        benchmark::DoNotOptimize(sorted.data());
+    }
+
+    setCounters(state, *graph, 0);
+}
+
+
+// scheduleGraph for each policy, the third argument is the SchedulePolicy
+static void BM_Schedule(benchmark::State& state)
+{
+    auto graph  = makeSyntheticGraph(kindOf(state), state.range(1));
+    auto policy = static_cast<SchedulePolicy>(state.range(2));
+
+    size_t peak_bytes = 0;
+    for (auto _ : state)
+    {
+        auto schedule = scheduleGraph(*graph, policy);
+        peak_bytes = schedule.peak_bytes;
+        benchmark::DoNotOptimize(schedule.order.data());
+    }
+
+    setCounters(state, *graph, 0);
+    state.SetLabel(graphKindToString(kindOf(state)) + "/" + schedulePolicyToString(policy));
+    state.counters["peak_activation_bytes"] = static_cast<double>(peak_bytes);
+}
+
+
+// CodeGen::buildModule - ONNX graph to linalg/tensor MLIR
+static void BM_CodeGenBuildModule(benchmark::State& state)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+
+    mlir::MLIRContext mlir_ctx;
+    llvm::LLVMContext llvm_ctx;
+    CodeGen gen(mlir_ctx, llvm_ctx);
+
+    size_t heap_bytes = 0;
+    for (auto _ : state)
+    {
+        size_t before = heapInUse();
+        auto mod = gen.buildModule(*graph);
+        heap_bytes = heapDelta(before);
+        benchmark::DoNotOptimize(mod.get());
+    }
+
+    setCounters(state, *graph, heap_bytes);
+}
+
+
+#ifdef MLIR_OPT_PATH
+
+// later stages need the output of the previous ones, which is prepared with the timer paused
+enum class Stage { Bufferize, LowerToLLVM, Translate, EmitObject };
+
+static void runCodeGenStage(benchmark::State& state, Stage stage)
+{
+    auto graph = makeSyntheticGraph(kindOf(state), state.range(1));
+    auto opts  = benchOptions();
+    auto obj   = std::filesystem::temp_directory_path() / "tc_bench_out.o";
+
+    mlir::MLIRContext mlir_ctx;
+    llvm::LLVMContext llvm_ctx;
+    CodeGen gen(mlir_ctx, llvm_ctx);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto mod = gen.buildModule(*graph);
+        state.ResumeTiming();
+
+        if (stage == Stage::Bufferize)
+        {
+            auto bufferized = gen.runLoweringPipeline(*mod);
+            benchmark::DoNotOptimize(bufferized.get());
+            continue;
+        }
+
+        state.PauseTiming();
+        auto bufferized = gen.runLoweringPipeline(*mod);
+        state.ResumeTiming();
+
+        if (stage == Stage::LowerToLLVM)
+        {
+            gen.lowerToLLVM(*bufferized);
+            continue;
+        }
+
+        state.PauseTiming();
+        gen.lowerToLLVM(*bufferized);
+        state.ResumeTiming();
+
+        if (stage == Stage::Translate)
+        {
+            auto llvm_mod = gen.translateToLLVMIR(*bufferized, llvm::nulls());
+            benchmark::DoNotOptimize(llvm_mod.get());
+            continue;
+        }
+
+        state.PauseTiming();
+        auto llvm_mod = gen.translateToLLVMIR(*bufferized, llvm::nulls());
+        state.ResumeTiming();
+
+        gen.emitObject(llvm_mod.get(), obj.string(), opts);
+    }
+
+    setCounters(state, *graph, 0);
+    std::filesystem::remove(obj);
+}
+
+static void BM_CodeGenBufferize(benchmark::State& state)   { runCodeGenStage(state, Stage::Bufferize); }
+static void BM_CodeGenLowerToLLVM(benchmark::State& state) { runCodeGenStage(state, Stage::LowerToLLVM); }
+static void BM_CodeGenTranslate(benchmark::State& state)   { runCodeGenStage(state, Stage::Translate); }
+static void BM_CodeGenEmitObject(benchmark::State& state)  { runCodeGenStage(state, Stage::EmitObject); }
+
+#endif // MLIR_OPT_PATH
+
+
+
+
+BENCHMARK(BM_OnnxLoad)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_GraphFileLoad)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReadModelInfo)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000, 100000}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_TopologicalSort)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_TopologicalSortCold)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Schedule)
+    ->ArgNames({"kind", "nodes", "policy"})
+    ->ArgsProduct({kKinds, {1000, 10000, 100000}, {
+        static_cast<int64_t>(SchedulePolicy::Kahn),
+        static_cast<int64_t>(SchedulePolicy::MinMemory),
+        static_cast<int64_t>(SchedulePolicy::DepthFirst)}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_CodeGenBuildModule)
+    ->ArgNames({"kind", "nodes"})
+    ->ArgsProduct({kKinds, {10, 100, 1000, 10000}})
+    ->Unit(benchmark::kMillisecond);
+
+#ifdef MLIR_OPT_PATH
+
+// lowering stages are orders of magnitude slower per node, so the sweep stops earlier
+#define TC_STAGE_BENCHMARK(fn)                              \
+    BENCHMARK(fn)                                           \
+        ->ArgNames({"kind", "nodes"})                       \
+        ->ArgsProduct({kKinds, {10, 100, 1000}})            \
+        ->Unit(benchmark::kMillisecond)                     \
+        ->Iterations(3)
+
+TC_STAGE_BENCHMARK(BM_CodeGenBufferize);
+TC_STAGE_BENCHMARK(BM_CodeGenLowerToLLVM);
+TC_STAGE_BENCHMARK(BM_CodeGenTranslate);
+TC_STAGE_BENCHMARK(BM_CodeGenEmitObject);
+
+#endif // MLIR_OPT_PATH
+
+BENCHMARK_MAIN();
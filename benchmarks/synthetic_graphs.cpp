@@ -0,0 +1,304 @@
+#include "synthetic_graphs.hpp"
+
+#include "onnx.pb.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace tc::bench
+{
+
+    static constexpr int64_t kWidth    = 64; // feature size of Chain / FanOut / Residual
+    static constexpr int64_t kChannels = 8;  // channels of ConvStack
+    static constexpr int64_t kSpatial  = 16; // H and W of ConvStack
+
+    std::string graphKindToString(GraphKind kind)
+    {
+        switch (kind)
+        {
+            case GraphKind::Chain:      return "chain";
+            case GraphKind::FanOut:     return "fanout";
+            case GraphKind::Residual:   return "residual";
+            case GraphKind::ConvStack:  return "conv_stack";
+            default:                    return "unknown";
+        }
+    }
+
+    static void addActivation(Graph& g, const std::string& name, TensorShape shape)
+    {
+        g.addTensor(g.createTensor(name, DataType::FLOAT, std::move(shape)));
+    }
+
+    static void addWeight(Graph& g, const std::string& name, TensorShape shape, float value)
+    {
+        auto t = g.createTensor(name, DataType::FLOAT, std::move(shape));
+
+        std::vector<float> vals(t->numElements(), value);
+        std::vector<uint8_t> raw(vals.size() * sizeof(float));
+        std::memcpy(raw.data(), vals.data(), raw.size());
+
+        t->setRawData(std::move(raw));
+        g.addTensor(std::move(t));
+    }
+
+    static void addNode(Graph& g, const std::string& name, OpType op,
+                        std::vector<std::string> inputs, std::vector<std::string> outputs,
+                        Node::AttributeList attrs = {})
+    {
+        g.addNode(g.createNode(name, op, opTypeToString(op),
+                               std::move(inputs), std::move(outputs),
+                               std::move(attrs)));
+    }
+
+
+
+
+    // x -> Add(b_i) -> Relu -> Add(b_i+1) -> Relu ...
+    static void buildChain(Graph& g, int64_t num_nodes)
+    {
+        TensorShape act{{1, kWidth}};
+        addActivation(g, "x", act);
+        g.addInput("x");
+
+        std::string cur = "x";
+        for (int64_t i = 0; i < num_nodes; ++i)
+        {
+            std::string out = "t" + std::to_string(i);
+            addActivation(g, out, act);
+
+            if (i % 2 == 0)
+            {
+                std::string bias = "b" + std::to_string(i);
+                addWeight(g, bias, TensorShape{{kWidth}}, 0.5f);
+                addNode(g, "add_" + std::to_string(i), OpType::Add, {cur, bias}, {out});
+            }
+
+            else
+            {
+                addNode(g, "relu_" + std::to_string(i), OpType::Relu, {cur}, {out});
+            }
+
+            cur = out;
+        }
+
+        g.addOutput(cur);
+    }
+
+
+    // x -> Mul(w_i) for every branch, branches are summed by a chain of Add
+    static void buildFanOut(Graph& g, int64_t num_nodes)
+    {
+        TensorShape act{{1, kWidth}};
+        addActivation(g, "x", act);
+        g.addInput("x");
+
+        int64_t branches = std::max<int64_t>(2, (num_nodes + 1) / 2);
+
+        std::vector<std::string> heads;
+        heads.reserve(branches);
+
+        for (int64_t i = 0; i < branches; ++i)
+        {
+            std::string w   = "w" + std::to_string(i);
+            std::string out = "m" + std::to_string(i);
+            addWeight(g, w, TensorShape{{kWidth}}, 1.0f + static_cast<float>(i % 7));
+            addActivation(g, out, act);
+            addNode(g, "mul_" + std::to_string(i), OpType::Mul, {"x", w}, {out});
+            heads.push_back(out);
+        }
+
+        std::string acc = heads[0];
+        for (int64_t i = 1; i < branches; ++i)
+        {
+            std::string out = "s" + std::to_string(i);
+            addActivation(g, out, act);
+            addNode(g, "sum_" + std::to_string(i), OpType::Add, {acc, heads[i]}, {out});
+            acc = out;
+        }
+
+        g.addOutput(acc);
+    }
+
+
+    // blocks of x -> MatMul(W1) -> Relu -> MatMul(W2) -> Add(x)
+    static void buildResidual(Graph& g, int64_t num_nodes)
+    {
+        TensorShape act{{1, kWidth}};
+        addActivation(g, "x", act);
+        g.addInput("x");
+
+        addWeight(g, "W1", TensorShape{{kWidth, kWidth}}, 0.01f);
+        addWeight(g, "W2", TensorShape{{kWidth, kWidth}}, 0.02f);
+
+        int64_t blocks = std::max<int64_t>(1, num_nodes / 4);
+
+        std::string cur = "x";
+        for (int64_t i = 0; i < blocks; ++i)
+        {
+            auto id = std::to_string(i);
+            for (const auto& t : {"r" + id + "_a", "r" + id + "_b", "r" + id + "_c", "r" + id + "_out"})
+                addActivation(g, t, act);
+
+            addNode(g, "mm1_" + id,  OpType::MatMul, {cur, "W1"},               {"r" + id + "_a"});
+            addNode(g, "relu_" + id, OpType::Relu,   {"r" + id + "_a"},         {"r" + id + "_b"});
+            addNode(g, "mm2_" + id,  OpType::MatMul, {"r" + id + "_b", "W2"},   {"r" + id + "_c"});
+            addNode(g, "skip_" + id, OpType::Add,    {cur, "r" + id + "_c"},    {"r" + id + "_out"});
+
+            cur = "r" + id + "_out";
+        }
+
+        g.addOutput(cur);
+    }
+
+
+    // Conv(3x3, pads 1) -> Relu layers with shared weights
+    static void buildConvStack(Graph& g, int64_t num_nodes)
+    {
+        TensorShape act{{1, kChannels, kSpatial, kSpatial}};
+        addActivation(g, "x", act);
+        g.addInput("x");
+
+        addWeight(g, "W", TensorShape{{kChannels, kChannels, 3, 3}}, 0.01f);
+        addWeight(g, "B", TensorShape{{kChannels}}, 0.1f);
+
+        int64_t layers = std::max<int64_t>(1, num_nodes / 2);
+
+        std::string cur = "x";
+        for (int64_t i = 0; i < layers; ++i)
+        {
+            auto id = std::to_string(i);
+            addActivation(g, "c" + id, act);
+            addActivation(g, "a" + id, act);
+
+            Node::AttributeList attrs;
+            attrs.emplace_back("kernel_shape", AttributeType::INTS, std::vector<int64_t>{3, 3});
+            attrs.emplace_back("pads",         AttributeType::INTS, std::vector<int64_t>{1, 1, 1, 1});
+
+            addNode(g, "conv_" + id, OpType::Conv, {cur, "W", "B"}, {"c" + id}, std::move(attrs));
+            addNode(g, "relu_" + id, OpType::Relu, {"c" + id},     {"a" + id});
+
+            cur = "a" + id;
+        }
+
+        g.addOutput(cur);
+    }
+
+
+    std::shared_ptr<Graph> makeSyntheticGraph(GraphKind kind, int64_t num_nodes)
+    {
+        auto g = std::make_shared<Graph>(graphKindToString(kind));
+
+        switch (kind)
+        {
+            case GraphKind::Chain:      buildChain(*g, num_nodes);      break;
+            case GraphKind::FanOut:     buildFanOut(*g, num_nodes);     break;
+            case GraphKind::Residual:   buildResidual(*g, num_nodes);   break;
+            case GraphKind::ConvStack:  buildConvStack(*g, num_nodes);  break;
+        }
+
+        return g;
+    }
+
+
+
+
+    static void fillValueInfo(onnx::ValueInfoProto* vi, const Tensor& t)
+    {
+        vi->set_name(t.getName());
+        auto* tt = vi->mutable_type()->mutable_tensor_type();
+        tt->set_elem_type(static_cast<int>(t.getDtype()));
+
+        auto* shape = tt->mutable_shape();
+        for (auto d : t.getShape().dims)
+        {
+            if (d < 0) shape->add_dim()->set_dim_param("?");
+            else       shape->add_dim()->set_dim_value(d);
+        }
+    }
+
+    static void fillAttribute(onnx::AttributeProto* ap, const Attribute& a)
+    {
+        ap->set_name(a.getName());
+
+        switch (a.getType())
+        {
+            case AttributeType::FLOAT:
+                ap->set_type(onnx::AttributeProto::FLOAT);
+                ap->set_f(a.asFloat());
+                break;
+
+            case AttributeType::INT:
+                ap->set_type(onnx::AttributeProto::INT);
+                ap->set_i(a.asInt());
+                break;
+
+            case AttributeType::STRING:
+                ap->set_type(onnx::AttributeProto::STRING);
+                ap->set_s(a.asString());
+                break;
+
+            case AttributeType::INTS:
+                ap->set_type(onnx::AttributeProto::INTS);
+                for (auto v : a.asInts()) ap->add_ints(v);
+                break;
+
+            case AttributeType::FLOATS:
+                ap->set_type(onnx::AttributeProto::FLOATS);
+                for (auto v : a.asFloats()) ap->add_floats(v);
+                break;
+
+            default:
+                throw std::runtime_error("writeOnnxModel: unsupported attribute " + a.getName());
+        }
+    }
+
+    void writeOnnxModel(const Graph& graph, const std::filesystem::path& path)
+    {
+        onnx::ModelProto model;
+        model.set_ir_version(8);
+        model.set_producer_name("tc_bench");
+        auto* opset = model.add_opset_import();
+        opset->set_domain("");
+        opset->set_version(13);
+
+        auto* gp = model.mutable_graph();
+        gp->set_name(graph.getName());
+
+        for (const auto& name : graph.getInputs())
+            if (auto t = graph.findTensor(name)) fillValueInfo(gp->add_input(), *t);
+
+        for (const auto& name : graph.getOutputs())
+            if (auto t = graph.findTensor(name)) fillValueInfo(gp->add_output(), *t);
+
+        for (const auto& t : graph.getTensors())
+        {
+            if (!t || !t->hasData()) continue;
+
+            auto* init = gp->add_initializer();
+            init->set_name(t->getName());
+            init->set_data_type(static_cast<int>(t->getDtype()));
+            for (auto d : t->getShape().dims) init->add_dims(d);
+
+            const auto& raw = t->getRawData();
+            init->set_raw_data(raw.data(), raw.size());
+        }
+
+        for (const auto& node : graph.getNodes())
+        {
+            auto* np = gp->add_node();
+            np->set_name(node->getName());
+            np->set_op_type(node->getOpStr());
+            for (const auto& i : node->getInputs())  np->add_input(i.data(), i.size());
+            for (const auto& o : node->getOutputs()) np->add_output(o.data(), o.size());
+            for (const auto& a : node->getAttributes()) fillAttribute(np->add_attribute(), a);
+        }
+
+        std::ofstream ofs(path, std::ios::binary);
+        if (!ofs || !model.SerializeToOstream(&ofs))
+            throw std::runtime_error("Cannot write ONNX model: " + path.string());
+    }
+
+} // namespace tc::bench
@@ -0,0 +1,32 @@
+#ifndef SYNTHETIC_GRAPHS_HPP
+#define SYNTHETIC_GRAPHS_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace tc::bench
+{
+
+    enum class GraphKind
+    {
+        Chain,      // x -> Add -> Relu -> Add -> Relu ...
+        FanOut,     // x -> N x Mul, summed back by an Add chain
+        Residual,   // blocks of MatMul -> Relu -> MatMul -> Add(skip)
+        ConvStack,  // Conv(3x3, pad 1) -> Relu layers
+    };
+
+    [[nodiscard]] std::string graphKindToString(GraphKind kind);
+
+    // builds a graph of roughly num_nodes operations, every node can be lowered by CodeGen
+    [[nodiscard]] std::shared_ptr<Graph> makeSyntheticGraph(GraphKind kind, int64_t num_nodes);
+
+    // serializes a tc::Graph back to an ONNX model so OnnxLoader::load can be measured
+    void writeOnnxModel(const Graph& graph, const std::filesystem::path& path);
+
+} // namespace tc::bench
+
+#endif // SYNTHETIC_GRAPHS_HPP
@@ -1,7 +1,10 @@
 #ifndef MLIR_GEN_HPP
 #define MLIR_GEN_HPP
 
+#include "backend/constant_pool.hpp"
 #include "graph/graph.hpp"
+#include "graph/partition.hpp"
+#include "graph/scheduler.hpp"
 
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -10,8 +13,9 @@
 #include "llvm/IR/Module.h"
 
 #include <filesystem>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace tc
 {
@@ -22,6 +26,10 @@ namespace tc
         bool print_mlir      = false; 
         bool print_mlir_opt  = false;
         bool optimize        = true;
+        // fast-math flags on float ops and denormals flushed to zero, see runOptPipeline()
+        bool fast_math        = false;
+        // polynomial approximations of tanh, erf, exp and the like instead of libm calls
+        bool approximate_math = false;
 
         bool lower_to_llvm   = true;
         bool print_llvm_ir   = false;
@@ -29,6 +37,27 @@ namespace tc
         bool emit_asm        = false;
         bool emit_obj        = false;
 
+        // destination-passing ABI: the caller passes preallocated output buffers after the inputs,
+        // the entry point writes results into them and returns nothing
+        bool dest_passing          = false;
+        // output buffers may alias input buffers, results are computed aside and then copied
+        bool outputs_may_alias     = false;
+        // bare-pointer calling convention, one plain pointer per memref. Needs static shapes and
+        // implies dest_passing; the generated header keeps a descriptor-ABI wrapper
+        bool bare_ptr              = false;
+
+        // order the nodes are emitted in, see scheduler.hpp
+        SchedulePolicy schedule    = SchedulePolicy::Kahn;
+        // orders the caller computed already, one per graph passed to buildModule(); when
+        // empty each graph is scheduled with `schedule`
+        std::vector<Schedule> schedules;
+
+        // run independent branches of the graph concurrently, see partition.hpp
+        bool parallel_branches     = false;
+        // split the loops of each op into chunks run concurrently
+        // both need the program to be linked with libtc_runtime, see tc_runtime.h
+        bool parallel_loops        = false;
+
 
         std::string target_triple = "arm64_bare_metal";
         std::string cpu           = "generic";
@@ -39,6 +68,9 @@ namespace tc
         std::filesystem::path llvm_ir_out;
         std::filesystem::path asm_out;
         std::filesystem::path obj_out;
+        std::filesystem::path header_out;   // C header for the entry point, see header_emitter.hpp
+        // the header also gets tc_<graph>_invoke_async(), queuing calls on libtc_runtime
+        bool                  async_api = false;
     };
 
 
@@ -47,6 +79,16 @@ namespace tc
     void printMLIRHelp();
 
 
+    // how buildModule() split an entry point into tasks, see CodeGenOptions::parallel_branches
+    struct TaskSplit
+    {
+        std::string entry;
+        size_t      tasks   = 0;
+        size_t      width   = 0;        // see TaskGraph::width()
+        bool        emitted = false;    // false: a single chain, or a tensor between tasks is dynamic
+    };
+
+
     class CodeGen
     {
     public:
@@ -56,42 +98,78 @@ namespace tc
         int generate(const Graph& graph, const CodeGenOptions& opts = {},
                         const std::string& mlir_out = "", const std::string& asm_out = "");
 
+        // several models in one object, one entry point each. Initializers they share are
+        // stored once, the entry point names (the graph names) must differ
+        int generate(std::span<const Graph* const> graphs, const CodeGenOptions& opts = {},
+                        const std::string& mlir_out = "", const std::string& asm_out = "");
+
+
+        // stages of generate(), exposed separately for benchmarking
+
+        [[nodiscard]] mlir::OwningOpRef<mlir::ModuleOp> buildModule(const Graph& graph, const CodeGenOptions& opts = {});
+
+        [[nodiscard]] mlir::OwningOpRef<mlir::ModuleOp> buildModule(std::span<const Graph* const> graphs, const CodeGenOptions& opts = {});
 
-        
+        // initializers of the module buildModule() built last, see ConstantPool
+        [[nodiscard]] const ConstantPool::Stats& constantStats() const { return constants_.stats(); }
 
+        // one per entry point of the module buildModule() built last, with parallel_branches
+        [[nodiscard]] const std::vector<TaskSplit>& taskSplits() const { return task_splits_; }
 
+        // elementwise fusion, the tiling of pooling chains, then the fast_math and
+        // approximate_math rewrites
+        static void runOptPipeline(mlir::ModuleOp mod, const CodeGenOptions& opts);
 
+        // Wraps every call of a tc.task function in async.execute, waiting only for the tasks
+        // in its tc.task_deps. Runs on the bufferized module, lowerToLLVM() calls it with
+        // parallel_branches
+        static void parallelizeTaskCalls(mlir::ModuleOp mod);
 
-        
+        mlir::OwningOpRef<mlir::ModuleOp> runLoweringPipeline(mlir::ModuleOp mod, const CodeGenOptions& opts = {});
+
+        void lowerToLLVM(mlir::ModuleOp mod, const CodeGenOptions& opts = {});
+
+        std::unique_ptr<llvm::Module> translateToLLVMIR(mlir::ModuleOp mod, llvm::raw_ostream &os);
+
+        void emitObject(llvm::Module *llvmModule, const std::string &filename, const CodeGenOptions& opts);
 
     private:
         mlir::MLIRContext& mlir_ctx_;
         llvm::LLVMContext& llvm_ctx_;
 
-        using ValueMap = std::unordered_map<std::string, mlir::Value>;
+        // indexed by TensorId
+        using ValueMap = std::vector<mlir::Value>;
+
+        // initializers of the module being built, see constant_pool.hpp
+        mutable ConstantPool constants_;
+        mutable std::vector<TaskSplit> task_splits_;
+
+        void buildEntryPoint(mlir::ModuleOp module, const Graph& graph, std::span<const NodeId> order,
+                             const CodeGenOptions& opts) const;
 
         void processNode(
             mlir::OpBuilder& builder,
-            const Node&      node,
+            NodeId           node,
             ValueMap&        vmap,
             const Graph&     graph) const;
 
+        // Emits each task as a private function writing its results into buffers the entry
+        // allocates, and a call of it at the builder's position, see parallelizeTaskCalls().
+        // False, with nothing emitted, if a result crossing tasks has a dynamic shape
+        bool emitTasks(
+            mlir::OpBuilder&  builder,
+            mlir::ModuleOp    module,
+            llvm::StringRef   entry_name,
+            ValueMap&         vmap,
+            const Graph&      graph,
+            const TaskGraph&  tasks) const;
+
 
         [[nodiscard]] mlir::RankedTensorType tensorTypeOf(const Tensor& t) const;
 
         [[nodiscard]] mlir::RankedTensorType makeTensorType(DataType dt, const TensorShape& shape) const;
 
         [[nodiscard]] mlir::Value makeWeightConstant(mlir::OpBuilder& builder, mlir::Location loc, const Tensor& weight) const;
-        
-        
-        void lowerToLLVM(mlir::ModuleOp mod);
-        static void runOptPipeline(mlir::ModuleOp mod);
-        std::unique_ptr<llvm::Module> translateToLLVMIR(mlir::ModuleOp mod, llvm::raw_ostream &os);
-
-        mlir::OwningOpRef<mlir::ModuleOp> runLoweringPipeline(mlir::ModuleOp mod);
-
-        void emitObject(llvm::Module *llvmModule, const std::string &filename, const CodeGenOptions& opts);
-        
     };
 
 } // namespace tc
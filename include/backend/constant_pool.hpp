@@ -0,0 +1,102 @@
+#ifndef CONSTANT_POOL_HPP
+#define CONSTANT_POOL_HPP
+
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace tc
+{
+
+    // Decides how the initializers of the models in a module are stored:
+    //  - tensors whose elements are all equal become splats, an inline constant when small
+    //    and a linalg.fill otherwise, with no storage at all
+    //  - other small tensors stay inline arith.constants, shape tensors among them, so the
+    //    builders can still fold them
+    //  - the rest go to read-only memref.globals aligned to kAlignment bytes, one per
+    //    distinct type and contents, shared by every model in the module. A function reads
+    //    each of them through a single `restrict` to_tensor
+    // finish() then drops what nothing reads, e.g. the shape tensors folded into a Reshape.
+    // The stats count each initializer once, however many tasks materialize it.
+    class ConstantPool
+    {
+    public:
+        static constexpr int64_t  kInlineElements = 16;
+        static constexpr uint64_t kAlignment      = 64;
+
+        struct Stats
+        {
+            size_t initializers = 0, bytes           = 0;   // as referenced by the models
+            size_t splats       = 0, splat_bytes     = 0;   // saved by each kind
+            size_t duplicates   = 0, duplicate_bytes = 0;   // initializers equal to an earlier one
+            size_t unused       = 0, unused_bytes    = 0;
+            size_t globals      = 0, global_bytes    = 0;   // what is left in globals
+
+            [[nodiscard]] size_t savedBytes() const { return splat_bytes + duplicate_bytes + unused_bytes; }
+            [[nodiscard]] std::string summary() const;
+        };
+
+        // forget the globals of the previous module
+        void reset();
+
+        // A tensor with the initializer's contents at the builder's position. `data` is the
+        // raw row-major buffer of `type`, as stored in the model, and may be unaligned.
+        [[nodiscard]] mlir::Value materialize(mlir::OpBuilder&         builder,
+                                              mlir::Location           loc,
+                                              mlir::RankedTensorType   type,
+                                              std::span<const uint8_t> data);
+
+        // what the pool held at some point, see rollback()
+        struct Checkpoint
+        {
+            Stats  stats;
+            size_t counted = 0, globals = 0, reads = 0, created = 0;
+        };
+
+        [[nodiscard]] Checkpoint checkpoint() const
+        {
+            return {stats_, counted_.size(), globals_.size(), reads_.size(), created_.size()};
+        }
+
+        // forgets what was materialized since `cp` and erases the globals created for it, once
+        // the caller has erased everything reading them
+        void rollback(const Checkpoint& cp);
+
+        // erases the constants, fills and globals materialize() created that nothing reads anymore
+        void finish(mlir::ModuleOp module);
+
+        [[nodiscard]] const Stats& stats() const { return stats_; }
+
+    private:
+        // the global as a tensor, read once per function
+        mlir::Value readGlobal(mlir::OpBuilder&       builder,
+                               mlir::Location         loc,
+                               mlir::RankedTensorType type,
+                               mlir::memref::GlobalOp global);
+
+        using FunctionAndGlobal = std::pair<mlir::Operation*, mlir::Operation*>;
+
+        llvm::MapVector<mlir::Attribute, mlir::memref::GlobalOp> globals_;
+        // see readGlobal()
+        llvm::MapVector<FunctionAndGlobal, mlir::Value>          reads_;
+        // ops materialize() created, in order, see finish()
+        llvm::SmallVector<mlir::Operation*>                      created_;
+        // raw buffers of the initializers in stats_, in the order they came
+        llvm::SetVector<const uint8_t*>                          counted_;
+        Stats                                                    stats_;
+    };
+
+} // namespace tc
+
+#endif // CONSTANT_POOL_HPP
@@ -0,0 +1,60 @@
+#ifndef HEADER_EMITTER_HPP
+#define HEADER_EMITTER_HPP
+
+#include "graph/graph.hpp"
+
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tc
+{
+
+    // one argument or result of a generated entry point
+    struct EntryTensorDesc
+    {
+        std::string          name;
+        DataType             dtype{DataType::FLOAT};
+        std::vector<int64_t> dims;  // -1 for dynamic dimensions
+    };
+
+    // what the caller of a generated `_mlir_ciface_<symbol>` needs to know
+    struct EntryPointDesc
+    {
+        std::string                  symbol;
+        std::vector<EntryTensorDesc> inputs;
+        std::vector<EntryTensorDesc> outputs;
+
+        bool dest_passing      = false;  // outputs are trailing arguments, see CodeGenOptions
+        bool outputs_may_alias = false;
+        bool bare_ptr          = false;  // implies dest_passing
+        bool async_api         = false;  // also tc_<symbol>_invoke_async(), on libtc_runtime
+    };
+
+    // sanitizes a name to a valid C identifier, used for entry point symbols
+    [[nodiscard]] std::string cIdentifier(const std::string& name);
+
+    // the entry point symbol of a graph loaded from `path`, with several models in one object:
+    // the graph name, or the file name if an earlier model took that. Adds it to `taken`,
+    // throws if both are taken
+    [[nodiscard]] std::string entryPointSymbol(const Graph& graph, const std::filesystem::path& path,
+                                               std::unordered_set<std::string>& taken);
+
+    [[nodiscard]] EntryPointDesc describeEntryPoint(const Graph& graph);
+
+    // C header with tensor metadata, memref descriptor types, the entry point prototype
+    // and a generic tc_<symbol>_invoke() wrapper used by bench_driver.cpp, optionally
+    // with an asynchronous variant queuing the call on libtc_runtime
+    void emitModelHeader(const EntryPointDesc& entry, std::ostream& os);
+
+    void writeModelHeader(const EntryPointDesc& entry, const std::filesystem::path& path);
+
+    // one header declaring several entry points, the first one is the default for bench_driver.cpp
+    void writeModelHeader(std::span<const EntryPointDesc> entries, const std::filesystem::path& path);
+
+} // namespace tc
+
+#endif // HEADER_EMITTER_HPP
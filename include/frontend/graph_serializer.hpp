@@ -0,0 +1,36 @@
+#ifndef GRAPH_SERIALIZER_HPP
+#define GRAPH_SERIALIZER_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace tc
+{
+
+    // Binary graph format (.tcg), a loaded and possibly optimized Graph that can be reloaded
+    // without going through ONNX again. Little-endian, laid out as
+    //
+    //   header | string table | tensor, node, edge and attribute arrays | weights
+    //
+    // Names are deduplicated in the string table and tensor ids are kept as they are. Every
+    // weight starts at a kGraphFileAlignment boundary, so the reader maps the file and hands
+    // weights out as views into the mapping (see Tensor::setRawDataView); nothing is copied.
+    //
+    // GRAPH and SPARSE_TENSOR attributes can't be stored, writing a graph with one throws.
+
+    inline constexpr uint32_t kGraphFileVersion   = 1;
+    inline constexpr size_t   kGraphFileAlignment = 64;
+
+    void writeGraphFile(const Graph& graph, const std::filesystem::path& path);
+
+    [[nodiscard]] std::shared_ptr<Graph> readGraphFile(const std::filesystem::path& path);
+
+    // true if `path` starts with the .tcg magic, whatever its extension
+    [[nodiscard]] bool isGraphFile(const std::filesystem::path& path);
+
+} // namespace tc
+
+#endif // GRAPH_SERIALIZER_HPP
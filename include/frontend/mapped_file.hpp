@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace tc
+{
+
+    // read-only memory mapping of a whole file, unmapped when the last owner goes away.
+    // Tensors loaded from the file hold a shared_ptr to it, see Tensor::setRawDataView
+    class MappedFile
+    {
+    public:
+        [[nodiscard]] static std::shared_ptr<MappedFile> open(const std::filesystem::path& path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] const uint8_t* data() const { return data_; }
+        [[nodiscard]] size_t         size() const { return size_; }
+
+        [[nodiscard]] std::span<const uint8_t> bytes() const { return {data_, size_}; }
+
+        [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+
+    private:
+        MappedFile(std::filesystem::path path, const uint8_t* data, size_t size);
+
+        std::filesystem::path path_;
+        const uint8_t*        data_{nullptr};
+        size_t                size_{0};
+    };
+
+} // namespace tc
+
+#endif // MAPPED_FILE_HPP
@@ -28,10 +28,37 @@ namespace tc
             std::string graph_name;
         };
 
+        // metadata only: scans the protobuf wire format and skips the graph apart from its name,
+        // weights are never read
         [[nodiscard]] static ModelInfo
         readModelInfo(const std::filesystem::path& path);
     };
 
+
+    // one parse of a model file serving both its metadata and its graph
+    class OnnxSession
+    {
+    public:
+        explicit OnnxSession(const std::filesystem::path& path);
+        ~OnnxSession();
+
+        OnnxSession(const OnnxSession&)            = delete;
+        OnnxSession& operator=(const OnnxSession&) = delete;
+
+        [[nodiscard]] const OnnxLoader::ModelInfo& info() const { return info_; }
+
+        // built on the first call, later calls return the same graph
+        [[nodiscard]] std::shared_ptr<Graph> graph();
+
+    private:
+        struct Parsed;
+
+        std::filesystem::path   path_;
+        OnnxLoader::ModelInfo   info_;
+        std::unique_ptr<Parsed> parsed_;
+        std::shared_ptr<Graph>  graph_;
+    };
+
 } // namespace tc
 
 #endif // ONNX_LOADER_HPP
@@ -0,0 +1,70 @@
+#ifndef ONNX_WIRE_HPP
+#define ONNX_WIRE_HPP
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace tc
+{
+
+    // Direct access to the protobuf wire format of an ONNX model, for the parts the
+    // generated parser would otherwise copy.
+
+    enum class WireType : uint32_t
+    {
+        VARINT  = 0,
+        FIXED64 = 1,
+        LEN     = 2,
+        FIXED32 = 5,
+    };
+
+    // one field of a message: the whole encoded field, its varint value or its payload
+    struct WireField
+    {
+        uint32_t                 number{};
+        WireType                 type{};
+        uint64_t                 value{};    // VARINT
+        std::span<const uint8_t> payload;    // LEN, FIXED32, FIXED64
+        std::span<const uint8_t> encoded;
+
+        [[nodiscard]] std::string asString() const
+        {
+            return {reinterpret_cast<const char*>(payload.data()), payload.size()};
+        }
+    };
+
+    // walks the fields of one message, payloads of LEN fields are skipped without being read
+    class WireReader
+    {
+    public:
+        explicit WireReader(std::span<const uint8_t> bytes)
+            : pos_(bytes.data()), end_(bytes.data() + bytes.size()) {}
+
+        [[nodiscard]] bool atEnd() const { return pos_ == end_; }
+
+        WireField next();
+
+    private:
+        uint64_t readVarint();
+        std::span<const uint8_t> take(size_t n);
+
+        const uint8_t* pos_;
+        const uint8_t* end_;
+    };
+
+    struct SplitModel
+    {
+        std::string                           skeleton;  // the model without initializer raw_data
+        std::vector<std::span<const uint8_t>> raw_data;  // one per graph initializer, in order
+    };
+
+    // Re-encodes a serialized ModelProto without the raw_data of its graph initializers, which
+    // are returned as ranges of `model` instead. Parsing the skeleton gives the same graph
+    // with empty raw_data fields; initializers without raw_data get an empty range.
+    [[nodiscard]] SplitModel splitInitializerData(std::span<const uint8_t> model);
+
+} // namespace tc
+
+#endif // ONNX_WIRE_HPP
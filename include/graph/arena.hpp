@@ -0,0 +1,75 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tc
+{
+
+    // Bump-pointer storage for the objects of one graph. Objects are placed back to back
+    // in large blocks and are all destroyed, in reverse order, when the arena dies;
+    // nothing is freed individually. Not thread-safe.
+    class GraphArena
+    {
+    public:
+        GraphArena() = default;
+        ~GraphArena();
+
+        GraphArena(const GraphArena&) = delete;
+        GraphArena& operator=(const GraphArena&) = delete;
+
+        template <typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            // room for the destructor entry first, so a constructed object is never lost
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                if (dtors_.size() == dtors_.capacity())
+                    dtors_.reserve(dtors_.empty() ? 64 : dtors_.capacity() * 2);
+
+            // an allocator-aware T, a Node, gets the arena for its containers too
+            void* mem = resource_.allocate(sizeof(T), alignof(T));
+            T* obj = std::uninitialized_construct_using_allocator(
+                static_cast<T*>(mem), std::pmr::polymorphic_allocator<>(&resource_), std::forward<Args>(args)...);
+
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                dtors_.push_back({obj, [](void* p) { static_cast<T*>(p)->~T(); }});
+
+            bytes_ += sizeof(T);
+            return obj;
+        }
+
+        // for containers that should allocate from the arena too
+        [[nodiscard]] std::pmr::memory_resource* resource() { return &resource_; }
+
+        // bytes handed out by create(), container storage not included
+        [[nodiscard]] size_t bytesUsed() const { return bytes_; }
+
+    private:
+        struct Dtor
+        {
+            void* obj;
+            void (*destroy)(void*);
+        };
+
+        std::pmr::monotonic_buffer_resource resource_;
+        std::vector<Dtor>                   dtors_;
+        size_t                              bytes_{0};
+    };
+
+    // Handle to an arena object that keeps the whole arena alive, so nodes and tensors
+    // handed out by a graph stay valid after the graph itself is gone.
+    template <typename T>
+    std::shared_ptr<T> arenaHandle(const std::shared_ptr<GraphArena>& arena, T* obj)
+    {
+        return std::shared_ptr<T>(arena, obj);
+    }
+
+} // namespace tc
+
+#endif // ARENA_HPP
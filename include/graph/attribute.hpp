@@ -1,7 +1,10 @@
 #ifndef ATTRIBUTE_HPP
 #define ATTRIBUTE_HPP
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <stdexcept>
@@ -46,14 +49,51 @@ namespace tc
         std::vector<std::vector<uint8_t>>          // SPARSE_TENSORS
     >;
 
+    // Attribute names the compiler reads, interned so a lookup compares one integer.
+    // Any other name is Other and is matched by its string.
+    enum class AttrKey : uint16_t
+    {
+        Other,
+        Alpha,
+        Beta,
+        TransA,
+        TransB,
+        Axis,
+        Axes,
+        Start,
+        End,
+        AllowZero,
+        KernelShape,
+        Strides,
+        Pads,
+        Dilations,
+        Group,
+        AutoPad,
+        Epsilon,
+        CeilMode,
+        CountIncludePad,
+        StorageOrder,
+        KeepDims,
+        Perm,
+        Approximate,
+        Min,
+        Max,
+        Value,
+        To,
+    };
+
+    [[nodiscard]] AttrKey     attrKeyFromString(std::string_view s);
+    [[nodiscard]] std::string attrKeyToString(AttrKey key);
+
     class Attribute
     {
     public:
         Attribute() = default;
         Attribute(std::string name, AttributeType type, AttributeValue value)
-            : name_(std::move(name)), type_(type), value_(std::move(value)) {}
+            : name_(std::move(name)), key_(attrKeyFromString(name_)), type_(type), value_(std::move(value)) {}
 
         [[nodiscard]] const std::string&    getName()  const { return name_; }
+        [[nodiscard]] AttrKey               getKey()   const { return key_; }
         [[nodiscard]] AttributeType         getType()  const { return type_; }
         [[nodiscard]] const AttributeValue& getValue() const { return value_; }
 
@@ -74,6 +114,7 @@ namespace tc
 
     private:
         std::string    name_;
+        AttrKey        key_{AttrKey::Other};
         AttributeType  type_{AttributeType::UNDEFINED};
         AttributeValue value_;
     };
@@ -0,0 +1,74 @@
+#ifndef COST_MODEL_HPP
+#define COST_MODEL_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tc
+{
+
+    // Roofline of the target: a node takes at least flops / peak and bytes / bandwidth,
+    // whichever is larger. The defaults are a small single-core CPU.
+    struct MachineModel
+    {
+        double peak_gflops       = 50.0;
+        double mem_bandwidth_gbs = 20.0;
+
+        // FLOPs per byte above which a node is compute-bound
+        [[nodiscard]] double ridgePoint() const { return peak_gflops / mem_bandwidth_gbs; }
+    };
+
+    // "<GFLOP/s>,<GB/s>", e.g. "50,20"
+    [[nodiscard]] MachineModel machineModelFromString(std::string_view spec);
+
+    enum class Bound
+    {
+        Compute,
+        Memory,
+    };
+
+    struct NodeCost
+    {
+        NodeId   node = kNoNode;
+        uint64_t flops            = 0;     // a multiply-add counts as 2
+        uint64_t weight_bytes     = 0;     // constant inputs
+        uint64_t activation_bytes = 0;     // other inputs read plus outputs written
+        double   seconds          = 0.0;   // roofline estimate
+        Bound    bound            = Bound::Memory;
+        bool     exact            = true;  // false if a shape was dynamic or unknown
+
+        [[nodiscard]] uint64_t bytes() const { return weight_bytes + activation_bytes; }
+        [[nodiscard]] double intensity() const
+        {
+            return bytes() ? static_cast<double>(flops) / static_cast<double>(bytes()) : 0.0;
+        }
+    };
+
+    struct CostReport
+    {
+        MachineModel          machine;
+        std::vector<NodeCost> nodes;        // in topological order
+
+        uint64_t flops            = 0;
+        uint64_t weight_bytes     = 0;      // each constant once, however many nodes read it
+        uint64_t activation_bytes = 0;
+        double   seconds          = 0.0;
+        size_t   inexact_nodes    = 0;
+
+        // totals, then the `top` most expensive nodes by estimated time
+        [[nodiscard]] std::string summary(const Graph& graph, size_t top = 10) const;
+    };
+
+    // Static cost of every node. Shapes not declared in the graph are inferred along the
+    // topological order for Add, Mul, Relu, MatMul, Gemm, Conv, Concat, Shape and Reshape
+    // (constant target shape); dynamic dimensions count as 1 and make the node inexact.
+    // Other ops are charged the bytes of their known inputs and outputs and no FLOPs.
+    [[nodiscard]] CostReport estimateCost(const Graph& graph, const MachineModel& machine = {});
+
+} // namespace tc
+
+#endif // COST_MODEL_HPP
@@ -0,0 +1,26 @@
+#ifndef FUSION_HPP
+#define FUSION_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace tc
+{
+
+    // Replaces the LayerNormalization exporters decompose into elementwise ops,
+    //   mean = ReduceMean(x), d = x - mean, var = ReduceMean(Pow(d, 2) or d * d),
+    //   y = d / Sqrt(var + epsilon) [* scale] [+ bias]
+    // over trailing axes, with one LayerNormalization node. The intermediates must have no
+    // other readers, epsilon and the exponent must be float initializers. `graph` is replaced
+    // by a rewritten copy when anything matched; returns the number of patterns replaced.
+    size_t fuseLayerNorm(std::shared_ptr<Graph>& graph);
+
+    // Replaces Mul(x, Sigmoid(x)), in either operand order, with one Swish node (SiLU,
+    // alpha 1) when the Sigmoid has no other reader. Returns the number of patterns replaced.
+    size_t fuseSwish(std::shared_ptr<Graph>& graph);
+
+} // namespace tc
+
+#endif // FUSION_HPP
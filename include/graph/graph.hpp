@@ -1,18 +1,32 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include "graph/arena.hpp"
 #include "graph/node.hpp"
 #include "graph/tensor.hpp"
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
-#include <optional>
 #include <stdexcept>
 
 namespace tc
 {
 
+    // Dense ids handed out by a Graph. Names are interned once when a tensor or node is
+    // added, after that every lookup along an edge is an array index.
+    using TensorId = uint32_t;
+    using NodeId   = uint32_t;
+
+    inline constexpr TensorId kNoTensor = std::numeric_limits<TensorId>::max();
+    inline constexpr NodeId   kNoNode   = std::numeric_limits<NodeId>::max();
+
     class Graph
     {
     public:
@@ -21,30 +35,125 @@ namespace tc
         [[nodiscard]] const std::string& getName() const { return name_; }
         void setName(std::string n) { name_ = std::move(n); }
 
+        // Build a node or tensor in the graph's arena. The handle shares ownership of the
+        // arena, the object itself still has to be added with addNode/addTensor.
+        template <typename... Args>
+        [[nodiscard]] std::shared_ptr<Node> createNode(Args&&... args)
+        {
+            return arenaHandle(arena_, arena_->create<Node>(std::forward<Args>(args)...));
+        }
+
+        template <typename... Args>
+        [[nodiscard]] std::shared_ptr<Tensor> createTensor(Args&&... args)
+        {
+            return arenaHandle(arena_, arena_->create<Tensor>(std::forward<Args>(args)...));
+        }
+
+        [[nodiscard]] const GraphArena& arena() const { return *arena_; }
+
+        // sizes the id tables up front when the number of nodes and tensors is known
+        void reserve(size_t num_nodes, size_t num_tensors);
+
+        // nodes are indexed by NodeId, in the order they were added
         void addNode(std::shared_ptr<Node> node);
         [[nodiscard]] const std::vector<std::shared_ptr<Node>>& getNodes() const;
-        [[nodiscard]] std::optional<std::shared_ptr<Node>> findNode(const std::string& name) const;
+        [[nodiscard]] Node*  findNode(std::string_view name) const;
+        [[nodiscard]] NodeId nodeId(std::string_view name) const;
+
+        // the tensors a node reads and writes, an empty (omitted optional) name is kNoTensor
+        [[nodiscard]] std::span<const TensorId> nodeInputs(NodeId id) const;
+        [[nodiscard]] std::span<const TensorId> nodeOutputs(NodeId id) const;
+
+        // use-def adjacency, kept up to date by addNode. The producer is kNoNode for graph
+        // inputs, constants and undefined tensors; consumers have one entry per use.
+        [[nodiscard]] NodeId producerOf(TensorId id) const { return producers_[id]; }
+        [[nodiscard]] std::span<const NodeId> consumersOf(TensorId id) const { return consumers_[id]; }
 
+        // whether a node reading `id` has to wait for its producer, i.e. `id` is an
+        // activation computed by the graph rather than an input or a constant
+        [[nodiscard]] bool dependsOnProducer(TensorId id) const
+        {
+            return id != kNoTensor && producers_[id] != kNoNode && !isSource(id);
+        }
+
+        // Tensors are indexed by TensorId. A name a node refers to gets an id even if no
+        // tensor was added for it, its slot is null until one is.
         void addTensor(std::shared_ptr<Tensor> tensor);
-        [[nodiscard]] std::optional<std::shared_ptr<Tensor>> findTensor(const std::string& name) const;
-        [[nodiscard]] const std::unordered_map<std::string, std::shared_ptr<Tensor>>& getTensors() const;
+        [[nodiscard]] Tensor* findTensor(std::string_view name) const;
+        [[nodiscard]] const std::vector<std::shared_ptr<Tensor>>& getTensors() const;
+
+        [[nodiscard]] TensorId internTensor(std::string_view name);
+        [[nodiscard]] TensorId tensorId(std::string_view name) const;
+        [[nodiscard]] const std::string& tensorName(TensorId id) const { return tensor_names_[id]; }
+        [[nodiscard]] Tensor* tensor(TensorId id) const { return tensors_[id].get(); }
+        [[nodiscard]] size_t  numTensorIds() const { return tensors_.size(); }
 
         void addInput (const std::string& name);
         void addOutput(const std::string& name);
         [[nodiscard]] const std::vector<std::string>& getInputs()  const { return inputs_; }
         [[nodiscard]] const std::vector<std::string>& getOutputs() const { return outputs_; }
+        [[nodiscard]] const std::vector<TensorId>& getInputIds()  const { return input_ids_; }
+        [[nodiscard]] const std::vector<TensorId>& getOutputIds() const { return output_ids_; }
 
+        // Computed on first use and cached. Nodes appended in dependency order, as a loader
+        // adds them, extend the cached order; any other change recomputes it on the next call.
+        // Nodes on a cycle are left out. Not safe to call concurrently with itself.
+        [[nodiscard]] const std::vector<NodeId>& topologicalOrder() const;
         [[nodiscard]] std::vector<std::shared_ptr<Node>> topologicalSort() const;
 
         [[nodiscard]] std::string summary() const;
 
     private:
+        // transparent, so lookups by string_view do not build a std::string
+        struct NameHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+        };
+        using NameIndex = std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>>;
+
+        // graph inputs and constants are available before any node runs
+        [[nodiscard]] bool isSource(TensorId id) const
+        {
+            return is_input_[id] || (tensors_[id] && tensors_[id]->hasData());
+        }
+
+        void computeTopologicalOrder() const;
+
+        // a node's edges in edges_: inputs are [begin, mid), outputs are [mid, end)
+        struct EdgeRange
+        {
+            uint32_t begin{};
+            uint32_t mid{};
+            uint32_t end{};
+        };
+
+        // first, so it outlives every member allocating from it
+        std::shared_ptr<GraphArena>             arena_;
+
         std::string name_;
-        std::vector<std::shared_ptr<Node>>                          nodes_;
-        std::unordered_map<std::string, std::shared_ptr<Node>>      node_map_;
-        std::unordered_map<std::string, std::shared_ptr<Tensor>>    tensor_map_;
-        std::vector<std::string>                                    inputs_;
-        std::vector<std::string>                                    outputs_;
+
+        std::vector<std::shared_ptr<Node>>      nodes_;
+        std::vector<EdgeRange>                  node_edges_;
+        std::vector<TensorId>                   edges_;
+        NameIndex                               node_ids_;
+
+        std::vector<std::shared_ptr<Tensor>>    tensors_;
+        std::vector<std::string>                tensor_names_;
+        NameIndex                               tensor_ids_;
+
+        // by TensorId
+        std::vector<NodeId>                     producers_;
+        std::vector<std::pmr::vector<NodeId>>   consumers_;     // storage in arena_
+        std::vector<uint8_t>                    is_input_;
+
+        mutable std::vector<NodeId>             topo_order_;
+        mutable bool                            topo_valid_{true};
+
+        std::vector<std::string>                inputs_;
+        std::vector<std::string>                outputs_;
+        std::vector<TensorId>                   input_ids_;
+        std::vector<TensorId>                   output_ids_;
     };
 
 } // namespace ts
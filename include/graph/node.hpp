@@ -4,9 +4,12 @@
 
 #include "graph/attribute.hpp"
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 
 namespace tc
@@ -24,6 +27,19 @@ namespace tc
         Shape,
         Reshape,
         Concat,
+        Softmax,
+        LogSoftmax,
+        LayerNormalization,
+        Sigmoid,
+        Tanh,
+        Gelu,
+        Swish,
+        HardSwish,
+        Erf,
+        Exp,
+        MaxPool,
+        AveragePool,
+        GlobalAveragePool,
         Other,
     };
 
@@ -33,7 +49,12 @@ namespace tc
     class Node
     {
     public:
-        using AttributeMap = std::unordered_map<std::string, Attribute>;
+        // The lists take their storage from the allocator, Graph::createNode() passes its
+        // arena. The attributes' own values are still separate allocations
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using NameList       = std::pmr::vector<std::pmr::string>;
+        // a handful per node, a linear scan over the keys beats hashing the name
+        using AttributeList  = std::pmr::vector<Attribute>;
 
         Node() = default;
         Node(std::string name,
@@ -41,29 +62,60 @@ namespace tc
             std::string op_str,
             std::vector<std::string> inputs,
             std::vector<std::string> outputs,
-            AttributeMap attributes = {});
+            AttributeList attributes = {});
+
+        Node(std::allocator_arg_t, const allocator_type& alloc,
+            std::string name,
+            OpType op,
+            std::string op_str,
+            std::vector<std::string> inputs,
+            std::vector<std::string> outputs,
+            AttributeList attributes = {});
 
         [[nodiscard]] const std::string& getName()    const { return name_; }
         [[nodiscard]] OpType             getOpType()  const { return op_; }
         [[nodiscard]] const std::string& getOpStr()   const { return op_str_; }
 
-        [[nodiscard]] const std::vector<std::string>& getInputs()  const { return inputs_; }
-        [[nodiscard]] const std::vector<std::string>& getOutputs() const { return outputs_; }
+        [[nodiscard]] const NameList& getInputs()  const { return inputs_; }
+        [[nodiscard]] const NameList& getOutputs() const { return outputs_; }
 
-        [[nodiscard]] const AttributeMap& getAttributes() const  { return attrs_; }
-        [[nodiscard]] bool hasAttribute(const std::string& key) const;
-        [[nodiscard]] const Attribute& getAttribute(const std::string& key) const;
+        [[nodiscard]] const AttributeList& getAttributes() const  { return attrs_; }
+        [[nodiscard]] bool hasAttribute(std::string_view name) const { return findAttribute(name) != nullptr; }
+        [[nodiscard]] bool hasAttribute(AttrKey key) const { return findAttribute(key) != nullptr; }
+        [[nodiscard]] const Attribute& getAttribute(std::string_view name) const;
+        [[nodiscard]] const Attribute& getAttribute(AttrKey key) const;
         void addAttribute(Attribute attr);
 
+        // null when the node has no such attribute, `key` must not be AttrKey::Other
+        [[nodiscard]] const Attribute* findAttribute(AttrKey key) const
+        {
+            for (const auto& a : attrs_)
+                if (a.getKey() == key) return &a;
+            return nullptr;
+        }
+
+        [[nodiscard]] const Attribute* findAttribute(std::string_view name) const;
+
+        // The attribute's value, or `fallback` when it is absent, in one lookup. T is given
+        // explicitly and must be the stored alternative, e.g. attributeOr<int64_t>(AttrKey::Group, 1).
+        template <typename T>
+        [[nodiscard]] T attributeOr(AttrKey key, const std::type_identity_t<T>& fallback) const
+        {
+            const auto* a = findAttribute(key);
+            if (!a) return fallback;
+            if (const auto* v = std::get_if<T>(&a->getValue())) return *v;
+            throw std::bad_variant_access{};
+        }
+
         [[nodiscard]] std::string toString() const;
 
     private:
-        std::string              name_;
-        OpType                   op_ { OpType::Unknown };
-        std::string              op_str_;
-        std::vector<std::string> inputs_;
-        std::vector<std::string> outputs_;
-        AttributeMap             attrs_;
+        std::string   name_;
+        OpType        op_ { OpType::Unknown };
+        std::string   op_str_;
+        NameList      inputs_;
+        NameList      outputs_;
+        AttributeList attrs_;
     };
 
 } // namespace tc
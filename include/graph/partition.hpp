@@ -0,0 +1,38 @@
+#ifndef PARTITION_HPP
+#define PARTITION_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace tc
+{
+
+    using TaskId = uint32_t;
+    inline constexpr TaskId kNoTask = std::numeric_limits<TaskId>::max();
+
+    // Nodes grouped into tasks that run one after another inside, and concurrently with
+    // every task they don't depend on. Chains of nodes stay in one task, a task starts
+    // wherever the graph branches or joins.
+    struct TaskGraph
+    {
+        std::vector<TaskId>              task_of;   // by NodeId, kNoTask for nodes not in the order
+        std::vector<std::vector<NodeId>> nodes;     // by TaskId, in the order they were given
+        std::vector<std::vector<TaskId>> deps;      // by TaskId, the tasks it waits for
+
+        [[nodiscard]] size_t size() const { return nodes.size(); }
+
+        // Most tasks on one dependency level, an estimate of how many can run at once.
+        // 1 means the tasks form a single chain and there is nothing to run in parallel.
+        [[nodiscard]] size_t width() const;
+    };
+
+    // `order` must be a topological order, e.g. Graph::topologicalOrder() or a Schedule
+    [[nodiscard]] TaskGraph partitionTasks(const Graph& graph, std::span<const NodeId> order);
+
+} // namespace tc
+
+#endif // PARTITION_HPP
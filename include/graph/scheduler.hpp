@@ -0,0 +1,48 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "graph/graph.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tc
+{
+
+    // The order nodes are emitted in. Every policy is a valid topological order, they differ
+    // in how many intermediate tensors are alive at the same time.
+    enum class SchedulePolicy
+    {
+        Kahn,           // breadth-first, Graph::topologicalOrder()
+        MinMemory,      // greedy, runs the ready node that grows the live set the least
+        DepthFirst,     // runs a consumer as soon as it is ready, keeps it next to its producer
+    };
+
+    // "kahn", "memory" or "depth-first"
+    [[nodiscard]] SchedulePolicy schedulePolicyFromString(std::string_view name);
+    [[nodiscard]] std::string    schedulePolicyToString(SchedulePolicy policy);
+
+    struct Schedule
+    {
+        std::vector<NodeId> order;
+        size_t              peak_bytes = 0;     // see peakActivationBytes
+    };
+
+    [[nodiscard]] Schedule scheduleGraph(const Graph& graph, SchedulePolicy policy);
+
+    // Size of an activation, dynamic dimensions count as 1. Tensors without a declared
+    // shape or with a type of unknown size count as 0.
+    [[nodiscard]] size_t activationBytes(const Graph& graph, TensorId id);
+
+    // Largest total size of the activations alive at once when the nodes run in `order`.
+    // An activation is alive from its producer until its last consumer has run, a node's
+    // inputs and outputs are alive together. Graph outputs stay alive to the end, graph
+    // inputs and constants are not counted.
+    [[nodiscard]] size_t peakActivationBytes(const Graph& graph, std::span<const NodeId> order);
+
+} // namespace tc
+
+#endif // SCHEDULER_HPP
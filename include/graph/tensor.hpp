@@ -3,6 +3,8 @@
 
 
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <optional>
@@ -53,9 +55,19 @@ namespace tc
         [[nodiscard]] DataType            getDtype()  const { return dtype_; }
         [[nodiscard]] const TensorShape&  getShape()  const { return shape_; }
 
-        [[nodiscard]] bool hasData() const { return !raw_data_.empty(); }
-        [[nodiscard]] const std::vector<uint8_t>& getRawData()  const { return raw_data_; }
-        void setRawData(std::vector<uint8_t> data) { raw_data_ = std::move(data); }
+        [[nodiscard]] bool hasData() const { return !getRawData().empty(); }
+
+        [[nodiscard]] std::span<const uint8_t> getRawData() const
+        {
+            return is_view_ ? data_view_ : std::span<const uint8_t>(raw_data_);
+        }
+
+        void setRawData(std::vector<uint8_t> data);
+
+        // zero-copy data, `bytes` must stay valid while `owner` is alive (e.g. a MappedFile)
+        void setRawDataView(std::span<const uint8_t> bytes, std::shared_ptr<const void> owner);
+
+        [[nodiscard]] bool isDataView() const { return is_view_; }
 
         void setShape(TensorShape shape) { shape_ = std::move(shape); }
         void setDtype(DataType dtype)    { dtype_ = dtype; }
@@ -70,15 +82,22 @@ namespace tc
             static_assert(std::is_arithmetic_v<T>, "T must be arithmetic");
             if (!hasData()) return {};
 
-            size_t elem_count = raw_data_.size() / sizeof(T);
+            auto raw = getRawData();
+            size_t elem_count = raw.size() / sizeof(T);
 
-            if (elem_count * sizeof(T) != raw_data_.size())
+            if (elem_count * sizeof(T) != raw.size())
             {
                 throw std::runtime_error("Data size not aligned with type");
             }
 
+            // views into a mapped file keep the offset protobuf gave them
+            if (reinterpret_cast<uintptr_t>(raw.data()) % alignof(T) != 0)
+            {
+                throw std::runtime_error("Data address not aligned with type, use getRawData()");
+            }
+
             return std::span<const T>(
-                reinterpret_cast<const T*>(raw_data_.data()),
+                reinterpret_cast<const T*>(raw.data()),
                 elem_count
             );
         }
@@ -88,8 +107,8 @@ namespace tc
         {
             if (!hasData()) return false;
             size_t elem_size = sizeof(T);
-            size_t elem_count = raw_data_.size() / elem_size;
-            return elem_count * elem_size == raw_data_.size();
+            size_t elem_count = getRawData().size() / elem_size;
+            return elem_count * elem_size == getRawData().size();
         }
 
 
@@ -102,6 +121,10 @@ namespace tc
         DataType             dtype_{DataType::UNDEFINED};
         TensorShape          shape_;
         std::vector<uint8_t> raw_data_;
+
+        bool                        is_view_{false};
+        std::span<const uint8_t>    data_view_;
+        std::shared_ptr<const void> data_owner_;
     };
 
 } // namespace tc
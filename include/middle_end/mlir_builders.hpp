@@ -52,6 +52,36 @@ namespace tc
 
     mlir::Value buildReLU(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value input, mlir::MLIRContext* ctx);
 
+    // Sigmoid, Tanh, Gelu, Swish, HardSwish, Erf or Exp as an elementwise linalg.generic.
+    // `alpha` is Swish's, `tanhGelu` selects GELU's tanh approximation.
+    mlir::Value buildActivation(OpType opType,
+                                mlir::OpBuilder& builder,
+                                mlir::Location loc,
+                                mlir::Value input,
+                                double alpha,
+                                bool tanhGelu,
+                                mlir::MLIRContext* ctx);
+
+    // Softmax or LogSoftmax along `axis` (negative counts from the back) as two generics:
+    // one pass computing the running max and sum of exponentials, one normalizing
+    mlir::Value buildSoftmax(mlir::OpBuilder& builder,
+                             mlir::Location loc,
+                             mlir::Value input,
+                             int64_t axis,
+                             bool logSoftmax,
+                             mlir::MLIRContext* ctx);
+
+    // LayerNormalization over the dimensions [axis, rank): a Welford pass for mean and
+    // variance, then one pass normalizing with scale and bias fused in
+    mlir::Value buildLayerNorm(mlir::OpBuilder& builder,
+                               mlir::Location loc,
+                               mlir::Value input,
+                               std::optional<mlir::Value> scale,
+                               std::optional<mlir::Value> bias,
+                               int64_t axis,
+                               double epsilon,
+                               mlir::MLIRContext* ctx);
+
     mlir::Value buildShapeOp(mlir::OpBuilder& builder,
                             mlir::Location loc,
                             mlir::Value input,
@@ -75,6 +105,27 @@ namespace tc
                                 llvm::StringRef autoPad,
                                 mlir::MLIRContext* ctx);
 
+    // MaxPool or AveragePool of an NCHW tensor as a linalg pooling op. Padding never wins a
+    // max; averages divide by the window size, or with count_include_pad = 0 by the window's
+    // positions inside the input. ceil_mode needs static H and W. `unsignedInts` makes a
+    // MaxPool of integers compare unsigned, e.g. for uint8, which is a signless i8 here
+    mlir::Value buildPool2dOp(OpType opType,
+                              mlir::OpBuilder& builder,
+                              mlir::Location loc,
+                              mlir::Value input,
+                              llvm::ArrayRef<int64_t> kernelShape,
+                              llvm::ArrayRef<int64_t> strides,
+                              llvm::ArrayRef<int64_t> pads,
+                              llvm::ArrayRef<int64_t> dilations,
+                              bool ceilMode,
+                              bool countIncludePad,
+                              llvm::StringRef autoPad,
+                              mlir::MLIRContext* ctx,
+                              bool unsignedInts = false);
+
+    // mean over all dimensions after N and C, which are kept with size 1
+    mlir::Value buildGlobalAveragePool(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value input, mlir::MLIRContext* ctx);
+
     mlir::Value makeZeroConstant(mlir::OpBuilder& builder, mlir::Location loc, mlir::Type elemType);
     std::optional<int64_t> foldToInt(mlir::Value v);
     std::optional<int64_t> tryGetConstShapeElem(mlir::Value tensor, int64_t elemIdx);
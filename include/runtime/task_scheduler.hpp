@@ -0,0 +1,100 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tc
+{
+
+    // Threads a process may use for inference, TC_NUM_THREADS or the hardware concurrency.
+    // Branches of the graph and chunks of parallel loops share this one budget.
+    [[nodiscard]] unsigned threadBudget();
+
+    // Work-stealing pool. Each worker pushes and pops the tasks it spawns at the back of
+    // its own deque and, when that is empty, steals the oldest task from the front of
+    // another one. Tasks from other threads go through a shared queue.
+    //
+    // A thread that has to wait for a result calls waitUntil() and runs pending tasks in
+    // the meantime, so the pool has threadBudget() - 1 workers and the caller is the last.
+    // Detached tasks, whole inference requests, are the exception: only idle workers take
+    // them, so a request that waits never runs another request nested on its stack.
+    class TaskScheduler
+    {
+    public:
+        struct Task
+        {
+            void (*fn)(void*) = nullptr;
+            void* arg         = nullptr;
+        };
+
+        explicit TaskScheduler(unsigned num_workers);
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        // created on first use with threadBudget() - 1 workers, at least one
+        static TaskScheduler& global();
+
+        void submit(Task task);
+
+        // a task only the workers' loops run, never waitUntil(); needs at least one worker
+        void submitDetached(Task task);
+
+        // runs one pending task on the calling thread, false if there was none
+        bool runOne();
+
+        // runs pending tasks until done() holds, sleeping when there are none
+        template <typename Done>
+        void waitUntil(Done&& done)
+        {
+            while (!done())
+            {
+                if (runOne()) continue;
+
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [&] { return done() || pending_.load(std::memory_order_acquire) > 0; });
+            }
+        }
+
+        // wakes threads in waitUntil(), call after making a done() condition true
+        void notifyWaiters();
+
+        [[nodiscard]] unsigned numWorkers() const { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        struct Queue
+        {
+            std::mutex       mu;
+            std::deque<Task> tasks;
+        };
+
+        void workerLoop(unsigned index);
+        bool popLocal(unsigned index, Task& task);
+        bool popShared(Task& task);
+        bool popDetached(Task& task);
+        bool steal(unsigned thief, Task& task);
+        void wake();
+
+        std::vector<std::unique_ptr<Queue>> queues_;       // one per worker
+        Queue                               shared_;       // from threads outside the pool
+        Queue                               detached_;     // see submitDetached()
+        std::vector<std::thread>            workers_;
+
+        std::atomic<size_t>                 pending_{0};   // tasks in any queue but detached_
+        std::atomic<size_t>                 detached_pending_{0};
+        std::mutex                          mu_;
+        std::condition_variable             cv_;
+        bool                                stop_ = false;
+    };
+
+} // namespace tc
+
+#endif // TASK_SCHEDULER_HPP
@@ -0,0 +1,50 @@
+#ifndef TC_RUNTIME_H
+#define TC_RUNTIME_H
+
+/*
+ * C interface of libtc_runtime, linked into programs that run models compiled with
+ * --parallel-branches or --parallel-loops, or that use the asynchronous entry points of
+ * --emit-header. The library also provides the mlirAsyncRuntime* functions the
+ * generated code calls.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* threads compiled models run on, TC_NUM_THREADS or the hardware concurrency */
+int32_t tc_runtime_num_threads(void);
+
+/*
+ * Requests: work queued on the runtime's threads, e.g. a whole inference through the
+ * tc_<model>_invoke_async() wrapper of a generated header, so the submitting thread does
+ * not block while it runs.
+ */
+typedef struct tc_request tc_request;
+
+/* called with the status the request's function returned */
+typedef void (*tc_completion_fn)(int status, void* user_data);
+
+/*
+ * Queues fn(arg). When it returns, on_done (may be NULL) runs on the same runtime thread,
+ * then the request counts as done. Returns NULL if out of memory. The handle must be
+ * released with tc_request_release(), before or after the request completes.
+ */
+tc_request* tc_runtime_submit(int (*fn)(void* arg), void* arg, tc_completion_fn on_done, void* user_data);
+
+/* nonzero once the request and its callback have finished */
+int tc_request_done(const tc_request* req);
+
+/* blocks on a futex until the request is done, returns the status fn returned.
+ * Not to be called from a completion callback or from inside fn. */
+int tc_request_wait(tc_request* req);
+
+void tc_request_release(tc_request* req);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TC_RUNTIME_H */
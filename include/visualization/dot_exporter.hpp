@@ -3,13 +3,27 @@
 
 
 
+#include "graph/cost_model.hpp"
 #include "graph/graph.hpp"
 #include <filesystem>
+#include <ostream>
 #include <string>
+#include <vector>
 
 namespace tc
 {
 
+    // Time per node in seconds, indexed by NodeId, used to color a heatmap. Either the
+    // roofline estimate or a measured profile.
+    using NodeHeat = std::vector<double>;
+
+    [[nodiscard]] NodeHeat heatFromCost(const Graph& graph, const CostReport& report);
+
+    // One node per line, "<node name>,<milliseconds>" or "<node name> <milliseconds>";
+    // blank lines and lines starting with '#' are skipped. Times of a repeated name add up,
+    // names not in the graph are ignored.
+    [[nodiscard]] NodeHeat loadProfile(const std::filesystem::path& path, const Graph& graph);
+
     class DotExporter
     {
     public:
@@ -18,12 +32,24 @@ namespace tc
             bool show_tensor_shapes{true};
             bool show_attributes{true};
             bool color_by_optype{true};
+
+            // when not empty nodes are colored and labeled by their share of the total
+            NodeHeat heat;
+
+            // Graphs with more nodes than this are drawn with nodes collapsed by name scope,
+            // e.g. "/layer1/0/conv1/Conv" into "/layer1/0", at the deepest scope level that
+            // gets the drawing under the threshold. 0 never collapses.
+            size_t cluster_threshold{1000};
+            char   scope_separator{'/'};
         };
 
         DotExporter() = default;
 
         explicit DotExporter(Options opts);
 
+        // the document is written straight to `os`, nothing is built in memory
+        void write(const Graph& graph, std::ostream& os) const;
+
         [[nodiscard]] std::string toDot(const Graph& graph) const;
 
         void exportToFile(const Graph& graph, const std::filesystem::path& path) const;
@@ -34,6 +60,7 @@ namespace tc
         Options opts_;
 
         [[nodiscard]] static std::string nodeColor(OpType op);
+        [[nodiscard]] static std::string heatColor(double fraction);
         [[nodiscard]] static std::string escapeLabel(const std::string& s);
     };
 
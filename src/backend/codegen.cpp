@@ -1,15 +1,23 @@
 #include "backend/codegen.hpp"
+#include "backend/constant_pool.hpp"
+#include "backend/header_emitter.hpp"
 #include "middle_end/mlir_builders.hpp"
 
 // ── MLIR ───────────────────────────────────────────────────────────────────
 #include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Async/IR/Async.h"
+#include "mlir/Dialect/Async/Passes.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Passes.h"
+#include "mlir/Dialect/Linalg/Transforms/TilingInterfaceImpl.h"
 #include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/Math/Transforms/Passes.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SCF/Transforms/TileUsingInterface.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/IR/TensorTilingInterfaceImpl.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/Bufferization/IR/Bufferization.h"
@@ -19,11 +27,13 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/Verifier.h"
 #include "mlir/IR/AffineMap.h"
 
 // ── MLIR passes ───────────────────────────────────────────────────────────────────
 #include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Conversion/Passes.h"
 
@@ -32,6 +42,7 @@
 #include "mlir/Conversion/ArithToLLVM/ArithToLLVM.h"
 #include "mlir/Conversion/ControlFlowToLLVM/ControlFlowToLLVM.h"
 #include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVM.h"
+#include "mlir/Conversion/MathToLibm/MathToLibm.h"
 #include "mlir/Conversion/MathToLLVM/MathToLLVM.h"
 #include "mlir/Conversion/MemRefToLLVM/MemRefToLLVM.h"
 #include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"
@@ -40,6 +51,7 @@
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
+#include "mlir/Conversion/AsyncToLLVM/AsyncToLLVM.h"
 #include "mlir/Dialect/Linalg/Passes.h"
 #include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVMPass.h"
 #include "mlir/Dialect/MemRef/Transforms/Passes.h"
@@ -61,6 +73,7 @@
 
 // ── LLVM ───────────────────────────────────────────────────────────────────
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Passes/PassBuilder.h"
 
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/FileSystem.h"
@@ -81,14 +94,22 @@
 #include <sstream>
 #include <stdexcept>
 #include <cstring>
+#include <unordered_set>
 
 namespace tc
 {
 
     static void registerAllDialects(mlir::MLIRContext& ctx)
     {
+        // tiling of linalg ops and of the tensor.pads between them, see tilePoolingChains()
+        mlir::DialectRegistry registry;
+        mlir::linalg::registerTilingInterfaceExternalModels(registry);
+        mlir::tensor::registerTilingInterfaceExternalModels(registry);
+        ctx.appendDialectRegistry(registry);
+
         ctx.loadDialect<
             mlir::arith::ArithDialect,
+            mlir::async::AsyncDialect,
             mlir::func::FuncDialect,
             mlir::linalg::LinalgDialect,
             mlir::memref::MemRefDialect,
@@ -113,12 +134,31 @@ namespace tc
             case DataType::INT16:   return mlir::IntegerType::get(ctx, 16);
             case DataType::INT32:   return mlir::IntegerType::get(ctx, 32);
             case DataType::INT64:   return mlir::IntegerType::get(ctx, 64);
-            case DataType::UINT8:   return mlir::IntegerType::get(ctx,  8, mlir::IntegerType::Unsigned);
+            // arith only takes signless integers, the sign lives in the ops that care
+            case DataType::UINT8:   return mlir::IntegerType::get(ctx,  8);
             case DataType::BOOL:    return mlir::IntegerType::get(ctx,  1);
             default:                return mlir::Float32Type::get(ctx);
         }
     }
 
+    // dtypes mlirElemType() maps to an element of the width they are stored with
+    static bool hasNativeElemType(DataType dt)
+    {
+        switch (dt)
+        {
+            case DataType::FLOAT:
+            case DataType::DOUBLE:
+            case DataType::FLOAT16:
+            case DataType::INT8:
+            case DataType::INT16:
+            case DataType::INT32:
+            case DataType::INT64:
+            case DataType::UINT8:
+            case DataType::BOOL:    return true;
+            default:                return false;
+        }
+    }
+
     CodeGen::CodeGen(mlir::MLIRContext& mlir_ctx, llvm::LLVMContext& llvm_ctx) : mlir_ctx_(mlir_ctx), llvm_ctx_(llvm_ctx)
     {
         registerAllDialects(mlir_ctx_);
@@ -161,39 +201,187 @@ namespace tc
     {
         auto rtt = tensorTypeOf(w);
 
-        if (w.getDtype() == DataType::FLOAT && w.hasValidData())
-        {
-            auto span = w.getDataAs<float>();
-            llvm::SmallVector<float> vals(span.begin(), span.end());
-            auto attr = mlir::DenseElementsAttr::get(rtt, llvm::ArrayRef<float>(vals));
-            return mlir::arith::ConstantOp::create(builder, loc, rtt, attr);
-        }
+        if (w.hasData() && !hasNativeElemType(w.getDtype()))
+            throw std::runtime_error("Weight '" + w.getName() + "' has unsupported type " + dataTypeToString(w.getDtype()));
 
-        if (w.getDtype() == DataType::INT64 && w.hasValidData())
-        {
-            auto span = w.getDataAs<int64_t>();
-            llvm::SmallVector<int64_t> vals(span.begin(), span.end());
-            auto attr = mlir::DenseIntElementsAttr::get(rtt, llvm::ArrayRef<int64_t>(vals));
-            return mlir::arith::ConstantOp::create(builder, loc, rtt, attr);
-        }
+        // raw bytes are copied straight into the attribute in their own width, they may be
+        // an unaligned view into the mapped model file
+        if (w.hasValidData())
+            return constants_.materialize(builder, loc, rtt, w.getRawData());
 
-        //TODO - other data types
+        // a weight that carries data of the wrong size must not turn into zeros silently
+        if (w.hasData())
+            throw std::runtime_error("Weight '" + w.getName() + "' has " + std::to_string(w.getRawData().size()) +
+                                     " bytes of data, expected " +
+                                     std::to_string(w.numElements() * Tensor::dataTypeSize(w.getDtype())));
 
-        // else zero tensor
+        // no data at all, zero tensor
         // std::cout << "No data for ConstantOp" << std::endl;
         auto zero = builder.getZeroAttr(rtt.getElementType());
         auto attr = mlir::DenseElementsAttr::get(rtt, zero);
         return mlir::arith::ConstantOp::create(builder, loc, rtt, attr);
     }
 
-    void CodeGen::runOptPipeline(mlir::ModuleOp mod)
+    // pooled rows per tile; overlapping windows recompute kernel - stride producer rows per
+    // tile, which more rows amortize
+    static constexpr int64_t kPoolRowsPerTile = 4;
+
+    // Computes each pooling op, e.g. Conv -> Relu -> MaxPool, in tiles of kPoolRowsPerTile
+    // output rows of one channel, with the ops producing its input fused into the tile loop,
+    // so their full-resolution results are never stored. The fused chain follows operand 0
+    // through elementwise linalg ops and pads, up to the first op with reductions, a conv
+    // typically, and only through results nothing else reads. The fills its ops read are
+    // fused along with them.
+    static void tilePoolingChains(mlir::ModuleOp mod)
     {
-        //TODO - optimize
-        return;
+        llvm::SmallVector<mlir::Operation*> pools;
+        mod.walk([&](mlir::Operation* op)
+        {
+            if (llvm::isa<mlir::linalg::PoolingNchwMaxOp, mlir::linalg::PoolingNchwSumOp>(op)) pools.push_back(op);
+        });
+
+        mlir::IRRewriter rewriter(mod->getContext());
+        for (auto* pool : pools)
+        {
+            // fused into an earlier pool's tiles already
+            if (pool->use_empty()) continue;
+
+            llvm::SmallPtrSet<mlir::Operation*, 8> chain;
+            // fills an op reads, inputs as well as inits, e.g. ReLU's zeros or a conv's
+            // accumulator, are computed per tile too instead of stored at full size
+            auto addFills = [&](mlir::Operation* op)
+            {
+                auto linalgOp = llvm::dyn_cast<mlir::linalg::LinalgOp>(op);
+                if (!linalgOp) return;
+                for (auto& operand : linalgOp->getOpOperands())
+                    if (auto fill = operand.get().getDefiningOp<mlir::linalg::FillOp>(); fill && fill->hasOneUse())
+                        chain.insert(fill);
+            };
+
+            // AveragePool's division, and whatever elementwise fusion merged into it, is the
+            // outermost op of the tile
+            mlir::Operation* target = pool;
+            if (pool->hasOneUse())
+            {
+                auto user = llvm::dyn_cast<mlir::linalg::GenericOp>(*pool->user_begin());
+                if (user && user.getNumReductionLoops() == 0 && user.getNumLoops() == 4 && user->getOperand(0) == pool->getResult(0))
+                {
+                    target = user;
+                    chain.insert(pool);
+                    addFills(user);
+                }
+            }
+
+            bool computes = false;
+            for (mlir::Operation* op = pool;;)
+            {
+                addFills(op);
+                auto* producer = op->getOperand(0).getDefiningOp();
+                if (!producer || producer->getNumResults() != 1 || !producer->hasOneUse()) break;
+
+                if (llvm::isa<mlir::tensor::PadOp>(producer))
+                {
+                    chain.insert(producer);
+                    op = producer;
+                    continue;
+                }
+
+                auto linalgOp = llvm::dyn_cast<mlir::linalg::LinalgOp>(producer);
+                if (!linalgOp || llvm::isa<mlir::linalg::FillOp>(producer)) break;
+
+                chain.insert(producer);
+                computes = true;
+                if (linalgOp.getNumReductionLoops() > 0)
+                {
+                    addFills(producer);
+                    break;
+                }
+                op = producer;
+            }
+            if (!computes) continue;
+
+            // N, C and output rows, the kernel loops and output columns stay whole
+            auto numLoops = llvm::cast<mlir::linalg::LinalgOp>(target).getNumLoops();
+            llvm::SmallVector<mlir::OpFoldResult> tileSizes(numLoops, rewriter.getIndexAttr(0));
+            tileSizes[0] = rewriter.getIndexAttr(1);
+            tileSizes[1] = rewriter.getIndexAttr(1);
+            tileSizes[2] = rewriter.getIndexAttr(kPoolRowsPerTile);
+
+            mlir::scf::SCFTileAndFuseOptions options;
+            options.tilingOptions.setTileSizes(tileSizes);
+            options.setFusionControlFn([&](mlir::tensor::ExtractSliceOp, mlir::OpResult producer, bool)
+                -> std::optional<mlir::scf::SCFTileAndFuseOptions::ControlFnResult>
+            {
+                if (!chain.contains(producer.getOwner())) return std::nullopt;
+                return mlir::scf::SCFTileAndFuseOptions::ControlFnResult{};
+            });
+
+            rewriter.setInsertionPoint(target);
+            auto tiled = mlir::scf::tileConsumerAndFuseProducersUsingSCF(
+                rewriter, llvm::cast<mlir::TilingInterface>(target), options);
+
+            // left as it is, still correct
+            if (mlir::failed(tiled)) continue;
+
+            for (auto result : target->getResults())
+                if (auto replacement = tiled->replacements.lookup(result))
+                    rewriter.replaceAllUsesWith(result, replacement);
+            if (target->use_empty()) rewriter.eraseOp(target);
+        }
+    }
+
+    void CodeGen::runOptPipeline(mlir::ModuleOp mod, const CodeGenOptions& opts)
+    {
+        auto* ctx = mod->getContext();
+
+        // chains of elementwise generics, e.g. the activations behind a MatMul, become one
+        // loop nest with no intermediate buffers
+        mlir::PassManager pm(ctx);
+        pm.addPass(mlir::createLinalgElementwiseOpFusionPass());
+        pm.addPass(mlir::createCanonicalizerPass());
+        pm.addPass(mlir::createCSEPass());
+        if (mlir::failed(pm.run(mod)))
+            throw std::runtime_error("MLIR optimization pipeline failed");
+
+        // parallel loops split each op on its own, tiles of single channels would leave too
+        // little work per op
+        if (!opts.parallel_loops)
+        {
+            tilePoolingChains(mod);
+
+            mlir::PassManager cleanup(ctx);
+            cleanup.addPass(mlir::createCanonicalizerPass());
+            cleanup.addPass(mlir::createCSEPass());
+            if (mlir::failed(cleanup.run(mod)))
+                throw std::runtime_error("MLIR optimization pipeline failed");
+        }
+
+        // tanh, erf, exp and friends as polynomials of plain arith ops, no libm calls
+        if (opts.approximate_math)
+        {
+            mlir::RewritePatternSet patterns(ctx);
+            mlir::populateMathPolynomialApproximationPatterns(patterns);
+            if (mlir::failed(mlir::applyPatternsGreedily(mod, std::move(patterns))))
+                throw std::runtime_error("Math approximation did not converge");
+        }
+
+        // nnan and ninf are left out: attention masks are -inf, which would turn into poison
+        if (opts.fast_math)
+        {
+            using mlir::arith::FastMathFlags;
+            auto flags = mlir::arith::FastMathFlagsAttr::get(ctx,
+                FastMathFlags::reassoc | FastMathFlags::contract | FastMathFlags::afn |
+                FastMathFlags::arcp | FastMathFlags::nsz);
+
+            mod.walk([&](mlir::arith::ArithFastMathInterface op)
+            {
+                op->setAttr(op.getFastMathAttrName(), flags);
+            });
+        }
     }
 
 
-    mlir::OwningOpRef<mlir::ModuleOp> CodeGen::runLoweringPipeline(mlir::ModuleOp mod)
+    mlir::OwningOpRef<mlir::ModuleOp> CodeGen::runLoweringPipeline(mlir::ModuleOp mod, const CodeGenOptions& opts)
     {
         //FIXME - bufferization using external mlir-opt call
         std::string tempInput   = std::filesystem::temp_directory_path() / "temp_input.mlir";
@@ -212,8 +400,15 @@ namespace tc
             mod->print(os);
         }
 
+        // bare pointers can only describe memrefs with the identity layout, and task functions
+        // take the buffers the entry allocates as they are
+        bool identity_layout = opts.bare_ptr || opts.parallel_branches;
+        std::string boundary_layout = identity_layout ? " function-boundary-type-conversion=identity-layout-map" : "";
+
         std::string cmd = std::string(MLIR_OPT_PATH) +
-            " --one-shot-bufferize=\"bufferize-function-boundaries=true allow-return-allocs-from-loops=true\"" +
+            " --eliminate-empty-tensors" +
+            " --one-shot-bufferize=\"bufferize-function-boundaries=true allow-return-allocs-from-loops=true" +
+            boundary_layout + "\"" +
             " " + tempInput + " -o " + tempOutput;
 
         int ret = std::system(cmd.c_str());
@@ -247,6 +442,26 @@ namespace tc
             throw std::runtime_error("Failed to translate MLIR module to LLVM IR");
         }
 
+        // async.execute bodies are LLVM coroutines, which the codegen pipeline of emitObject()
+        // expects to be split already
+        if (llvmModule->getFunction("llvm.coro.begin"))
+        {
+            llvm::LoopAnalysisManager    lam;
+            llvm::FunctionAnalysisManager fam;
+            llvm::CGSCCAnalysisManager   cgam;
+            llvm::ModuleAnalysisManager  mam;
+
+            llvm::PassBuilder pb;
+            pb.registerModuleAnalyses(mam);
+            pb.registerCGSCCAnalyses(cgam);
+            pb.registerFunctionAnalyses(fam);
+            pb.registerLoopAnalyses(lam);
+            pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+            auto mpm = pb.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+            mpm.run(*llvmModule, mam);
+        }
+
         return llvmModule;
     }
 
@@ -271,6 +486,18 @@ namespace tc
         llvmModule->setDataLayout(TM->createDataLayout());
         llvmModule->setTargetTriple(targetTriple);
 
+        // denormal results and operands may be flushed to zero; the instructions selected
+        // assume so, the host still has to set FTZ/DAZ (FPCR.FZ on AArch64) to get the speed
+        if (opts.fast_math)
+        {
+            for (auto& fn : *llvmModule)
+            {
+                if (fn.isDeclaration()) continue;
+                fn.addFnAttr("denormal-fp-math", "preserve-sign,preserve-sign");
+                fn.addFnAttr("denormal-fp-math-f32", "preserve-sign,preserve-sign");
+            }
+        }
+
         std::error_code ec;
         llvm::raw_fd_ostream dest(filename, ec, llvm::sys::fs::OF_None);
         if (ec) throw std::runtime_error("Cannot open file: " + ec.message());
@@ -296,31 +523,33 @@ namespace tc
 
     
     void CodeGen::processNode(mlir::OpBuilder& builder,
-                              const Node&      node,
+                              NodeId           id,
                               ValueMap&        vmap,
                               const Graph&     graph) const
     {
         auto loc = builder.getUnknownLoc();
+        const Node& node = *graph.getNodes()[id];
         auto nodeType = node.getOpType();
+        auto inputs  = graph.nodeInputs(id);
+        auto outputs = graph.nodeOutputs(id);
 
-        // get data by tensor name
-        auto resolve = [&](const std::string& name) -> mlir::Value
+        // get data by tensor id, constants are materialized on first use
+        auto resolve = [&](TensorId tid) -> mlir::Value
         {
-            if (name.empty())
-                throw std::runtime_error("Empty tensor name");
+            if (tid == kNoTensor)
+                throw std::runtime_error("Empty tensor name in node '" + node.getName() + "'");
 
-            auto it = vmap.find(name);
-            if (it != vmap.end()) return it->second;
+            if (vmap[tid]) return vmap[tid];
 
-            auto opt = graph.findTensor(name);
-            if (opt && (*opt)->hasData())
+            const auto* tensor = graph.tensor(tid);
+            if (tensor && tensor->hasData())
             {
-                auto val = makeWeightConstant(builder, loc, **opt);
-                vmap[name] = val;
+                auto val = makeWeightConstant(builder, loc, *tensor);
+                vmap[tid] = val;
                 return val;
             }
             throw std::runtime_error(
-                "Cannot resolve tensor '" + name +
+                "Cannot resolve tensor '" + graph.tensorName(tid) +
                 "' in node '" + node.getName() + "'");
         };
 
@@ -335,15 +564,15 @@ namespace tc
         // ── Add / Mul ───────────────────────────────────────────────────────────────────
         if (nodeType == OpType::Add || nodeType == OpType::Mul)
         {
-            auto lhs = resolve(node.getInputs()[0]);
-            auto rhs = resolve(node.getInputs()[1]);
+            auto lhs = resolve(inputs[0]);
+            auto rhs = resolve(inputs[1]);
 
 
             //always use generic build //TODO - straight generation when same shapes
 
 
             auto result = buildElementwise(nodeType, builder, loc, lhs, rhs, &mlir_ctx_);
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
         
             return;
         }
@@ -358,12 +587,12 @@ namespace tc
         // ── MatMul ────────────────────────────────────────────────────────────────
         if (nodeType == OpType::MatMul)
         {
-            auto A = resolve(node.getInputs()[0]);
-            auto B = resolve(node.getInputs()[1]);
+            auto A = resolve(inputs[0]);
+            auto B = resolve(inputs[1]);
 
             //TODO - if 2D or 3D use linalg.batch_matmul
             auto result = buildMatMul(builder, loc, A, B, false, false, &mlir_ctx_);
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
             return;
         }
 
@@ -373,21 +602,18 @@ namespace tc
         // ── Gemm ──────────────────────────────────────────────────────────────────
         if (nodeType == OpType::Gemm)
         {
-            auto A = resolve(node.getInputs()[0]);
-            auto B = resolve(node.getInputs()[1]);
+            auto A = resolve(inputs[0]);
+            auto B = resolve(inputs[1]);
 
             mlir::Value C = nullptr;
 
-            if (node.getInputs().size() >= 3 && !node.getInputs()[2].empty())
-                C = resolve(node.getInputs()[2]);
-
-            float alpha = 1.0f, beta = 1.0f;
-            bool transA = false, transB = false;
+            if (inputs.size() >= 3 && inputs[2] != kNoTensor)
+                C = resolve(inputs[2]);
 
-            if (node.hasAttribute("alpha"))     alpha   = node.getAttribute("alpha").asFloat();
-            if (node.hasAttribute("beta"))      beta    = node.getAttribute("beta").asFloat();
-            if (node.hasAttribute("transA"))    transA  = node.getAttribute("transA").asInt() != 0;
-            if (node.hasAttribute("transB"))    transB  = node.getAttribute("transB").asInt() != 0;
+            float alpha  = node.attributeOr<float>(AttrKey::Alpha, 1.0f);
+            float beta   = node.attributeOr<float>(AttrKey::Beta,  1.0f);
+            bool  transA = node.attributeOr<int64_t>(AttrKey::TransA, 0) != 0;
+            bool  transB = node.attributeOr<int64_t>(AttrKey::TransB, 0) != 0;
 
             // A[] * B[]
             mlir::Value result = buildMatMul(builder, loc, A, B, transA, transB, &mlir_ctx_);
@@ -422,7 +648,7 @@ namespace tc
                 result = buildElementwise(OpType::Add, builder, loc, result, Cval, &mlir_ctx_);
             }
 
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
             return;
         }
         
@@ -430,31 +656,80 @@ namespace tc
         // ── Relu ──────────────────────────────────────────────────────────────────
         if (nodeType == OpType::Relu)
         {
-            auto input = resolve(node.getInputs()[0]);
+            auto input = resolve(inputs[0]);
             auto result = buildReLU(builder, loc, input, &mlir_ctx_);
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
 
             return;
         }
         
 
 
-        // ── Shape ─────────────────────────────────────────────────────────────────
-        if (nodeType == OpType::Shape)
+        // ── Sigmoid / Tanh / Gelu / Swish / HardSwish / Erf / Exp ─────────────────
+        if (nodeType == OpType::Sigmoid || nodeType == OpType::Tanh || nodeType == OpType::Gelu ||
+            nodeType == OpType::Swish || nodeType == OpType::HardSwish || nodeType == OpType::Erf ||
+            nodeType == OpType::Exp)
         {
-            auto input = resolve(node.getInputs()[0]);
+            auto input = resolve(inputs[0]);
 
-            int64_t start = 0;
-            int64_t end = std::numeric_limits<int64_t>::max();
+            float alpha = node.attributeOr<float>(AttrKey::Alpha, 1.0f);
 
-            if (node.hasAttribute("start"))
-                start = node.getAttribute("start").asInt();
+            const auto* approximate = node.findAttribute(AttrKey::Approximate);
+            bool tanhGelu = approximate && approximate->asString() == "tanh";
 
-            if (node.hasAttribute("end"))
-                end = node.getAttribute("end").asInt();
+            auto result = buildActivation(nodeType, builder, loc, input, alpha, tanhGelu, &mlir_ctx_);
+            vmap[outputs[0]] = result;
+
+            return;
+        }
+
+
+        // ── Softmax / LogSoftmax ──────────────────────────────────────────────────
+        if (nodeType == OpType::Softmax || nodeType == OpType::LogSoftmax)
+        {
+            auto input = resolve(inputs[0]);
+
+            // opset 13 semantics, a single axis; older opsets flattened from `axis` on
+            int64_t axis = node.attributeOr<int64_t>(AttrKey::Axis, -1);
+
+            auto result = buildSoftmax(builder, loc, input, axis, nodeType == OpType::LogSoftmax, &mlir_ctx_);
+            vmap[outputs[0]] = result;
+
+            return;
+        }
+
+
+        // ── LayerNormalization ────────────────────────────────────────────────────
+        if (nodeType == OpType::LayerNormalization)
+        {
+            auto input = resolve(inputs[0]);
+
+            // Scale is required by ONNX, a fused pattern without a Mul leaves it out
+            std::optional<mlir::Value> scale, bias;
+            if (inputs.size() >= 2 && inputs[1] != kNoTensor) scale = resolve(inputs[1]);
+            if (inputs.size() >= 3 && inputs[2] != kNoTensor) bias  = resolve(inputs[2]);
+
+            int64_t axis    = node.attributeOr<int64_t>(AttrKey::Axis, -1);
+            float   epsilon = node.attributeOr<float>(AttrKey::Epsilon, 1e-5f);
+
+            // only Y, the Mean and InvStdDev outputs are for training
+            auto result = buildLayerNorm(builder, loc, input, scale, bias, axis, epsilon, &mlir_ctx_);
+            vmap[outputs[0]] = result;
+
+            return;
+        }
+
+
+        // ── Shape ─────────────────────────────────────────────────────────────────
+        if (nodeType == OpType::Shape)
+        {
+            auto input = resolve(inputs[0]);
+
+            int64_t start = node.attributeOr<int64_t>(AttrKey::Start, 0);
+            int64_t end   = node.attributeOr<int64_t>(AttrKey::End, std::numeric_limits<int64_t>::max());
 
             auto result = buildShapeOp(builder, loc, input, start, end);
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
 
             return;
         }
@@ -463,16 +738,13 @@ namespace tc
         // ── Reshape ───────────────────────────────────────────────────────────────
         if (nodeType == OpType::Reshape)
         {
-            auto data = resolve(node.getInputs()[0]);
-            auto shape = resolve(node.getInputs()[1]);
+            auto data = resolve(inputs[0]);
+            auto shape = resolve(inputs[1]);
 
-            bool allowZero = false;
-
-            if (node.hasAttribute("allowzero"))
-                allowZero = node.getAttribute("allowzero").asInt() != 0;
+            bool allowZero = node.attributeOr<int64_t>(AttrKey::AllowZero, 0) != 0;
 
             auto result = buildReshapeOp(builder, loc, data, shape, allowZero);
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
 
             return;
         }
@@ -481,16 +753,16 @@ namespace tc
         // ── Concat ────────────────────────────────────────────────────────────────
         if (nodeType == OpType::Concat)
         {
-            int64_t axis = node.getAttribute("axis").asInt();
+            int64_t axis = node.getAttribute(AttrKey::Axis).asInt();
 
-            llvm::SmallVector<mlir::Value> inputs;
-            inputs.reserve(node.getInputs().size());
+            llvm::SmallVector<mlir::Value> operands;
+            operands.reserve(inputs.size());
 
-            for (const auto& inputName : node.getInputs())
-                inputs.push_back(resolve(inputName));
+            for (auto tid : inputs)
+                operands.push_back(resolve(tid));
 
-            auto result = buildConcatOp(builder, loc, inputs, axis);
-            vmap[node.getOutputs()[0]] = result;
+            auto result = buildConcatOp(builder, loc, operands, axis);
+            vmap[outputs[0]] = result;
 
             return;
         }
@@ -499,36 +771,23 @@ namespace tc
         // ── Conv2d ────────────────────────────────────────────────────────────────
         if (nodeType == OpType::Conv)
         {
-            auto input = resolve(node.getInputs()[0]);
-            auto weights = resolve(node.getInputs()[1]);
+            auto input = resolve(inputs[0]);
+            auto weights = resolve(inputs[1]);
 
             std::optional<mlir::Value> bias = std::nullopt;
-            if (node.getInputs().size() >= 3 && !node.getInputs()[2].empty())
-                bias = resolve(node.getInputs()[2]);
-
-            std::vector<int64_t> kernelShape = {};
-            if (node.hasAttribute("kernel_shape"))
-                kernelShape = node.getAttribute("kernel_shape").asInts();
-
-            std::vector<int64_t> strides = {1, 1};
-            if (node.hasAttribute("strides"))
-                strides = node.getAttribute("strides").asInts();
-
-            std::vector<int64_t> pads = {0, 0, 0, 0};
-            if (node.hasAttribute("pads"))
-                pads = node.getAttribute("pads").asInts();
+            if (inputs.size() >= 3 && inputs[2] != kNoTensor)
+                bias = resolve(inputs[2]);
 
-            std::vector<int64_t> dilations = {1, 1};
-            if (node.hasAttribute("dilations"))
-                dilations = node.getAttribute("dilations").asInts();
+            using Ints = std::vector<int64_t>;
+            auto kernelShape = node.attributeOr<Ints>(AttrKey::KernelShape, {});
+            auto strides     = node.attributeOr<Ints>(AttrKey::Strides,     {1, 1});
+            auto pads        = node.attributeOr<Ints>(AttrKey::Pads,        {0, 0, 0, 0});
+            auto dilations   = node.attributeOr<Ints>(AttrKey::Dilations,   {1, 1});
+            auto group       = node.attributeOr<int64_t>(AttrKey::Group, 1);
 
-            int64_t group = 1;
-            if (node.hasAttribute("group"))
-                group = node.getAttribute("group").asInt();
-
-            llvm::StringRef autoPad = "NOTSET";
-            if (node.hasAttribute("auto_pad"))
-                autoPad = node.getAttribute("auto_pad").asString();
+            // a view of the stored string, not a copy
+            const auto* autoPadAttr = node.findAttribute(AttrKey::AutoPad);
+            llvm::StringRef autoPad = autoPadAttr ? llvm::StringRef(autoPadAttr->asString()) : "NOTSET";
 
 
 
@@ -550,7 +809,42 @@ namespace tc
 
 
 
-            vmap[node.getOutputs()[0]] = result;
+            vmap[outputs[0]] = result;
+            return;
+        }
+
+        // ── MaxPool / AveragePool ─────────────────────────────────────────────────
+        if (nodeType == OpType::MaxPool || nodeType == OpType::AveragePool)
+        {
+            if (outputs.size() > 1 && outputs[1] != kNoTensor)
+                throw std::runtime_error("MaxPool '" + node.getName() + "': the Indices output is not supported");
+
+            auto input = resolve(inputs[0]);
+
+            using Ints = std::vector<int64_t>;
+            auto kernelShape = node.attributeOr<Ints>(AttrKey::KernelShape, {});
+            auto strides     = node.attributeOr<Ints>(AttrKey::Strides,     {1, 1});
+            auto pads        = node.attributeOr<Ints>(AttrKey::Pads,        {0, 0, 0, 0});
+            auto dilations   = node.attributeOr<Ints>(AttrKey::Dilations,   {1, 1});
+            bool ceilMode        = node.attributeOr<int64_t>(AttrKey::CeilMode, 0) != 0;
+            bool countIncludePad = node.attributeOr<int64_t>(AttrKey::CountIncludePad, 0) != 0;
+
+            const auto* autoPadAttr = node.findAttribute(AttrKey::AutoPad);
+            llvm::StringRef autoPad = autoPadAttr ? llvm::StringRef(autoPadAttr->asString()) : "NOTSET";
+
+            // uint8 lowers to a signless i8, the sign has to come from the model
+            const auto* inputTensor = graph.tensor(inputs[0]);
+            bool unsignedInts = inputTensor && inputTensor->getDtype() == DataType::UINT8;
+
+            vmap[outputs[0]] = buildPool2dOp(nodeType, builder, loc, input, kernelShape, strides, pads, dilations,
+                                             ceilMode, countIncludePad, autoPad, &mlir_ctx_, unsignedInts);
+            return;
+        }
+
+        // ── GlobalAveragePool ─────────────────────────────────────────────────────
+        if (nodeType == OpType::GlobalAveragePool)
+        {
+            vmap[outputs[0]] = buildGlobalAveragePool(builder, loc, resolve(inputs[0]), &mlir_ctx_);
             return;
         }
 
@@ -565,25 +859,115 @@ namespace tc
 
 
 
-    
+    // Any other op touching buffers, and the return, first waits for all tasks launched
+    // before it, tasks share memrefs
+    void CodeGen::parallelizeTaskCalls(mlir::ModuleOp mod)
+    {
+        mlir::OpBuilder builder(mod.getContext());
 
-    void CodeGen::lowerToLLVM(mlir::ModuleOp mod)
+        for (auto entry : mod.getOps<mlir::func::FuncOp>())
+        {
+            if (entry.isExternal() || entry->hasAttr("tc.task")) continue;
+
+            llvm::DenseMap<int64_t, mlir::Value> tokens;    // by task index
+            llvm::SmallVector<mlir::Value>       pending;   // launched and not awaited yet
+
+            for (auto& op : llvm::make_early_inc_range(entry.getBody().front()))
+            {
+                auto call   = llvm::dyn_cast<mlir::func::CallOp>(op);
+                auto callee = call ? mod.lookupSymbol<mlir::func::FuncOp>(call.getCallee()) : nullptr;
+
+                if (callee && callee->hasAttr("tc.task"))
+                {
+                    llvm::SmallVector<mlir::Value> deps;
+                    for (auto d : callee->getAttrOfType<mlir::DenseI64ArrayAttr>("tc.task_deps").asArrayRef())
+                        if (auto token = tokens.lookup(d)) deps.push_back(token);
+
+                    builder.setInsertionPoint(call);
+                    auto exec = mlir::async::ExecuteOp::create(
+                        builder, call.getLoc(), mlir::TypeRange{}, deps, mlir::ValueRange{},
+                        [&](mlir::OpBuilder& b, mlir::Location loc, mlir::ValueRange)
+                        {
+                            mlir::func::CallOp::create(b, loc, callee, call.getOperands());
+                            mlir::async::YieldOp::create(b, loc, mlir::ValueRange{});
+                        });
+
+                    auto index = callee->getAttrOfType<mlir::IntegerAttr>("tc.task_index").getInt();
+                    tokens[index] = exec.getToken();
+                    pending.push_back(exec.getToken());
+                    call.erase();
+                    continue;
+                }
+
+                bool touches_buffers = op.hasTrait<mlir::OpTrait::IsTerminator>() ||
+                    llvm::any_of(op.getOperandTypes(), [](mlir::Type t) { return llvm::isa<mlir::BaseMemRefType>(t); });
+                if (pending.empty() || !touches_buffers) continue;
+
+                builder.setInsertionPoint(&op);
+                for (auto token : pending)
+                    mlir::async::AwaitOp::create(builder, op.getLoc(), token);
+                pending.clear();
+            }
+        }
+    }
+
+
+    void CodeGen::lowerToLLVM(mlir::ModuleOp mod, const CodeGenOptions& opts)
     {
         mlir::PassManager pm(mod->getContext());
 
-        mod.walk([](mlir::func::FuncOp funcOp)
+        if (opts.parallel_branches)
+            parallelizeTaskCalls(mod);
+
+        // with bare pointers the descriptor wrapper lives in the generated header instead
+        if (!opts.bare_ptr)
         {
-            funcOp->setAttr("llvm.emit_c_interface", mlir::UnitAttr::get(funcOp.getContext()));
-        });
+            mod.walk([](mlir::func::FuncOp funcOp)
+            {
+                if (funcOp->hasAttr("tc.task")) return;
+                funcOp->setAttr("llvm.emit_c_interface", mlir::UnitAttr::get(funcOp.getContext()));
+            });
+        }
+
+        bool use_async = opts.parallel_branches || opts.parallel_loops;
+
+        if (opts.parallel_loops)
+        {
+            // chunks of at least this many iterations, smaller ones aren't worth a task
+            constexpr int32_t kMinTaskSize = 1024;
+
+            pm.addPass(mlir::createConvertLinalgToParallelLoopsPass());
+            // -1 workers: ask the runtime, so loops use the same TC_NUM_THREADS budget as branches
+            pm.addPass(mlir::createAsyncParallelForPass(/*asyncDispatch=*/true, /*numWorkerThreads=*/-1, kMinTaskSize));
+        }
+        else
+        {
+            pm.addPass(mlir::createConvertLinalgToLoopsPass());
+        }
+
+        if (use_async)
+        {
+            pm.addPass(mlir::createAsyncToAsyncRuntimePass());
+            pm.addPass(mlir::createAsyncRuntimeRefCountingPass());
+            pm.addPass(mlir::createAsyncRuntimeRefCountingOptPass());
+        }
 
-        pm.addPass(mlir::createConvertLinalgToLoopsPass());
         pm.addPass(mlir::createLowerAffinePass());
 
         pm.addPass(mlir::createSCFToControlFlowPass());
 
+        if (use_async)
+            pm.addPass(mlir::createConvertAsyncToLLVMPass());
+
 
+        // exp, log and the like emitted by Softmax; what has no LLVM intrinsic, erf and tanh
+        // among them, becomes a libm call
+        pm.addPass(mlir::createConvertMathToLLVMPass());
+        pm.addPass(mlir::createConvertMathToLibmPass());
         pm.addPass(mlir::createArithToLLVMConversionPass());
-        pm.addPass(mlir::createConvertFuncToLLVMPass());
+        mlir::ConvertFuncToLLVMPassOptions func_opts;
+        func_opts.useBarePtrCallConv = opts.bare_ptr;
+        pm.addPass(mlir::createConvertFuncToLLVMPass(func_opts));
 
 
 
@@ -612,34 +996,227 @@ namespace tc
     }
 
 
-    int CodeGen::generate(const Graph& graph, const CodeGenOptions& opts,
-                            const std::string& mlir_out, const std::string& asm_out)
+    bool CodeGen::emitTasks(mlir::OpBuilder&  builder,
+                            mlir::ModuleOp    module,
+                            llvm::StringRef   entry_name,
+                            ValueMap&         vmap,
+                            const Graph&      graph,
+                            const TaskGraph&  tasks) const
     {
-        auto module = mlir::ModuleOp::create(mlir::UnknownLoc::get(&mlir_ctx_), graph.getName());
+        auto loc = builder.getUnknownLoc();
+
+        std::vector<bool> is_output(graph.numTensorIds(), false);
+        for (auto tid : graph.getOutputIds())
+            is_output[tid] = true;
+
+        // one map for every task body, the entries a task set are cleared after it
+        ValueMap local(graph.numTensorIds());
+        // what was emitted so far, undone when a task can't be emitted
+        llvm::SmallVector<mlir::Operation*> emitted;
+        std::vector<TensorId>               assigned;
+        // the initializers the tasks materialize are counted again by the sequential fallback
+        auto constants_before = constants_.checkpoint();
+
+        auto discard = [&]
+        {
+            for (auto it = emitted.rbegin(); it != emitted.rend(); ++it)
+                (*it)->erase();
+            for (auto tid : assigned)
+                vmap[tid] = nullptr;
+            constants_.rollback(constants_before);
+        };
+
+        for (TaskId t = 0; t < tasks.size(); ++t)
+        {
+            const auto& nodes = tasks.nodes[t];
+
+            // computed outside the task: graph inputs and results of earlier tasks.
+            // Initializers aren't, each task materializes the constants it reads
+            std::vector<TensorId> args;
+            for (auto n : nodes)
+                for (auto tid : graph.nodeInputs(n))
+                    if (tid != kNoTensor && vmap[tid] && !llvm::is_contained(args, tid))
+                        args.push_back(tid);
+
+            llvm::SmallVector<mlir::Type> arg_types;
+            for (auto tid : args)
+                arg_types.push_back(vmap[tid].getType());
+
+            auto fn = mlir::func::FuncOp::create(loc, (entry_name + "_task" + llvm::Twine(t)).str(),
+                                                 builder.getFunctionType(arg_types, {}));
+            fn.setPrivate();
+            fn->setAttr("tc.task", builder.getUnitAttr());
+            fn->setAttr("tc.task_index", builder.getI64IntegerAttr(t));
+            llvm::SmallVector<int64_t> deps(tasks.deps[t].begin(), tasks.deps[t].end());
+            fn->setAttr("tc.task_deps", builder.getDenseI64ArrayAttr(deps));
+            module.push_back(fn);
+            emitted.push_back(fn);
+
+            auto* body_block = fn.addEntryBlock();
+            auto body = mlir::OpBuilder::atBlockBegin(body_block);
+            for (size_t i = 0; i < args.size(); ++i)
+                local[args[i]] = body_block->getArgument(static_cast<unsigned>(i));
+
+            for (auto n : nodes)
+                processNode(body, n, local, graph);
+
+            // results read by other tasks or returned are written to buffers passed in after the inputs
+            std::vector<TensorId> results;
+            llvm::SmallVector<mlir::MemRefType> result_types;
+            for (auto n : nodes)
+            {
+                for (auto tid : graph.nodeOutputs(n))
+                {
+                    if (tid == kNoTensor || !local[tid]) continue;
+
+                    bool escapes = is_output[tid];
+                    for (auto c : graph.consumersOf(tid))
+                        escapes = escapes || tasks.task_of[c] != t;
+                    if (!escapes) continue;
+
+                    auto type = llvm::cast<mlir::RankedTensorType>(local[tid].getType());
+                    if (!type.hasStaticShape())
+                    {
+                        for (auto& entry : local) entry = nullptr;
+                        discard();
+                        return false;
+                    }
+
+                    auto memref_type = mlir::MemRefType::get(type.getShape(), type.getElementType());
+                    auto out = body_block->addArgument(memref_type, loc);
+                    mlir::bufferization::MaterializeInDestinationOp::create(
+                        body, loc, mlir::Type{}, local[tid], out, /*restrict=*/true, /*writable=*/true);
+
+                    results.push_back(tid);
+                    result_types.push_back(memref_type);
+                }
+            }
+            mlir::func::ReturnOp::create(body, loc);
+            fn.setFunctionType(builder.getFunctionType(body_block->getArgumentTypes(), {}));
+
+            for (auto n : nodes)
+            {
+                for (auto tid : graph.nodeInputs(n))  if (tid != kNoTensor) local[tid] = nullptr;
+                for (auto tid : graph.nodeOutputs(n)) if (tid != kNoTensor) local[tid] = nullptr;
+            }
+
+            // the entry allocates the buffers, calls the task and reads the results through them
+            llvm::SmallVector<mlir::Value> operands;
+            for (auto tid : args)
+                operands.push_back(vmap[tid]);
+
+            llvm::SmallVector<mlir::Value> buffers;
+            for (auto type : result_types)
+            {
+                auto alloc = mlir::memref::AllocOp::create(builder, loc, type);
+                emitted.push_back(alloc);
+                buffers.push_back(alloc);
+            }
+            operands.append(buffers.begin(), buffers.end());
+
+            emitted.push_back(mlir::func::CallOp::create(builder, loc, fn, operands));
 
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                auto tensor_type = mlir::RankedTensorType::get(result_types[i].getShape(), result_types[i].getElementType());
+                auto tensor = mlir::bufferization::ToTensorOp::create(
+                    builder, loc, tensor_type, buffers[i], /*restrict=*/true, /*writable=*/true);
+                emitted.push_back(tensor);
+                vmap[results[i]] = tensor;
+                assigned.push_back(results[i]);
+            }
+        }
+        return true;
+    }
+
+
+    mlir::OwningOpRef<mlir::ModuleOp> CodeGen::buildModule(const Graph& graph, const CodeGenOptions& opts)
+    {
+        const Graph* graphs[] = {&graph};
+        return buildModule(graphs, opts);
+    }
+
+
+    mlir::OwningOpRef<mlir::ModuleOp> CodeGen::buildModule(std::span<const Graph* const> graphs, const CodeGenOptions& opts)
+    {
+        if (graphs.empty())
+            throw std::runtime_error("No model to compile");
+
+        auto name = graphs.size() == 1 ? graphs.front()->getName() : std::string("tc_models");
+        mlir::OwningOpRef<mlir::ModuleOp> owned = mlir::ModuleOp::create(mlir::UnknownLoc::get(&mlir_ctx_), name);
+        auto module = *owned;
+
+        constants_.reset();
+        task_splits_.clear();
+
+        if (!opts.schedules.empty() && opts.schedules.size() != graphs.size())
+            throw std::runtime_error("Got " + std::to_string(opts.schedules.size()) + " schedules for " +
+                                     std::to_string(graphs.size()) + " models");
+
+        std::unordered_set<std::string> symbols;
+        for (size_t i = 0; i < graphs.size(); ++i)
+        {
+            const auto& graph = *graphs[i];
+            auto symbol = cIdentifier(graph.getName());
+            if (!symbols.insert(symbol).second)
+                throw std::runtime_error("Two models compile to the same entry point '" + symbol + "'");
+
+            if (opts.schedules.empty())
+            {
+                buildEntryPoint(module, graph, scheduleGraph(graph, opts.schedule).order, opts);
+                continue;
+            }
+
+            const auto& order = opts.schedules[i].order;
+            if (order.size() != graph.getNodes().size())
+                throw std::runtime_error("The schedule of '" + graph.getName() + "' has " + std::to_string(order.size()) +
+                                         " nodes, the graph " + std::to_string(graph.getNodes().size()));
+            buildEntryPoint(module, graph, order, opts);
+        }
+
+        constants_.finish(module);
+
+        return owned;
+    }
+
+
+    void CodeGen::buildEntryPoint(mlir::ModuleOp module, const Graph& graph, std::span<const NodeId> order,
+                                  const CodeGenOptions& opts) const
+    {
         mlir::OpBuilder builder(&mlir_ctx_);
         builder.setInsertionPointToEnd(module.getBody());
 
         llvm::SmallVector<mlir::Type> arg_types;
-        for (const auto& inp_name : graph.getInputs())
+        for (auto tid : graph.getInputIds())
         {
-            auto opt = graph.findTensor(inp_name);
-            if (!opt)
-                throw std::runtime_error("Input tensor not found: " + inp_name);
-            arg_types.push_back(tensorTypeOf(**opt));
+            const auto* tensor = graph.tensor(tid);
+            if (!tensor)
+                throw std::runtime_error("Input tensor not found: " + graph.tensorName(tid));
+            if (opts.bare_ptr && tensor->getShape().isDynamic())
+                throw std::runtime_error("--bare-ptr needs static shapes, input '" + graph.tensorName(tid) + "' is dynamic");
+            arg_types.push_back(tensorTypeOf(*tensor));
         }
 
         llvm::SmallVector<mlir::Type> ret_types;
-        for (const auto& out_name : graph.getOutputs())
+        for (auto tid : graph.getOutputIds())
         {
-            auto opt = graph.findTensor(out_name);
-            if (!opt)
-                throw std::runtime_error("Output tensor not found: " + out_name);
-            ret_types.push_back(tensorTypeOf(**opt));
+            const auto* tensor = graph.tensor(tid);
+            if (!tensor)
+                throw std::runtime_error("Output tensor not found: " + graph.tensorName(tid));
+
+            if (opts.bare_ptr && tensor->getShape().isDynamic())
+                throw std::runtime_error("--bare-ptr needs static shapes, output '" + graph.tensorName(tid) + "' is dynamic");
+
+            auto type = tensorTypeOf(*tensor);
+            if (opts.dest_passing || opts.bare_ptr)
+                arg_types.push_back(mlir::MemRefType::get(type.getShape(), type.getElementType()));
+            else
+                ret_types.push_back(type);
         }
 
         auto func_type = builder.getFunctionType(arg_types, ret_types);
-        auto func = mlir::func::FuncOp::create(builder.getUnknownLoc(), graph.getName(), func_type);
+        // the symbol must be a valid C identifier, it is what the generated header declares
+        auto func = mlir::func::FuncOp::create(builder.getUnknownLoc(), cIdentifier(graph.getName()), func_type);
 
         module.push_back(func);
         func.addEntryBlock();
@@ -649,32 +1226,82 @@ namespace tc
 
 
 
-        ValueMap vmap;
-        for (size_t i = 0; i < graph.getInputs().size(); ++i)
-            vmap[graph.getInputs()[i]] = func.getArgument(static_cast<unsigned>(i));
+        // values by tensor id, a null value is one not computed yet
+        ValueMap vmap(graph.numTensorIds());
+        const auto& input_ids = graph.getInputIds();
+        for (size_t i = 0; i < input_ids.size(); ++i)
+            vmap[input_ids[i]] = func.getArgument(static_cast<unsigned>(i));
+
+        bool emitted = false;
+        if (opts.parallel_branches)
+        {
+            auto tasks = partitionTasks(graph, order);
 
-        auto sorted = graph.topologicalSort();
-        for (const auto& node : sorted)
-            processNode(builder, *node, vmap, graph);
+            // a single chain gains nothing from tasks
+            if (tasks.width() > 1)
+                emitted = emitTasks(builder, module, func.getSymName(), vmap, graph, tasks);
+
+            task_splits_.push_back({func.getSymName().str(), tasks.size(), tasks.width(), emitted});
+        }
+
+        if (!emitted)
+        {
+            for (auto id : order)
+                processNode(builder, id, vmap, graph);
+        }
 
 
         llvm::SmallVector<mlir::Value> ret_vals;
-        for (const auto& out_name : graph.getOutputs())
+        for (auto tid : graph.getOutputIds())
         {
-            auto it = vmap.find(out_name);
-            if (it == vmap.end())
+            if (!vmap[tid])
                 throw std::runtime_error(
-                    "Output tensor '" + out_name + "' not computed");
-            ret_vals.push_back(it->second);
+                    "Output tensor '" + graph.tensorName(tid) + "' not computed");
+            ret_vals.push_back(vmap[tid]);
         }
 
+        // destination-passing: each result is materialized in its output argument. With `restrict`
+        // eliminate-empty-tensors lets the op producing the result write into the caller's buffer
+        if (opts.dest_passing || opts.bare_ptr)
+        {
+            auto first_out = static_cast<unsigned>(graph.getInputs().size());
+            for (size_t i = 0; i < ret_vals.size(); ++i)
+            {
+                mlir::bufferization::MaterializeInDestinationOp::create(
+                    builder, builder.getUnknownLoc(), mlir::Type{},
+                    ret_vals[i], func.getArgument(first_out + static_cast<unsigned>(i)),
+                    /*restrict=*/!opts.outputs_may_alias, /*writable=*/true);
+            }
+            ret_vals.clear();
+        }
 
         mlir::func::ReturnOp::create(builder, builder.getUnknownLoc(), ret_vals);
+    }
 
-        
+
+    int CodeGen::generate(const Graph& graph, const CodeGenOptions& opts,
+                            const std::string& mlir_out, const std::string& asm_out)
+    {
+        const Graph* graphs[] = {&graph};
+        return generate(graphs, opts, mlir_out, asm_out);
+    }
 
 
+    int CodeGen::generate(std::span<const Graph* const> graphs, const CodeGenOptions& opts,
+                            const std::string& mlir_out, const std::string& asm_out)
+    {
+        auto owned = buildModule(graphs, opts);
+        auto module = *owned;
 
+        if (constantStats().initializers > 0)
+            std::cout << constantStats().summary() << "\n";
+        for (const auto& split : taskSplits())
+        {
+            std::cout << "Parallel branches of " << split.entry << ": " << split.tasks << " tasks, up to "
+                      << split.width << " at once\n";
+            if (split.width > 1 && !split.emitted)
+                std::cout << "A tensor between tasks has a dynamic shape, emitting sequentially\n";
+        }
 
         if (opts.print_mlir)
         {
@@ -698,8 +1325,33 @@ namespace tc
         if (mlir::failed(mlir::verify(module)))
             throw std::runtime_error("MLIR module verification failed");
 
+        if (opts.optimize)
+        {
+            runOptPipeline(module, opts);
+            if (opts.print_mlir_opt)
+            {
+                llvm::outs() << "\nOptimized MLIR:\n";
+                module.print(llvm::outs());
+                llvm::outs() << "\n";
+            }
+        }
+
+        if (!opts.header_out.empty())
+        {
+            std::vector<EntryPointDesc> entries;
+            for (const auto* graph : graphs)
+            {
+                auto& entry = entries.emplace_back(describeEntryPoint(*graph));
+                entry.dest_passing      = opts.dest_passing || opts.bare_ptr;
+                entry.bare_ptr          = opts.bare_ptr;
+                entry.outputs_may_alias = opts.outputs_may_alias;
+                entry.async_api         = opts.async_api;
+            }
+            writeModelHeader(entries, opts.header_out);
+            std::cout << "Model header written to " << opts.header_out.string() << std::endl;
+        }
 
-        auto bufferized = runLoweringPipeline(module);
+        auto bufferized = runLoweringPipeline(module, opts);
 
         if (!opts.mlir_out.empty())
         {
@@ -708,11 +1360,9 @@ namespace tc
             if (!ec) module.print(ofs);
         }
 
-        lowerToLLVM(*bufferized);
+        lowerToLLVM(*bufferized, opts);
 
         auto llvmModule = translateToLLVMIR(*bufferized, llvm::outs());
-        
-        if (opts.optimize) runOptPipeline(module);
 
         std::string asm_out_final = (asm_out == "") ? "out.o" : asm_out;
         emitObject(llvmModule.get(), asm_out_final, opts);
@@ -729,8 +1379,22 @@ namespace tc
                 R"(
                 MLIR / LLVM codegen options:
                 --print-mlir            Print MLIR before optimization
-                
+                --print-mlir-opt        Print MLIR after optimization
+                --no-optimize           Skip elementwise fusion and the options below
+                --fast-math             Reassociate, contract and approximate float math, flush denormals
+                                        (no nnan/ninf, so -inf masks stay exact)
+                --approx-math           Polynomial tanh, erf, exp, log etc. instead of libm calls
                 --mlir-out=<path>       Write MLIR to file
+                --emit-header=<path>    Write a C header for the compiled entry point
+                --async-api             Add tc_<graph>_invoke_async() to the header (needs libtc_runtime)
+                --dest-passing          Caller passes preallocated output buffers
+                --allow-output-aliasing Like --dest-passing, but outputs may alias inputs (one copy per output)
+                --bare-ptr              Bare-pointer calling convention for static models (implies --dest-passing)
+                --schedule=<policy>     Node order: kahn (default), memory (lowest peak activations)
+                                        or depth-first (consumers next to producers)
+                --parallel-branches     Run independent branches of the graph concurrently
+                --parallel-loops        Split the loops of each op across threads
+                                        (both need libtc_runtime, threads from TC_NUM_THREADS)
     )";
     }
 
@@ -780,6 +1444,16 @@ namespace tc
             if (arg == "--print-mlir")         { opts.print_mlir     = true; continue; }
             if (arg == "--print-mlir-opt")     { opts.print_mlir_opt = true; continue; }
             if (arg == "--no-optimize")        { opts.optimize       = false; continue; }
+            if (arg == "--fast-math")          { opts.fast_math      = true; continue; }
+            if (arg == "--approx-math")        { opts.approximate_math = true; continue; }
+            if (arg == "--dest-passing")       { opts.dest_passing   = true; continue; }
+            if (arg == "--allow-output-aliasing")
+            { opts.dest_passing = true; opts.outputs_may_alias = true; continue; }
+
+            if (arg == "--bare-ptr")           { opts.bare_ptr = true; opts.dest_passing = true; continue; }
+            if (arg == "--parallel-branches")  { opts.parallel_branches = true; continue; }
+            if (arg == "--parallel-loops")     { opts.parallel_loops    = true; continue; }
+            if (arg == "--async-api")          { opts.async_api         = true; continue; }
 
             if (startsWith(arg, "--target-triple="))
             { opts.target_triple = getValue(arg, "--target-triple="); continue; }
@@ -793,6 +1467,12 @@ namespace tc
             if (startsWith(arg, "--mlir-out="))
             { opts.mlir_out = getValue(arg, "--mlir-out="); continue; }
 
+            if (startsWith(arg, "--emit-header="))
+            { opts.header_out = getValue(arg, "--emit-header="); continue; }
+
+            if (startsWith(arg, "--schedule="))
+            { opts.schedule = schedulePolicyFromString(getValue(arg, "--schedule=")); continue; }
+
         }
 
         return opts;
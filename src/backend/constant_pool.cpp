@@ -0,0 +1,231 @@
+#include "backend/constant_pool.hpp"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace tc
+{
+
+    static constexpr llvm::StringLiteral kGlobalPrefix = "__tc_weight";
+
+    static bool allElementsEqual(std::span<const uint8_t> data, size_t elem_size)
+    {
+        for (size_t off = elem_size; off < data.size(); off += elem_size)
+            if (std::memcmp(data.data(), data.data() + off, elem_size) != 0) return false;
+        return true;
+    }
+
+    static size_t byteSize(mlir::ShapedType type)
+    {
+        return static_cast<size_t>(type.getNumElements()) * ((type.getElementTypeBitWidth() + 7) / 8);
+    }
+
+    std::string ConstantPool::Stats::summary() const
+    {
+        std::ostringstream os;
+        os << "Constants: " << initializers << " initializers, " << bytes << " bytes; "
+           << splats << " splats (-" << splat_bytes << " B), "
+           << duplicates << " duplicates (-" << duplicate_bytes << " B), "
+           << unused << " unused (-" << unused_bytes << " B); "
+           << global_bytes << " bytes in " << globals << " globals aligned to " << kAlignment;
+        return os.str();
+    }
+
+    void ConstantPool::reset()
+    {
+        globals_.clear();
+        reads_.clear();
+        created_.clear();
+        counted_.clear();
+        stats_ = {};
+    }
+
+    void ConstantPool::rollback(const Checkpoint& cp)
+    {
+        // the caller erased them
+        created_.truncate(cp.created);
+        while (reads_.size() > cp.reads)
+            reads_.pop_back();
+        while (globals_.size() > cp.globals)
+        {
+            globals_.back().second.erase();
+            globals_.pop_back();
+        }
+        while (counted_.size() > cp.counted)
+            counted_.pop_back();
+        stats_ = cp.stats;
+    }
+
+    mlir::Value ConstantPool::materialize(mlir::OpBuilder&         builder,
+                                          mlir::Location           loc,
+                                          mlir::RankedTensorType   type,
+                                          std::span<const uint8_t> data)
+    {
+        auto elems     = type.getNumElements();
+        auto elem_size = elems > 0 ? data.size() / static_cast<size_t>(elems) : data.size();
+
+        // an initializer read by several tasks is materialized in each of them, from the same buffer
+        bool first = counted_.insert(data.data());
+        if (first)
+        {
+            ++stats_.initializers;
+            stats_.bytes += data.size();
+        }
+
+        bool                    splat = false;
+        mlir::DenseElementsAttr value;
+        if (type.getElementType().isInteger(1))
+        {
+            // i1 attributes are bit-packed while bools are stored a byte each, any nonzero
+            // byte being true
+            llvm::SmallVector<bool> bits(data.begin(), data.end());
+            splat = elems > 1 && llvm::all_equal(bits);
+            value = mlir::DenseElementsAttr::get(type, llvm::ArrayRef<bool>(bits).take_front(splat ? 1 : bits.size()));
+        }
+        else
+        {
+            // a buffer of a single element makes getFromRawBuffer() build a splat
+            splat    = elems > 1 && allElementsEqual(data, elem_size);
+            auto raw = llvm::ArrayRef<char>(reinterpret_cast<const char*>(data.data()), splat ? elem_size : data.size());
+            value    = mlir::DenseElementsAttr::getFromRawBuffer(type, raw);
+        }
+
+        if (splat && first)
+        {
+            ++stats_.splats;
+            stats_.splat_bytes += data.size() - elem_size;
+        }
+
+        if (elems <= kInlineElements)
+        {
+            auto constant = mlir::arith::ConstantOp::create(builder, loc, type, value);
+            created_.push_back(constant);
+            return constant;
+        }
+
+        if (splat)
+        {
+            auto scalar = mlir::arith::ConstantOp::create(
+                builder, loc, llvm::cast<mlir::TypedAttr>(value.getSplatValue<mlir::Attribute>()));
+            auto empty = mlir::tensor::EmptyOp::create(builder, loc, type.getShape(), type.getElementType());
+            auto fill  = mlir::linalg::FillOp::create(builder, loc, mlir::ValueRange{scalar}, mlir::ValueRange{empty});
+            created_.append({scalar, empty, fill});
+            return fill.getResult(0);
+        }
+
+        // dense attributes are uniqued by a hash of their type and contents, so equal
+        // initializers of any model in the module are the same key
+        auto& global = globals_[value];
+        if (global && first)
+        {
+            ++stats_.duplicates;
+            stats_.duplicate_bytes += data.size();
+        }
+        else if (!global)
+        {
+            auto module = builder.getInsertionBlock()->getParentOp()->getParentOfType<mlir::ModuleOp>();
+
+            mlir::OpBuilder::InsertionGuard guard(builder);
+            builder.setInsertionPointToStart(module.getBody());
+            global = mlir::memref::GlobalOp::create(
+                builder, loc, (llvm::Twine(kGlobalPrefix) + llvm::Twine(globals_.size() - 1)).str(),
+                builder.getStringAttr("private"), mlir::MemRefType::get(type.getShape(), type.getElementType()),
+                value, /*constant=*/true, builder.getI64IntegerAttr(kAlignment));
+        }
+
+        return readGlobal(builder, loc, type, global);
+    }
+
+    mlir::Value ConstantPool::readGlobal(mlir::OpBuilder&       builder,
+                                         mlir::Location         loc,
+                                         mlir::RankedTensorType type,
+                                         mlir::memref::GlobalOp global)
+    {
+        auto* parent = builder.getInsertionBlock()->getParentOp();
+        auto  func   = llvm::isa<mlir::func::FuncOp>(parent) ? llvm::cast<mlir::func::FuncOp>(parent)
+                                                             : parent->getParentOfType<mlir::func::FuncOp>();
+
+        // one-shot bufferization needs `restrict`: the to_tensor must be the only one over its
+        // buffer, and equal initializers share the global. Every read in a function gets the
+        // tensor made at its start, which dominates them all
+        auto& read = reads_[{func, global}];
+        if (read) return read;
+
+        mlir::OpBuilder::InsertionGuard guard(builder);
+        if (func) builder.setInsertionPointToStart(&func.getBody().front());
+
+        auto ref    = mlir::memref::GetGlobalOp::create(builder, loc, global.getType(), global.getSymName());
+        auto tensor = mlir::bufferization::ToTensorOp::create(builder, loc, type, ref, /*restrict=*/true, /*writable=*/false);
+        created_.append({ref, tensor});
+        read = tensor;
+        return read;
+    }
+
+    void ConstantPool::finish(mlir::ModuleOp module)
+    {
+        // inline values erased here, an initializer several tasks read is unused only if none
+        // of its copies is, and counts once
+        llvm::SetVector<mlir::Attribute> dropped;
+        llvm::DenseSet<mlir::Attribute>  kept;
+
+        // only what materialize() created, the builders' own constants aren't initializers.
+        // Each materialization's ops come after the ones they use, walking backwards lets
+        // them die in one pass
+        for (auto* op : llvm::reverse(created_))
+        {
+            // splats were counted as saved already
+            mlir::DenseElementsAttr dense;
+            if (auto constant = llvm::dyn_cast<mlir::arith::ConstantOp>(op))
+                dense = llvm::dyn_cast<mlir::DenseElementsAttr>(constant.getValue());
+            bool initializer = dense && !dense.isSplat();
+
+            if (!op->use_empty())
+            {
+                if (initializer) kept.insert(dense);
+                continue;
+            }
+            if (initializer) dropped.insert(dense);
+            op->erase();
+        }
+        created_.clear();
+
+        for (auto value : dropped)
+        {
+            if (kept.contains(value)) continue;
+            ++stats_.unused;
+            stats_.unused_bytes += byteSize(llvm::cast<mlir::DenseElementsAttr>(value).getType());
+        }
+
+        llvm::StringSet<> referenced;
+        module.walk([&](mlir::memref::GetGlobalOp ref) { referenced.insert(ref.getName()); });
+
+        for (auto& entry : globals_)
+        {
+            auto global = entry.second;
+            auto bytes = byteSize(global.getType());
+            if (referenced.contains(global.getSymName()))
+            {
+                ++stats_.globals;
+                stats_.global_bytes += bytes;
+                continue;
+            }
+            ++stats_.unused;
+            stats_.unused_bytes += bytes;
+            global.erase();
+        }
+        globals_.clear();
+        reads_.clear();
+        counted_.clear();
+    }
+
+} // namespace tc
@@ -0,0 +1,508 @@
+#include "backend/header_emitter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+namespace tc
+{
+
+    static constexpr size_t kMaxRank = 8; // TC_MAX_RANK in the generated header
+
+    std::string cIdentifier(const std::string& name)
+    {
+        std::string out;
+        out.reserve(name.size() + 1);
+
+        for (char c : name)
+            out += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+        if (out.empty() || std::isdigit(static_cast<unsigned char>(out[0])))
+            out.insert(out.begin(), '_');
+
+        return out;
+    }
+
+    std::string entryPointSymbol(const Graph& graph, const std::filesystem::path& path,
+                                 std::unordered_set<std::string>& taken)
+    {
+        // variants of one model often keep the exporter's graph name
+        auto symbol = cIdentifier(graph.getName());
+        if (taken.insert(symbol).second)
+            return symbol;
+
+        symbol = cIdentifier(path.stem().string());
+        if (!taken.insert(symbol).second)
+            throw std::runtime_error("Two models compile to the same entry point '" + symbol + "'");
+        return symbol;
+    }
+
+    // must stay in sync with mlirElemType() in codegen.cpp
+    static const char* cElemType(DataType dt)
+    {
+        switch (dt)
+        {
+            case DataType::FLOAT:   return "float";
+            case DataType::DOUBLE:  return "double";
+            case DataType::FLOAT16: return "uint16_t";
+            case DataType::INT8:    return "int8_t";
+            case DataType::INT16:   return "int16_t";
+            case DataType::INT32:   return "int32_t";
+            case DataType::INT64:   return "int64_t";
+            case DataType::UINT8:   return "uint8_t";
+            case DataType::BOOL:    return "uint8_t";
+            default:                return "float";
+        }
+    }
+
+    static const char* cDtypeEnum(DataType dt)
+    {
+        switch (dt)
+        {
+            case DataType::DOUBLE:  return "TC_DTYPE_DOUBLE";
+            case DataType::FLOAT16: return "TC_DTYPE_FLOAT16";
+            case DataType::INT8:    return "TC_DTYPE_INT8";
+            case DataType::INT16:   return "TC_DTYPE_INT16";
+            case DataType::INT32:   return "TC_DTYPE_INT32";
+            case DataType::INT64:   return "TC_DTYPE_INT64";
+            case DataType::UINT8:   return "TC_DTYPE_UINT8";
+            case DataType::BOOL:    return "TC_DTYPE_BOOL";
+            default:                return "TC_DTYPE_FLOAT";
+        }
+    }
+
+    static std::string upper(std::string s)
+    {
+        for (auto& c : s) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    static std::string escapeCString(const std::string& s)
+    {
+        std::string out;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    EntryPointDesc describeEntryPoint(const Graph& graph)
+    {
+        EntryPointDesc entry;
+        entry.symbol = cIdentifier(graph.getName());
+
+        auto describe = [&](const std::string& name)
+        {
+            const auto* tensor = graph.findTensor(name);
+            if (!tensor)
+                throw std::runtime_error("Entry point tensor not found: " + name);
+
+            const auto& t = *tensor;
+            EntryTensorDesc desc;
+            desc.name  = name;
+            desc.dtype = t.getDtype() == DataType::UNDEFINED ? DataType::FLOAT : t.getDtype();
+            desc.dims  = t.getShape().dims;
+
+            if (desc.dims.size() > kMaxRank)
+                throw std::runtime_error("Entry point tensor '" + name + "' exceeds rank " + std::to_string(kMaxRank));
+
+            return desc;
+        };
+
+        for (const auto& name : graph.getInputs())  entry.inputs.push_back(describe(name));
+        for (const auto& name : graph.getOutputs()) entry.outputs.push_back(describe(name));
+
+        return entry;
+    }
+
+
+
+
+    static void emitCommonTypes(std::ostream& os)
+    {
+        os << "#ifndef TC_MODEL_COMMON_DEFINED\n"
+              "#define TC_MODEL_COMMON_DEFINED\n\n"
+              "#define TC_MAX_RANK " << kMaxRank << "\n\n"
+              "/* element types, values follow onnx.TensorProto.DataType */\n"
+              "typedef enum\n"
+              "{\n"
+              "    TC_DTYPE_FLOAT   = 1,\n"
+              "    TC_DTYPE_UINT8   = 2,\n"
+              "    TC_DTYPE_INT8    = 3,\n"
+              "    TC_DTYPE_INT16   = 5,\n"
+              "    TC_DTYPE_INT32   = 6,\n"
+              "    TC_DTYPE_INT64   = 7,\n"
+              "    TC_DTYPE_BOOL    = 9,\n"
+              "    TC_DTYPE_FLOAT16 = 10,\n"
+              "    TC_DTYPE_DOUBLE  = 11\n"
+              "} tc_dtype;\n\n"
+              "typedef struct\n"
+              "{\n"
+              "    const char*    name;\n"
+              "    tc_dtype       dtype;\n"
+              "    size_t         elem_size;\n"
+              "    int32_t        rank;\n"
+              "    const int64_t* dims;      /* -1 marks a dynamic dimension */\n"
+              "} tc_tensor_info;\n\n"
+              "/* dense row-major buffer passed to tc_<model>_invoke() */\n"
+              "typedef struct\n"
+              "{\n"
+              "    void*   data;\n"
+              "    void*   allocated;        /* returned outputs the caller owns, release with free(); else NULL */\n"
+              "    int32_t rank;\n"
+              "    int64_t sizes[TC_MAX_RANK];\n"
+              "} tc_buffer;\n\n"
+              "#endif /* TC_MODEL_COMMON_DEFINED */\n\n";
+    }
+
+    static std::string shapeComment(const EntryTensorDesc& t)
+    {
+        std::string s = t.name + " : " + dataTypeToString(t.dtype) + TensorShape{t.dims}.toString();
+        // keep "*/" in a tensor name from closing the comment
+        for (size_t pos = s.find("*/"); pos != std::string::npos; pos = s.find("*/", pos))
+            s.replace(pos, 2, "* /");
+        return s;
+    }
+
+    static void emitMemrefType(std::ostream& os, const std::string& type_name, const EntryTensorDesc& t)
+    {
+        const char* elem = cElemType(t.dtype);
+
+        os << "/* " << shapeComment(t) << " */\n"
+           << "typedef struct\n"
+           << "{\n"
+           << "    " << elem << "* allocated;\n"
+           << "    " << elem << "* aligned;\n"
+           << "    int64_t offset;\n";
+
+        if (!t.dims.empty())
+        {
+            os << "    int64_t sizes["   << t.dims.size() << "];\n"
+               << "    int64_t strides[" << t.dims.size() << "];\n";
+        }
+
+        os << "} " << type_name << ";\n\n";
+    }
+
+    static void emitTensorInfos(std::ostream& os, const std::string& prefix, const std::string& kind,
+                                const std::vector<EntryTensorDesc>& tensors)
+    {
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            const auto& dims = tensors[i].dims;
+            if (dims.empty()) continue;
+
+            os << "static const int64_t " << prefix << "_" << kind << i << "_dims[" << dims.size() << "] = {";
+            for (size_t d = 0; d < dims.size(); ++d)
+                os << (d ? ", " : "") << (dims[d] < 0 ? -1 : dims[d]);
+            os << "};\n";
+        }
+
+        os << "\nstatic const tc_tensor_info " << prefix << "_" << kind << "s[" << std::max<size_t>(1, tensors.size()) << "] = {\n";
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            const auto& t = tensors[i];
+            os << "    {\"" << escapeCString(t.name) << "\", " << cDtypeEnum(t.dtype)
+               << ", sizeof(" << cElemType(t.dtype) << "), " << t.dims.size() << ", ";
+
+            if (t.dims.empty()) os << "NULL";
+            else                os << prefix << "_" << kind << i << "_dims";
+
+            os << "},\n";
+        }
+        if (tensors.empty())
+            os << "    {NULL, TC_DTYPE_FLOAT, 0, 0, NULL},\n";
+        os << "};\n\n";
+    }
+
+    // dense row-major descriptor `var` over buffer `buf` (an expression of type tc_buffer)
+    static void emitDenseDescriptor(std::ostream& os, const std::string& type_name, const std::string& var,
+                                    const std::string& buf, const EntryTensorDesc& t)
+    {
+        const char* elem = cElemType(t.dtype);
+        size_t      rank = t.dims.size();
+
+        os << "    " << type_name << " " << var << ";\n"
+           << "    " << var << ".allocated = (" << elem << "*)" << buf << ".data;\n"
+           << "    " << var << ".aligned   = (" << elem << "*)" << buf << ".data;\n"
+           << "    " << var << ".offset    = 0;\n";
+
+        for (size_t d = rank; d-- > 0;)
+        {
+            os << "    " << var << ".sizes[" << d << "]   = " << buf << ".sizes[" << d << "];\n";
+            if (d + 1 == rank)
+                os << "    " << var << ".strides[" << d << "] = 1;\n";
+            else
+                os << "    " << var << ".strides[" << d << "] = " << var << ".strides[" << d + 1 << "] * "
+                   << var << ".sizes[" << d + 1 << "];\n";
+        }
+        os << "\n";
+    }
+
+    // tc_<symbol>_invoke() queued on the runtime's threads, see tc_runtime_submit()
+    static void emitAsyncInvoke(std::ostream& os, const std::string& prefix, size_t n_in)
+    {
+        os << "/* arguments of a queued " << prefix << "_invoke(), freed when it has run */\n"
+           << "typedef struct\n"
+           << "{\n"
+           << "    tc_buffer  inputs[" << std::max<size_t>(1, n_in) << "];\n"
+           << "    tc_buffer* outputs;\n"
+           << "} " << prefix << "_call;\n\n"
+           << "static inline int " << prefix << "_run_call(void* arg)\n"
+           << "{\n"
+           << "    " << prefix << "_call* call = (" << prefix << "_call*)arg;\n"
+           << "    int status = " << prefix << "_invoke(call->inputs, call->outputs);\n"
+           << "    free(call);\n"
+           << "    return status;\n"
+           << "}\n\n"
+           << "/* Queues " << prefix << "_invoke() on the runtime's threads and returns at once. The input\n"
+           << " * descriptors are copied, but the data they point to and `outputs` must stay valid until\n"
+           << " * the request is done. on_done (may be NULL) then runs on a runtime thread with the status\n"
+           << " * " << prefix << "_invoke() returned. Wait with tc_request_wait() or poll tc_request_done(),\n"
+           << " * release the handle with tc_request_release(). NULL if out of memory. */\n"
+           << "static inline tc_request* " << prefix << "_invoke_async(const tc_buffer* inputs, tc_buffer* outputs,\n"
+           << std::string(prefix.size() + 39, ' ') << "tc_completion_fn on_done, void* user_data)\n"
+           << "{\n"
+           << "    " << prefix << "_call* call = (" << prefix << "_call*)malloc(sizeof(*call));\n"
+           << "    if (!call) return NULL;\n"
+           << "    for (int i = 0; i < " << n_in << "; ++i)\n"
+           << "        call->inputs[i] = inputs[i];\n"
+           << "    call->outputs = outputs;\n\n"
+           << "    tc_request* req = tc_runtime_submit(" << prefix << "_run_call, call, on_done, user_data);\n"
+           << "    if (!req) free(call);\n"
+           << "    return req;\n"
+           << "}\n\n";
+    }
+
+    void emitModelHeader(const EntryPointDesc& entry, std::ostream& os)
+    {
+        const std::string& sym    = entry.symbol;
+        const std::string  prefix = "tc_" + sym;
+        const std::string  macro  = "TC_" + upper(sym);
+        const size_t       n_in   = entry.inputs.size();
+        const size_t       n_out  = entry.outputs.size();
+
+        os << "/* Generated by tcompiler - do not edit.\n"
+              " * Entry point _mlir_ciface_" << sym << " of the compiled model. */\n\n"
+           << "#ifndef " << macro << "_MODEL_H\n"
+           << "#define " << macro << "_MODEL_H\n\n"
+           << "#include <stddef.h>\n"
+              "#include <stdint.h>\n";
+        if (entry.async_api)
+            os << "#include <stdlib.h>\n\n"
+                  "#include \"runtime/tc_runtime.h\"\n";
+        os << "\n"
+              "#ifdef __cplusplus\n"
+              "extern \"C\" {\n"
+              "#endif\n\n";
+
+        emitCommonTypes(os);
+
+        // memref descriptors, as produced by MLIR's C interface
+        for (size_t i = 0; i < n_in; ++i)
+            emitMemrefType(os, prefix + "_in" + std::to_string(i) + "_memref", entry.inputs[i]);
+
+        for (size_t i = 0; i < n_out; ++i)
+            emitMemrefType(os, prefix + "_out" + std::to_string(i) + "_memref", entry.outputs[i]);
+
+        // several results are returned packed in one struct
+        const bool  returns_results = n_out > 0 && !entry.dest_passing;
+        std::string result_type     = prefix + "_out0_memref";
+        if (returns_results && n_out > 1)
+        {
+            result_type = prefix + "_results";
+            os << "typedef struct\n{\n";
+            for (size_t i = 0; i < n_out; ++i)
+                os << "    " << prefix << "_out" << i << "_memref out" << i << ";\n";
+            os << "} " << result_type << ";\n\n";
+        }
+
+        if (entry.dest_passing)
+        {
+            os << "/* destination-passing: results are written into the caller's output buffers, sized to the\n"
+               << (entry.outputs_may_alias
+                   ? " * result shapes. Outputs may alias inputs. */\n"
+                   : " * result shapes. Outputs must not alias inputs or each other. */\n");
+        }
+
+        bool first = true;
+        if (entry.bare_ptr)
+        {
+            // the compiled symbol takes aligned data pointers, all shapes are static
+            os << "/* bare-pointer entry point: one pointer per input, then one per output */\n"
+               << "void " << sym << "(";
+            for (size_t i = 0; i < n_in; ++i)
+            {
+                os << (first ? "" : ", ") << cElemType(entry.inputs[i].dtype) << "* in" << i;
+                first = false;
+            }
+            for (size_t i = 0; i < n_out; ++i)
+            {
+                os << (first ? "" : ", ") << cElemType(entry.outputs[i].dtype) << "* out" << i;
+                first = false;
+            }
+            os << ");\n\n"
+               << "/* descriptor ABI, kept for callers written against the memref interface */\n"
+               << "static inline void _mlir_ciface_" << sym << "(";
+        }
+        else
+        {
+            os << "void _mlir_ciface_" << sym << "(";
+        }
+
+        first = true;
+        if (returns_results)
+        {
+            os << result_type << "* result";
+            first = false;
+        }
+        for (size_t i = 0; i < n_in; ++i)
+        {
+            os << (first ? "" : ", ") << prefix << "_in" << i << "_memref* in" << i;
+            first = false;
+        }
+        for (size_t i = 0; entry.dest_passing && i < n_out; ++i)
+        {
+            os << (first ? "" : ", ") << prefix << "_out" << i << "_memref* out" << i;
+            first = false;
+        }
+        os << ")";
+
+        if (entry.bare_ptr)
+        {
+            os << "\n{\n    " << sym << "(";
+            first = true;
+            for (size_t i = 0; i < n_in; ++i)
+            {
+                os << (first ? "" : ", ") << "in" << i << "->aligned + in" << i << "->offset";
+                first = false;
+            }
+            for (size_t i = 0; i < n_out; ++i)
+            {
+                os << (first ? "" : ", ") << "out" << i << "->aligned + out" << i << "->offset";
+                first = false;
+            }
+            os << ");\n}\n\n";
+        }
+        else
+        {
+            os << ";\n\n";
+        }
+
+        // metadata
+        os << "#define " << macro << "_NUM_INPUTS   " << n_in  << "\n"
+           << "#define " << macro << "_NUM_OUTPUTS  " << n_out << "\n"
+           << "#define " << macro << "_DEST_PASSING " << (entry.dest_passing ? 1 : 0) << "\n\n";
+
+        emitTensorInfos(os, prefix, "input",  entry.inputs);
+        emitTensorInfos(os, prefix, "output", entry.outputs);
+
+        // generic wrapper: dense buffers in, dense buffers out
+        os << "/* returns 0 on success, -1 if an output is not dense row-major */\n"
+           << "static inline int " << prefix << "_invoke(const tc_buffer* inputs, tc_buffer* outputs)\n"
+           << "{\n";
+
+        for (size_t i = 0; i < n_in; ++i)
+            emitDenseDescriptor(os, prefix + "_in" + std::to_string(i) + "_memref", "in" + std::to_string(i),
+                                "inputs[" + std::to_string(i) + "]", entry.inputs[i]);
+
+        // destination-passing outputs are described the same way as inputs
+        for (size_t i = 0; entry.dest_passing && i < n_out; ++i)
+            emitDenseDescriptor(os, prefix + "_out" + std::to_string(i) + "_memref", "out" + std::to_string(i),
+                                "outputs[" + std::to_string(i) + "]", entry.outputs[i]);
+
+        if (returns_results) os << "    " << result_type << " result;\n";
+
+        os << "    _mlir_ciface_" << sym << "(";
+        first = true;
+        if (returns_results) { os << "&result"; first = false; }
+        for (size_t i = 0; i < n_in; ++i)
+        {
+            os << (first ? "" : ", ") << "&in" << i;
+            first = false;
+        }
+        for (size_t i = 0; entry.dest_passing && i < n_out; ++i)
+        {
+            os << (first ? "" : ", ") << "&out" << i;
+            first = false;
+        }
+        os << ");\n\n";
+
+        for (size_t i = 0; returns_results && i < n_out; ++i)
+        {
+            std::string r    = n_out > 1 ? "result.out" + std::to_string(i) : "result";
+            size_t      rank = entry.outputs[i].dims.size();
+
+            // a result may be a global, which MLIR marks 0xdeadbeef, an input, or an earlier
+            // result; none of them is the caller's to free
+            std::string out = "outputs[" + std::to_string(i) + "].allocated";
+            os << "    " << out << " = " << r << ".allocated;\n"
+               << "    if (" << out << " == (void*)0xdeadbeef";
+            for (size_t j = 0; j < n_in; ++j)
+                os << " ||\n        " << out << " == inputs[" << j << "].data";
+            for (size_t k = 0; k < i; ++k)
+                os << " ||\n        " << out << " == (void*)result.out" << k << ".allocated";
+            os << ")\n"
+               << "        " << out << " = NULL;\n"
+               << "    outputs[" << i << "].data      = " << r << ".aligned + " << r << ".offset;\n"
+               << "    outputs[" << i << "].rank      = " << rank << ";\n";
+
+            if (rank > 0)
+                os << "    {\n"
+                   << "        int64_t expected = 1;\n"
+                   << "        for (int d = " << rank - 1 << "; d >= 0; --d)\n"
+                   << "        {\n"
+                   << "            outputs[" << i << "].sizes[d] = " << r << ".sizes[d];\n"
+                   << "            if (" << r << ".sizes[d] != 1 && " << r << ".strides[d] != expected) return -1;\n"
+                   << "            expected *= " << r << ".sizes[d];\n"
+                   << "        }\n"
+                   << "    }\n";
+        }
+
+        os << "    return 0;\n"
+           << "}\n\n";
+
+        if (entry.async_api)
+            emitAsyncInvoke(os, prefix, n_in);
+
+        // the first included model becomes the default one for bench_driver.cpp
+        os << "#ifndef TC_MODEL_INVOKE\n"
+           << "#define TC_MODEL_NAME         \"" << sym << "\"\n"
+           << "#define TC_MODEL_NUM_INPUTS   " << macro << "_NUM_INPUTS\n"
+           << "#define TC_MODEL_NUM_OUTPUTS  " << macro << "_NUM_OUTPUTS\n"
+           << "#define TC_MODEL_DEST_PASSING " << macro << "_DEST_PASSING\n"
+           << "#define TC_MODEL_INPUTS       " << prefix << "_inputs\n"
+           << "#define TC_MODEL_OUTPUTS      " << prefix << "_outputs\n"
+           << "#define TC_MODEL_INVOKE       " << prefix << "_invoke\n"
+           << (entry.async_api ? "#define TC_MODEL_INVOKE_ASYNC " + prefix + "_invoke_async\n" : "")
+           << "#endif\n\n";
+
+        os << "#ifdef __cplusplus\n"
+              "}\n"
+              "#endif\n\n"
+           << "#endif /* " << macro << "_MODEL_H */\n";
+    }
+
+    void writeModelHeader(const EntryPointDesc& entry, const std::filesystem::path& path)
+    {
+        writeModelHeader(std::span<const EntryPointDesc>(&entry, 1), path);
+    }
+
+    void writeModelHeader(std::span<const EntryPointDesc> entries, const std::filesystem::path& path)
+    {
+        std::ofstream ofs(path);
+        if (!ofs)
+            throw std::runtime_error("Cannot open header output file: " + path.string());
+
+        // each model's part has its own guard, the common types are defined once
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i) ofs << "\n";
+            emitModelHeader(entries[i], ofs);
+        }
+    }
+
+} // namespace tc
@@ -0,0 +1,608 @@
+#include "frontend/graph_serializer.hpp"
+#include "frontend/mapped_file.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tc
+{
+
+    static constexpr char kMagic[8] = {'T', 'C', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+    static constexpr uint32_t kTensorPresent = 1;   // a tensor object exists, not just the name
+    static constexpr uint32_t kNoIndex       = std::numeric_limits<uint32_t>::max();
+
+    // on-disk records, all fields little-endian and naturally aligned
+
+    struct Section
+    {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t graph_name;          // string id
+        uint32_t num_graph_tensors;   // tensors past these belong to attributes
+        uint32_t reserved;
+
+        Section  string_offsets;      // uint32, one more than there are strings
+        Section  string_bytes;
+        Section  tensors;             // TensorRecord
+        Section  dims;                // int64
+        Section  nodes;               // NodeRecord
+        Section  edges;               // uint32 tensor id, kNoTensor for an omitted input
+        Section  inputs;              // uint32 tensor id
+        Section  outputs;             // uint32 tensor id
+        Section  attrs;               // AttrRecord
+        Section  attr_values;         // bytes, 8-aligned per attribute
+        Section  data;                // bytes, kGraphFileAlignment-aligned per weight
+
+        uint64_t file_size;
+    };
+
+    struct TensorRecord
+    {
+        uint32_t name;
+        int32_t  dtype;
+        uint32_t rank;
+        uint32_t flags;
+        uint64_t first_dim;
+        uint64_t data_offset;         // relative to the data section
+        uint64_t data_size;
+    };
+
+    struct NodeRecord
+    {
+        uint32_t name;
+        uint32_t op;
+        uint32_t num_inputs;
+        uint32_t num_outputs;
+        uint64_t first_edge;
+        uint32_t first_attr;
+        uint32_t num_attrs;
+    };
+
+    struct AttrRecord
+    {
+        uint32_t name;
+        uint32_t type;
+        uint64_t offset;              // into attr_values
+        uint64_t count;               // elements
+    };
+
+    static_assert(sizeof(FileHeader)   == 208);
+    static_assert(sizeof(TensorRecord) == 40);
+    static_assert(sizeof(NodeRecord)   == 32);
+    static_assert(sizeof(AttrRecord)   == 24);
+
+    static void requireLittleEndian()
+    {
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("Graph files are only supported on little-endian hosts");
+    }
+
+    static uint64_t alignUp(uint64_t v, uint64_t a)
+    {
+        return (v + a - 1) / a * a;
+    }
+
+
+
+
+    // ── writer ──────────────────────────────────────────────────────────────────
+
+    class StringTable
+    {
+    public:
+        uint32_t add(const std::string& s)
+        {
+            auto [it, inserted] = ids_.try_emplace(s, static_cast<uint32_t>(strings_.size()));
+            if (inserted) strings_.push_back(&it->first);
+            return it->second;
+        }
+
+        [[nodiscard]] const std::vector<const std::string*>& strings() const { return strings_; }
+
+    private:
+        std::unordered_map<std::string, uint32_t> ids_;
+        std::vector<const std::string*>           strings_;   // keys of ids_, in id order
+    };
+
+    struct GraphWriter
+    {
+        StringTable                             strings;
+        std::vector<TensorRecord>               tensors;
+        std::vector<int64_t>                    dims;
+        std::vector<NodeRecord>                 nodes;
+        std::vector<uint32_t>                   edges;
+        std::vector<uint32_t>                   inputs;
+        std::vector<uint32_t>                   outputs;
+        std::vector<AttrRecord>                 attrs;
+        std::string                             attr_values;
+        std::vector<std::span<const uint8_t>>   weights;      // one per tensor record, may be empty
+        uint64_t                                data_size{0};
+
+        uint32_t addTensor(const std::string& name, const Tensor* t)
+        {
+            TensorRecord rec{};
+            rec.name        = strings.add(name);
+            rec.first_dim   = dims.size();
+            rec.data_offset = 0;
+
+            std::span<const uint8_t> data;
+            if (t)
+            {
+                rec.flags = kTensorPresent;
+                rec.dtype = static_cast<int32_t>(t->getDtype());
+                rec.rank  = static_cast<uint32_t>(t->getShape().rank());
+                dims.insert(dims.end(), t->getShape().dims.begin(), t->getShape().dims.end());
+
+                data = t->getRawData();
+                if (!data.empty())
+                {
+                    data_size       = alignUp(data_size, kGraphFileAlignment);
+                    rec.data_offset = data_size;
+                    rec.data_size   = data.size();
+                    data_size      += data.size();
+                }
+            }
+
+            tensors.push_back(rec);
+            weights.push_back(data);
+            return static_cast<uint32_t>(tensors.size() - 1);
+        }
+
+        template <typename T>
+        void appendValues(const T* values, size_t n)
+        {
+            attr_values.append(reinterpret_cast<const char*>(values), n * sizeof(T));
+        }
+
+        void addAttribute(const Attribute& a)
+        {
+            attr_values.resize(alignUp(attr_values.size(), 8));
+
+            AttrRecord rec{};
+            rec.name   = strings.add(a.getName());
+            rec.type   = static_cast<uint32_t>(a.getType());
+            rec.offset = attr_values.size();
+
+            std::vector<uint32_t> ids;
+            switch (a.getType())
+            {
+                case AttributeType::FLOAT:
+                {
+                    float v = a.asFloat();
+                    appendValues(&v, 1);
+                    rec.count = 1;
+                    break;
+                }
+                case AttributeType::INT:
+                {
+                    int64_t v = a.asInt();
+                    appendValues(&v, 1);
+                    rec.count = 1;
+                    break;
+                }
+                case AttributeType::FLOATS:
+                    appendValues(a.asFloats().data(), a.asFloats().size());
+                    rec.count = a.asFloats().size();
+                    break;
+
+                case AttributeType::INTS:
+                    appendValues(a.asInts().data(), a.asInts().size());
+                    rec.count = a.asInts().size();
+                    break;
+
+                case AttributeType::STRING:
+                    ids.push_back(strings.add(a.asString()));
+                    break;
+
+                case AttributeType::STRINGS:
+                    for (const auto& s : a.asStrings()) ids.push_back(strings.add(s));
+                    break;
+
+                case AttributeType::TENSOR:
+                    ids.push_back(attributeTensor(a.asTensor()));
+                    break;
+
+                case AttributeType::TENSORS:
+                    for (const auto& t : a.asTensors()) ids.push_back(attributeTensor(t));
+                    break;
+
+                default:
+                    throw std::runtime_error("Cannot store attribute '" + a.getName() + "' in a graph file: unsupported type " +
+                                             std::to_string(static_cast<int>(a.getType())));
+            }
+
+            // strings and tensors are stored as string ids and tensor record indices
+            bool by_id = a.getType() == AttributeType::STRING || a.getType() == AttributeType::STRINGS ||
+                         a.getType() == AttributeType::TENSOR || a.getType() == AttributeType::TENSORS;
+            if (by_id)
+            {
+                appendValues(ids.data(), ids.size());
+                rec.count = ids.size();
+            }
+
+            attrs.push_back(rec);
+        }
+
+        uint32_t attributeTensor(const std::shared_ptr<Tensor>& t)
+        {
+            if (!t) return kNoIndex;
+            return addTensor(t->getName(), t.get());
+        }
+    };
+
+    template <typename T>
+    static void appendSection(std::string& meta, Section& section, const std::vector<T>& items, uint64_t base)
+    {
+        meta.resize(alignUp(meta.size(), 8));
+        section.offset = base + meta.size();
+        section.count  = items.size();
+        meta.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+    }
+
+    void writeGraphFile(const Graph& graph, const std::filesystem::path& path)
+    {
+        requireLittleEndian();
+
+        GraphWriter w;
+        FileHeader  header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version    = kGraphFileVersion;
+        header.graph_name = w.strings.add(graph.getName());
+
+        // tensor ids are kept, record i is tensor id i
+        for (TensorId id = 0; id < graph.numTensorIds(); ++id)
+            w.addTensor(graph.tensorName(id), graph.tensor(id));
+        header.num_graph_tensors = static_cast<uint32_t>(graph.numTensorIds());
+
+        const auto& nodes = graph.getNodes();
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            const auto& node = *nodes[id];
+
+            NodeRecord rec{};
+            rec.name        = w.strings.add(node.getName());
+            rec.op          = w.strings.add(node.getOpStr());
+            rec.first_edge  = w.edges.size();
+            rec.num_inputs  = static_cast<uint32_t>(graph.nodeInputs(id).size());
+            rec.num_outputs = static_cast<uint32_t>(graph.nodeOutputs(id).size());
+            w.edges.insert(w.edges.end(), graph.nodeInputs(id).begin(),  graph.nodeInputs(id).end());
+            w.edges.insert(w.edges.end(), graph.nodeOutputs(id).begin(), graph.nodeOutputs(id).end());
+
+            rec.first_attr = static_cast<uint32_t>(w.attrs.size());
+            rec.num_attrs  = static_cast<uint32_t>(node.getAttributes().size());
+            for (const auto& a : node.getAttributes())
+                w.addAttribute(a);
+
+            w.nodes.push_back(rec);
+        }
+
+        w.inputs.assign(graph.getInputIds().begin(), graph.getInputIds().end());
+        w.outputs.assign(graph.getOutputIds().begin(), graph.getOutputIds().end());
+
+        // string table: offsets, then the bytes
+        std::vector<uint32_t> string_offsets;
+        std::string           string_bytes;
+        string_offsets.reserve(w.strings.strings().size() + 1);
+        for (const auto* s : w.strings.strings())
+        {
+            string_offsets.push_back(static_cast<uint32_t>(string_bytes.size()));
+            string_bytes += *s;
+        }
+        string_offsets.push_back(static_cast<uint32_t>(string_bytes.size()));
+
+        if (string_bytes.size() > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Graph file string table too large: " + path.string());
+
+        std::string meta;
+        const uint64_t base = sizeof(FileHeader);
+        std::vector<char> bytes(string_bytes.begin(), string_bytes.end());
+        std::vector<char> values(w.attr_values.begin(), w.attr_values.end());
+
+        appendSection(meta, header.string_offsets, string_offsets, base);
+        appendSection(meta, header.string_bytes,   bytes,          base);
+        appendSection(meta, header.tensors,        w.tensors,      base);
+        appendSection(meta, header.dims,           w.dims,         base);
+        appendSection(meta, header.nodes,          w.nodes,        base);
+        appendSection(meta, header.edges,          w.edges,        base);
+        appendSection(meta, header.inputs,         w.inputs,       base);
+        appendSection(meta, header.outputs,        w.outputs,      base);
+        appendSection(meta, header.attrs,          w.attrs,        base);
+        appendSection(meta, header.attr_values,    values,         base);
+
+        header.data.offset = alignUp(base + meta.size(), kGraphFileAlignment);
+        header.data.count  = w.data_size;
+        header.file_size   = header.data.offset + header.data.count;
+
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+            throw std::runtime_error("Cannot open graph file for writing: " + path.string());
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(meta.data(), static_cast<std::streamsize>(meta.size()));
+
+        // weights are streamed from wherever they live, mapped model files included
+        uint64_t pos = header.data.offset;
+        const std::string padding(kGraphFileAlignment, '\0');
+        auto padTo = [&](uint64_t target)
+        {
+            uint64_t cur = static_cast<uint64_t>(ofs.tellp());
+            ofs.write(padding.data(), static_cast<std::streamsize>(target - cur));
+        };
+
+        padTo(pos);
+        for (size_t i = 0; i < w.tensors.size(); ++i)
+        {
+            if (w.weights[i].empty()) continue;
+            padTo(header.data.offset + w.tensors[i].data_offset);
+            ofs.write(reinterpret_cast<const char*>(w.weights[i].data()),
+                      static_cast<std::streamsize>(w.weights[i].size()));
+        }
+
+        if (!ofs)
+            throw std::runtime_error("Failed to write graph file: " + path.string());
+    }
+
+
+
+
+    // ── reader ──────────────────────────────────────────────────────────────────
+
+    class GraphFileView
+    {
+    public:
+        explicit GraphFileView(std::shared_ptr<MappedFile> file) : file_(std::move(file))
+        {
+            const auto bytes = file_->bytes();
+            if (bytes.size() < sizeof(FileHeader))
+                fail("file too small");
+
+            std::memcpy(&header_, bytes.data(), sizeof(FileHeader));
+            if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0)
+                fail("bad magic");
+            if (header_.version != kGraphFileVersion)
+                fail("unsupported version " + std::to_string(header_.version));
+            if (header_.file_size != bytes.size())
+                fail("file size mismatch");
+
+            check(header_.string_offsets, sizeof(uint32_t));
+            check(header_.string_bytes,   1);
+            check(header_.tensors,        sizeof(TensorRecord));
+            check(header_.dims,           sizeof(int64_t));
+            check(header_.nodes,          sizeof(NodeRecord));
+            check(header_.edges,          sizeof(uint32_t));
+            check(header_.inputs,         sizeof(uint32_t));
+            check(header_.outputs,        sizeof(uint32_t));
+            check(header_.attrs,          sizeof(AttrRecord));
+            check(header_.attr_values,    1);
+            check(header_.data,           1);
+
+            if (header_.string_offsets.count == 0)
+                fail("empty string table");
+            if (header_.num_graph_tensors > header_.tensors.count)
+                fail("tensor count out of range");
+        }
+
+        [[nodiscard]] const FileHeader& header() const { return header_; }
+        [[nodiscard]] const std::shared_ptr<MappedFile>& file() const { return file_; }
+
+        template <typename T>
+        [[nodiscard]] T at(const Section& s, uint64_t i) const
+        {
+            if (i >= s.count) fail("index out of range");
+            T value;
+            std::memcpy(&value, file_->data() + s.offset + i * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        [[nodiscard]] std::string_view string(uint32_t id) const
+        {
+            if (id + 1ull >= header_.string_offsets.count) fail("string id out of range");
+            auto begin = at<uint32_t>(header_.string_offsets, id);
+            auto end   = at<uint32_t>(header_.string_offsets, id + 1);
+            if (begin > end || end > header_.string_bytes.count) fail("bad string table");
+            return {reinterpret_cast<const char*>(file_->data() + header_.string_bytes.offset + begin), end - begin};
+        }
+
+        [[nodiscard]] std::span<const uint8_t> data(uint64_t offset, uint64_t size) const
+        {
+            if (offset > header_.data.count || size > header_.data.count - offset)
+                fail("weight data out of range");
+            return {file_->data() + header_.data.offset + offset, static_cast<size_t>(size)};
+        }
+
+        [[nodiscard]] const uint8_t* attrValues(const AttrRecord& rec, size_t elem_size) const
+        {
+            const auto& s = header_.attr_values;
+            if (rec.offset > s.count || rec.count > (s.count - rec.offset) / elem_size)
+                fail("attribute value out of range");
+            return file_->data() + s.offset + rec.offset;
+        }
+
+        [[noreturn]] void fail(const std::string& what) const
+        {
+            throw std::runtime_error("Malformed graph file " + file_->path().string() + ": " + what);
+        }
+
+    private:
+        void check(const Section& s, uint64_t elem_size) const
+        {
+            if (s.offset > header_.file_size || s.count > (header_.file_size - s.offset) / elem_size)
+                fail("section out of range");
+        }
+
+        std::shared_ptr<MappedFile> file_;
+        FileHeader                  header_{};
+    };
+
+    // null for a name that only appears as an edge
+    static std::shared_ptr<Tensor> readTensor(const GraphFileView& view, uint64_t index, Graph& graph)
+    {
+        auto rec = view.at<TensorRecord>(view.header().tensors, index);
+        if (!(rec.flags & kTensorPresent)) return nullptr;
+
+        TensorShape shape;
+        shape.dims.reserve(rec.rank);
+        for (uint32_t d = 0; d < rec.rank; ++d)
+            shape.dims.push_back(view.at<int64_t>(view.header().dims, rec.first_dim + d));
+
+        auto t = graph.createTensor(std::string(view.string(rec.name)), static_cast<DataType>(rec.dtype), std::move(shape));
+        if (rec.data_size > 0)
+            t->setRawDataView(view.data(rec.data_offset, rec.data_size), view.file());
+        return t;
+    }
+
+    template <typename T>
+    static std::vector<T> readValues(const GraphFileView& view, const AttrRecord& rec)
+    {
+        const uint8_t* src = view.attrValues(rec, sizeof(T));
+        std::vector<T> out(rec.count);
+        if (!out.empty()) std::memcpy(out.data(), src, rec.count * sizeof(T));
+        return out;
+    }
+
+    static Attribute readAttribute(const GraphFileView& view, uint64_t index, Graph& graph)
+    {
+        auto rec  = view.at<AttrRecord>(view.header().attrs, index);
+        auto name = std::string(view.string(rec.name));
+        auto type = static_cast<AttributeType>(rec.type);
+
+        auto tensorAt = [&](uint32_t i) -> std::shared_ptr<Tensor>
+        {
+            if (i == kNoIndex) return nullptr;
+            if (i < view.header().num_graph_tensors) view.fail("attribute tensor is a graph tensor");
+            return readTensor(view, i, graph);
+        };
+
+        auto scalarCount = [&]
+        {
+            if (rec.count != 1) view.fail("attribute '" + name + "' is not a scalar");
+        };
+
+        switch (type)
+        {
+            case AttributeType::FLOAT:
+                scalarCount();
+                return {name, type, readValues<float>(view, rec)[0]};
+
+            case AttributeType::INT:
+                scalarCount();
+                return {name, type, readValues<int64_t>(view, rec)[0]};
+
+            case AttributeType::FLOATS:
+                return {name, type, readValues<float>(view, rec)};
+
+            case AttributeType::INTS:
+                return {name, type, readValues<int64_t>(view, rec)};
+
+            case AttributeType::STRING:
+                scalarCount();
+                return {name, type, std::string(view.string(readValues<uint32_t>(view, rec)[0]))};
+
+            case AttributeType::STRINGS:
+            {
+                std::vector<std::string> out;
+                for (auto id : readValues<uint32_t>(view, rec)) out.emplace_back(view.string(id));
+                return {name, type, std::move(out)};
+            }
+
+            case AttributeType::TENSOR:
+                scalarCount();
+                return {name, type, tensorAt(readValues<uint32_t>(view, rec)[0])};
+
+            case AttributeType::TENSORS:
+            {
+                std::vector<std::shared_ptr<Tensor>> out;
+                for (auto i : readValues<uint32_t>(view, rec)) out.push_back(tensorAt(i));
+                return {name, type, std::move(out)};
+            }
+
+            default:
+                view.fail("attribute '" + name + "' has unsupported type " + std::to_string(rec.type));
+        }
+    }
+
+    std::shared_ptr<Graph> readGraphFile(const std::filesystem::path& path)
+    {
+        requireLittleEndian();
+
+        GraphFileView view(MappedFile::open(path));
+        const auto& h = view.header();
+
+        auto graph = std::make_shared<Graph>(std::string(view.string(h.graph_name)));
+        graph->reserve(h.nodes.count, h.num_graph_tensors);
+
+        // interning the names in record order gives back the same tensor ids
+        for (uint32_t i = 0; i < h.num_graph_tensors; ++i)
+        {
+            auto name = view.string(view.at<TensorRecord>(h.tensors, i).name);
+            if (auto t = readTensor(view, i, *graph))
+                graph->addTensor(std::move(t));
+            else
+                (void)graph->internTensor(name);
+
+            if (graph->numTensorIds() != i + 1ull)
+                view.fail("duplicate tensor name '" + std::string(name) + "'");
+        }
+
+        auto tensorName = [&](uint32_t id) -> const std::string&
+        {
+            static const std::string empty;
+            if (id == kNoTensor) return empty;
+            if (id >= h.num_graph_tensors) view.fail("tensor id out of range");
+            return graph->tensorName(id);
+        };
+
+        for (uint64_t i = 0; i < h.inputs.count; ++i)
+            graph->addInput(tensorName(view.at<uint32_t>(h.inputs, i)));
+        for (uint64_t i = 0; i < h.outputs.count; ++i)
+            graph->addOutput(tensorName(view.at<uint32_t>(h.outputs, i)));
+
+        for (uint64_t n = 0; n < h.nodes.count; ++n)
+        {
+            auto rec = view.at<NodeRecord>(h.nodes, n);
+
+            std::vector<std::string> inputs, outputs;
+            inputs.reserve(rec.num_inputs);
+            outputs.reserve(rec.num_outputs);
+            for (uint32_t k = 0; k < rec.num_inputs; ++k)
+                inputs.push_back(tensorName(view.at<uint32_t>(h.edges, rec.first_edge + k)));
+            for (uint32_t k = 0; k < rec.num_outputs; ++k)
+                outputs.push_back(tensorName(view.at<uint32_t>(h.edges, rec.first_edge + rec.num_inputs + k)));
+
+            Node::AttributeList attrs;
+            attrs.reserve(rec.num_attrs);
+            for (uint32_t k = 0; k < rec.num_attrs; ++k)
+                attrs.push_back(readAttribute(view, static_cast<uint64_t>(rec.first_attr) + k, *graph));
+
+            auto op = std::string(view.string(rec.op));
+            graph->addNode(graph->createNode(
+                std::string(view.string(rec.name)), opTypeFromString(op), op,
+                std::move(inputs), std::move(outputs), std::move(attrs)));
+        }
+
+        return graph;
+    }
+
+    bool isGraphFile(const std::filesystem::path& path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        char magic[sizeof(kMagic)] = {};
+        if (!ifs.read(magic, sizeof(magic))) return false;
+        return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    }
+
+} // namespace tc
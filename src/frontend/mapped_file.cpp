@@ -0,0 +1,62 @@
+#include "frontend/mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tc
+{
+
+    std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Cannot open file: " + path.string() + " (" + std::strerror(errno) + ")");
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file: " + path.string() + " (" + std::strerror(err) + ")");
+        }
+
+        auto size = static_cast<size_t>(st.st_size);
+        const uint8_t* data = nullptr;
+
+        // mmap rejects zero-length mappings, an empty file is just an empty span
+        if (size > 0)
+        {
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                int err = errno;
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path.string() + " (" + std::strerror(err) + ")");
+            }
+            data = static_cast<const uint8_t*>(addr);
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+
+        return std::shared_ptr<MappedFile>(new MappedFile(path, data, size));
+    }
+
+    MappedFile::MappedFile(std::filesystem::path path, const uint8_t* data, size_t size)
+        : path_(std::move(path)),
+        data_(data),
+        size_(size) {}
+
+    MappedFile::~MappedFile()
+    {
+        if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+} // namespace tc
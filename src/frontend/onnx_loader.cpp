@@ -1,17 +1,31 @@
 #include "frontend/onnx_loader.hpp"
+#include "frontend/mapped_file.hpp"
+#include "frontend/onnx_wire.hpp"
 #include "graph/attribute.hpp"
 
 #include "onnx.pb.h"
 
-#include <fstream>
+#include <google/protobuf/arena.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace tc
 {
 
-    static Attribute convertAttribute(const onnx::AttributeProto& ap);
+    struct ExternalData;
+    static Attribute convertAttribute(const onnx::AttributeProto& ap, ExternalData& external);
 
     static TensorShape shapeFromTypeProto(const onnx::TypeProto& tp)
     {
@@ -39,85 +53,261 @@ namespace tc
         return shape;
     }
 
+    // initializers above this many typed elements are decoded in chunks of kDecodeChunk
+    // elements, spread over worker threads
+    static constexpr size_t kDecodeChunk         = size_t{1} << 18;
+    static constexpr size_t kParallelDecodeLimit = size_t{1} << 20;
+
+    // elements stored in the typed field that holds `tp`'s data type, see onnx.proto
+    static size_t typedFieldSize(const onnx::TensorProto& tp)
+    {
+        switch (tp.data_type())
+        {
+            case onnx::TensorProto::FLOAT:  return tp.float_data_size();
+            case onnx::TensorProto::DOUBLE: return tp.double_data_size();
+            case onnx::TensorProto::INT64:  return tp.int64_data_size();
+
+            case onnx::TensorProto::INT32:
+            case onnx::TensorProto::INT16:
+            case onnx::TensorProto::INT8:
+            case onnx::TensorProto::UINT16:
+            case onnx::TensorProto::UINT8:
+            case onnx::TensorProto::BOOL:
+            case onnx::TensorProto::FLOAT16: return tp.int32_data_size();
+
+            case onnx::TensorProto::UINT32:
+            case onnx::TensorProto::UINT64: return tp.uint64_data_size();
+
+            default:                        return 0;
+        }
+    }
+
+    // same element type is a plain copy, narrower types are a loop the compiler vectorizes
+    template<typename Dst, typename Src>
+    static void convertRange(const Src* src, uint8_t* dst, size_t begin, size_t end)
+    {
+        if constexpr (std::is_same_v<Dst, Src>)
+        {
+            std::memcpy(dst + begin * sizeof(Dst), src + begin, (end - begin) * sizeof(Dst));
+        }
+        else
+        {
+            auto* out = reinterpret_cast<Dst*>(dst);
+            for (size_t i = begin; i < end; ++i)
+                out[i] = static_cast<Dst>(src[i]);
+        }
+    }
+
+    // decodes elements [begin, end) of `tp`'s typed field into `dst`
+    static void decodeTypedRange(const onnx::TensorProto& tp, uint8_t* dst, size_t begin, size_t end)
+    {
+        switch (tp.data_type())
+        {
+            case onnx::TensorProto::FLOAT:  convertRange<float>   (tp.float_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::DOUBLE: convertRange<double>  (tp.double_data().data(), dst, begin, end); break;
+            case onnx::TensorProto::INT64:  convertRange<int64_t> (tp.int64_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::INT32:  convertRange<int32_t> (tp.int32_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::INT16:  convertRange<int16_t> (tp.int32_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::INT8:   convertRange<int8_t>  (tp.int32_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::UINT16: convertRange<uint16_t>(tp.int32_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::UINT8:  convertRange<uint8_t> (tp.int32_data().data(),  dst, begin, end); break;
+            case onnx::TensorProto::BOOL:   convertRange<uint8_t> (tp.int32_data().data(),  dst, begin, end); break;
+            // the IEEE half bit pattern in the low 16 bits
+            case onnx::TensorProto::FLOAT16: convertRange<uint16_t>(tp.int32_data().data(), dst, begin, end); break;
+            case onnx::TensorProto::UINT32: convertRange<uint32_t>(tp.uint64_data().data(), dst, begin, end); break;
+            case onnx::TensorProto::UINT64: convertRange<uint64_t>(tp.uint64_data().data(), dst, begin, end); break;
+            default: break;
+        }
+    }
+
+    // output buffer for `tp`'s typed data, sized from its dims; elements the field doesn't
+    // provide stay zero
+    static std::vector<uint8_t> allocTypedData(const onnx::TensorProto& tp)
+    {
+        size_t elem_size = Tensor::dataTypeSize(dataTypeFromOnnx(tp.data_type()));
+        if (elem_size == 0 || typedFieldSize(tp) == 0) return {};
+
+        size_t elem_count = 1;
+        for (auto d : tp.dims()) elem_count *= d;
+
+        return std::vector<uint8_t>(elem_count * elem_size);
+    }
+
+    static size_t decodedElements(const onnx::TensorProto& tp, const std::vector<uint8_t>& data)
+    {
+        size_t elem_size = Tensor::dataTypeSize(dataTypeFromOnnx(tp.data_type()));
+        return elem_size ? std::min(typedFieldSize(tp), data.size() / elem_size) : 0;
+    }
+
     static std::vector<uint8_t> rawDataFromTensorProto(const onnx::TensorProto& tp)
     {
-        std::vector<uint8_t> data;
         if (!tp.raw_data().empty())
         {
             const auto& rd = tp.raw_data();
-            data.assign(
+            return std::vector<uint8_t>(
                 reinterpret_cast<const uint8_t*>(rd.data()),
                 reinterpret_cast<const uint8_t*>(rd.data()) + rd.size());
         }
 
+        auto data = allocTypedData(tp);
+        decodeTypedRange(tp, data.data(), 0, decodedElements(tp, data));
+        return data;
+    }
 
-        size_t elem_count = 1;
-        for (auto d : tp.dims()) elem_count *= d;
-
-        size_t elem_size = 0;
-    
-        switch (tp.data_type())
+    // runs fn(i) for every i in [0, n) on up to `workers` threads, rethrows the first failure
+    static void parallelFor(size_t n, size_t workers, const std::function<void(size_t)>& fn)
+    {
+        workers = std::min(workers, n);
+        if (workers <= 1)
         {
-            case onnx::TensorProto::FLOAT:
-            {
-                elem_size = sizeof(float);
-                data.resize(elem_count * elem_size);
-                float* ptr = reinterpret_cast<float*>(data.data());
+            for (size_t i = 0; i < n; ++i) fn(i);
+            return;
+        }
 
-                for (int i = 0; i < tp.float_data_size(); ++i)
-                    ptr[i] = tp.float_data(i);
+        std::atomic<size_t> next{0};
+        std::exception_ptr  error;
+        std::mutex          error_mutex;
 
-                break;
+        auto work = [&]
+        {
+            for (size_t i = next++; i < n; i = next++)
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = n;
+                }
             }
+        };
 
-            case onnx::TensorProto::INT32:
-            {
-                elem_size = sizeof(int32_t);
-                data.resize(elem_count * elem_size);
-                int32_t* ptr = reinterpret_cast<int32_t*>(data.data());
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t t = 1; t < workers; ++t) threads.emplace_back(work);
+        work();
+        for (auto& t : threads) t.join();
 
-                for (int i = 0; i < tp.int32_data_size(); ++i)
-                    ptr[i] = tp.int32_data(i);
+        if (error) std::rethrow_exception(error);
+    }
 
-                break;
-            }
-            
-            case onnx::TensorProto::INT64:
-            {
-                elem_size = sizeof(int64_t);
-                data.resize(elem_count * elem_size);
-                int64_t* ptr = reinterpret_cast<int64_t*>(data.data());
+    // initializer whose data sits in a typed field (float_data, int32_data, ...)
+    struct TypedInitializer
+    {
+        const onnx::TensorProto* proto;
+        std::shared_ptr<Tensor>  tensor;
+        std::vector<uint8_t>     data;
+    };
+
+    // decodes all typed initializers of a model, each tensor split into chunks so one large
+    // embedding table is spread over all threads as well
+    static void decodeTypedInitializers(std::vector<TypedInitializer>& pending)
+    {
+        struct Chunk { size_t item, begin, end; };
 
-                for (int i = 0; i < tp.int64_data_size(); ++i)
-                    ptr[i] = tp.int64_data(i);
+        std::vector<Chunk> chunks;
+        size_t total = 0;
 
-                break;
-            }
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            auto& item = pending[i];
+            item.data  = allocTypedData(*item.proto);
 
-            default:
-                break;
+            size_t count = decodedElements(*item.proto, item.data);
+            total += count;
+
+            for (size_t begin = 0; begin < count; begin += kDecodeChunk)
+                chunks.push_back({i, begin, std::min(count, begin + kDecodeChunk)});
         }
 
-        return data;
+        size_t workers = total < kParallelDecodeLimit ? 1 : std::max(1u, std::thread::hardware_concurrency());
+
+        parallelFor(chunks.size(), workers, [&](size_t c)
+        {
+            const auto& chunk = chunks[c];
+            auto& item = pending[chunk.item];
+            decodeTypedRange(*item.proto, item.data.data(), chunk.begin, chunk.end);
+        });
+
+        for (auto& item : pending)
+            item.tensor->setRawData(std::move(item.data));
     }
 
 
 
 
-    static std::shared_ptr<Tensor> tensorFromProto(const onnx::TensorProto& tp)
+    // external data files of one model, each mapped once and shared by the tensors of its
+    // graph and subgraphs
+    struct ExternalData
+    {
+        std::filesystem::path                                        model_dir;
+        std::unordered_map<std::string, std::shared_ptr<MappedFile>> files;
+    };
+
+    // binds an initializer stored with data_location = EXTERNAL to its bytes in the data file.
+    // Only the mapping is created here, pages are read when the data is first consumed
+    static void bindExternalData(Tensor& tensor, const onnx::TensorProto& tp, ExternalData& external)
+    {
+        std::string location;
+        std::optional<uint64_t> offset, length;
+
+        for (const auto& entry : tp.external_data())
+        {
+            try
+            {
+                if      (entry.key() == "location") location = entry.value();
+                else if (entry.key() == "offset")   offset   = std::stoull(entry.value());
+                else if (entry.key() == "length")   length   = std::stoull(entry.value());
+            }
+            catch (const std::logic_error&)
+            {
+                throw std::runtime_error("Invalid external_data '" + entry.key() + "' of tensor '" + tp.name() + "'");
+            }
+        }
+
+        if (location.empty())
+            throw std::runtime_error("External tensor '" + tp.name() + "' has no location");
+
+        // same rule as onnx.checker: data files live next to the model
+        std::filesystem::path rel(location);
+        if (rel.is_absolute() || std::find(rel.begin(), rel.end(), "..") != rel.end())
+            throw std::runtime_error("External data location of '" + tp.name() + "' escapes the model directory: " + location);
+
+        auto& file = external.files[location];
+        if (!file) file = MappedFile::open(external.model_dir / rel);
+
+        uint64_t begin = offset.value_or(0);
+        if (begin > file->size())
+            throw std::runtime_error("External data of '" + tp.name() + "' starts past the end of " + location);
+
+        // without a length the data runs to the end of the file
+        uint64_t size = length.value_or(file->size() - begin);
+        if (size > file->size() - begin)
+            throw std::runtime_error("External data of '" + tp.name() + "' runs past the end of " + location);
+
+        tensor.setRawDataView(file->bytes().subspan(begin, size), file);
+    }
+
+    static std::shared_ptr<Tensor> tensorFromProto(const onnx::TensorProto& tp, ExternalData& external)
     {
         auto shape = shapeFromTensorProto(tp);
         auto dtype = dataTypeFromOnnx(tp.data_type());
         auto tensor = std::make_shared<Tensor>(tp.name(), dtype, shape);
 
-        tensor->setRawData(rawDataFromTensorProto(tp));
+        if (tp.data_location() == onnx::TensorProto::EXTERNAL)
+            bindExternalData(*tensor, tp, external);
+        else
+            tensor->setRawData(rawDataFromTensorProto(tp));
         return tensor;
     }
 
 
 
 
-    static std::shared_ptr<Graph> graphFromProto(const onnx::GraphProto& gp)
+    static std::shared_ptr<Graph> graphFromProto(const onnx::GraphProto& gp, ExternalData& external)
     {
         auto graph = std::make_shared<Graph>(gp.name().empty() ? "subgraph" : gp.name());
         
@@ -136,13 +326,13 @@ namespace tc
             if (vi.type().has_tensor_type())
                 dtype = dataTypeFromOnnx(vi.type().tensor_type().elem_type());
 
-            graph->addTensor(std::make_shared<Tensor>(vi.name(), dtype, shape));
+            graph->addTensor(graph->createTensor(vi.name(), dtype, shape));
         }
         
 
         for (const auto& init : gp.initializer())
         {
-            auto tensor = tensorFromProto(init);
+            auto tensor = tensorFromProto(init, external);
             graph->addTensor(tensor);
         }
         
@@ -153,7 +343,7 @@ namespace tc
             auto dtype = DataType::UNDEFINED;
             if (vi.type().has_tensor_type())
                 dtype = dataTypeFromOnnx(vi.type().tensor_type().elem_type());
-            graph->addTensor(std::make_shared<Tensor>(vi.name(), dtype, shape));
+            graph->addTensor(graph->createTensor(vi.name(), dtype, shape));
         }
         
 
@@ -168,7 +358,7 @@ namespace tc
                 if (vi.type().has_tensor_type())
                     dtype = dataTypeFromOnnx(vi.type().tensor_type().elem_type());
 
-                graph->addTensor(std::make_shared<Tensor>(vi.name(), dtype, shape));
+                graph->addTensor(graph->createTensor(vi.name(), dtype, shape));
             }
         }
         
@@ -185,15 +375,13 @@ namespace tc
             std::vector<std::string> inputs(np.input().begin(), np.input().end());
             std::vector<std::string> outputs(np.output().begin(), np.output().end());
             
-            Node::AttributeMap attrs;
+            Node::AttributeList attrs;
+            attrs.reserve(np.attribute_size());
             for (const auto& ap : np.attribute())
-            {
-                auto attr = convertAttribute(ap);
-                attrs.emplace(attr.getName(), std::move(attr));
-            }
+                attrs.push_back(convertAttribute(ap, external));
             
             auto op = opTypeFromString(np.op_type());
-            auto node = std::make_shared<Node>(
+            auto node = graph->createNode(
                 node_name, op, np.op_type(),
                 std::move(inputs), std::move(outputs),
                 std::move(attrs)
@@ -205,7 +393,7 @@ namespace tc
     }
 
 
-    static Attribute convertAttribute(const onnx::AttributeProto& ap)
+    static Attribute convertAttribute(const onnx::AttributeProto& ap, ExternalData& external)
     {
         const auto& name = ap.name();
 
@@ -223,13 +411,13 @@ namespace tc
 
             case onnx::AttributeProto::TENSOR:
             {
-                auto tensor = tensorFromProto(ap.t());
+                auto tensor = tensorFromProto(ap.t(), external);
                 return {name, AttributeType::TENSOR, std::move(tensor)};
             }
 
             case onnx::AttributeProto::GRAPH:
             {
-                auto subgraph = graphFromProto(ap.g());
+                auto subgraph = graphFromProto(ap.g(), external);
                 return {name, AttributeType::GRAPH, std::move(subgraph)};
             }
 
@@ -265,7 +453,7 @@ namespace tc
                 std::vector<std::shared_ptr<Tensor>> tensors;
                 tensors.reserve(ap.tensors_size());
                 for (const auto& tp : ap.tensors())
-                    tensors.push_back(tensorFromProto(tp));
+                    tensors.push_back(tensorFromProto(tp, external));
                 return {name, AttributeType::TENSORS, std::move(tensors)};
             }
 
@@ -274,7 +462,7 @@ namespace tc
                 std::vector<std::shared_ptr<Graph>> graphs;
                 graphs.reserve(ap.graphs_size());
                 for (const auto& gp : ap.graphs())
-                    graphs.push_back(graphFromProto(gp));
+                    graphs.push_back(graphFromProto(gp, external));
                 return {name, AttributeType::GRAPHS, std::move(graphs)};
             }
 
@@ -297,33 +485,55 @@ namespace tc
     }
 
 
-    std::shared_ptr<Graph> OnnxLoader::load(const std::filesystem::path& path) const
+    // state kept between parsing a model and building its graph
+    struct OnnxSession::Parsed
+    {
+        std::shared_ptr<MappedFile> file;
+        SplitModel                  split;
+        google::protobuf::Arena     arena;
+        onnx::ModelProto*           model{nullptr};
+    };
+
+    static std::shared_ptr<Graph> graphFromModel(const onnx::ModelProto&            model,
+                                                 const SplitModel&                  split,
+                                                 const std::shared_ptr<MappedFile>& file,
+                                                 const std::filesystem::path&       path)
     {
-        std::ifstream ifs(path, std::ios::binary);
-        if (!ifs)
-            throw std::runtime_error("Cannot open file: " + path.string());
-
-        GOOGLE_PROTOBUF_VERIFY_VERSION;
-
-        onnx::ModelProto model;
-        if (!model.ParseFromIstream(&ifs))
-            throw std::runtime_error("Failed to parse ONNX model: " + path.string());
-
         const auto& gp = model.graph();
         auto graph = std::make_shared<Graph>(
             gp.name().empty() ? "onnx_graph" : gp.name());
 
+        if (static_cast<size_t>(gp.initializer_size()) != split.raw_data.size())
+            throw std::runtime_error("Inconsistent initializers in ONNX model: " + path.string());
+
+        // about one new tensor per node output, most nodes have one
+        graph->reserve(gp.node_size(),
+                       gp.initializer_size() + gp.input_size() + gp.value_info_size() +
+                       gp.output_size() + gp.node_size());
+
+        ExternalData                    external{path.parent_path(), {}};
+        std::vector<TypedInitializer>   typed;
         std::unordered_set<std::string> initializer_names;
-        for (const auto& init : gp.initializer())
+        for (int i = 0; i < gp.initializer_size(); ++i)
         {
+            const auto& init = gp.initializer(i);
             initializer_names.insert(init.name());
             auto shape  = shapeFromTensorProto(init);
             auto dtype  = dataTypeFromOnnx(init.data_type());
-            auto tensor = std::make_shared<Tensor>(init.name(), dtype, shape);
-            tensor->setRawData(rawDataFromTensorProto(init));
+            auto tensor = graph->createTensor(init.name(), dtype, shape);
+
+            if (init.data_location() == onnx::TensorProto::EXTERNAL)
+                bindExternalData(*tensor, init, external);
+            else if (!split.raw_data[i].empty())
+                tensor->setRawDataView(split.raw_data[i], file);
+            else
+                typed.push_back({&init, tensor, {}});
+
             graph->addTensor(std::move(tensor));
         }
 
+        decodeTypedInitializers(typed);
+
         for (const auto& vi : gp.input())
         {
             if (initializer_names.contains(vi.name())) continue;
@@ -333,7 +543,7 @@ namespace tc
             if (vi.type().has_tensor_type())
                 dtype = dataTypeFromOnnx(vi.type().tensor_type().elem_type());
             if (!graph->findTensor(vi.name()))
-                graph->addTensor(std::make_shared<Tensor>(vi.name(), dtype, shape));
+                graph->addTensor(graph->createTensor(vi.name(), dtype, shape));
         }
 
         auto addValueInfo = [&](const onnx::ValueInfoProto& vi)
@@ -343,7 +553,7 @@ namespace tc
             auto dtype = DataType::UNDEFINED;
             if (vi.type().has_tensor_type())
                 dtype = dataTypeFromOnnx(vi.type().tensor_type().elem_type());
-            graph->addTensor(std::make_shared<Tensor>(vi.name(), dtype, shape));
+            graph->addTensor(graph->createTensor(vi.name(), dtype, shape));
         };
 
         for (const auto& vi : gp.value_info()) addValueInfo(vi);
@@ -363,15 +573,13 @@ namespace tc
             std::vector<std::string> inputs(np.input().begin(),  np.input().end());
             std::vector<std::string> outputs(np.output().begin(), np.output().end());
 
-            Node::AttributeMap attrs;
+            Node::AttributeList attrs;
+            attrs.reserve(np.attribute_size());
             for (const auto& ap : np.attribute())
-            {
-                auto attr = convertAttribute(ap);
-                attrs.emplace(attr.getName(), std::move(attr));
-            }
+                attrs.push_back(convertAttribute(ap, external));
 
             auto op   = opTypeFromString(np.op_type());
-            auto node = std::make_shared<Node>(
+            auto node = graph->createNode(
                 node_name, op, np.op_type(),
                 std::move(inputs), std::move(outputs),
                 std::move(attrs));
@@ -381,24 +589,103 @@ namespace tc
         return graph;
     }
 
+    OnnxSession::OnnxSession(const std::filesystem::path& path)
+        : path_(path),
+        parsed_(std::make_unique<Parsed>())
+    {
+        GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+        // initializer raw_data is cut out of the wire bytes before parsing and referenced
+        // in place, only the small remainder of the model goes through protobuf
+        parsed_->file  = MappedFile::open(path);
+        parsed_->split = splitInitializerData(parsed_->file->bytes());
+
+        const auto& skeleton = parsed_->split.skeleton;
+        if (skeleton.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+            throw std::runtime_error("ONNX model metadata exceeds 2 GB: " + path.string());
+
+        parsed_->model = google::protobuf::Arena::Create<onnx::ModelProto>(&parsed_->arena);
+        if (!parsed_->model->ParseFromArray(skeleton.data(), static_cast<int>(skeleton.size())))
+            throw std::runtime_error("Failed to parse ONNX model: " + path.string());
+
+        const auto& model = *parsed_->model;
+        info_.ir_version       = model.ir_version();
+        info_.producer_name    = model.producer_name();
+        info_.producer_version = model.producer_version();
+        info_.domain           = model.domain();
+        info_.model_version    = model.model_version();
+        info_.doc_string       = model.doc_string();
+        info_.graph_name       = model.graph().name();
+    }
+
+    OnnxSession::~OnnxSession() = default;
+
+    std::shared_ptr<Graph> OnnxSession::graph()
+    {
+        if (graph_) return graph_;
+
+        graph_ = graphFromModel(*parsed_->model, parsed_->split, parsed_->file, path_);
+
+        // tensors keep the mapping alive on their own, the parsed proto is no longer needed
+        parsed_.reset();
+        return graph_;
+    }
+
+    std::shared_ptr<Graph> OnnxLoader::load(const std::filesystem::path& path) const
+    {
+        return OnnxSession(path).graph();
+    }
+
     OnnxLoader::ModelInfo OnnxLoader::readModelInfo(const std::filesystem::path& path)
     {
-        std::ifstream ifs(path, std::ios::binary);
-        if (!ifs)
-            throw std::runtime_error("Cannot open file: " + path.string());
+        // field numbers from onnx.proto
+        enum : uint32_t
+        {
+            kIrVersion       = 1,
+            kProducerName    = 2,
+            kProducerVersion = 3,
+            kDomain          = 4,
+            kModelVersion    = 5,
+            kDocString       = 6,
+            kGraph           = 7,
+            kGraphName       = 2,
+        };
 
-        onnx::ModelProto model;
-        if (!model.ParseFromIstream(&ifs))
-            throw std::runtime_error("Failed to parse ONNX model");
+        auto file = MappedFile::open(path);
 
         ModelInfo info;
-        info.ir_version       = model.ir_version();
-        info.producer_name    = model.producer_name();
-        info.producer_version = model.producer_version();
-        info.domain           = model.domain();
-        info.model_version    = model.model_version();
-        info.doc_string       = model.doc_string();
-        info.graph_name       = model.graph().name();
+        WireReader reader(file->bytes());
+
+        while (!reader.atEnd())
+        {
+            auto f = reader.next();
+
+            switch (f.number)
+            {
+                case kIrVersion:       info.ir_version       = static_cast<int64_t>(f.value); break;
+                case kProducerName:    info.producer_name    = f.asString(); break;
+                case kProducerVersion: info.producer_version = f.asString(); break;
+                case kDomain:          info.domain           = f.asString(); break;
+                case kModelVersion:    info.model_version    = static_cast<int64_t>(f.value); break;
+                case kDocString:       info.doc_string       = f.asString(); break;
+
+                case kGraph:
+                {
+                    // only the name, nodes and initializers are stepped over by their length
+                    WireReader graph(f.payload);
+                    while (!graph.atEnd())
+                    {
+                        auto g = graph.next();
+                        if (g.number == kGraphName && g.type == WireType::LEN) info.graph_name = g.asString();
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
         return info;
     }
 
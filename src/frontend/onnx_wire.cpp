@@ -0,0 +1,161 @@
+#include "frontend/onnx_wire.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace tc
+{
+
+    // field numbers from onnx.proto
+    static constexpr uint32_t kModelGraph       = 7;
+    static constexpr uint32_t kGraphInitializer = 5;
+    static constexpr uint32_t kTensorRawData    = 9;
+
+    WireField WireReader::next()
+    {
+        WireField f;
+        const uint8_t* start = pos_;
+
+        uint64_t tag = readVarint();
+        f.number = static_cast<uint32_t>(tag >> 3);
+        f.type   = static_cast<WireType>(tag & 7);
+
+        switch (f.type)
+        {
+            case WireType::VARINT:
+                f.value = readVarint();
+                break;
+
+            case WireType::FIXED64:
+                f.payload = take(8);
+                break;
+
+            case WireType::FIXED32:
+                f.payload = take(4);
+                break;
+
+            case WireType::LEN:
+            {
+                uint64_t len = readVarint();
+                if (len > static_cast<uint64_t>(end_ - pos_))
+                    throw std::runtime_error("Malformed ONNX model: field length past end of message");
+                f.payload = take(static_cast<size_t>(len));
+                break;
+            }
+
+            default:
+                throw std::runtime_error("Malformed ONNX model: unsupported wire type " + std::to_string(static_cast<uint32_t>(f.type)));
+        }
+
+        f.encoded = {start, static_cast<size_t>(pos_ - start)};
+        return f;
+    }
+
+    uint64_t WireReader::readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos_ == end_)
+                throw std::runtime_error("Malformed ONNX model: truncated varint");
+
+            uint8_t b = *pos_++;
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed ONNX model: varint too long");
+    }
+
+    std::span<const uint8_t> WireReader::take(size_t n)
+    {
+        if (n > static_cast<size_t>(end_ - pos_))
+            throw std::runtime_error("Malformed ONNX model: truncated field");
+
+        std::span<const uint8_t> bytes(pos_, n);
+        pos_ += n;
+        return bytes;
+    }
+
+
+
+
+    static void appendVarint(std::string& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out += static_cast<char>((v & 0x7F) | 0x80);
+            v >>= 7;
+        }
+        out += static_cast<char>(v);
+    }
+
+    static void appendBytes(std::string& out, std::span<const uint8_t> bytes)
+    {
+        out.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    static void appendMessage(std::string& out, uint32_t number, const std::string& body)
+    {
+        appendVarint(out, (static_cast<uint64_t>(number) << 3) | static_cast<uint64_t>(WireType::LEN));
+        appendVarint(out, body.size());
+        out += body;
+    }
+
+
+
+
+    static std::string stripTensor(std::span<const uint8_t> tensor, std::span<const uint8_t>& raw_data)
+    {
+        std::string out;
+        WireReader reader(tensor);
+
+        while (!reader.atEnd())
+        {
+            auto f = reader.next();
+            // a repeated scalar field keeps the last value, as in the generated parser
+            if (f.number == kTensorRawData && f.type == WireType::LEN) raw_data = f.payload;
+            else appendBytes(out, f.encoded);
+        }
+
+        return out;
+    }
+
+    static std::string stripGraph(std::span<const uint8_t> graph, std::vector<std::span<const uint8_t>>& raw_data)
+    {
+        std::string out;
+        WireReader reader(graph);
+
+        while (!reader.atEnd())
+        {
+            auto f = reader.next();
+            if (f.number == kGraphInitializer && f.type == WireType::LEN)
+            {
+                std::span<const uint8_t> raw;
+                appendMessage(out, f.number, stripTensor(f.payload, raw));
+                raw_data.push_back(raw);
+            }
+            else appendBytes(out, f.encoded);
+        }
+
+        return out;
+    }
+
+    SplitModel splitInitializerData(std::span<const uint8_t> model)
+    {
+        SplitModel split;
+        WireReader reader(model);
+
+        while (!reader.atEnd())
+        {
+            auto f = reader.next();
+            // several graph fields are merged by protobuf, initializers simply concatenate
+            if (f.number == kModelGraph && f.type == WireType::LEN)
+                appendMessage(split.skeleton, f.number, stripGraph(f.payload, split.raw_data));
+            else
+                appendBytes(split.skeleton, f.encoded);
+        }
+
+        return split;
+    }
+
+} // namespace tc
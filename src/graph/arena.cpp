@@ -0,0 +1,12 @@
+#include "graph/arena.hpp"
+
+namespace tc
+{
+
+    GraphArena::~GraphArena()
+    {
+        for (auto it = dtors_.rbegin(); it != dtors_.rend(); ++it)
+            it->destroy(it->obj);
+    }
+
+} // namespace tc
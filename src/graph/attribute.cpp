@@ -3,10 +3,80 @@
 #include "graph/graph.hpp"
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace tc
 {
 
+    AttrKey attrKeyFromString(std::string_view s)
+    {
+        static const std::unordered_map<std::string_view, AttrKey> table = {
+            {"alpha",               AttrKey::Alpha},
+            {"beta",                AttrKey::Beta},
+            {"transA",              AttrKey::TransA},
+            {"transB",              AttrKey::TransB},
+            {"axis",                AttrKey::Axis},
+            {"axes",                AttrKey::Axes},
+            {"start",               AttrKey::Start},
+            {"end",                 AttrKey::End},
+            {"allowzero",           AttrKey::AllowZero},
+            {"kernel_shape",        AttrKey::KernelShape},
+            {"strides",             AttrKey::Strides},
+            {"pads",                AttrKey::Pads},
+            {"dilations",           AttrKey::Dilations},
+            {"group",               AttrKey::Group},
+            {"auto_pad",            AttrKey::AutoPad},
+            {"epsilon",             AttrKey::Epsilon},
+            {"ceil_mode",           AttrKey::CeilMode},
+            {"count_include_pad",   AttrKey::CountIncludePad},
+            {"storage_order",       AttrKey::StorageOrder},
+            {"keepdims",            AttrKey::KeepDims},
+            {"perm",                AttrKey::Perm},
+            {"approximate",         AttrKey::Approximate},
+            {"min",                 AttrKey::Min},
+            {"max",                 AttrKey::Max},
+            {"value",               AttrKey::Value},
+            {"to",                  AttrKey::To},
+        };
+
+        auto it = table.find(s);
+        return (it != table.end()) ? it->second : AttrKey::Other;
+    }
+
+    std::string attrKeyToString(AttrKey key)
+    {
+        switch (key)
+        {
+            case AttrKey::Alpha:            return "alpha";
+            case AttrKey::Beta:             return "beta";
+            case AttrKey::TransA:           return "transA";
+            case AttrKey::TransB:           return "transB";
+            case AttrKey::Axis:             return "axis";
+            case AttrKey::Axes:             return "axes";
+            case AttrKey::Start:            return "start";
+            case AttrKey::End:              return "end";
+            case AttrKey::AllowZero:        return "allowzero";
+            case AttrKey::KernelShape:      return "kernel_shape";
+            case AttrKey::Strides:          return "strides";
+            case AttrKey::Pads:             return "pads";
+            case AttrKey::Dilations:        return "dilations";
+            case AttrKey::Group:            return "group";
+            case AttrKey::AutoPad:          return "auto_pad";
+            case AttrKey::Epsilon:          return "epsilon";
+            case AttrKey::CeilMode:         return "ceil_mode";
+            case AttrKey::CountIncludePad:  return "count_include_pad";
+            case AttrKey::StorageOrder:     return "storage_order";
+            case AttrKey::KeepDims:         return "keepdims";
+            case AttrKey::Perm:             return "perm";
+            case AttrKey::Approximate:      return "approximate";
+            case AttrKey::Min:              return "min";
+            case AttrKey::Max:              return "max";
+            case AttrKey::Value:            return "value";
+            case AttrKey::To:               return "to";
+            default:                        return "other";
+        }
+    }
+
     float Attribute::asFloat() const
     {
         if (const auto* v = std::get_if<float>(&value_)) return *v;
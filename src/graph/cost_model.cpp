@@ -0,0 +1,560 @@
+#include "graph/cost_model.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace tc
+{
+
+    MachineModel machineModelFromString(std::string_view spec)
+    {
+        auto comma = spec.find(',');
+        if (comma == std::string_view::npos)
+            throw std::runtime_error("Bad roofline '" + std::string(spec) + "', expected <GFLOP/s>,<GB/s>");
+
+        MachineModel m;
+        try
+        {
+            m.peak_gflops       = std::stod(std::string(spec.substr(0, comma)));
+            m.mem_bandwidth_gbs = std::stod(std::string(spec.substr(comma + 1)));
+        }
+        catch (const std::logic_error&)
+        {
+            throw std::runtime_error("Bad roofline '" + std::string(spec) + "', expected <GFLOP/s>,<GB/s>");
+        }
+
+        if (m.peak_gflops <= 0.0 || m.mem_bandwidth_gbs <= 0.0)
+            throw std::runtime_error("Roofline peak and bandwidth must be positive");
+        return m;
+    }
+
+
+    // a tensor's shape as far as it is known, declared or inferred
+    struct ShapeInfo
+    {
+        std::vector<int64_t> dims;
+        DataType             dtype = DataType::UNDEFINED;
+        bool                 known = false;
+    };
+
+    // elements with dynamic dimensions counted as 1
+    static uint64_t elementCount(const std::vector<int64_t>& dims)
+    {
+        uint64_t n = 1;
+        for (auto d : dims)
+            if (d > 0) n *= static_cast<uint64_t>(d);
+        return n;
+    }
+
+    static bool isDynamic(const std::vector<int64_t>& dims)
+    {
+        return std::any_of(dims.begin(), dims.end(), [](int64_t d) { return d < 0; });
+    }
+
+    static uint64_t byteCount(const ShapeInfo& s)
+    {
+        return s.known ? elementCount(s.dims) * Tensor::dataTypeSize(s.dtype) : 0;
+    }
+
+    // numpy broadcasting, a dynamic dimension against n > 1 is n
+    static std::vector<int64_t> broadcastDims(const std::vector<int64_t>& a, const std::vector<int64_t>& b)
+    {
+        size_t rank = std::max(a.size(), b.size());
+        std::vector<int64_t> out(rank);
+        for (size_t i = 0; i < rank; ++i)
+        {
+            int64_t da = i < rank - a.size() ? 1 : a[i - (rank - a.size())];
+            int64_t db = i < rank - b.size() ? 1 : b[i - (rank - b.size())];
+            if (da == 1)       out[i] = db;
+            else if (db == 1)  out[i] = da;
+            else if (da < 0)   out[i] = db;
+            else if (db < 0 || da == db) out[i] = da;
+            else throw std::runtime_error("Incompatible broadcast dimensions " +
+                                          std::to_string(da) + " and " + std::to_string(db));
+        }
+        return out;
+    }
+
+    static int64_t normalizeAxis(int64_t axis, size_t rank)
+    {
+        return axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+    }
+
+
+    // Per node: fills in the output shapes that are not declared and returns the FLOPs
+    class CostEstimator
+    {
+    public:
+        explicit CostEstimator(const Graph& graph) : graph_(graph), shapes_(graph.numTensorIds())
+        {
+            for (TensorId t = 0; t < graph.numTensorIds(); ++t)
+            {
+                const auto* tensor = graph.tensor(t);
+                // an empty shape without data is "no shape" in a value_info, not a scalar
+                if (!tensor || (tensor->getShape().dims.empty() && !tensor->hasData())) continue;
+                shapes_[t] = {tensor->getShape().dims, tensor->getDtype(), true};
+            }
+        }
+
+        NodeCost estimate(NodeId id)
+        {
+            const Node& node = *graph_.getNodes()[id];
+            auto inputs  = graph_.nodeInputs(id);
+            auto outputs = graph_.nodeOutputs(id);
+
+            NodeCost cost;
+            cost.node = id;
+            exact_ = true;
+
+            uint64_t flops = 0;
+            bool metadata_only = false;
+            switch (node.getOpType())
+            {
+                case OpType::Add:
+                case OpType::Mul:
+                    flops = elementwise(inputs, outputs);
+                    break;
+                case OpType::Relu:
+                case OpType::Tanh:
+                case OpType::Erf:
+                case OpType::Exp:
+                    flops = unary(inputs, outputs);
+                    break;
+                // counting a transcendental as one flop, plus the arithmetic around it
+                case OpType::Sigmoid:
+                    flops = 3 * unary(inputs, outputs);
+                    break;
+                case OpType::Swish:
+                case OpType::HardSwish:
+                    flops = 4 * unary(inputs, outputs);
+                    break;
+                case OpType::Gelu:
+                    flops = 5 * unary(inputs, outputs);
+                    break;
+                case OpType::Softmax:
+                case OpType::LogSoftmax:
+                    // max, 2 exps, 2 subs and a multiply-add reducing, sub, exp and div normalizing
+                    flops = 9 * unary(inputs, outputs);
+                    break;
+                case OpType::LayerNormalization:
+                    // Welford's add, 2 subs, div and multiply-add, then sub, 2 muls and add
+                    flops = 10 * unary(inputs, outputs);
+                    break;
+                case OpType::MatMul:
+                    flops = matMul(inputs, outputs);
+                    break;
+                case OpType::Gemm:
+                    flops = gemm(node, inputs, outputs);
+                    break;
+                case OpType::Conv:
+                    flops = conv(node, inputs, outputs);
+                    break;
+                case OpType::MaxPool:
+                case OpType::AveragePool:
+                    flops = pool(node, inputs, outputs);
+                    break;
+                case OpType::GlobalAveragePool:
+                    flops = globalPool(inputs, outputs);
+                    break;
+                case OpType::Concat:
+                    concat(node, inputs, outputs);
+                    break;
+                case OpType::Shape:
+                    shape(inputs, outputs);
+                    metadata_only = true;
+                    break;
+                case OpType::Reshape:
+                    reshape(node, inputs, outputs);
+                    metadata_only = true;
+                    break;
+                default:
+                    exact_ = false;
+                    break;
+            }
+            cost.flops = flops;
+
+            // Shape and Reshape only touch metadata, the data is not read or copied
+            if (!metadata_only)
+            {
+                for (auto t : inputs)
+                {
+                    if (t == kNoTensor) continue;
+                    if (!shapes_[t].known) { exact_ = false; continue; }
+
+                    const auto* tensor = graph_.tensor(t);
+                    if (tensor && tensor->hasData())
+                        cost.weight_bytes += tensor->getRawData().size();
+                    else
+                        cost.activation_bytes += byteCount(shapes_[t]);
+                }
+                for (auto t : outputs)
+                {
+                    if (t == kNoTensor) continue;
+                    if (!shapes_[t].known) { exact_ = false; continue; }
+                    cost.activation_bytes += byteCount(shapes_[t]);
+                }
+            }
+
+            for (auto ids : {inputs, outputs})
+                for (auto t : ids)
+                    if (t != kNoTensor && shapes_[t].known && isDynamic(shapes_[t].dims)) exact_ = false;
+
+            cost.exact = exact_;
+            return cost;
+        }
+
+    private:
+        const ShapeInfo* known(std::span<const TensorId> ids, size_t i)
+        {
+            if (i >= ids.size() || ids[i] == kNoTensor || !shapes_[ids[i]].known)
+            {
+                exact_ = false;
+                return nullptr;
+            }
+            return &shapes_[ids[i]];
+        }
+
+        // declared shapes win over inferred ones, except for their dynamic dimensions
+        void setOutput(std::span<const TensorId> outputs, std::vector<int64_t> dims, DataType dtype)
+        {
+            if (outputs.empty() || outputs[0] == kNoTensor) return;
+            auto& s = shapes_[outputs[0]];
+            if (!s.known)
+            {
+                s = {std::move(dims), dtype, true};
+                return;
+            }
+            if (s.dims.size() != dims.size()) return;
+            for (size_t i = 0; i < dims.size(); ++i)
+                if (s.dims[i] < 0) s.dims[i] = dims[i];
+        }
+
+        uint64_t outputElements(std::span<const TensorId> outputs)
+        {
+            auto* out = known(outputs, 0);
+            return out ? elementCount(out->dims) : 0;
+        }
+
+        uint64_t elementwise(std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* a = known(inputs, 0);
+            auto* b = known(inputs, 1);
+            if (a && b) setOutput(outputs, broadcastDims(a->dims, b->dims), a->dtype);
+            return outputElements(outputs);
+        }
+
+        uint64_t unary(std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            if (auto* x = known(inputs, 0)) setOutput(outputs, x->dims, x->dtype);
+            return outputElements(outputs);
+        }
+
+        // 2 * batch * M * N * K, with ONNX's 1-D promotion and broadcast batch dims
+        uint64_t matMul(std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* a = known(inputs, 0);
+            auto* b = known(inputs, 1);
+            if (!a || !b || a->dims.empty() || b->dims.empty()) return 0;
+
+            auto ad = a->dims;
+            auto bd = b->dims;
+            bool a_vec = ad.size() == 1, b_vec = bd.size() == 1;
+            if (a_vec) ad.insert(ad.begin(), 1);
+            if (b_vec) bd.push_back(1);
+
+            int64_t m = ad[ad.size() - 2], k = ad.back(), n = bd.back();
+            auto batch = broadcastDims({ad.begin(), ad.end() - 2}, {bd.begin(), bd.end() - 2});
+
+            auto out = batch;
+            if (!a_vec) out.push_back(m);
+            if (!b_vec) out.push_back(n);
+            setOutput(outputs, out, a->dtype);
+
+            return 2 * elementCount(batch) * elementCount({m, n, k});
+        }
+
+        // alpha * A' * B' + beta * C
+        uint64_t gemm(const Node& node, std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* a = known(inputs, 0);
+            auto* b = known(inputs, 1);
+            if (!a || !b || a->dims.size() != 2 || b->dims.size() != 2) return 0;
+
+            bool trans_a = node.attributeOr<int64_t>(AttrKey::TransA, 0) != 0;
+            bool trans_b = node.attributeOr<int64_t>(AttrKey::TransB, 0) != 0;
+            int64_t m = a->dims[trans_a ? 1 : 0], k = a->dims[trans_a ? 0 : 1];
+            int64_t n = b->dims[trans_b ? 0 : 1];
+            setOutput(outputs, {m, n}, a->dtype);
+
+            uint64_t mn = elementCount({m, n});
+            uint64_t flops = 2 * mn * elementCount({k});
+            if (node.attributeOr<float>(AttrKey::Alpha, 1.0f) != 1.0f) flops += mn;
+            if (inputs.size() >= 3 && inputs[2] != kNoTensor)
+            {
+                flops += mn;
+                if (node.attributeOr<float>(AttrKey::Beta, 1.0f) != 1.0f) flops += mn;
+            }
+            return flops;
+        }
+
+        // 2 * N * C_out * spatial_out * (C_in / group) * kernel, plus the bias add
+        uint64_t conv(const Node& node, std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* x = known(inputs, 0);
+            auto* w = known(inputs, 1);
+            if (!x || !w || x->dims.size() < 3 || w->dims.size() != x->dims.size()) return 0;
+
+            using Ints = std::vector<int64_t>;
+            const size_t spatial = x->dims.size() - 2;
+
+            Ints kernel = node.attributeOr<Ints>(AttrKey::KernelShape, {});
+            if (kernel.empty()) kernel.assign(w->dims.begin() + 2, w->dims.end());
+            Ints strides   = node.attributeOr<Ints>(AttrKey::Strides,   Ints(spatial, 1));
+            Ints dilations = node.attributeOr<Ints>(AttrKey::Dilations, Ints(spatial, 1));
+            Ints pads      = node.attributeOr<Ints>(AttrKey::Pads,      Ints(2 * spatial, 0));
+            int64_t group  = node.attributeOr<int64_t>(AttrKey::Group, 1);
+
+            const auto* auto_pad_attr = node.findAttribute(AttrKey::AutoPad);
+            std::string_view auto_pad = auto_pad_attr ? std::string_view(auto_pad_attr->asString()) : "NOTSET";
+
+            if (kernel.size() != spatial || strides.size() != spatial ||
+                dilations.size() != spatial || pads.size() != 2 * spatial || group <= 0)
+                throw std::runtime_error("Conv '" + node.getName() + "' has inconsistent attributes");
+
+            Ints out = {x->dims[0], w->dims[0]};
+            for (size_t i = 0; i < spatial; ++i)
+            {
+                int64_t in = x->dims[2 + i];
+                if (in < 0) { out.push_back(-1); continue; }
+
+                int64_t extent = dilations[i] * (kernel[i] - 1) + 1;
+                if (auto_pad == "SAME_UPPER" || auto_pad == "SAME_LOWER")
+                    out.push_back((in + strides[i] - 1) / strides[i]);
+                else if (auto_pad == "VALID")
+                    out.push_back((in - extent) / strides[i] + 1);
+                else
+                    out.push_back((in + pads[i] + pads[i + spatial] - extent) / strides[i] + 1);
+            }
+            setOutput(outputs, out, x->dtype);
+
+            int64_t c_in = x->dims[1] > 0 ? x->dims[1] : w->dims[1] * group;
+            uint64_t out_elems = elementCount(out);
+            uint64_t macs = out_elems * elementCount({c_in / group}) * elementCount(kernel);
+
+            uint64_t flops = 2 * macs;
+            if (inputs.size() >= 3 && inputs[2] != kNoTensor) flops += out_elems;
+            return flops;
+        }
+
+        // a compare or add per window element, plus the division of AveragePool
+        uint64_t pool(const Node& node, std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* x = known(inputs, 0);
+            if (!x || x->dims.size() < 3) return 0;
+
+            using Ints = std::vector<int64_t>;
+            const size_t spatial = x->dims.size() - 2;
+
+            Ints kernel    = node.attributeOr<Ints>(AttrKey::KernelShape, {});
+            Ints strides   = node.attributeOr<Ints>(AttrKey::Strides,   Ints(spatial, 1));
+            Ints dilations = node.attributeOr<Ints>(AttrKey::Dilations, Ints(spatial, 1));
+            Ints pads      = node.attributeOr<Ints>(AttrKey::Pads,      Ints(2 * spatial, 0));
+            bool ceil_mode = node.attributeOr<int64_t>(AttrKey::CeilMode, 0) != 0;
+
+            const auto* auto_pad_attr = node.findAttribute(AttrKey::AutoPad);
+            std::string_view auto_pad = auto_pad_attr ? std::string_view(auto_pad_attr->asString()) : "NOTSET";
+
+            if (kernel.size() != spatial || strides.size() != spatial ||
+                dilations.size() != spatial || pads.size() != 2 * spatial)
+                throw std::runtime_error("Pool '" + node.getName() + "' has inconsistent attributes");
+
+            Ints out = {x->dims[0], x->dims[1]};
+            for (size_t i = 0; i < spatial; ++i)
+            {
+                int64_t in = x->dims[2 + i];
+                if (in < 0) { out.push_back(-1); continue; }
+
+                int64_t extent = dilations[i] * (kernel[i] - 1) + 1;
+                if (auto_pad == "SAME_UPPER" || auto_pad == "SAME_LOWER")
+                {
+                    out.push_back((in + strides[i] - 1) / strides[i]);
+                    continue;
+                }
+
+                int64_t span = in - extent + (auto_pad == "VALID" ? 0 : pads[i] + pads[i + spatial]);
+                int64_t o    = (ceil_mode ? (span + strides[i] - 1) / strides[i] : span / strides[i]) + 1;
+                // a window starting in the end padding is dropped
+                if (ceil_mode && (o - 1) * strides[i] >= in + (auto_pad == "VALID" ? 0 : pads[i])) --o;
+                out.push_back(o);
+            }
+            setOutput(outputs, out, x->dtype);
+
+            uint64_t out_elems = elementCount(out);
+            uint64_t flops = out_elems * elementCount(kernel);
+            if (node.getOpType() == OpType::AveragePool) flops += out_elems;
+            return flops;
+        }
+
+        // N x C x 1 x 1 ..., an add per input element and a division per channel
+        uint64_t globalPool(std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* x = known(inputs, 0);
+            if (!x || x->dims.size() < 3) return 0;
+
+            std::vector<int64_t> out(x->dims.size(), 1);
+            out[0] = x->dims[0];
+            out[1] = x->dims[1];
+            setOutput(outputs, out, x->dtype);
+            return elementCount(x->dims) + elementCount(out);
+        }
+
+        void concat(const Node& node, std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* first = known(inputs, 0);
+            if (!first) return;
+
+            auto out = first->dims;
+            int64_t axis = normalizeAxis(node.attributeOr<int64_t>(AttrKey::Axis, 0), out.size());
+            if (axis < 0 || axis >= static_cast<int64_t>(out.size())) return;
+
+            for (size_t i = 1; i < inputs.size(); ++i)
+            {
+                auto* s = known(inputs, i);
+                if (!s || s->dims.size() != out.size()) return;
+                int64_t d = s->dims[axis];
+                out[axis] = (out[axis] < 0 || d < 0) ? -1 : out[axis] + d;
+            }
+            setOutput(outputs, out, first->dtype);
+        }
+
+        void shape(std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            if (auto* x = known(inputs, 0))
+                setOutput(outputs, {static_cast<int64_t>(x->dims.size())}, DataType::INT64);
+        }
+
+        // only with a constant target shape
+        void reshape(const Node& node, std::span<const TensorId> inputs, std::span<const TensorId> outputs)
+        {
+            auto* data = known(inputs, 0);
+            const auto* target = inputs.size() >= 2 && inputs[1] != kNoTensor ? graph_.tensor(inputs[1]) : nullptr;
+            if (!data || !target || !target->hasData() || target->getDtype() != DataType::INT64)
+            {
+                exact_ = false;
+                return;
+            }
+
+            auto raw = target->getRawData();
+            std::vector<int64_t> out(raw.size() / sizeof(int64_t));
+            if (!out.empty()) std::memcpy(out.data(), raw.data(), out.size() * sizeof(int64_t));
+
+            bool allow_zero = node.attributeOr<int64_t>(AttrKey::AllowZero, 0) != 0;
+            int64_t known_elems = 1;
+            int64_t infer_at = -1;
+            for (size_t i = 0; i < out.size(); ++i)
+            {
+                if (out[i] == 0 && !allow_zero && i < data->dims.size()) out[i] = data->dims[i];
+                if (out[i] == -1) infer_at = static_cast<int64_t>(i);
+                else known_elems *= out[i];
+            }
+            if (infer_at >= 0)
+            {
+                out[infer_at] = isDynamic(data->dims) || known_elems <= 0
+                    ? -1
+                    : static_cast<int64_t>(elementCount(data->dims)) / known_elems;
+            }
+            setOutput(outputs, out, data->dtype);
+        }
+
+        const Graph&           graph_;
+        std::vector<ShapeInfo> shapes_;
+        bool                   exact_ = true;
+    };
+
+
+    CostReport estimateCost(const Graph& graph, const MachineModel& machine)
+    {
+        CostReport report;
+        report.machine = machine;
+
+        const double flops_per_s = machine.peak_gflops * 1e9;
+        const double bytes_per_s = machine.mem_bandwidth_gbs * 1e9;
+
+        CostEstimator estimator(graph);
+        std::vector<uint8_t> counted(graph.numTensorIds(), 0);
+
+        const auto& order = graph.topologicalOrder();
+        report.nodes.reserve(order.size());
+        for (auto id : order)
+        {
+            auto cost = estimator.estimate(id);
+
+            double compute = static_cast<double>(cost.flops) / flops_per_s;
+            double memory  = static_cast<double>(cost.bytes()) / bytes_per_s;
+            cost.seconds = std::max(compute, memory);
+            cost.bound   = cost.flops > 0 && cost.intensity() >= machine.ridgePoint()
+                               ? Bound::Compute : Bound::Memory;
+
+            report.flops            += cost.flops;
+            report.activation_bytes += cost.activation_bytes;
+            report.seconds          += cost.seconds;
+            if (!cost.exact) ++report.inexact_nodes;
+
+            for (auto t : graph.nodeInputs(id))
+            {
+                const auto* tensor = t != kNoTensor ? graph.tensor(t) : nullptr;
+                if (!tensor || !tensor->hasData() || counted[t]) continue;
+                counted[t] = 1;
+                report.weight_bytes += tensor->getRawData().size();
+            }
+
+            report.nodes.push_back(cost);
+        }
+        return report;
+    }
+
+
+    std::string CostReport::summary(const Graph& graph, size_t top) const
+    {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3);
+        oss << "Cost model (" << machine.peak_gflops << " GFLOP/s, "
+            << machine.mem_bandwidth_gbs << " GB/s, ridge " << machine.ridgePoint() << " FLOP/B)\n";
+        oss << "  GFLOPs           : " << static_cast<double>(flops) / 1e9 << "\n";
+        oss << "  weight MB        : " << static_cast<double>(weight_bytes) / 1e6 << "\n";
+        oss << "  activation MB    : " << static_cast<double>(activation_bytes) / 1e6 << "\n";
+        oss << "  estimated ms     : " << seconds * 1e3 << "\n";
+        if (inexact_nodes)
+            oss << "  inexact nodes    : " << inexact_nodes << " (dynamic or unknown shapes)\n";
+
+        size_t compute_bound = std::count_if(nodes.begin(), nodes.end(),
+            [](const NodeCost& c) { return c.bound == Bound::Compute; });
+        oss << "  compute-bound    : " << compute_bound << " of " << nodes.size() << " nodes\n";
+
+        std::vector<const NodeCost*> by_time;
+        by_time.reserve(nodes.size());
+        for (const auto& c : nodes) by_time.push_back(&c);
+        top = std::min(top, by_time.size());
+        std::partial_sort(by_time.begin(), by_time.begin() + top, by_time.end(),
+            [](const NodeCost* a, const NodeCost* b) { return a->seconds > b->seconds; });
+
+        if (top) oss << "  most expensive:\n";
+        for (size_t i = 0; i < top; ++i)
+        {
+            const auto& c = *by_time[i];
+            const auto& node = *graph.getNodes()[c.node];
+            oss << "    " << node.getOpStr() << "  " << node.getName()
+                << "  " << static_cast<double>(c.flops) / 1e6 << " MFLOP"
+                << "  " << static_cast<double>(c.bytes()) / 1e6 << " MB"
+                << "  " << c.intensity() << " FLOP/B"
+                << "  " << (c.bound == Bound::Compute ? "compute" : "memory")
+                << "  " << c.seconds * 1e3 << " ms"
+                << (c.exact ? "" : "  (inexact)") << "\n";
+        }
+        return oss.str();
+    }
+
+} // namespace tc
@@ -0,0 +1,322 @@
+#include "graph/fusion.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+
+namespace tc
+{
+
+    namespace
+    {
+
+        // nodes replaced by one node, which goes where the last of them was
+        struct Fusion
+        {
+            std::vector<NodeId>   nodes;
+            std::shared_ptr<Node> node;
+        };
+
+        // the tensor name of an edge, empty for an omitted optional one
+        std::string edgeName(const Graph& graph, TensorId t)
+        {
+            return t == kNoTensor ? std::string() : graph.tensorName(t);
+        }
+
+        // the only node reading `t`, kNoNode if there are several or `t` is a graph output
+        NodeId soleReader(const Graph& graph, const std::vector<uint8_t>& is_output, TensorId t)
+        {
+            if (t == kNoTensor || is_output[t]) return kNoNode;
+            auto readers = graph.consumersOf(t);
+            return readers.size() == 1 ? readers[0] : kNoNode;
+        }
+
+        std::vector<uint8_t> outputMask(const Graph& graph)
+        {
+            std::vector<uint8_t> is_output(graph.numTensorIds(), 0);
+            for (auto t : graph.getOutputIds()) is_output[t] = 1;
+            return is_output;
+        }
+
+        struct LayerNormMatch
+        {
+            std::vector<NodeId> nodes;  // the decomposed ops, the last one writes y
+            TensorId x     = kNoTensor;
+            TensorId scale = kNoTensor;
+            TensorId bias  = kNoTensor;
+            TensorId y     = kNoTensor;
+            int64_t  axis  = -1;
+            float    epsilon = 0.0f;
+        };
+
+        class LayerNormMatcher
+        {
+        public:
+            explicit LayerNormMatcher(const Graph& graph) : graph_(graph), is_output_(outputMask(graph)) {}
+
+            // the pattern whose first ReduceMean is `r1`
+            std::optional<LayerNormMatch> match(NodeId r1) const
+            {
+                LayerNormMatch m;
+                m.x = input(r1, 0);
+                auto rank = rankOf(m.x);
+                auto axis = reduceAxis(r1, rank);
+                if (m.x == kNoTensor || !axis) return std::nullopt;
+                m.axis = *axis;
+
+                // d = x - mean
+                auto mean = output(r1);
+                auto sub  = soleReader(mean);
+                if (!isOp(sub, "Sub") || input(sub, 0) != m.x || input(sub, 1) != mean) return std::nullopt;
+                auto d = output(sub);
+
+                // d feeds the square and the division, nothing else
+                if (d == kNoTensor || is_output_[d]) return std::nullopt;
+                NodeId square = kNoNode, div = kNoNode;
+                for (auto c : graph_.consumersOf(d))
+                {
+                    if (isOp(c, "Div") && input(c, 0) == d)
+                        div = c;
+                    else if (square == kNoNode || square == c)
+                        square = c;
+                    else
+                        return std::nullopt;
+                }
+                bool is_pow = isOp(square, "Pow") && input(square, 0) == d && scalarConstant(input(square, 1)) == 2.0f;
+                bool is_mul = isOp(square, "Mul") && input(square, 0) == d && input(square, 1) == d;
+                if (div == kNoNode || !(is_pow || is_mul)) return std::nullopt;
+
+                // var = ReduceMean(d^2) over the same axes
+                auto r2 = soleReader(output(square));
+                if (!isOp(r2, "ReduceMean") || reduceAxis(r2, rank) != m.axis) return std::nullopt;
+
+                // Sqrt(var + epsilon), in either operand order
+                auto add_eps = soleReader(output(r2));
+                if (!isOp(add_eps, "Add")) return std::nullopt;
+                auto var = output(r2);
+                auto eps = scalarConstant(input(add_eps, input(add_eps, 0) == var ? 1 : 0));
+                if (!eps) return std::nullopt;
+                m.epsilon = *eps;
+
+                auto sqrt = soleReader(output(add_eps));
+                if (!isOp(sqrt, "Sqrt") || soleReader(output(sqrt)) != div || input(div, 1) != output(sqrt))
+                    return std::nullopt;
+
+                m.nodes = {r1, sub, square, r2, add_eps, sqrt, div};
+                m.y     = output(div);
+
+                // scale and bias, if the next readers apply per-feature parameters
+                auto mul = soleReader(m.y);
+                if (isOp(mul, "Mul")) m.scale = parameter(mul, m.y, m.axis);
+                if (m.scale != kNoTensor)
+                {
+                    m.nodes.push_back(mul);
+                    m.y = output(mul);
+                }
+
+                auto add = soleReader(m.y);
+                if (isOp(add, "Add")) m.bias = parameter(add, m.y, m.axis);
+                if (m.bias != kNoTensor)
+                {
+                    m.nodes.push_back(add);
+                    m.y = output(add);
+                }
+
+                if (m.y == kNoTensor) return std::nullopt;
+                return m;
+            }
+
+        private:
+            [[nodiscard]] bool isOp(NodeId id, std::string_view op) const
+            {
+                return id != kNoNode && graph_.getNodes()[id]->getOpStr() == op;
+            }
+
+            [[nodiscard]] TensorId input(NodeId id, size_t i) const
+            {
+                auto ins = graph_.nodeInputs(id);
+                return i < ins.size() ? ins[i] : kNoTensor;
+            }
+
+            [[nodiscard]] TensorId output(NodeId id) const
+            {
+                auto outs = graph_.nodeOutputs(id);
+                return outs.size() == 1 ? outs[0] : kNoTensor;
+            }
+
+            [[nodiscard]] NodeId soleReader(TensorId t) const { return tc::soleReader(graph_, is_output_, t); }
+
+            [[nodiscard]] int64_t rankOf(TensorId t) const
+            {
+                const auto* tensor = t == kNoTensor ? nullptr : graph_.tensor(t);
+                if (!tensor || (tensor->getShape().dims.empty() && !tensor->hasData())) return -1;
+                return static_cast<int64_t>(tensor->getShape().rank());
+            }
+
+            // a one-element float initializer, read byte-wise as it may be an unaligned view
+            [[nodiscard]] std::optional<float> scalarConstant(TensorId t) const
+            {
+                const auto* tensor = t == kNoTensor ? nullptr : graph_.tensor(t);
+                if (!tensor || tensor->getDtype() != DataType::FLOAT || tensor->getRawData().size() != sizeof(float))
+                    return std::nullopt;
+
+                float value;
+                std::memcpy(&value, tensor->getRawData().data(), sizeof(value));
+                return value;
+            }
+
+            // First of the trailing axes a keepdims ReduceMean averages over, counted from the
+            // back, `rank` is x's or -1. Axes come from the attribute, or the second input
+            // since opset 18.
+            [[nodiscard]] std::optional<int64_t> reduceAxis(NodeId id, int64_t rank) const
+            {
+                const Node& node = *graph_.getNodes()[id];
+                if (node.getOpStr() != "ReduceMean" || node.attributeOr<int64_t>(AttrKey::KeepDims, 1) == 0)
+                    return std::nullopt;
+
+                auto axes = node.attributeOr<std::vector<int64_t>>(AttrKey::Axes, {});
+                if (axes.empty() && input(id, 1) != kNoTensor)
+                {
+                    const auto* t = graph_.tensor(input(id, 1));
+                    if (!t || t->getDtype() != DataType::INT64 || !t->hasValidData()) return std::nullopt;
+                    axes.resize(t->getRawData().size() / sizeof(int64_t));
+                    std::memcpy(axes.data(), t->getRawData().data(), t->getRawData().size());
+                }
+                // no axes reduces everything
+                if (axes.empty()) return std::nullopt;
+
+                for (auto& a : axes)
+                {
+                    if (a >= 0 && rank < 0) return std::nullopt;
+                    if (a >= 0) a -= rank;
+                }
+                std::sort(axes.begin(), axes.end());
+                for (size_t i = 0; i < axes.size(); ++i)
+                    if (axes[i] != static_cast<int64_t>(i) - static_cast<int64_t>(axes.size())) return std::nullopt;
+                return axes.front();
+            }
+
+            // The other operand of an elementwise `op` reading `y`, if it is a per-feature
+            // parameter: available up front and no wider than the normalized dimensions,
+            // -axis of them as reduceAxis() counts from the back.
+            [[nodiscard]] TensorId parameter(NodeId op, TensorId y, int64_t axis) const
+            {
+                auto ins = graph_.nodeInputs(op);
+                if (ins.size() != 2 || (ins[0] == y) == (ins[1] == y)) return kNoTensor;
+
+                auto p    = ins[0] == y ? ins[1] : ins[0];
+                auto rank = rankOf(p);
+                if (p == kNoTensor || graph_.dependsOnProducer(p) || rank < 0 || rank > -axis) return kNoTensor;
+                return p;
+            }
+
+            const Graph&         graph_;
+            std::vector<uint8_t> is_output_;
+        };
+
+        // `graph` without the fused nodes, each fusion's node where its last node was, and
+        // without the tensors only they used
+        std::shared_ptr<Graph> rewrite(const Graph& graph, const std::vector<Fusion>& fusions)
+        {
+            std::vector<std::shared_ptr<Node>> replacement(graph.getNodes().size());
+            std::vector<uint8_t>               removed(graph.getNodes().size(), 0);
+            for (const auto& f : fusions)
+            {
+                for (auto id : f.nodes) removed[id] = 1;
+                replacement[f.nodes.back()] = f.node;
+            }
+
+            std::vector<std::shared_ptr<Node>> nodes;
+            for (auto id : graph.topologicalOrder())
+            {
+                if (!removed[id])         nodes.push_back(graph.getNodes()[id]);
+                else if (replacement[id]) nodes.push_back(replacement[id]);
+            }
+
+            std::unordered_set<std::string_view> used(graph.getInputs().begin(), graph.getInputs().end());
+            used.insert(graph.getOutputs().begin(), graph.getOutputs().end());
+            for (const auto& n : nodes)
+            {
+                used.insert(n->getInputs().begin(), n->getInputs().end());
+                used.insert(n->getOutputs().begin(), n->getOutputs().end());
+            }
+
+            auto out = std::make_shared<Graph>(graph.getName());
+            out->reserve(nodes.size(), used.size());
+            for (const auto& t : graph.getTensors())
+                if (t && used.contains(t->getName())) out->addTensor(t);
+            for (const auto& name : graph.getInputs()) out->addInput(name);
+            for (auto& n : nodes) out->addNode(std::move(n));
+            for (const auto& name : graph.getOutputs()) out->addOutput(name);
+            return out;
+        }
+
+    } // namespace
+
+    size_t fuseLayerNorm(std::shared_ptr<Graph>& graph)
+    {
+        LayerNormMatcher     matcher(*graph);
+        std::vector<Fusion>  fusions;
+        std::vector<uint8_t> claimed(graph->getNodes().size(), 0);
+
+        for (auto id : graph->topologicalOrder())
+        {
+            if (claimed[id] || graph->getNodes()[id]->getOpStr() != "ReduceMean") continue;
+
+            auto m = matcher.match(id);
+            if (!m) continue;
+            for (auto n : m->nodes) claimed[n] = 1;
+
+            auto name = [&](TensorId t) { return edgeName(*graph, t); };
+            fusions.push_back({m->nodes, std::make_shared<Node>(
+                graph->getNodes()[m->nodes.back()]->getName(), OpType::LayerNormalization, "LayerNormalization",
+                std::vector<std::string>{name(m->x), name(m->scale), name(m->bias)},
+                std::vector<std::string>{name(m->y)},
+                Node::AttributeList{
+                    Attribute("axis",    AttributeType::INT,   m->axis),
+                    Attribute("epsilon", AttributeType::FLOAT, m->epsilon),
+                })});
+        }
+
+        if (!fusions.empty()) graph = rewrite(*graph, fusions);
+        return fusions.size();
+    }
+
+    size_t fuseSwish(std::shared_ptr<Graph>& graph)
+    {
+        auto                 is_output = outputMask(*graph);
+        std::vector<Fusion>  fusions;
+
+        for (auto id : graph->topologicalOrder())
+        {
+            if (graph->getNodes()[id]->getOpType() != OpType::Sigmoid) continue;
+
+            auto ins  = graph->nodeInputs(id);
+            auto outs = graph->nodeOutputs(id);
+            if (ins.size() != 1 || outs.size() != 1) continue;
+
+            // Mul(x, Sigmoid(x)) in either operand order
+            auto x   = ins[0];
+            auto sig = outs[0];
+            auto mul = soleReader(*graph, is_output, sig);
+            if (mul == kNoNode || graph->getNodes()[mul]->getOpType() != OpType::Mul) continue;
+
+            auto mul_ins = graph->nodeInputs(mul);
+            bool matches = mul_ins.size() == 2 &&
+                           ((mul_ins[0] == x && mul_ins[1] == sig) || (mul_ins[0] == sig && mul_ins[1] == x));
+            if (!matches || graph->nodeOutputs(mul).size() != 1) continue;
+
+            const auto& last = *graph->getNodes()[mul];
+            fusions.push_back({{id, mul}, std::make_shared<Node>(
+                last.getName(), OpType::Swish, "Swish",
+                std::vector<std::string>{edgeName(*graph, x)},
+                std::vector<std::string>{edgeName(*graph, graph->nodeOutputs(mul)[0])})});
+        }
+
+        if (!fusions.empty()) graph = rewrite(*graph, fusions);
+        return fusions.size();
+    }
+
+} // namespace tc
@@ -1,19 +1,73 @@
 #include "graph/graph.hpp"
 #include <sstream>
 #include <stdexcept>
-#include <unordered_set>
-#include <queue>
+#include <unordered_map>
 
 namespace tc
 {
 
-    Graph::Graph(std::string name) : name_(std::move(name)) {}
+    Graph::Graph(std::string name)
+        : arena_(std::make_shared<GraphArena>()), name_(std::move(name)) {}
+
+    void Graph::reserve(size_t num_nodes, size_t num_tensors)
+    {
+        nodes_.reserve(num_nodes);
+        node_edges_.reserve(num_nodes);
+        node_ids_.reserve(num_nodes);
+
+        tensors_.reserve(num_tensors);
+        tensor_names_.reserve(num_tensors);
+        tensor_ids_.reserve(num_tensors);
+        producers_.reserve(num_tensors);
+        consumers_.reserve(num_tensors);
+        is_input_.reserve(num_tensors);
+    }
 
     void Graph::addNode(std::shared_ptr<Node> node)
     {
         if (!node) throw std::invalid_argument("null node");
-        node_map_[node->getName()] = node;
+
+        auto id = static_cast<NodeId>(nodes_.size());
+        node_ids_.insert_or_assign(node->getName(), id);
+
+        // optional inputs and outputs ONNX leaves out are empty names, they are no tensor
+        auto edge = [&](std::string_view name)
+        {
+            edges_.push_back(name.empty() ? kNoTensor : internTensor(name));
+        };
+
+        EdgeRange range;
+        range.begin = static_cast<uint32_t>(edges_.size());
+        for (const auto& inp : node->getInputs()) edge(inp);
+        range.mid = static_cast<uint32_t>(edges_.size());
+        for (const auto& out : node->getOutputs()) edge(out);
+        range.end = static_cast<uint32_t>(edges_.size());
+
+        node_edges_.push_back(range);
         nodes_.push_back(std::move(node));
+
+        // The cached order can be extended when every node so far is in it and no node
+        // already placed reads one of the new outputs, i.e. the new node goes last.
+        bool append = topo_valid_ && topo_order_.size() + 1 == nodes_.size();
+
+        for (auto t : nodeOutputs(id))
+        {
+            if (t == kNoTensor) continue;
+            if (producers_[t] != kNoNode || (!consumers_[t].empty() && !isSource(t)))
+                append = false;
+            producers_[t] = id;
+        }
+
+        for (auto t : nodeInputs(id))
+        {
+            if (t == kNoTensor) continue;
+            consumers_[t].push_back(id);
+            if (producers_[t] == id && !isSource(t))
+                append = false;
+        }
+
+        if (append) topo_order_.push_back(id);
+        else        topo_valid_ = false;
     }
 
     const std::vector<std::shared_ptr<Node>>& Graph::getNodes() const
@@ -21,94 +75,143 @@ namespace tc
         return nodes_;
     }
 
-    std::optional<std::shared_ptr<Node>> Graph::findNode(const std::string& name) const
+    Node* Graph::findNode(std::string_view name) const
     {
-        auto it = node_map_.find(name);
-        if (it == node_map_.end()) return std::nullopt;
-        return it->second;
+        auto id = nodeId(name);
+        return id == kNoNode ? nullptr : nodes_[id].get();
     }
 
-    void Graph::addTensor(std::shared_ptr<Tensor> tensor)
+    NodeId Graph::nodeId(std::string_view name) const
     {
-        if (!tensor) throw std::invalid_argument("null tensor");
-        tensor_map_[tensor->getName()] = std::move(tensor);
+        auto it = node_ids_.find(name);
+        return it == node_ids_.end() ? kNoNode : it->second;
     }
 
-    std::optional<std::shared_ptr<Tensor>> Graph::findTensor(const std::string& name) const
+    std::span<const TensorId> Graph::nodeInputs(NodeId id) const
     {
-        auto it = tensor_map_.find(name);
-        if (it == tensor_map_.end()) return std::nullopt;
-
-
-        return it->second;
+        const auto& r = node_edges_[id];
+        return {edges_.data() + r.begin, r.mid - r.begin};
     }
 
-    const std::unordered_map<std::string, std::shared_ptr<Tensor>>& Graph::getTensors() const
+    std::span<const TensorId> Graph::nodeOutputs(NodeId id) const
     {
-        return tensor_map_;
+        const auto& r = node_edges_[id];
+        return {edges_.data() + r.mid, r.end - r.mid};
     }
 
-    void Graph::addInput(const std::string& name)  { inputs_.push_back(name); }
-    void Graph::addOutput(const std::string& name) { outputs_.push_back(name); }
-
-    std::vector<std::shared_ptr<Node>> Graph::topologicalSort() const
+    TensorId Graph::internTensor(std::string_view name)
     {
-        std::unordered_map<std::string, std::vector<std::shared_ptr<Node>>> consumers;
-        std::unordered_map<std::shared_ptr<Node>, int> in_degree;
-
-        std::unordered_set<std::string> available;
-        for (const auto& inp : inputs_) available.insert(inp);
-        for (const auto& [name, t] : tensor_map_)
-            if (t->hasData()) available.insert(name);
-
-        for (const auto& node : nodes_)
-        {
-            int deg = 0;
-            for (const auto& inp : node->getInputs())
-            {
-                if (!available.contains(inp))
-                {
-                    consumers[inp].push_back(node);
-                    ++deg;
-                }
-            }
-            in_degree[node] = deg;
-        }
-
+        auto it = tensor_ids_.find(name);
+        if (it != tensor_ids_.end()) return it->second;
+
+        auto id = static_cast<TensorId>(tensors_.size());
+        if (id == kNoTensor)
+            throw std::length_error("Too many tensors in graph '" + name_ + "'");
+
+        tensor_ids_.emplace(std::string(name), id);
+        tensor_names_.emplace_back(name);
+        tensors_.emplace_back();
+        producers_.push_back(kNoNode);
+        consumers_.emplace_back(arena_->resource());
+        is_input_.push_back(0);
+        return id;
+    }
 
+    TensorId Graph::tensorId(std::string_view name) const
+    {
+        auto it = tensor_ids_.find(name);
+        return it == tensor_ids_.end() ? kNoTensor : it->second;
+    }
 
-        
+    void Graph::addTensor(std::shared_ptr<Tensor> tensor)
+    {
+        if (!tensor) throw std::invalid_argument("null tensor");
+        auto id = internTensor(tensor->getName());
+        tensors_[id] = std::move(tensor);
 
-        std::queue<std::shared_ptr<Node>> q;
+        // a constant produced by a node no longer orders its consumers after it
+        if (producers_[id] != kNoNode) topo_valid_ = false;
+    }
 
+    Tensor* Graph::findTensor(std::string_view name) const
+    {
+        auto id = tensorId(name);
+        return id == kNoTensor ? nullptr : tensors_[id].get();
+    }
 
-        for (const auto& node : nodes_)
-            if (in_degree[node] == 0)
-                q.push(node);
+    const std::vector<std::shared_ptr<Tensor>>& Graph::getTensors() const
+    {
+        return tensors_;
+    }
 
-        std::vector<std::shared_ptr<Node>> sorted;
-        sorted.reserve(nodes_.size());
+    void Graph::addInput(const std::string& name)
+    {
+        auto id = internTensor(name);
+        inputs_.push_back(name);
+        input_ids_.push_back(id);
+        is_input_[id] = 1;
+        if (producers_[id] != kNoNode) topo_valid_ = false;
+    }
 
+    void Graph::addOutput(const std::string& name)
+    {
+        outputs_.push_back(name);
+        output_ids_.push_back(internTensor(name));
+    }
 
-        while (!q.empty())
+    const std::vector<NodeId>& Graph::topologicalOrder() const
+    {
+        if (!topo_valid_)
         {
-            auto cur = q.front(); q.pop();
-            sorted.push_back(cur);
+            computeTopologicalOrder();
+            topo_valid_ = true;
+        }
+        return topo_order_;
+    }
 
-            for (const auto& out : cur->getOutputs())
+    void Graph::computeTopologicalOrder() const
+    {
+        const size_t num_nodes = nodes_.size();
+
+        // tensors a reader has to wait for, decided once instead of per use
+        std::vector<uint8_t> waits(tensors_.size());
+        for (TensorId t = 0; t < tensors_.size(); ++t)
+            waits[t] = dependsOnProducer(t);
+
+        // one count per use, matching the entries in consumers_
+        std::vector<uint32_t> in_degree(num_nodes, 0);
+        for (NodeId n = 0; n < num_nodes; ++n)
+            for (auto t : nodeInputs(n))
+                if (t != kNoTensor && waits[t]) ++in_degree[n];
+
+        // Kahn's algorithm, the ready list doubles as the result
+        topo_order_.clear();
+        topo_order_.reserve(num_nodes);
+        for (NodeId n = 0; n < num_nodes; ++n)
+            if (in_degree[n] == 0)
+                topo_order_.push_back(n);
+
+        for (size_t head = 0; head < topo_order_.size(); ++head)
+        {
+            NodeId cur = topo_order_[head];
+            for (auto t : nodeOutputs(cur))
             {
-                auto it = consumers.find(out);
-                if (it == consumers.end()) continue;
-
-
-                for (auto& consumer : it->second)
-                {
-                    if (--in_degree[consumer] == 0)
-                        q.push(consumer);
-                }
+                // only the recorded producer releases the consumers
+                if (t == kNoTensor || !waits[t] || producers_[t] != cur) continue;
+                for (auto c : consumers_[t])
+                    if (--in_degree[c] == 0)
+                        topo_order_.push_back(c);
             }
         }
+    }
 
+    std::vector<std::shared_ptr<Node>> Graph::topologicalSort() const
+    {
+        std::vector<std::shared_ptr<Node>> sorted;
+        const auto& order = topologicalOrder();
+        sorted.reserve(order.size());
+        for (auto id : order)
+            sorted.push_back(nodes_[id]);
         return sorted;
     }
 
@@ -119,10 +222,14 @@ namespace tc
         for (const auto& n : nodes_)
             ++op_counts[n->getOpStr()];
 
+        size_t num_tensors = 0;
+        for (const auto& t : tensors_)
+            if (t) ++num_tensors;
+
         std::ostringstream oss;
         oss << "Graph: " << name_ << "\n";
         oss << "  nodes  : " << nodes_.size()   << "\n";
-        oss << "  tensors: " << tensor_map_.size() << "\n";
+        oss << "  tensors: " << num_tensors << "\n";
         oss << "  inputs : ";
         for (const auto& i : inputs_)  oss << i << " ";
         oss << "\n  outputs: ";
@@ -18,6 +18,19 @@ namespace tc
             {"Shape",       OpType::Shape},
             {"Reshape",     OpType::Reshape},
             {"Concat",     OpType::Concat},
+            {"Softmax",     OpType::Softmax},
+            {"LogSoftmax",  OpType::LogSoftmax},
+            {"LayerNormalization", OpType::LayerNormalization},
+            {"Sigmoid",     OpType::Sigmoid},
+            {"Tanh",        OpType::Tanh},
+            {"Gelu",        OpType::Gelu},
+            {"Swish",       OpType::Swish},
+            {"HardSwish",   OpType::HardSwish},
+            {"Erf",         OpType::Erf},
+            {"Exp",         OpType::Exp},
+            {"MaxPool",     OpType::MaxPool},
+            {"AveragePool", OpType::AveragePool},
+            {"GlobalAveragePool", OpType::GlobalAveragePool},
         };
 
         
@@ -38,6 +51,19 @@ namespace tc
             case OpType::Shape:     return "Shape";
             case OpType::Reshape:   return "Reshape";
             case OpType::Concat:    return "Concat";
+            case OpType::Softmax:   return "Softmax";
+            case OpType::LogSoftmax: return "LogSoftmax";
+            case OpType::LayerNormalization: return "LayerNormalization";
+            case OpType::Sigmoid:   return "Sigmoid";
+            case OpType::Tanh:      return "Tanh";
+            case OpType::Gelu:      return "Gelu";
+            case OpType::Swish:     return "Swish";
+            case OpType::HardSwish: return "HardSwish";
+            case OpType::Erf:       return "Erf";
+            case OpType::Exp:       return "Exp";
+            case OpType::MaxPool:   return "MaxPool";
+            case OpType::AveragePool: return "AveragePool";
+            case OpType::GlobalAveragePool: return "GlobalAveragePool";
             case OpType::Other:     return "Other";
             default:                return "Unknown";
         }
@@ -49,33 +75,57 @@ namespace tc
         std::string op_str,
         std::vector<std::string> inputs,
         std::vector<std::string> outputs,
-        AttributeMap attributes)
+        AttributeList attributes)
+
+        : Node(std::allocator_arg, allocator_type{}, std::move(name), op, std::move(op_str),
+               std::move(inputs), std::move(outputs), std::move(attributes))
+    {}
+
+    Node::Node(
+        std::allocator_arg_t,
+        const allocator_type& alloc,
+        std::string name,
+        OpType op,
+        std::string op_str,
+        std::vector<std::string> inputs,
+        std::vector<std::string> outputs,
+        AttributeList attributes)
 
         : name_(std::move(name)),
         op_(op),
         op_str_(std::move(op_str)),
-        inputs_(std::move(inputs)),
-        outputs_(std::move(outputs)),
-        attrs_(std::move(attributes))
+        inputs_(inputs.begin(), inputs.end(), alloc),
+        outputs_(outputs.begin(), outputs.end(), alloc),
+        attrs_(std::move(attributes), alloc)
     {}
 
-    bool Node::hasAttribute(const std::string& key) const
+    const Attribute* Node::findAttribute(std::string_view name) const
+    {
+        auto key = attrKeyFromString(name);
+        if (key != AttrKey::Other) return findAttribute(key);
+
+        for (const auto& a : attrs_)
+            if (a.getName() == name) return &a;
+        return nullptr;
+    }
+
+    const Attribute& Node::getAttribute(std::string_view name) const
     {
-        return attrs_.contains(key);
+        if (const auto* a = findAttribute(name)) return *a;
+        throw std::out_of_range("Attribute not found: " + std::string(name));
     }
 
-    const Attribute& Node::getAttribute(const std::string& key) const
+    const Attribute& Node::getAttribute(AttrKey key) const
     {
-        auto it = attrs_.find(key);
-        if (it == attrs_.end())
-            throw std::out_of_range("Attribute not found: " + key);
-        return it->second;
+        if (const auto* a = findAttribute(key)) return *a;
+        throw std::out_of_range("Attribute not found: " + attrKeyToString(key));
     }
 
     void Node::addAttribute(Attribute attr)
     {
-        auto key = attr.getName();
-        attrs_.emplace(std::move(key), std::move(attr));
+        // like a map insert, an attribute that is already there is kept
+        if (findAttribute(attr.getName())) return;
+        attrs_.push_back(std::move(attr));
     }
 
     std::string Node::toString() const
@@ -94,7 +144,7 @@ namespace tc
         if (!attrs_.empty())
         {
             oss << "  attrs  : ";
-            for (const auto& [k, a] : attrs_)
+            for (const auto& a : attrs_)
                 oss << a.toString() << "  ";
             oss << "\n";
         }
@@ -0,0 +1,85 @@
+#include "graph/partition.hpp"
+
+#include <algorithm>
+
+namespace tc
+{
+
+    size_t TaskGraph::width() const
+    {
+        // tasks are created after the tasks they depend on
+        std::vector<uint32_t> level(nodes.size(), 0);
+        std::vector<size_t>   per_level;
+        for (TaskId t = 0; t < nodes.size(); ++t)
+        {
+            for (auto d : deps[t])
+                level[t] = std::max(level[t], level[d] + 1);
+            if (per_level.size() <= level[t]) per_level.resize(level[t] + 1, 0);
+            ++per_level[level[t]];
+        }
+        return per_level.empty() ? 0 : *std::max_element(per_level.begin(), per_level.end());
+    }
+
+    // the only node reading p's results, kNoNode if there are none or several
+    static NodeId soleConsumer(const Graph& graph, NodeId p)
+    {
+        NodeId sole = kNoNode;
+        for (auto t : graph.nodeOutputs(p))
+        {
+            if (t == kNoTensor) continue;
+            for (auto c : graph.consumersOf(t))
+            {
+                if (sole != kNoNode && sole != c) return kNoNode;
+                sole = c;
+            }
+        }
+        return sole;
+    }
+
+    TaskGraph partitionTasks(const Graph& graph, std::span<const NodeId> order)
+    {
+        TaskGraph tasks;
+        tasks.task_of.assign(graph.getNodes().size(), kNoTask);
+
+        std::vector<NodeId> preds;
+        for (auto n : order)
+        {
+            preds.clear();
+            for (auto t : graph.nodeInputs(n))
+            {
+                if (!graph.dependsOnProducer(t)) continue;
+                auto p = graph.producerOf(t);
+                if (std::find(preds.begin(), preds.end(), p) == preds.end())
+                    preds.push_back(p);
+            }
+
+            // continue the producer's chain if n is the only thing it feeds
+            if (preds.size() == 1)
+            {
+                auto p = preds.front();
+                auto t = tasks.task_of[p];
+                if (t != kNoTask && tasks.nodes[t].back() == p && soleConsumer(graph, p) == n)
+                {
+                    tasks.task_of[n] = t;
+                    tasks.nodes[t].push_back(n);
+                    continue;
+                }
+            }
+
+            auto id = static_cast<TaskId>(tasks.nodes.size());
+            tasks.task_of[n] = id;
+            tasks.nodes.push_back({n});
+
+            std::vector<TaskId> deps;
+            for (auto p : preds)
+            {
+                auto t = tasks.task_of[p];
+                if (t != kNoTask && std::find(deps.begin(), deps.end(), t) == deps.end())
+                    deps.push_back(t);
+            }
+            tasks.deps.push_back(std::move(deps));
+        }
+        return tasks;
+    }
+
+} // namespace tc
@@ -0,0 +1,298 @@
+#include "graph/scheduler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+
+namespace tc
+{
+
+    SchedulePolicy schedulePolicyFromString(std::string_view name)
+    {
+        if (name == "kahn")        return SchedulePolicy::Kahn;
+        if (name == "memory")      return SchedulePolicy::MinMemory;
+        if (name == "depth-first") return SchedulePolicy::DepthFirst;
+        throw std::runtime_error("Unknown schedule '" + std::string(name) +
+                                 "', expected kahn, memory or depth-first");
+    }
+
+    std::string schedulePolicyToString(SchedulePolicy policy)
+    {
+        switch (policy)
+        {
+            case SchedulePolicy::Kahn:       return "kahn";
+            case SchedulePolicy::MinMemory:  return "memory";
+            case SchedulePolicy::DepthFirst: return "depth-first";
+        }
+        return "unknown";
+    }
+
+    size_t activationBytes(const Graph& graph, TensorId id)
+    {
+        const auto* t = graph.tensor(id);
+        if (!t) return 0;
+        return t->numElements() * Tensor::dataTypeSize(t->getDtype());
+    }
+
+
+    // Per-tensor facts every scheduler needs, computed once per call
+    struct TensorFacts
+    {
+        std::vector<uint8_t>  waits;        // dependsOnProducer
+        std::vector<uint8_t>  is_output;
+        std::vector<size_t>   bytes;        // 0 for anything that is not an activation
+    };
+
+    static TensorFacts collectTensorFacts(const Graph& graph)
+    {
+        const size_t num_tensors = graph.numTensorIds();
+
+        TensorFacts facts;
+        facts.waits.resize(num_tensors);
+        facts.is_output.resize(num_tensors);
+        facts.bytes.resize(num_tensors);
+
+        for (TensorId t = 0; t < num_tensors; ++t)
+        {
+            facts.waits[t] = graph.dependsOnProducer(t);
+            if (facts.waits[t])
+                facts.bytes[t] = activationBytes(graph, t);
+        }
+        for (auto t : graph.getOutputIds())
+            facts.is_output[t] = 1;
+
+        return facts;
+    }
+
+    // one count per use of an activation, as Graph::computeTopologicalOrder
+    static std::vector<uint32_t> inDegrees(const Graph& graph, const TensorFacts& facts)
+    {
+        std::vector<uint32_t> in_degree(graph.getNodes().size(), 0);
+        for (NodeId n = 0; n < in_degree.size(); ++n)
+            for (auto t : graph.nodeInputs(n))
+                if (t != kNoTensor && facts.waits[t]) ++in_degree[n];
+        return in_degree;
+    }
+
+    // calls on_ready for every consumer `cur` was the last dependency of, in use order
+    template <typename OnReady>
+    static void releaseConsumers(const Graph& graph, const TensorFacts& facts,
+                                 std::vector<uint32_t>& in_degree, NodeId cur, OnReady&& on_ready)
+    {
+        for (auto t : graph.nodeOutputs(cur))
+        {
+            if (t == kNoTensor || !facts.waits[t] || graph.producerOf(t) != cur) continue;
+            for (auto c : graph.consumersOf(t))
+                if (--in_degree[c] == 0)
+                    on_ready(c);
+        }
+    }
+
+    static size_t usesBy(const Graph& graph, NodeId n, TensorId t)
+    {
+        auto ins = graph.nodeInputs(n);
+        return static_cast<size_t>(std::count(ins.begin(), ins.end(), t));
+    }
+
+    static size_t peakBytes(const Graph& graph, const TensorFacts& facts, std::span<const NodeId> order)
+    {
+        std::vector<uint32_t> remaining(graph.numTensorIds(), 0);
+        for (auto n : order)
+            for (auto t : graph.nodeInputs(n))
+                if (t != kNoTensor && facts.waits[t]) ++remaining[t];
+
+        auto release = [&](TensorId t, size_t& live)
+        {
+            if (!facts.is_output[t]) live -= facts.bytes[t];
+        };
+
+        size_t live = 0;
+        size_t peak = 0;
+        for (auto n : order)
+        {
+            for (auto t : graph.nodeOutputs(n))
+                if (t != kNoTensor && facts.waits[t] && graph.producerOf(t) == n)
+                    live += facts.bytes[t];
+            peak = std::max(peak, live);
+
+            for (auto t : graph.nodeInputs(n))
+                if (t != kNoTensor && facts.waits[t] && --remaining[t] == 0)
+                    release(t, live);
+
+            // results nobody reads are dropped right away
+            for (auto t : graph.nodeOutputs(n))
+                if (t != kNoTensor && facts.waits[t] && graph.producerOf(t) == n && remaining[t] == 0)
+                    release(t, live);
+        }
+        return peak;
+    }
+
+    size_t peakActivationBytes(const Graph& graph, std::span<const NodeId> order)
+    {
+        return peakBytes(graph, collectTensorFacts(graph), order);
+    }
+
+
+    static std::vector<NodeId> depthFirstOrder(const Graph& graph, const TensorFacts& facts)
+    {
+        auto in_degree = inDegrees(graph, facts);
+
+        std::vector<NodeId> order;
+        order.reserve(in_degree.size());
+
+        // pushed in reverse, so the first ready node is popped first
+        std::vector<NodeId> stack;
+        for (NodeId n = static_cast<NodeId>(in_degree.size()); n-- > 0;)
+            if (in_degree[n] == 0) stack.push_back(n);
+
+        std::vector<NodeId> fresh;
+        while (!stack.empty())
+        {
+            NodeId cur = stack.back();
+            stack.pop_back();
+            order.push_back(cur);
+
+            fresh.clear();
+            releaseConsumers(graph, facts, in_degree, cur, [&](NodeId c) { fresh.push_back(c); });
+            stack.insert(stack.end(), fresh.rbegin(), fresh.rend());
+        }
+        return order;
+    }
+
+
+    // Greedy list scheduling: of the ready nodes, run the one whose outputs minus the inputs
+    // it frees is smallest. Ties go to the most recently readied node, which keeps a branch
+    // going instead of opening a new one.
+    static std::vector<NodeId> minMemoryOrder(const Graph& graph, const TensorFacts& facts)
+    {
+        auto in_degree = inDegrees(graph, facts);
+        const size_t num_nodes = in_degree.size();
+
+        // uses not run yet; max_uses is the most uses of a tensor by a single node
+        std::vector<uint32_t> remaining(graph.numTensorIds(), 0);
+        std::vector<uint32_t> max_uses(graph.numTensorIds(), 0);
+        for (NodeId n = 0; n < num_nodes; ++n)
+        {
+            for (auto t : graph.nodeInputs(n))
+            {
+                if (t == kNoTensor || !facts.waits[t]) continue;
+                ++remaining[t];
+                max_uses[t] = std::max(max_uses[t], static_cast<uint32_t>(usesBy(graph, n, t)));
+            }
+        }
+
+        auto delta = [&](NodeId n)
+        {
+            int64_t d = 0;
+            for (auto t : graph.nodeOutputs(n))
+                if (t != kNoTensor && facts.waits[t] && graph.producerOf(t) == n)
+                    d += static_cast<int64_t>(facts.bytes[t]);
+
+            auto ins = graph.nodeInputs(n);
+            for (size_t i = 0; i < ins.size(); ++i)
+            {
+                auto t = ins[i];
+                if (t == kNoTensor || !facts.waits[t] || facts.is_output[t]) continue;
+                if (std::find(ins.begin(), ins.begin() + i, t) != ins.begin() + i) continue;
+                if (remaining[t] == usesBy(graph, n, t))
+                    d -= static_cast<int64_t>(facts.bytes[t]);
+            }
+            return d;
+        };
+
+        struct Ready
+        {
+            int64_t  delta;
+            uint64_t seq;
+            NodeId   id;
+
+            bool operator<(const Ready& o) const
+            {
+                if (delta != o.delta) return delta < o.delta;
+                return seq > o.seq;
+            }
+        };
+
+        std::set<Ready>      ready;
+        std::vector<Ready>   key(num_nodes);
+        std::vector<uint8_t> queued(num_nodes, 0);
+        uint64_t             seq = 0;
+
+        auto push = [&](NodeId n)
+        {
+            key[n] = {delta(n), seq++, n};
+            ready.insert(key[n]);
+            queued[n] = 1;
+        };
+
+        for (NodeId n = static_cast<NodeId>(num_nodes); n-- > 0;)
+            if (in_degree[n] == 0) push(n);
+
+        std::vector<NodeId> order;
+        order.reserve(num_nodes);
+
+        std::vector<NodeId> fresh;
+        while (!ready.empty())
+        {
+            NodeId cur = ready.begin()->id;
+            ready.erase(ready.begin());
+            queued[cur] = 0;
+            order.push_back(cur);
+
+            auto ins = graph.nodeInputs(cur);
+            for (auto t : ins)
+                if (t != kNoTensor && facts.waits[t]) --remaining[t];
+
+            // A ready reader of t frees it once its own uses are all that is left. That can
+            // only have changed for readers when few uses remain, which keeps rescoring rare.
+            for (size_t i = 0; i < ins.size(); ++i)
+            {
+                auto t = ins[i];
+                if (t == kNoTensor || !facts.waits[t] || remaining[t] == 0 || remaining[t] > max_uses[t])
+                    continue;
+                if (std::find(ins.begin(), ins.begin() + i, t) != ins.begin() + i) continue;
+
+                for (auto c : graph.consumersOf(t))
+                {
+                    if (!queued[c]) continue;
+                    auto d = delta(c);
+                    if (d == key[c].delta) continue;
+                    ready.erase(key[c]);
+                    key[c].delta = d;
+                    ready.insert(key[c]);
+                }
+            }
+
+            fresh.clear();
+            releaseConsumers(graph, facts, in_degree, cur, [&](NodeId c) { fresh.push_back(c); });
+            for (auto it = fresh.rbegin(); it != fresh.rend(); ++it)
+                push(*it);
+        }
+        return order;
+    }
+
+
+    Schedule scheduleGraph(const Graph& graph, SchedulePolicy policy)
+    {
+        auto facts = collectTensorFacts(graph);
+
+        Schedule schedule;
+        switch (policy)
+        {
+            case SchedulePolicy::Kahn:
+                schedule.order = graph.topologicalOrder();
+                break;
+            case SchedulePolicy::MinMemory:
+                schedule.order = minMemoryOrder(graph, facts);
+                break;
+            case SchedulePolicy::DepthFirst:
+                schedule.order = depthFirstOrder(graph, facts);
+                break;
+        }
+
+        schedule.peak_bytes = peakBytes(graph, facts, schedule.order);
+        return schedule;
+    }
+
+} // namespace tc
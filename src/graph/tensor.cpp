@@ -63,6 +63,23 @@ namespace tc
         dtype_(dtype),
         shape_(std::move(shape)) {}
 
+    void Tensor::setRawData(std::vector<uint8_t> data)
+    {
+        raw_data_  = std::move(data);
+        is_view_   = false;
+        data_view_ = {};
+        data_owner_.reset();
+    }
+
+    void Tensor::setRawDataView(std::span<const uint8_t> bytes, std::shared_ptr<const void> owner)
+    {
+        raw_data_.clear();
+        raw_data_.shrink_to_fit();
+        is_view_    = true;
+        data_view_  = bytes;
+        data_owner_ = std::move(owner);
+    }
+
     std::string Tensor::toString() const
     {
         return name_ + " : " + dataTypeToString(dtype_) + shape_.toString();
@@ -85,7 +102,7 @@ namespace tc
         if (!hasData()) return false;
 
         size_t expected = numElements() * dataTypeSize(dtype_);
-        return raw_data_.size() == expected;
+        return getRawData().size() == expected;
     }
 
     size_t Tensor::dataTypeSize(DataType dt)
@@ -94,6 +111,7 @@ namespace tc
         {
             case DataType::FLOAT:      return sizeof(float);
             case DataType::DOUBLE:     return sizeof(double);
+            case DataType::FLOAT16:    return sizeof(uint16_t);
             case DataType::INT8:       return sizeof(int8_t);
             case DataType::INT16:      return sizeof(int16_t);
             case DataType::INT32:      return sizeof(int32_t);
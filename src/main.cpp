@@ -1,6 +1,11 @@
 #include "frontend/onnx_loader.hpp"
+#include "frontend/graph_serializer.hpp"
+#include "graph/scheduler.hpp"
+#include "graph/cost_model.hpp"
+#include "graph/fusion.hpp"
 #include "visualization/dot_exporter.hpp"
 #include "backend/codegen.hpp"
+#include "backend/header_emitter.hpp"
 
 #include "mlir/IR/MLIRContext.h"
 
@@ -11,14 +16,50 @@
 #include <fstream>
 #include <filesystem>
 #include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
 static void printUsage(const char* prog)
 {
     std::cout << "Usage: " << prog
-              << " <model.onnx> [codegen-options...]\n\n";
+              << " <model.onnx | graph.tcg>... [options...]\n\n"
+              << "  Several models are compiled into one object, one entry point each, sharing equal\n"
+              << "  initializers. Analyses and DOT/graph files below are done for the first one.\n\n"
+              << "  --save-graph=<path>     Write the loaded graph in the binary .tcg format\n"
+              << "  --cost-report           Print FLOPs, bytes and a roofline estimate per node\n"
+              << "  --roofline=<GF/s>,<GB/s> Machine peak and memory bandwidth for --cost-report\n"
+              << "  --dot-out=<path>        Where to write the DOT graph (default graph.dot)\n"
+              << "  --no-dot                Don't write a DOT graph\n"
+              << "  --dot-heat              Color DOT nodes by estimated cost (see --roofline)\n"
+              << "  --dot-profile=<path>    Color DOT nodes by measured time, lines of <node>,<ms>\n"
+              << "  --dot-cluster=<n>       Collapse name scopes above n nodes (default 1000, 0 = never)\n";
     tc::printMLIRHelp();
 }
 
+static std::shared_ptr<tc::Graph> loadModel(const std::filesystem::path& path)
+{
+    if (tc::isGraphFile(path))
+    {
+        // a graph saved with --save-graph, no ONNX parsing at all
+        auto graph = tc::readGraphFile(path);
+        std::cout << "Graph file: " << path << "\n\n";
+        return graph;
+    }
+
+    // the model is parsed once, for both its metadata and its graph
+    tc::OnnxSession session(path);
+
+    const auto& info = session.info();
+    std::cout << "ONNX Model Info\n"
+              << "  Version        : " << info.ir_version        << "\n"
+              << "  Producer       : " << info.producer_name     << " " << info.producer_version << "\n"
+              << "  Domain         : " << info.domain            << "\n"
+              << "  Model version  : " << info.model_version     << "\n"
+              << "  Graph name     : " << info.graph_name        << "\n\n";
+
+    return session.graph();
+}
+
 int main(int argc, char* argv[])
 {
     llvm::InitLLVM init_llvm(argc, argv);
@@ -33,37 +74,120 @@ int main(int argc, char* argv[])
 
 
 
-    const std::filesystem::path onnx_path = argv[1];
-    const std::filesystem::path dot_path  = "graph.dot";
+    // every argument that is neither an option nor an option's value is a model
+    std::vector<std::filesystem::path> model_paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" || arg == "--mlir-out") { ++i; continue; }
+        if (arg.rfind("-", 0) != 0) model_paths.emplace_back(arg);
+    }
+    if (model_paths.empty())
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
 
-    tc::CodeGenOptions mlir_opts = tc::parseMLIROptions(argc, argv);
+    std::filesystem::path dot_path = "graph.dot";
 
     try
     {
-        auto info = tc::OnnxLoader::readModelInfo(onnx_path);
-        std::cout << "ONNX Model Info\n"
-                  << "  Version        : " << info.ir_version        << "\n"
-                  << "  Producer       : " << info.producer_name     << " " << info.producer_version << "\n"
-                  << "  Domain         : " << info.domain            << "\n"
-                  << "  Model version  : " << info.model_version     << "\n"
-                  << "  Graph name     : " << info.graph_name        << "\n\n";
+        // throws on a malformed option value, e.g. an unknown --schedule
+        tc::CodeGenOptions mlir_opts = tc::parseMLIROptions(argc, argv);
+
+        std::string save_graph;
+        bool        cost_report = false;
+        std::string roofline;
+        bool        dot_heat = false;
+        std::string dot_profile;
+        tc::DotExporter::Options dot_opts;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.rfind("--save-graph=", 0) == 0)
+                save_graph = arg.substr(std::string("--save-graph=").size());
+            else if (arg == "--cost-report")
+                cost_report = true;
+            else if (arg.rfind("--roofline=", 0) == 0)
+                roofline = arg.substr(std::string("--roofline=").size());
+            else if (arg.rfind("--dot-out=", 0) == 0)
+                dot_path = arg.substr(std::string("--dot-out=").size());
+            else if (arg == "--no-dot")
+                dot_path.clear();
+            else if (arg == "--dot-heat")
+                dot_heat = true;
+            else if (arg.rfind("--dot-profile=", 0) == 0)
+                dot_profile = arg.substr(std::string("--dot-profile=").size());
+            else if (arg.rfind("--dot-cluster=", 0) == 0)
+                dot_opts.cluster_threshold = std::stoul(arg.substr(std::string("--dot-cluster=").size()));
+        }
+
+        std::vector<std::shared_ptr<tc::Graph>> graphs;
+        std::unordered_set<std::string>         symbols;
+        for (const auto& path : model_paths)
+        {
+            auto model = loadModel(path);
+
+            if (auto fused = tc::fuseLayerNorm(model))
+                std::cout << "Fused " << fused << " decomposed LayerNormalization patterns\n\n";
+            if (auto fused = tc::fuseSwish(model))
+                std::cout << "Fused " << fused << " x * Sigmoid(x) patterns into Swish\n\n";
 
-        tc::OnnxLoader loader;
-        auto graph = loader.load(onnx_path);
+            auto symbol = tc::entryPointSymbol(*model, path, symbols);
+            if (symbol != tc::cIdentifier(model->getName()))
+            {
+                std::cout << "Entry point '" << model->getName() << "' is taken, using '"
+                          << symbol << "' for " << path << "\n\n";
+                model->setName(symbol);
+            }
+            graphs.push_back(std::move(model));
+        }
+
+        const auto& graph = graphs.front();
+
+        if (!save_graph.empty())
+        {
+            tc::writeGraphFile(*graph, save_graph);
+            std::cout << "Graph file written: " << save_graph << "\n";
+        }
 
         std::cout << graph->summary() << "\n";
 
+        if (cost_report || dot_heat)
+        {
+            tc::MachineModel machine = roofline.empty() ? tc::MachineModel{} : tc::machineModelFromString(roofline);
+            auto cost = tc::estimateCost(*graph, machine);
+            if (cost_report)
+                std::cout << cost.summary(*graph) << "\n";
+            if (dot_heat)
+                dot_opts.heat = tc::heatFromCost(*graph, cost);
+        }
+        // a measured profile wins over the estimate
+        if (!dot_profile.empty())
+            dot_opts.heat = tc::loadProfile(dot_profile, *graph);
+
 
-        auto sorted = graph->topologicalSort();
-        std::cout << "Topologically sorted (" << sorted.size() << " nodes)\n";
-        for (const auto& n : sorted)
+        // computed once here, codegen emits the nodes in these orders
+        for (const auto& g : graphs)
+            mlir_opts.schedules.push_back(tc::scheduleGraph(*g, mlir_opts.schedule));
+
+        const auto& schedule = mlir_opts.schedules.front();
+        std::cout << "Schedule " << tc::schedulePolicyToString(mlir_opts.schedule)
+                  << " (" << schedule.order.size() << " nodes, peak activations "
+                  << schedule.peak_bytes << " bytes)\n";
+        for (auto id : schedule.order)
+        {
+            const auto& n = graph->getNodes()[id];
             std::cout << "  " << n->getOpStr() << "  " << n->getName() << "\n";
+        }
         std::cout << "\n";
 
         
-        tc::DotExporter exporter;
-        exporter.exportToFile(*graph, dot_path);
-        std::cout << "DOT file written: " << dot_path << "\n";
+        if (!dot_path.empty())
+        {
+            tc::DotExporter(dot_opts).exportToFile(*graph, dot_path);
+            std::cout << "DOT file written: " << dot_path << "\n";
+        }
 
 
 
@@ -100,8 +224,12 @@ int main(int argc, char* argv[])
         }
 
 
+        std::vector<const tc::Graph*> models;
+        for (const auto& g : graphs)
+            models.push_back(g.get());
+
         tc::CodeGen gen(mlir_ctx, llvm_ctx);
-        gen.generate(*graph, mlir_opts, mlir_out, asm_out);
+        gen.generate(models, mlir_opts, mlir_out, asm_out);
 
 
         
@@ -63,6 +63,9 @@
 #include <sstream>
 #include <stdexcept>
 #include <cstring>
+#include <cmath>
+#include <limits>
+#include <numbers>
 
 
 
@@ -771,6 +774,369 @@ namespace tc
     }
 
 
+    // f(x) of one activation, in x's float type
+    static mlir::Value emitActivation(OpType opType, mlir::OpBuilder& b, mlir::Location loc, mlir::Value x,
+                                      double alpha, bool tanhGelu)
+    {
+        auto type = x.getType();
+        auto cst  = [&](double v) -> mlir::Value { return mlir::arith::ConstantOp::create(b, loc, b.getFloatAttr(type, v)); };
+        auto add  = [&](mlir::Value l, mlir::Value r) -> mlir::Value { return mlir::arith::AddFOp::create(b, loc, l, r); };
+        auto mul  = [&](mlir::Value l, mlir::Value r) -> mlir::Value { return mlir::arith::MulFOp::create(b, loc, l, r); };
+
+        // 1 / (1 + exp(-v)), exp overflowing to inf still gives 0
+        auto sigmoid = [&](mlir::Value v) -> mlir::Value
+        {
+            auto e = mlir::math::ExpOp::create(b, loc, mlir::arith::NegFOp::create(b, loc, v));
+            return mlir::arith::DivFOp::create(b, loc, cst(1.0), add(cst(1.0), e));
+        };
+
+        switch (opType)
+        {
+            case OpType::Sigmoid:   return sigmoid(x);
+            case OpType::Tanh:      return mlir::math::TanhOp::create(b, loc, x);
+            case OpType::Erf:       return mlir::math::ErfOp::create(b, loc, x);
+            case OpType::Exp:       return mlir::math::ExpOp::create(b, loc, x);
+
+            // x * sigmoid(alpha * x), SiLU for alpha = 1
+            case OpType::Swish:     return mul(x, sigmoid(alpha == 1.0 ? x : mul(cst(alpha), x)));
+
+            // x * clamp(x / 6 + 1/2, 0, 1)
+            case OpType::HardSwish:
+            {
+                mlir::Value gate = add(mul(x, cst(1.0 / 6.0)), cst(0.5));
+                gate = mlir::arith::MaximumFOp::create(b, loc, gate, cst(0.0));
+                gate = mlir::arith::MinimumFOp::create(b, loc, gate, cst(1.0));
+                return mul(x, gate);
+            }
+
+            // x / 2 * (1 + erf(x / sqrt(2))), or with tanh(sqrt(2 / pi) * (x + 0.044715 x^3))
+            case OpType::Gelu:
+            {
+                mlir::Value inner;
+                if (tanhGelu)
+                {
+                    auto x3 = mul(mul(x, x), x);
+                    inner = mlir::math::TanhOp::create(b, loc, mul(cst(std::sqrt(2.0 / std::numbers::pi)), add(x, mul(cst(0.044715), x3))));
+                }
+                else
+                {
+                    inner = mlir::math::ErfOp::create(b, loc, mul(x, cst(1.0 / std::numbers::sqrt2)));
+                }
+                return mul(mul(x, cst(0.5)), add(cst(1.0), inner));
+            }
+
+            default:
+                throw std::runtime_error("Unsupported activation " + opTypeToString(opType));
+        }
+    }
+
+    mlir::Value buildActivation(OpType opType,
+                                mlir::OpBuilder& builder,
+                                mlir::Location loc,
+                                mlir::Value input,
+                                double alpha,
+                                bool tanhGelu,
+                                mlir::MLIRContext* ctx)
+    {
+        auto type     = llvm::cast<mlir::RankedTensorType>(input.getType());
+        auto elemType = type.getElementType();
+        if (!llvm::isa<mlir::FloatType>(elemType))
+            throw std::runtime_error(opTypeToString(opType) + ": unsupported element type");
+
+        auto emptyOut = mlir::tensor::EmptyOp::create(builder, loc, type, mlir::tensor::createDynamicDimValues(builder, loc, input));
+        auto idMap    = mlir::AffineMap::getMultiDimIdentityMap(type.getRank(), ctx);
+
+        // a generic rather than a named op, so elementwise fusion can merge it into its producer
+        auto generic = mlir::linalg::GenericOp::create(builder,
+                                                      loc,
+                                                      type,
+                                                      mlir::ValueRange{input},
+                                                      mlir::ValueRange{emptyOut},
+                                                      {idMap, idMap},
+                                                      llvm::SmallVector<mlir::utils::IteratorType>(type.getRank(), mlir::utils::IteratorType::parallel));
+
+        mlir::OpBuilder::InsertionGuard guard(builder);
+
+        auto* block = builder.createBlock(&generic.getRegion());
+        block->addArguments({elemType, elemType}, {loc, loc});
+        builder.setInsertionPointToStart(block);
+
+        auto out = emitActivation(opType, builder, loc, block->getArgument(0), alpha, tanhGelu);
+        mlir::linalg::YieldOp::create(builder, loc, out);
+
+        return generic->getResult(0);
+    }
+
+
+    mlir::Value buildSoftmax(mlir::OpBuilder& builder,
+                             mlir::Location loc,
+                             mlir::Value input,
+                             int64_t axis,
+                             bool logSoftmax,
+                             mlir::MLIRContext* ctx)
+    {
+        auto inType   = llvm::cast<mlir::RankedTensorType>(input.getType());
+        auto elemType = llvm::dyn_cast<mlir::FloatType>(inType.getElementType());
+        int64_t rank  = inType.getRank();
+
+        if (!elemType)
+            throw std::runtime_error("Softmax: unsupported element type");
+        if (axis < 0) axis += rank;
+        if (axis < 0 || axis >= rank)
+            throw std::runtime_error("Softmax: axis " + std::to_string(axis) + " out of range for rank " + std::to_string(rank));
+
+        // the other dimensions in order, then the softmax axis as the innermost loop, so
+        // both passes walk it contiguously when it is the last one
+        auto d = [&](unsigned i) { return mlir::getAffineDimExpr(i, ctx); };
+
+        llvm::SmallVector<mlir::AffineExpr> inExprs(rank), statExprs;
+        llvm::SmallVector<int64_t>          statShape;
+        llvm::SmallVector<mlir::Value>      statDynSizes;
+        for (int64_t i = 0, pos = 0; i < rank; ++i)
+        {
+            if (i == axis) continue;
+            inExprs[i] = d(pos);
+            statExprs.push_back(d(pos++));
+            statShape.push_back(inType.getDimSize(i));
+            if (inType.isDynamicDim(i))
+                statDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, input, i));
+        }
+        inExprs[axis] = d(rank - 1);
+
+        auto inMap   = mlir::AffineMap::get(rank, 0, inExprs, ctx);
+        auto statMap = mlir::AffineMap::get(rank, 0, statExprs, ctx);
+        auto statType = mlir::RankedTensorType::get(statShape, elemType);
+
+        auto fill = [&](mlir::TypedAttr value) -> mlir::Value
+        {
+            auto scalar = mlir::arith::ConstantOp::create(builder, loc, value);
+            auto empty  = mlir::tensor::EmptyOp::create(builder, loc, statType, statDynSizes);
+            return mlir::linalg::FillOp::create(builder, loc, mlir::ValueRange{scalar}, mlir::ValueRange{empty}).getResult(0);
+        };
+
+        // the lowest finite value rather than -inf, so a fully masked row never computes
+        // exp(-inf - -inf)
+        auto lowest  = llvm::APFloat::getLargest(elemType.getFloatSemantics(), /*Negative=*/true);
+        auto maxInit = fill(builder.getFloatAttr(elemType, lowest));
+        auto sumInit = fill(builder.getFloatAttr(elemType, 0.0));
+
+        llvm::SmallVector<mlir::utils::IteratorType> iterators(rank, mlir::utils::IteratorType::parallel);
+        iterators.back() = mlir::utils::IteratorType::reduction;
+
+        // pass 1, online normalizer: running max m and sum s of exp(x - m), rescaling s
+        // whenever m grows
+        //   m' = max(m, x),  s' = s * exp(m - m') + exp(x - m')
+        auto stats = mlir::linalg::GenericOp::create(builder,
+                                                    loc,
+                                                    mlir::TypeRange{statType, statType},
+                                                    mlir::ValueRange{input},
+                                                    mlir::ValueRange{maxInit, sumInit},
+                                                    {inMap, statMap, statMap},
+                                                    iterators);
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&stats.getRegion());
+            block->addArguments({elemType, elemType, elemType}, {loc, loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            auto x = block->getArgument(0), m = block->getArgument(1), s = block->getArgument(2);
+            auto newMax  = mlir::arith::MaximumFOp::create(builder, loc, m, x);
+            auto rescale = mlir::math::ExpOp::create(builder, loc, mlir::arith::SubFOp::create(builder, loc, m, newMax));
+            auto term    = mlir::math::ExpOp::create(builder, loc, mlir::arith::SubFOp::create(builder, loc, x, newMax));
+            auto newSum  = mlir::arith::AddFOp::create(builder, loc, mlir::arith::MulFOp::create(builder, loc, s, rescale), term);
+
+            mlir::linalg::YieldOp::create(builder, loc, mlir::ValueRange{newMax, newSum});
+        }
+
+        // pass 2, normalize: exp(x - m) / s, or (x - m) - log(s)
+        auto emptyOut = mlir::tensor::EmptyOp::create(builder, loc, inType, mlir::tensor::createDynamicDimValues(builder, loc, input));
+        iterators.back() = mlir::utils::IteratorType::parallel;
+
+        auto normalized = mlir::linalg::GenericOp::create(builder,
+                                                         loc,
+                                                         inType,
+                                                         mlir::ValueRange{input, stats.getResult(0), stats.getResult(1)},
+                                                         mlir::ValueRange{emptyOut},
+                                                         {inMap, statMap, statMap, inMap},
+                                                         iterators);
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&normalized.getRegion());
+            block->addArguments({elemType, elemType, elemType, elemType}, {loc, loc, loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            auto x = block->getArgument(0), m = block->getArgument(1), s = block->getArgument(2);
+            mlir::Value shifted = mlir::arith::SubFOp::create(builder, loc, x, m);
+            mlir::Value out;
+            if (logSoftmax)
+                out = mlir::arith::SubFOp::create(builder, loc, shifted, mlir::math::LogOp::create(builder, loc, s));
+            else
+                out = mlir::arith::DivFOp::create(builder, loc, mlir::math::ExpOp::create(builder, loc, shifted), s);
+
+            mlir::linalg::YieldOp::create(builder, loc, out);
+        }
+
+        return normalized->getResult(0);
+    }
+
+
+    mlir::Value buildLayerNorm(mlir::OpBuilder& builder,
+                               mlir::Location loc,
+                               mlir::Value input,
+                               std::optional<mlir::Value> scale,
+                               std::optional<mlir::Value> bias,
+                               int64_t axis,
+                               double epsilon,
+                               mlir::MLIRContext* ctx)
+    {
+        auto inType   = llvm::cast<mlir::RankedTensorType>(input.getType());
+        auto elemType = llvm::dyn_cast<mlir::FloatType>(inType.getElementType());
+        int64_t rank  = inType.getRank();
+
+        if (!elemType)
+            throw std::runtime_error("LayerNorm: unsupported element type");
+        if (axis < 0) axis += rank;
+        if (axis < 0 || axis >= rank)
+            throw std::runtime_error("LayerNorm: axis " + std::to_string(axis) + " out of range for rank " + std::to_string(rank));
+        for (auto param : {scale, bias})
+        {
+            if (!param) continue;
+            auto paramType = llvm::cast<mlir::RankedTensorType>(param->getType());
+            if (paramType.getRank() > rank - axis || paramType.getElementType() != elemType)
+                throw std::runtime_error("LayerNorm: scale and bias must match the normalized dimensions");
+        }
+
+        // statistics in at least f32, ONNX's default stash_type; an f16 count is exact only up to 2048
+        auto statElem = elemType.getWidth() < 32 ? llvm::cast<mlir::FloatType>(builder.getF32Type()) : elemType;
+        auto toStat = [&](mlir::Value v) -> mlir::Value
+        {
+            if (v.getType() == statElem) return v;
+            return mlir::arith::ExtFOp::create(builder, loc, statElem, v);
+        };
+
+        // the normalized dimensions [axis, rank) are the trailing loops already
+        llvm::SmallVector<mlir::AffineExpr> statExprs;
+        llvm::SmallVector<int64_t>          statShape;
+        llvm::SmallVector<mlir::Value>      statDynSizes;
+        for (int64_t i = 0; i < axis; ++i)
+        {
+            statExprs.push_back(mlir::getAffineDimExpr(i, ctx));
+            statShape.push_back(inType.getDimSize(i));
+            if (inType.isDynamicDim(i))
+                statDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, input, i));
+        }
+
+        auto idMap    = mlir::AffineMap::getMultiDimIdentityMap(rank, ctx);
+        auto statMap  = mlir::AffineMap::get(rank, 0, statExprs, ctx);
+        auto statType = mlir::RankedTensorType::get(statShape, statElem);
+
+        llvm::SmallVector<mlir::utils::IteratorType> iterators(rank, mlir::utils::IteratorType::parallel);
+        for (int64_t i = axis; i < rank; ++i) iterators[i] = mlir::utils::IteratorType::reduction;
+
+        // pass 1, Welford: mean, sum of squared deviations m2 and count n in one read
+        //   n' = n + 1,  d = x - mean,  mean' = mean + d / n',  m2' = m2 + d * (x - mean')
+        auto zero  = [&] { return createConstantTensor(builder, loc, statType, statDynSizes, 0.0); };
+        auto stats = mlir::linalg::GenericOp::create(builder,
+                                                    loc,
+                                                    mlir::TypeRange{statType, statType, statType},
+                                                    mlir::ValueRange{input},
+                                                    mlir::ValueRange{zero(), zero(), zero()},
+                                                    {idMap, statMap, statMap, statMap},
+                                                    iterators);
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&stats.getRegion());
+            block->addArguments({elemType, statElem, statElem, statElem}, {loc, loc, loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            auto x    = toStat(block->getArgument(0));
+            auto mean = block->getArgument(1), m2 = block->getArgument(2), n = block->getArgument(3);
+
+            auto one     = mlir::arith::ConstantOp::create(builder, loc, builder.getFloatAttr(statElem, 1.0));
+            auto newN    = mlir::arith::AddFOp::create(builder, loc, n, one);
+            auto delta   = mlir::arith::SubFOp::create(builder, loc, x, mean);
+            auto newMean = mlir::arith::AddFOp::create(builder, loc, mean, mlir::arith::DivFOp::create(builder, loc, delta, newN));
+            auto newM2   = mlir::arith::AddFOp::create(builder, loc, m2,
+                               mlir::arith::MulFOp::create(builder, loc, delta, mlir::arith::SubFOp::create(builder, loc, x, newMean)));
+
+            mlir::linalg::YieldOp::create(builder, loc, mlir::ValueRange{newMean, newM2, newN});
+        }
+
+        // 1 / sqrt(m2 / n + epsilon), once per row rather than per element
+        auto statId  = mlir::AffineMap::getMultiDimIdentityMap(axis, ctx);
+        auto invStd  = mlir::linalg::GenericOp::create(builder,
+                                                      loc,
+                                                      statType,
+                                                      mlir::ValueRange{stats.getResult(1), stats.getResult(2)},
+                                                      mlir::ValueRange{mlir::tensor::EmptyOp::create(builder, loc, statType, statDynSizes)},
+                                                      {statId, statId, statId},
+                                                      llvm::SmallVector<mlir::utils::IteratorType>(axis, mlir::utils::IteratorType::parallel));
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&invStd.getRegion());
+            block->addArguments({statElem, statElem, statElem}, {loc, loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            auto eps = mlir::arith::ConstantOp::create(builder, loc, builder.getFloatAttr(statElem, epsilon));
+            auto var = mlir::arith::DivFOp::create(builder, loc, block->getArgument(0), block->getArgument(1));
+            auto out = mlir::math::RsqrtOp::create(builder, loc, mlir::arith::AddFOp::create(builder, loc, var, eps));
+
+            mlir::linalg::YieldOp::create(builder, loc, mlir::ValueRange{out});
+        }
+
+        // pass 2, normalize with scale and bias applied on the way out, both broadcast over
+        // the normalized dimensions
+        llvm::SmallVector<mlir::Value>     operands{input, stats.getResult(0), invStd.getResult(0)};
+        llvm::SmallVector<mlir::AffineMap> maps{idMap, statMap, statMap};
+        llvm::SmallVector<mlir::Type>      argTypes{elemType, statElem, statElem};
+        for (auto param : {scale, bias})
+        {
+            if (!param) continue;
+            auto paramType = llvm::cast<mlir::RankedTensorType>(param->getType());
+
+            operands.push_back(*param);
+            maps.push_back(makeBroadcastMap(rank, paramType.getRank(), paramType.getShape(), ctx));
+            argTypes.push_back(elemType);
+        }
+        maps.push_back(idMap);
+        argTypes.push_back(elemType);
+
+        auto emptyOut = mlir::tensor::EmptyOp::create(builder, loc, inType, mlir::tensor::createDynamicDimValues(builder, loc, input));
+        auto normalized = mlir::linalg::GenericOp::create(builder,
+                                                         loc,
+                                                         inType,
+                                                         operands,
+                                                         mlir::ValueRange{emptyOut},
+                                                         maps,
+                                                         llvm::SmallVector<mlir::utils::IteratorType>(rank, mlir::utils::IteratorType::parallel));
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&normalized.getRegion());
+            block->addArguments(argTypes, llvm::SmallVector<mlir::Location>(argTypes.size(), loc));
+            builder.setInsertionPointToStart(block);
+
+            unsigned arg = 0;
+            auto x = toStat(block->getArgument(arg++));
+            auto mean = block->getArgument(arg++), inv = block->getArgument(arg++);
+
+            mlir::Value y = mlir::arith::MulFOp::create(builder, loc, mlir::arith::SubFOp::create(builder, loc, x, mean), inv);
+            if (scale) y = mlir::arith::MulFOp::create(builder, loc, y, toStat(block->getArgument(arg++)));
+            if (bias)  y = mlir::arith::AddFOp::create(builder, loc, y, toStat(block->getArgument(arg++)));
+            if (statElem != elemType)
+                y = mlir::arith::TruncFOp::create(builder, loc, elemType, y);
+
+            mlir::linalg::YieldOp::create(builder, loc, y);
+        }
+
+        return normalized->getResult(0);
+    }
+
+
 
 
 
@@ -1481,6 +1847,78 @@ namespace tc
             return fromElements.getResult();
         };
 
+        // bias [M] broadcasts to [N, M, oH, oW]
+        auto addBias = [&](mlir::Value result) -> mlir::Value
+        {
+            if (!bias.has_value()) return result;
+
+            mlir::Value biasVal = bias.value();
+            auto biasType = mlir::cast<mlir::RankedTensorType>(biasVal.getType());
+
+            if (biasType.getRank() != 1)
+                throw std::runtime_error("Conv2d: bias must be 1D");
+
+            auto biasReshapeType = mlir::RankedTensorType::get({1, M, 1, 1}, elemType);
+
+            llvm::SmallVector<mlir::Value> biasDynamicDims;
+            if (M == mlir::ShapedType::kDynamic)
+                biasDynamicDims.push_back(mlir::tensor::DimOp::create(builder, loc, biasVal, 0).getResult());
+
+            mlir::Value biasShapeTensor = buildReshapeShapeTensor(biasReshapeType, biasDynamicDims);
+
+            auto biasReshapeOp = mlir::tensor::ReshapeOp::create(builder, loc, biasReshapeType, biasVal, biasShapeTensor);
+            mlir::Value reshapedBias = biasReshapeOp.getResult();
+
+            return buildElementwise(OpType::Add, builder, loc, result, reshapedBias, ctx);
+        };
+
+        auto stridesAttr   = mlir::DenseI64ArrayAttr::get(ctx, {sH, sW});
+        auto dilationsAttr = mlir::DenseI64ArrayAttr::get(ctx, {dH, dW});
+
+        // without groups the plain NCHW op needs no reshapes, which keeps the convolution
+        // tileable, e.g. into the loops of a following pooling op
+        if (G == 1)
+        {
+            int64_t oH = computeConvOutputDim(paddedH, kH, 0, 0, sH, dH);
+            int64_t oW = computeConvOutputDim(paddedW, kW, 0, 0, sW, dW);
+
+            auto convOutType = mlir::RankedTensorType::get({N, M, oH, oW}, elemType);
+
+            llvm::SmallVector<mlir::Value> convDynSizes;
+            if (N == mlir::ShapedType::kDynamic)
+                convDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, paddedInput, 0).getResult());
+
+            if (M == mlir::ShapedType::kDynamic)
+                convDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, weights, 0).getResult());
+
+            if (oH == mlir::ShapedType::kDynamic)
+            {
+                mlir::Value hDim = mlir::tensor::DimOp::create(builder, loc, paddedInput, 2).getResult();
+                convDynSizes.push_back(computeConvOutputDimValue(builder, loc, hDim, kH, 0, 0, sH, dH));
+            }
+
+            if (oW == mlir::ShapedType::kDynamic)
+            {
+                mlir::Value wDim = mlir::tensor::DimOp::create(builder, loc, paddedInput, 3).getResult();
+                convDynSizes.push_back(computeConvOutputDimValue(builder, loc, wDim, kW, 0, 0, sW, dW));
+            }
+
+            auto emptyOut = mlir::tensor::EmptyOp::create(builder, loc, convOutType, convDynSizes);
+            mlir::Value zero = makeZeroConstant(builder, loc, elemType);
+            mlir::Value initOut = mlir::linalg::FillOp::create(builder, loc, mlir::ValueRange{zero}, mlir::ValueRange{emptyOut.getResult()})->getResult(0);
+
+            auto convOp = mlir::linalg::Conv2DNchwFchwOp::create(
+                builder,
+                loc,
+                mlir::TypeRange{convOutType},
+                mlir::ValueRange{paddedInput, weights},
+                mlir::ValueRange{initOut},
+                stridesAttr,
+                dilationsAttr);
+
+            return addBias(convOp->getResult(0));
+        }
+
         llvm::SmallVector<mlir::Value> inputDynamicDims;
         if (N == mlir::ShapedType::kDynamic)
             inputDynamicDims.push_back(mlir::tensor::DimOp::create(builder, loc, paddedInput, 0).getResult());
@@ -1594,9 +2032,6 @@ namespace tc
         auto fillOp = mlir::linalg::FillOp::create(builder, loc, mlir::ValueRange{zero}, mlir::ValueRange{emptyOut.getResult()});
         mlir::Value initOut = fillOp->getResult(0);
 
-        auto stridesAttr   = mlir::DenseI64ArrayAttr::get(ctx, {sH, sW});
-        auto dilationsAttr = mlir::DenseI64ArrayAttr::get(ctx, {dH, dW});
-
 
 
 
@@ -1651,33 +2086,382 @@ namespace tc
 
 
 
-        // bias [M] broadcasts to [N, M, oH, oW]
-        if (bias.has_value())
+        return addBias(result);
+    }
+
+
+    // pads dimensions 2 and 3 of an NCHW tensor with `value`
+    static mlir::Value padSpatial(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value input,
+                                  int64_t top, int64_t left, int64_t bottom, int64_t right, mlir::Value value)
+    {
+        if (top == 0 && left == 0 && bottom == 0 && right == 0) return input;
+
+        auto type = mlir::cast<mlir::RankedTensorType>(input.getType());
+        llvm::SmallVector<int64_t> shape(type.getShape());
+        auto grow = [](int64_t dim, int64_t by) { return dim == mlir::ShapedType::kDynamic ? dim : dim + by; };
+        shape[2] = grow(shape[2], top + bottom);
+        shape[3] = grow(shape[3], left + right);
+
+        llvm::SmallVector<mlir::OpFoldResult> low  = {builder.getIndexAttr(0), builder.getIndexAttr(0),
+                                                      builder.getIndexAttr(top), builder.getIndexAttr(left)};
+        llvm::SmallVector<mlir::OpFoldResult> high = {builder.getIndexAttr(0), builder.getIndexAttr(0),
+                                                      builder.getIndexAttr(bottom), builder.getIndexAttr(right)};
+
+        return mlir::tensor::PadOp::create(builder, loc, mlir::RankedTensorType::get(shape, type.getElementType()),
+                                           input, low, high, value).getResult();
+    }
+
+
+    mlir::Value buildPool2dOp(OpType opType,
+                              mlir::OpBuilder& builder,
+                              mlir::Location loc,
+                              mlir::Value input,
+                              llvm::ArrayRef<int64_t> kernelShape,
+                              llvm::ArrayRef<int64_t> strides,
+                              llvm::ArrayRef<int64_t> pads,
+                              llvm::ArrayRef<int64_t> dilations,
+                              bool ceilMode,
+                              bool countIncludePad,
+                              llvm::StringRef autoPad,
+                              mlir::MLIRContext* ctx,
+                              bool unsignedInts)
+    {
+        bool isMax = opType == OpType::MaxPool;
+        std::string name = opTypeToString(opType);
+
+        auto inputType = mlir::cast<mlir::RankedTensorType>(input.getType());
+        auto elemType  = inputType.getElementType();
+        auto floatType = llvm::dyn_cast<mlir::FloatType>(elemType);
+
+        if (!isMax && opType != OpType::AveragePool)
+            throw std::runtime_error(name + ": not a pooling op");
+        if (inputType.getRank() != 4)
+            throw std::runtime_error(name + ": input must be 4D [N, C, H, W]");
+        if (kernelShape.size() != 2)
+            throw std::runtime_error(name + ": kernel_shape must have 2 values");
+        if (!floatType && !(isMax && elemType.isSignlessInteger() && elemType.getIntOrFloatBitWidth() > 1))
+            throw std::runtime_error(name + ": unsupported element type");
+        bool unsignedMax = isMax && unsignedInts && !floatType;
+
+        int64_t N  = inputType.getDimSize(0);
+        int64_t C  = inputType.getDimSize(1);
+        int64_t H  = inputType.getDimSize(2);
+        int64_t W  = inputType.getDimSize(3);
+        int64_t kH = kernelShape[0];
+        int64_t kW = kernelShape[1];
+
+        int64_t sH = (strides.size()   > 0) ? strides[0]   : 1;
+        int64_t sW = (strides.size()   > 1) ? strides[1]   : 1;
+        int64_t dH = (dilations.size() > 0) ? dilations[0] : 1;
+        int64_t dW = (dilations.size() > 1) ? dilations[1] : 1;
+
+        int64_t padHBegin = 0, padHEnd = 0;
+        int64_t padWBegin = 0, padWEnd = 0;
+
+        if (autoPad == "NOTSET" || autoPad.empty())
         {
-            mlir::Value biasVal = bias.value();
-            auto biasType = mlir::cast<mlir::RankedTensorType>(biasVal.getType());
+            if (pads.size() >= 4)
+            {
+                padHBegin = pads[0];
+                padWBegin = pads[1];
+                padHEnd   = pads[2];
+                padWEnd   = pads[3];
+            }
+        }
 
-            if (biasType.getRank() != 1)
-                throw std::runtime_error("Conv2d: bias must be 1D");
+        else if (autoPad == "SAME_UPPER" || autoPad == "SAME_LOWER")
+        {
+            if (H == mlir::ShapedType::kDynamic || W == mlir::ShapedType::kDynamic)
+                throw std::runtime_error(name + ": auto_pad " + autoPad.str() + " needs static spatial dimensions");
 
-            auto biasReshapeType = mlir::RankedTensorType::get({1, M, 1, 1}, elemType);
+            bool upper = (autoPad == "SAME_UPPER");
+            computeSamePad(H, kH, sH, dH, upper, padHBegin, padHEnd);
+            computeSamePad(W, kW, sW, dW, upper, padWBegin, padWEnd);
+        }
 
-            llvm::SmallVector<mlir::Value> biasDynamicDims;
-            if (M == mlir::ShapedType::kDynamic)
-                biasDynamicDims.push_back(mlir::tensor::DimOp::create(builder, loc, biasVal, 0).getResult());
+        else if (autoPad != "VALID")
+        {
+            throw std::runtime_error(name + ": unknown auto_pad value: " + autoPad.str());
+        }
 
-            mlir::Value biasShapeTensor = buildReshapeShapeTensor(biasReshapeType, biasDynamicDims);
+        // ceil_mode keeps the last partial window, unless it would start in the end padding.
+        // It becomes extra end padding that averages never count
+        auto ceilPad = [&](int64_t in, int64_t k, int64_t padBegin, int64_t padEnd, int64_t stride, int64_t dilation) -> int64_t
+        {
+            if (!ceilMode) return 0;
+            if (in == mlir::ShapedType::kDynamic)
+                throw std::runtime_error(name + ": ceil_mode needs static spatial dimensions");
+
+            int64_t extent = dilation * (k - 1) + 1;
+            int64_t span   = in + padBegin + padEnd - extent;
+            int64_t out    = (span + stride - 1) / stride + 1;
+            if ((out - 1) * stride >= in + padBegin) --out;
+            return std::max<int64_t>(0, (out - 1) * stride + extent - (in + padBegin + padEnd));
+        };
+        int64_t ceilH = ceilPad(H, kH, padHBegin, padHEnd, sH, dH);
+        int64_t ceilW = ceilPad(W, kW, padWBegin, padWEnd, sW, dW);
+
+        // padding never wins a max, and adds nothing to a sum
+        mlir::Value padValue;
+        if (!isMax || unsignedMax)
+            padValue = makeZeroConstant(builder, loc, elemType);
+        else if (floatType)
+            padValue = mlir::arith::ConstantOp::create(builder, loc, builder.getFloatAttr(elemType, -std::numeric_limits<double>::infinity()));
+        else
+            padValue = mlir::arith::ConstantOp::create(builder, loc, builder.getIntegerAttr(elemType,
+                           llvm::APInt::getSignedMinValue(elemType.getIntOrFloatBitWidth())));
 
-            auto biasReshapeOp = mlir::tensor::ReshapeOp::create(builder, loc, biasReshapeType, biasVal, biasShapeTensor);
-            mlir::Value reshapedBias = biasReshapeOp.getResult();
+        mlir::Value padded = padSpatial(builder, loc, input, padHBegin, padWBegin, padHEnd + ceilH, padWEnd + ceilW, padValue);
+        auto paddedType = mlir::cast<mlir::RankedTensorType>(padded.getType());
 
-            result = buildElementwise(OpType::Add, builder, loc, result, reshapedBias, ctx);
+        // sums of narrow floats are kept in f32
+        mlir::Type accType = elemType;
+        if (!isMax && floatType.getWidth() < 32) accType = builder.getF32Type();
+
+        int64_t oH = computeConvOutputDim(paddedType.getDimSize(2), kH, 0, 0, sH, dH);
+        int64_t oW = computeConvOutputDim(paddedType.getDimSize(3), kW, 0, 0, sW, dW);
+
+        llvm::SmallVector<mlir::Value> outDynSizes;
+        if (N == mlir::ShapedType::kDynamic)
+            outDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, padded, 0).getResult());
+
+        if (C == mlir::ShapedType::kDynamic)
+            outDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, padded, 1).getResult());
+
+        if (oH == mlir::ShapedType::kDynamic)
+        {
+            mlir::Value hDim = mlir::tensor::DimOp::create(builder, loc, padded, 2).getResult();
+            outDynSizes.push_back(computeConvOutputDimValue(builder, loc, hDim, kH, 0, 0, sH, dH));
+        }
+
+        if (oW == mlir::ShapedType::kDynamic)
+        {
+            mlir::Value wDim = mlir::tensor::DimOp::create(builder, loc, padded, 3).getResult();
+            outDynSizes.push_back(computeConvOutputDimValue(builder, loc, wDim, kW, 0, 0, sW, dW));
+        }
+
+        auto stridesAttr   = mlir::DenseI64ArrayAttr::get(ctx, {sH, sW});
+        auto dilationsAttr = mlir::DenseI64ArrayAttr::get(ctx, {dH, dW});
+
+        // only the shape of the window operand matters
+        auto window = mlir::tensor::EmptyOp::create(builder, loc, llvm::ArrayRef<int64_t>{kH, kW}, elemType);
+
+        auto accOutType = mlir::RankedTensorType::get({N, C, oH, oW}, accType);
+        auto accEmpty   = mlir::tensor::EmptyOp::create(builder, loc, accOutType, outDynSizes);
+        mlir::Value init = mlir::linalg::FillOp::create(builder, loc, mlir::ValueRange{isMax ? padValue : makeZeroConstant(builder, loc, accType)},
+                                                        mlir::ValueRange{accEmpty.getResult()})->getResult(0);
+
+        // linalg's max pooling compares signed, unsigned integers get the same loops as a generic
+        if (unsignedMax)
+        {
+            auto d = [&](unsigned i) { return mlir::getAffineDimExpr(i, ctx); };
+            auto inMap = mlir::AffineMap::get(6, 0, {d(0), d(1), d(2) * sH + d(4) * dH, d(3) * sW + d(5) * dW}, ctx);
+
+            llvm::SmallVector<mlir::utils::IteratorType> iterators(4, mlir::utils::IteratorType::parallel);
+            iterators.append(2, mlir::utils::IteratorType::reduction);
+
+            auto max = mlir::linalg::GenericOp::create(builder,
+                                                       loc,
+                                                       accOutType,
+                                                       mlir::ValueRange{padded, window},
+                                                       mlir::ValueRange{init},
+                                                       {inMap,
+                                                        mlir::AffineMap::get(6, 0, {d(4), d(5)}, ctx),
+                                                        mlir::AffineMap::get(6, 0, {d(0), d(1), d(2), d(3)}, ctx)},
+                                                       iterators);
+
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&max.getRegion());
+            block->addArguments({elemType, elemType, elemType}, {loc, loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            mlir::Value value = mlir::arith::MaxUIOp::create(builder, loc, block->getArgument(2), block->getArgument(0));
+            mlir::linalg::YieldOp::create(builder, loc, value);
+
+            return max->getResult(0);
+        }
+
+        if (isMax)
+        {
+            return mlir::linalg::PoolingNchwMaxOp::create(builder, loc, mlir::TypeRange{accOutType},
+                                                          mlir::ValueRange{padded, window}, mlir::ValueRange{init},
+                                                          stridesAttr, dilationsAttr)->getResult(0);
+        }
+
+        mlir::Value sum = mlir::linalg::PoolingNchwSumOp::create(builder, loc, mlir::TypeRange{accOutType},
+                                                                 mlir::ValueRange{padded, window}, mlir::ValueRange{init},
+                                                                 stridesAttr, dilationsAttr)->getResult(0);
+
+        // the divisor of each output position, by sum pooling a padded plane of ones, unless
+        // every window counts all kH * kW positions
+        mlir::Value counts;
+        if (!countIncludePad || ceilH > 0 || ceilW > 0)
+        {
+            llvm::SmallVector<mlir::Value> planeDynSizes;
+            if (H == mlir::ShapedType::kDynamic) planeDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, input, 2).getResult());
+            if (W == mlir::ShapedType::kDynamic) planeDynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, input, 3).getResult());
+
+            auto accZero = makeZeroConstant(builder, loc, accType);
+            auto accOne  = mlir::arith::ConstantOp::create(builder, loc, builder.getFloatAttr(accType, 1.0));
+
+            mlir::Value plane = createConstantTensor(builder, loc, mlir::RankedTensorType::get({1, 1, H, W}, accType), planeDynSizes, 1.0);
+            plane = padSpatial(builder, loc, plane, padHBegin, padWBegin, padHEnd, padWEnd, countIncludePad ? accOne : accZero);
+            plane = padSpatial(builder, loc, plane, 0, 0, ceilH, ceilW, accZero);
+
+            // oH and oW are the last of the output's dynamic sizes
+            auto spatialFrom = static_cast<size_t>(accOutType.isDynamicDim(0)) + static_cast<size_t>(accOutType.isDynamicDim(1));
+            llvm::SmallVector<mlir::Value> countDynSizes(outDynSizes.begin() + spatialFrom, outDynSizes.end());
+
+            auto countType = mlir::RankedTensorType::get({1, 1, oH, oW}, accType);
+            auto countInit = createConstantTensor(builder, loc, countType, countDynSizes, 0.0);
+            counts = mlir::linalg::PoolingNchwSumOp::create(builder, loc, mlir::TypeRange{countType},
+                                                            mlir::ValueRange{plane, window}, mlir::ValueRange{countInit},
+                                                            stridesAttr, dilationsAttr)->getResult(0);
+        }
+
+        // sum / count back in the input's type
+        auto d = [&](unsigned i) { return mlir::getAffineDimExpr(i, ctx); };
+        auto zeroExpr = mlir::getAffineConstantExpr(0, ctx);
+        auto idMap    = mlir::AffineMap::getMultiDimIdentityMap(4, ctx);
+        auto countMap = mlir::AffineMap::get(4, 0, {zeroExpr, zeroExpr, d(2), d(3)}, ctx);
+
+        llvm::SmallVector<mlir::Value>     ins  = {sum};
+        llvm::SmallVector<mlir::AffineMap> maps = {idMap};
+        if (counts)
+        {
+            ins.push_back(counts);
+            maps.push_back(countMap);
+        }
+        maps.push_back(idMap);
+
+        auto outType  = mlir::RankedTensorType::get({N, C, oH, oW}, elemType);
+        auto outEmpty = mlir::tensor::EmptyOp::create(builder, loc, outType, outDynSizes);
+
+        auto average = mlir::linalg::GenericOp::create(builder,
+                                                       loc,
+                                                       outType,
+                                                       ins,
+                                                       mlir::ValueRange{outEmpty},
+                                                       maps,
+                                                       llvm::SmallVector<mlir::utils::IteratorType>(4, mlir::utils::IteratorType::parallel));
+
+        mlir::OpBuilder::InsertionGuard guard(builder);
+
+        auto* block = builder.createBlock(&average.getRegion());
+        llvm::SmallVector<mlir::Type>     argTypes(ins.size(), accType);
+        argTypes.push_back(elemType);
+        block->addArguments(argTypes, llvm::SmallVector<mlir::Location>(argTypes.size(), loc));
+        builder.setInsertionPointToStart(block);
+
+        mlir::Value value;
+        if (counts)
+        {
+            value = mlir::arith::DivFOp::create(builder, loc, block->getArgument(0), block->getArgument(1));
         }
+        else
+        {
+            auto scale = mlir::arith::ConstantOp::create(builder, loc, builder.getFloatAttr(accType, 1.0 / static_cast<double>(kH * kW)));
+            value = mlir::arith::MulFOp::create(builder, loc, block->getArgument(0), scale);
+        }
+        if (accType != elemType)
+            value = mlir::arith::TruncFOp::create(builder, loc, elemType, value);
+        mlir::linalg::YieldOp::create(builder, loc, value);
 
-        return result;
+        return average->getResult(0);
     }
 
 
-}
+    mlir::Value buildGlobalAveragePool(mlir::OpBuilder& builder, mlir::Location loc, mlir::Value input, mlir::MLIRContext* ctx)
+    {
+        auto inputType = mlir::cast<mlir::RankedTensorType>(input.getType());
+        auto elemType  = llvm::dyn_cast<mlir::FloatType>(inputType.getElementType());
+        int64_t rank   = inputType.getRank();
+
+        if (rank < 3)
+            throw std::runtime_error("GlobalAveragePool: input must be at least 3D [N, C, ...]");
+        if (!elemType)
+            throw std::runtime_error("GlobalAveragePool: unsupported element type");
+
+        // sums of narrow floats are kept in f32
+        auto accType = elemType.getWidth() < 32 ? llvm::cast<mlir::FloatType>(builder.getF32Type()) : elemType;
+
+        auto d = [&](unsigned i) { return mlir::getAffineDimExpr(i, ctx); };
 
+        llvm::SmallVector<mlir::Value> dynSizes;
+        for (unsigned i = 0; i < 2; ++i)
+            if (inputType.isDynamicDim(i))
+                dynSizes.push_back(mlir::tensor::DimOp::create(builder, loc, input, i).getResult());
 
+        // the spatial element count, folded away for static shapes
+        mlir::Value count = mlir::arith::ConstantIndexOp::create(builder, loc, 1);
+        for (int64_t i = 2; i < rank; ++i)
+        {
+            mlir::Value dim = mlir::tensor::DimOp::create(builder, loc, input, i);
+            count = mlir::arith::MulIOp::create(builder, loc, count, dim);
+        }
+        count = mlir::arith::IndexCastOp::create(builder, loc, builder.getI64Type(), count);
+        count = mlir::arith::SIToFPOp::create(builder, loc, accType, count);
+
+        auto sumType = mlir::RankedTensorType::get({inputType.getDimSize(0), inputType.getDimSize(1)}, accType);
+        auto sumInit = createConstantTensor(builder, loc, sumType, dynSizes, 0.0);
+
+        llvm::SmallVector<mlir::utils::IteratorType> iterators(rank, mlir::utils::IteratorType::reduction);
+        iterators[0] = iterators[1] = mlir::utils::IteratorType::parallel;
+
+        auto sum = mlir::linalg::GenericOp::create(builder,
+                                                   loc,
+                                                   sumType,
+                                                   mlir::ValueRange{input},
+                                                   mlir::ValueRange{sumInit},
+                                                   {mlir::AffineMap::getMultiDimIdentityMap(rank, ctx),
+                                                    mlir::AffineMap::get(rank, 0, {d(0), d(1)}, ctx)},
+                                                   iterators);
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&sum.getRegion());
+            block->addArguments({elemType, accType}, {loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            mlir::Value x = block->getArgument(0);
+            if (accType != elemType) x = mlir::arith::ExtFOp::create(builder, loc, accType, x);
+            mlir::linalg::YieldOp::create(builder, loc, mlir::Value(mlir::arith::AddFOp::create(builder, loc, block->getArgument(1), x)));
+        }
+
+        auto meanType = mlir::RankedTensorType::get(sumType.getShape(), elemType);
+        auto meanEmpty = mlir::tensor::EmptyOp::create(builder, loc, meanType, dynSizes);
+        auto idMap = mlir::AffineMap::getMultiDimIdentityMap(2, ctx);
+
+        auto mean = mlir::linalg::GenericOp::create(builder,
+                                                    loc,
+                                                    meanType,
+                                                    mlir::ValueRange{sum->getResult(0)},
+                                                    mlir::ValueRange{meanEmpty},
+                                                    {idMap, idMap},
+                                                    llvm::SmallVector<mlir::utils::IteratorType>(2, mlir::utils::IteratorType::parallel));
+        {
+            mlir::OpBuilder::InsertionGuard guard(builder);
+
+            auto* block = builder.createBlock(&mean.getRegion());
+            block->addArguments({accType, elemType}, {loc, loc});
+            builder.setInsertionPointToStart(block);
+
+            mlir::Value value = mlir::arith::DivFOp::create(builder, loc, block->getArgument(0), count);
+            if (accType != elemType) value = mlir::arith::TruncFOp::create(builder, loc, elemType, value);
+            mlir::linalg::YieldOp::create(builder, loc, value);
+        }
+
+        // [N, C] to [N, C, 1, ...]
+        llvm::SmallVector<int64_t> outShape(rank, 1);
+        outShape[0] = inputType.getDimSize(0);
+        outShape[1] = inputType.getDimSize(1);
+
+        llvm::SmallVector<mlir::ReassociationIndices> groups = {{0}, {1}};
+        for (int64_t i = 2; i < rank; ++i) groups.back().push_back(i);
+
+        return mlir::tensor::ExpandShapeOp::create(builder, loc, mlir::RankedTensorType::get(outShape, elemType),
+                                                   mean->getResult(0), groups).getResult();
+    }
+
+}
@@ -0,0 +1,226 @@
+#include "runtime/tc_runtime.h"
+#include "runtime/task_scheduler.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The mlirAsyncRuntime* C ABI that MLIR's convert-async-to-llvm lowers async.execute,
+// async.await and async groups to, implemented on TaskScheduler. The reference counting
+// follows the upstream runtime: tokens and values start with two references, one of them
+// dropped when they are emplaced, groups start with one.
+
+namespace tc
+{
+
+    class RefCounted
+    {
+    public:
+        explicit RefCounted(int64_t count) : ref_count_(count) {}
+        virtual ~RefCounted() = default;
+
+        void addRef(int64_t count) { ref_count_.fetch_add(count, std::memory_order_relaxed); }
+
+        void dropRef(int64_t count)
+        {
+            if (ref_count_.fetch_sub(count, std::memory_order_acq_rel) == count)
+                delete this;
+        }
+
+    private:
+        std::atomic<int64_t> ref_count_;
+    };
+
+    // something that becomes available, or an error, exactly once
+    class Awaitable : public RefCounted
+    {
+    public:
+        enum class State : int { Unavailable, Available, Error };
+
+        using RefCounted::RefCounted;
+
+        [[nodiscard]] bool ready() const { return state_.load(std::memory_order_acquire) != State::Unavailable; }
+        [[nodiscard]] bool isError() const { return state_.load(std::memory_order_acquire) == State::Error; }
+
+        // runs fn now if ready, otherwise on the thread that completes this
+        void onReady(std::function<void()> fn)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (!ready())
+                {
+                    awaiters_.push_back(std::move(fn));
+                    return;
+                }
+            }
+            fn();
+        }
+
+        void complete(State state)
+        {
+            std::vector<std::function<void()>> awaiters;
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                state_.store(state, std::memory_order_release);
+                awaiters.swap(awaiters_);
+            }
+            for (auto& fn : awaiters) fn();
+            TaskScheduler::global().notifyWaiters();
+        }
+
+        // blocks, running other tasks meanwhile
+        void wait() const
+        {
+            TaskScheduler::global().waitUntil([this] { return ready(); });
+        }
+
+    private:
+        std::atomic<State>                 state_{State::Unavailable};
+        std::mutex                         mu_;
+        std::vector<std::function<void()>> awaiters_;
+    };
+
+    struct AsyncToken : Awaitable
+    {
+        AsyncToken() : Awaitable(2) {}
+    };
+
+    struct AsyncValue : Awaitable
+    {
+        explicit AsyncValue(int64_t size)
+            : Awaitable(2), storage(new std::max_align_t[(size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)])
+        {}
+
+        std::unique_ptr<std::max_align_t[]> storage;
+    };
+
+    struct AsyncGroup : Awaitable
+    {
+        explicit AsyncGroup(int64_t size) : Awaitable(1), pending(size)
+        {
+            if (size == 0) complete(State::Available);
+        }
+
+        std::atomic<int64_t> pending;
+        std::atomic<int64_t> rank{0};
+        std::atomic<int64_t> errors{0};
+    };
+
+    // a suspended coroutine continues on the pool, so consumers released by one producer
+    // run in parallel instead of one after another on the producer's thread
+    static std::function<void()> resumeOnPool(void* handle, void (*resume)(void*))
+    {
+        return [handle, resume] { TaskScheduler::global().submit({resume, handle}); };
+    }
+
+} // namespace tc
+
+
+using tc::AsyncGroup;
+using tc::AsyncToken;
+using tc::AsyncValue;
+using CoroHandle = void*;
+using CoroResume = void (*)(void*);
+
+extern "C"
+{
+
+    void mlirAsyncRuntimeAddRef(void* ptr, int64_t count)  { static_cast<tc::RefCounted*>(ptr)->addRef(count); }
+    void mlirAsyncRuntimeDropRef(void* ptr, int64_t count) { static_cast<tc::RefCounted*>(ptr)->dropRef(count); }
+
+    AsyncToken* mlirAsyncRuntimeCreateToken()             { return new AsyncToken(); }
+    AsyncValue* mlirAsyncRuntimeCreateValue(int64_t size) { return new AsyncValue(size); }
+    AsyncGroup* mlirAsyncRuntimeCreateGroup(int64_t size) { return new AsyncGroup(size); }
+
+    int64_t mlirAsyncRuntimeAddTokenToGroup(AsyncToken* token, AsyncGroup* group)
+    {
+        int64_t rank = group->rank.fetch_add(1);
+
+        group->addRef(1);
+        token->onReady([token, group]
+        {
+            if (token->isError()) group->errors.fetch_add(1);
+            if (group->pending.fetch_sub(1) == 1)
+                group->complete(group->errors.load() > 0 ? tc::Awaitable::State::Error
+                                                         : tc::Awaitable::State::Available);
+            group->dropRef(1);
+        });
+        return rank;
+    }
+
+    bool mlirAsyncRuntimeIsTokenError(AsyncToken* token) { return token->isError(); }
+    bool mlirAsyncRuntimeIsValueError(AsyncValue* value) { return value->isError(); }
+    bool mlirAsyncRuntimeIsGroupError(AsyncGroup* group) { return group->errors.load() > 0; }
+
+    void mlirAsyncRuntimeEmplaceToken(AsyncToken* token)
+    {
+        token->complete(tc::Awaitable::State::Available);
+        token->dropRef(1);
+    }
+
+    void mlirAsyncRuntimeEmplaceValue(AsyncValue* value)
+    {
+        value->complete(tc::Awaitable::State::Available);
+        value->dropRef(1);
+    }
+
+    void mlirAsyncRuntimeSetTokenError(AsyncToken* token)
+    {
+        token->complete(tc::Awaitable::State::Error);
+        token->dropRef(1);
+    }
+
+    void mlirAsyncRuntimeSetValueError(AsyncValue* value)
+    {
+        value->complete(tc::Awaitable::State::Error);
+        value->dropRef(1);
+    }
+
+    void mlirAsyncRuntimeAwaitToken(AsyncToken* token)       { token->wait(); }
+    void mlirAsyncRuntimeAwaitValue(AsyncValue* value)       { value->wait(); }
+    void mlirAsyncRuntimeAwaitAllInGroup(AsyncGroup* group)  { group->wait(); }
+
+    void* mlirAsyncRuntimeGetValueStorage(AsyncValue* value) { return value->storage.get(); }
+
+    void mlirAsyncRuntimeExecute(CoroHandle handle, CoroResume resume)
+    {
+        tc::TaskScheduler::global().submit({resume, handle});
+    }
+
+    void mlirAsyncRuntimeAwaitTokenAndExecute(AsyncToken* token, CoroHandle handle, CoroResume resume)
+    {
+        token->onReady(tc::resumeOnPool(handle, resume));
+    }
+
+    void mlirAsyncRuntimeAwaitValueAndExecute(AsyncValue* value, CoroHandle handle, CoroResume resume)
+    {
+        value->onReady(tc::resumeOnPool(handle, resume));
+    }
+
+    void mlirAsyncRuntimeAwaitAllInGroupAndExecute(AsyncGroup* group, CoroHandle handle, CoroResume resume)
+    {
+        group->onReady(tc::resumeOnPool(handle, resume));
+    }
+
+    // the name the async lowering calls, misspelled upstream
+    int64_t mlirAsyncRuntimGetNumWorkerThreads()
+    {
+        return static_cast<int64_t>(tc::TaskScheduler::global().numWorkers()) + 1;
+    }
+
+    void mlirAsyncRuntimePrintCurrentThreadId()
+    {
+        std::cout << "Current thread id: " << std::this_thread::get_id() << std::endl;
+    }
+
+    int32_t tc_runtime_num_threads(void)
+    {
+        return static_cast<int32_t>(mlirAsyncRuntimGetNumWorkerThreads());
+    }
+
+} // extern "C"
@@ -0,0 +1,79 @@
+#include "runtime/tc_runtime.h"
+#include "runtime/task_scheduler.hpp"
+
+#include <atomic>
+#include <new>
+
+// tc_request: a detached task on TaskScheduler::global() with a completion flag a caller can
+// block on. Detached, because a request's model may wait on its own async work, and that
+// wait must not pick up the next request.
+// std::atomic::wait() sleeps on a futex on Linux, so a waiting thread costs nothing until
+// the request completes.
+
+struct tc_request
+{
+    int (*fn)(void*);
+    void*            arg;
+    tc_completion_fn on_done;
+    void*            user_data;
+
+    int               status = 0;
+    std::atomic<int>  done{0};
+    std::atomic<int>  refs{2};      // the queued task and the caller's handle
+};
+
+namespace tc
+{
+
+    static void releaseRequest(tc_request* req)
+    {
+        if (req->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete req;
+    }
+
+    static void runRequest(void* arg)
+    {
+        auto* req = static_cast<tc_request*>(arg);
+
+        req->status = req->fn(req->arg);
+        if (req->on_done)
+            req->on_done(req->status, req->user_data);
+
+        req->done.store(1, std::memory_order_release);
+        req->done.notify_all();
+        releaseRequest(req);
+    }
+
+} // namespace tc
+
+
+extern "C"
+{
+
+    tc_request* tc_runtime_submit(int (*fn)(void*), void* arg, tc_completion_fn on_done, void* user_data)
+    {
+        auto* req = new (std::nothrow) tc_request{fn, arg, on_done, user_data};
+        if (!req) return nullptr;
+
+        tc::TaskScheduler::global().submitDetached({tc::runRequest, req});
+        return req;
+    }
+
+    int tc_request_done(const tc_request* req)
+    {
+        return req->done.load(std::memory_order_acquire);
+    }
+
+    int tc_request_wait(tc_request* req)
+    {
+        while (!req->done.load(std::memory_order_acquire))
+            req->done.wait(0, std::memory_order_acquire);
+        return req->status;
+    }
+
+    void tc_request_release(tc_request* req)
+    {
+        if (req) tc::releaseRequest(req);
+    }
+
+} // extern "C"
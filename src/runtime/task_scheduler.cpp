@@ -0,0 +1,186 @@
+#include "runtime/task_scheduler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace tc
+{
+
+    // the worker a thread is, in the scheduler it belongs to
+    static thread_local const TaskScheduler* tl_scheduler = nullptr;
+    static thread_local unsigned             tl_worker    = 0;
+
+    unsigned threadBudget()
+    {
+        if (const char* env = std::getenv("TC_NUM_THREADS"))
+        {
+            try
+            {
+                int n = std::stoi(env);
+                if (n > 0) return static_cast<unsigned>(n);
+            }
+            catch (const std::logic_error&) {}
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    TaskScheduler::TaskScheduler(unsigned num_workers)
+    {
+        queues_.reserve(num_workers);
+        for (unsigned i = 0; i < num_workers; ++i)
+            queues_.push_back(std::make_unique<Queue>());
+
+        workers_.reserve(num_workers);
+        for (unsigned i = 0; i < num_workers; ++i)
+            workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_)
+            w.join();
+    }
+
+    TaskScheduler& TaskScheduler::global()
+    {
+        // at least one worker, requests must make progress with nobody waiting on them
+        static TaskScheduler scheduler(std::max(1u, threadBudget() - 1));
+        return scheduler;
+    }
+
+    void TaskScheduler::submit(Task task)
+    {
+        // a worker keeps what it spawns, for locality; others may steal it
+        Queue& q = tl_scheduler == this ? *queues_[tl_worker] : shared_;
+
+        // counted first, so the count never drops below the tasks actually queued
+        pending_.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(q.mu);
+            q.tasks.push_back(task);
+        }
+        wake();
+    }
+
+    void TaskScheduler::submitDetached(Task task)
+    {
+        detached_pending_.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(detached_.mu);
+            detached_.tasks.push_back(task);
+        }
+        // all of them: a waiter woken instead of an idle worker would go back to sleep
+        notifyWaiters();
+    }
+
+    void TaskScheduler::wake()
+    {
+        // taking the lock orders this against a sleeper checking its predicate
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+        }
+        cv_.notify_one();
+    }
+
+    void TaskScheduler::notifyWaiters()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+        }
+        cv_.notify_all();
+    }
+
+    bool TaskScheduler::popLocal(unsigned index, Task& task)
+    {
+        Queue& q = *queues_[index];
+        std::lock_guard<std::mutex> lock(q.mu);
+        if (q.tasks.empty()) return false;
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool TaskScheduler::popShared(Task& task)
+    {
+        std::lock_guard<std::mutex> lock(shared_.mu);
+        if (shared_.tasks.empty()) return false;
+        task = shared_.tasks.front();
+        shared_.tasks.pop_front();
+        return true;
+    }
+
+    bool TaskScheduler::popDetached(Task& task)
+    {
+        std::lock_guard<std::mutex> lock(detached_.mu);
+        if (detached_.tasks.empty()) return false;
+        task = detached_.tasks.front();
+        detached_.tasks.pop_front();
+        detached_pending_.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    bool TaskScheduler::steal(unsigned thief, Task& task)
+    {
+        const auto n = static_cast<unsigned>(queues_.size());
+        for (unsigned k = 1; k <= n; ++k)
+        {
+            Queue& q = *queues_[(thief + k) % n];
+            std::lock_guard<std::mutex> lock(q.mu);
+            if (q.tasks.empty()) continue;
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool TaskScheduler::runOne()
+    {
+        if (pending_.load(std::memory_order_acquire) == 0) return false;
+
+        Task task;
+        bool is_worker = tl_scheduler == this;
+        bool found = (is_worker && popLocal(tl_worker, task)) ||
+                     popShared(task) ||
+                     (!queues_.empty() && steal(is_worker ? tl_worker : 0, task));
+        if (!found) return false;
+
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+        task.fn(task.arg);
+        return true;
+    }
+
+    void TaskScheduler::workerLoop(unsigned index)
+    {
+        tl_scheduler = this;
+        tl_worker    = index;
+
+        while (true)
+        {
+            // work of requests already running first, a new request only when there is none
+            if (runOne()) continue;
+
+            Task task;
+            if (detached_pending_.load(std::memory_order_acquire) > 0 && popDetached(task))
+            {
+                task.fn(task.arg);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [&]
+            {
+                return stop_ || pending_.load(std::memory_order_acquire) > 0 ||
+                       detached_pending_.load(std::memory_order_acquire) > 0;
+            });
+            if (stop_) return;
+        }
+    }
+
+} // namespace tc
@@ -4,6 +4,14 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace tc
 {
@@ -15,7 +23,17 @@ namespace tc
         switch (op)
         {
             case OpType::Conv:      return "#AED6F1";
-            case OpType::Relu:      return "#A9DFBF";
+            case OpType::MaxPool:
+            case OpType::AveragePool:
+            case OpType::GlobalAveragePool: return "#85C1E9";
+            case OpType::Relu:
+            case OpType::Sigmoid:
+            case OpType::Tanh:
+            case OpType::Gelu:
+            case OpType::Swish:
+            case OpType::HardSwish:
+            case OpType::Erf:
+            case OpType::Exp:       return "#A9DFBF";
             case OpType::Add:       return "#F9E79F";
             case OpType::Mul:       return "#F5CBA7";
             case OpType::MatMul:    return "#D7BDE2";
@@ -23,11 +41,25 @@ namespace tc
             case OpType::Shape:     return "#A99BD3";
             case OpType::Reshape:   return "#394B43";
             case OpType::Concat:    return "#A9DF1F";
+            case OpType::Softmax:
+            case OpType::LogSoftmax: return "#F1948A";
+            case OpType::LayerNormalization: return "#76D7C4";
             
             default:                return "#E8E8E8";
         }
     }
 
+    // white to dark red
+    std::string DotExporter::heatColor(double fraction)
+    {
+        fraction = std::clamp(fraction, 0.0, 1.0);
+        auto mix = [&](int lo, int hi) { return static_cast<int>(std::lround(lo + (hi - lo) * fraction)); };
+
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "#%02X%02X%02X", mix(0xFF, 0xA5), mix(0xF5, 0x0F), mix(0xF0, 0x15));
+        return buf;
+    }
+
     std::string DotExporter::escapeLabel(const std::string& s)
     {
         std::string out;
@@ -45,190 +77,364 @@ namespace tc
         return out;
     }
 
-    std::string DotExporter::toDot(const Graph& graph) const
+    NodeHeat heatFromCost(const Graph& graph, const CostReport& report)
     {
-        std::ostringstream dot;
+        NodeHeat heat(graph.getNodes().size(), 0.0);
+        for (const auto& c : report.nodes)
+            heat[c.node] = c.seconds;
+        return heat;
+    }
 
-        dot << "digraph \"" << escapeLabel(graph.getName()) << "\" {\n";
-        dot << "  graph [rankdir=TB, bgcolor=\"#FAFAFA\", fontname=\"Helvetica\"];\n";
-        dot << "  node  [shape=record, style=filled, fontname=\"Helvetica\", fontsize=11];\n";
-        dot << "  edge  [fontname=\"Helvetica\", fontsize=9];\n\n";
+    NodeHeat loadProfile(const std::filesystem::path& path, const Graph& graph)
+    {
+        std::ifstream ifs(path);
+        if (!ifs)
+            throw std::runtime_error("Cannot open profile: " + path.string());
 
-        const auto& tensors = graph.getTensors();
+        NodeHeat heat(graph.getNodes().size(), 0.0);
+        size_t matched = 0;
 
-        dot << "  // Graph inputs\n";
-        for (const auto& inp : graph.getInputs())
+        std::string line;
+        for (size_t line_no = 1; std::getline(ifs, line); ++line_no)
         {
-            std::string label = escapeLabel(inp);
-
-            if (opts_.show_tensor_shapes)
+            std::string_view sv(line);
+            while (!sv.empty() && std::isspace(static_cast<unsigned char>(sv.back())))  sv.remove_suffix(1);
+            while (!sv.empty() && std::isspace(static_cast<unsigned char>(sv.front()))) sv.remove_prefix(1);
+            if (sv.empty() || sv.front() == '#') continue;
+
+            // the time is the last field, the name is everything before it
+            auto cut = sv.find_last_of(", \t");
+            if (cut == std::string_view::npos)
+                throw std::runtime_error("Profile " + path.string() + ":" + std::to_string(line_no) +
+                                         ": expected <node name>,<milliseconds>");
+
+            std::string_view name = sv.substr(0, cut);
+            while (!name.empty() && (name.back() == ',' || std::isspace(static_cast<unsigned char>(name.back()))))
+                name.remove_suffix(1);
+
+            double ms = 0.0;
+            try
+            {
+                ms = std::stod(std::string(sv.substr(cut + 1)));
+            }
+            catch (const std::logic_error&)
             {
-                auto it = tensors.find(inp);
-                if (it != tensors.end())
-                    label += "\\n" + escapeLabel(it->second->getShape().toString());
+                throw std::runtime_error("Profile " + path.string() + ":" + std::to_string(line_no) +
+                                         ": bad time '" + std::string(sv.substr(cut + 1)) + "'");
             }
 
+            auto id = graph.nodeId(name);
+            if (id == kNoNode) continue;
+            heat[id] += ms * 1e-3;
+            ++matched;
+        }
+
+        if (matched == 0)
+            throw std::runtime_error("Profile " + path.string() + " matches no node of graph '" + graph.getName() + "'");
+        return heat;
+    }
 
 
+    namespace
+    {
+        // What gets drawn for each node: itself, or the scope it is collapsed into
+        struct Drawing
+        {
+            std::vector<uint32_t>    unit_of;       // by NodeId
+            std::vector<std::string> scope;         // by unit, empty for a plain node
+            std::vector<NodeId>      first_node;    // by unit
+            std::vector<uint32_t>    size;          // by unit
 
+            [[nodiscard]] bool collapsed() const { return scope.size() < unit_of.size(); }
+        };
 
-            dot << "  \"input_" << escapeLabel(inp) << "\" ["
-                << "label=\"{INPUT|" << label << "}\", "
-                << "fillcolor=\"#85C1E9\", shape=record];\n";
+        // the name up to its `depth`-th scope separator, a leading separator doesn't count
+        std::string_view scopeOf(std::string_view name, size_t depth, char sep)
+        {
+            size_t pos = name.empty() || name.front() != sep ? 0 : 1;
+            size_t end = std::string_view::npos;
+            for (size_t d = 0; d < depth; ++d)
+            {
+                auto next = name.find(sep, pos);
+                if (next == std::string_view::npos) break;
+                end = next;
+                pos = next + 1;
+            }
+            return end == std::string_view::npos ? std::string_view{} : name.substr(0, end);
         }
 
-        dot << "\n  // Graph outputs\n";
+        size_t scopeDepth(std::string_view name, char sep)
+        {
+            auto n = static_cast<size_t>(std::count(name.begin(), name.end(), sep));
+            return !name.empty() && name.front() == sep ? n - 1 : n;
+        }
 
-        for (const auto& out : graph.getOutputs())
+        Drawing layOut(const Graph& graph, size_t threshold, char sep)
         {
-            std::string label = escapeLabel(out);
+            const auto& nodes = graph.getNodes();
+            Drawing drawing;
+            drawing.unit_of.resize(nodes.size());
 
-            if (opts_.show_tensor_shapes)
+            auto plain = [&]
             {
-                auto it = tensors.find(out);
-                if (it != tensors.end())
-                    label += "\\n" + escapeLabel(it->second->getShape().toString());
+                drawing.scope.assign(nodes.size(), std::string{});
+                drawing.size.assign(nodes.size(), 1);
+                drawing.first_node.resize(nodes.size());
+                std::iota(drawing.unit_of.begin(), drawing.unit_of.end(), 0);
+                std::iota(drawing.first_node.begin(), drawing.first_node.end(), 0);
+                return drawing;
+            };
+
+            if (threshold == 0 || nodes.size() <= threshold)
+                return plain();
+
+            size_t max_depth = 0;
+            for (const auto& n : nodes)
+                max_depth = std::max(max_depth, scopeDepth(n->getName(), sep));
+            if (max_depth == 0)
+                return plain();
+
+            // deepest level that fits, or the outermost one
+            std::unordered_map<std::string_view, uint32_t> members;
+            size_t depth = max_depth;
+            for (; depth > 0; --depth)
+            {
+                members.clear();
+                size_t units = 0;
+                for (const auto& n : nodes)
+                {
+                    auto scope = scopeOf(n->getName(), depth, sep);
+                    if (scope.empty() || members[scope]++ == 0) ++units;
+                }
+                if (units <= threshold || depth == 1) break;
             }
 
-            dot << "  \"output_" << escapeLabel(out) << "\" ["
-                << "label=\"{OUTPUT|" << label << "}\", "
-                << "fillcolor=\"#82E0AA\", shape=record];\n";
+            std::unordered_map<std::string_view, uint32_t> unit_of_scope;
+            for (NodeId n = 0; n < nodes.size(); ++n)
+            {
+                auto scope = scopeOf(nodes[n]->getName(), depth, sep);
+
+                // a scope holding a single node is drawn as that node
+                bool grouped = !scope.empty() && members[scope] > 1;
+                if (grouped)
+                {
+                    auto [it, inserted] = unit_of_scope.try_emplace(scope, static_cast<uint32_t>(drawing.scope.size()));
+                    if (!inserted)
+                    {
+                        drawing.unit_of[n] = it->second;
+                        ++drawing.size[it->second];
+                        continue;
+                    }
+                }
+
+                drawing.unit_of[n] = static_cast<uint32_t>(drawing.scope.size());
+                drawing.scope.emplace_back(grouped ? scope : std::string_view{});
+                drawing.first_node.push_back(n);
+                drawing.size.push_back(1);
+            }
+            return drawing;
         }
+    } // namespace
 
 
-        dot << "\n  // Operation nodes\n";
+    void DotExporter::write(const Graph& graph, std::ostream& dot) const
+    {
+        dot << "digraph \"" << escapeLabel(graph.getName()) << "\" {\n";
+        dot << "  graph [rankdir=TB, bgcolor=\"#FAFAFA\", fontname=\"Helvetica\"];\n";
+        dot << "  node  [shape=record, style=filled, fontname=\"Helvetica\", fontsize=11];\n";
+        dot << "  edge  [fontname=\"Helvetica\", fontsize=9];\n\n";
+
+        // graph inputs and outputs by tensor id
+        std::vector<uint8_t> is_graph_input(graph.numTensorIds(), 0);
+        std::vector<uint8_t> is_graph_output(graph.numTensorIds(), 0);
+        for (auto id : graph.getInputIds())  is_graph_input[id] = 1;
+        for (auto id : graph.getOutputIds()) is_graph_output[id] = 1;
+
+        auto shapeOf = [&](TensorId id) -> std::string
+        {
+            const auto* t = graph.tensor(id);
+            return t ? escapeLabel(t->getShape().toString()) : std::string{};
+        };
+
+        dot << "  // Graph inputs\n";
+        for (auto id : graph.getInputIds())
+        {
+            const auto& inp = graph.tensorName(id);
+            dot << "  \"input_" << escapeLabel(inp) << "\" [label=\"{INPUT|" << escapeLabel(inp);
+            if (opts_.show_tensor_shapes && graph.tensor(id))
+                dot << "\\n" << shapeOf(id);
+            dot << "}\", fillcolor=\"#85C1E9\", shape=record];\n";
+        }
+
+        dot << "\n  // Graph outputs\n";
+
+        for (auto id : graph.getOutputIds())
+        {
+            const auto& out = graph.tensorName(id);
+            dot << "  \"output_" << escapeLabel(out) << "\" [label=\"{OUTPUT|" << escapeLabel(out);
+            if (opts_.show_tensor_shapes && graph.tensor(id))
+                dot << "\\n" << shapeOf(id);
+            dot << "}\", fillcolor=\"#82E0AA\", shape=record];\n";
+        }
+
 
+        const auto& nodes = graph.getNodes();
+        const auto drawing = layOut(graph, opts_.cluster_threshold, opts_.scope_separator);
+        const size_t num_units = drawing.scope.size();
 
-        for (const auto& node : graph.getNodes())
+        // heat per drawn unit, scaled by the hottest one
+        const bool heatmap = !opts_.heat.empty();
+        std::vector<double> unit_heat;
+        double total_heat = 0.0;
+        double max_heat   = 0.0;
+        if (heatmap)
+        {
+            if (opts_.heat.size() != nodes.size())
+                throw std::runtime_error("Heat has " + std::to_string(opts_.heat.size()) +
+                                         " entries for " + std::to_string(nodes.size()) + " nodes");
+            unit_heat.assign(num_units, 0.0);
+            for (NodeId n = 0; n < nodes.size(); ++n)
+                unit_heat[drawing.unit_of[n]] += opts_.heat[n];
+            total_heat = std::accumulate(unit_heat.begin(), unit_heat.end(), 0.0);
+            max_heat   = *std::max_element(unit_heat.begin(), unit_heat.end());
+        }
+
+        auto unitName = [&](uint32_t u) -> std::string
+        {
+            return drawing.scope[u].empty()
+                ? escapeLabel(nodes[drawing.first_node[u]]->getName())
+                : "scope_" + escapeLabel(drawing.scope[u]);
+        };
+
+        // "|1.25 ms (12.5%)" row and the fill color
+        auto heatRow = [&](uint32_t u)
+        {
+            char buf[64];
+            double pct = total_heat > 0.0 ? 100.0 * unit_heat[u] / total_heat : 0.0;
+            std::snprintf(buf, sizeof(buf), "|%.3f ms (%.1f%%)", unit_heat[u] * 1e3, pct);
+            return std::string(buf);
+        };
+        auto fill = [&](uint32_t u, const std::string& otherwise)
         {
-            std::string color = opts_.color_by_optype
-                ? nodeColor(node->getOpType())
-                : "#E8E8E8";
+            if (!heatmap) return otherwise;
+            return heatColor(max_heat > 0.0 ? unit_heat[u] / max_heat : 0.0);
+        };
 
-            std::string header = escapeLabel(node->getOpStr());
+        // op breakdown of each collapsed scope
+        std::vector<std::map<std::string_view, uint32_t>> scope_ops(drawing.collapsed() ? num_units : 0);
+        if (drawing.collapsed())
+            for (NodeId n = 0; n < nodes.size(); ++n)
+                ++scope_ops[drawing.unit_of[n]][nodes[n]->getOpStr()];
+
+        dot << "\n  // Operation nodes\n";
+
+        for (uint32_t u = 0; u < num_units; ++u)
+        {
+            if (!drawing.scope[u].empty())
+            {
+                dot << "  \"" << unitName(u) << "\" [label=\"{" << escapeLabel(drawing.scope[u])
+                    << "\\n(" << drawing.size[u] << " nodes)|";
+                for (const auto& [op, cnt] : scope_ops[u])
+                    dot << escapeLabel(std::string(op)) << " x" << cnt << "\\l";
+                if (heatmap) dot << heatRow(u);
+                dot << "}\", fillcolor=\"" << fill(u, "#D5DBDB") << "\", style=\"filled,rounded\"];\n";
+                continue;
+            }
+
+            NodeId n = drawing.first_node[u];
+            const auto& node = nodes[n];
+
+            dot << "  \"" << escapeLabel(node->getName()) << "\" [label=\"{" << escapeLabel(node->getOpStr());
             if (!node->getName().empty())
-                header += "\\n(" + escapeLabel(node->getName()) + ")";
+                dot << "\\n(" << escapeLabel(node->getName()) << ")";
 
-            std::string attr_str;
             if (opts_.show_attributes && !node->getAttributes().empty())
             {
-                for (const auto& [k, a] : node->getAttributes())
-                    attr_str += escapeLabel(a.toString()) + "\\l";
+                dot << "|";
+                for (const auto& a : node->getAttributes())
+                    dot << escapeLabel(a.toString()) << "\\l";
             }
 
-            std::string const_str;
-            for (const auto& inp : node->getInputs())
+            bool const_header = false;
+            for (auto id : graph.nodeInputs(n))
             {
-                auto it = tensors.find(inp);
-                if (it != tensors.end() && it->second->hasData())
+                if (id == kNoTensor || is_graph_input[id]) continue;
+
+                const auto* tensor = graph.tensor(id);
+                if (tensor && tensor->hasData())
                 {
-                    bool is_graph_input = false;
-                    for (const auto& gi : graph.getInputs())
-                        if (gi == inp) { is_graph_input = true; break; }
-                    if (is_graph_input) continue;
-
-                    const_str += escapeLabel(inp) + " = ";
-                    const auto& tensor = it->second;
-                    const_str += dataTypeToString(tensor->getDtype()) + tensor->getShape().toString();
-                    const_str += "\\l";
+                    if (!const_header) dot << "|const inputs:\\l";
+                    const_header = true;
+                    dot << escapeLabel(graph.tensorName(id)) << " = "
+                        << dataTypeToString(tensor->getDtype()) << tensor->getShape().toString() << "\\l";
                 }
             }
 
-            std::string label = "{" + header;
-            if (!attr_str.empty()) label += "|" + attr_str;
-            if (!const_str.empty()) label += "|const inputs:\\l" + const_str;
-            label += "}";
+            if (heatmap) dot << heatRow(u);
 
-            dot << "  \"" << escapeLabel(node->getName()) << "\" ["
-                << "label=\"" << label << "\", "
-                << "fillcolor=\"" << color << "\"];\n";
+            std::string color = opts_.color_by_optype ? nodeColor(node->getOpType()) : "#E8E8E8";
+            dot << "}\", fillcolor=\"" << fill(u, color) << "\"];\n";
         }
 
         dot << "\n  // Edges\n";
 
-        std::unordered_map<std::string, std::vector<std::string>> consumers;
-
-        for (const auto& node : graph.getNodes())
-            for (const auto& inp : node->getInputs())
-                consumers[inp].push_back(node->getName());
-
-        std::unordered_map<std::string, std::string> producers;
+        auto edgeLabel = [&](TensorId id) -> std::string
+        {
+            if (!opts_.show_tensor_shapes || !graph.tensor(id)) return {};
+            return " [label=\"" + shapeOf(id) + "\"]";
+        };
 
-        for (const auto& node : graph.getNodes())
-            for (const auto& out : node->getOutputs())
-                producers[out] = node->getName();
+        // collapsed drawings have many parallel edges between the same two units, one is kept
+        std::unordered_set<uint64_t> drawn_inputs, drawn_outputs, drawn;
+        auto firstEdge = [&](std::unordered_set<uint64_t>& set, uint32_t from, uint32_t to)
+        {
+            return !drawing.collapsed() || set.insert(uint64_t{from} << 32 | to).second;
+        };
 
-        for (const auto& inp : graph.getInputs())
+        for (auto id : graph.getInputIds())
         {
-            auto it = consumers.find(inp);
-            if (it == consumers.end()) continue;
-            for (const auto& dst : it->second)
+            for (auto dst : graph.consumersOf(id))
             {
-                std::string edge_label;
-                if (opts_.show_tensor_shapes)
-                {
-                    auto ti = tensors.find(inp);
-
-
-                    if (ti != tensors.end())
-                        edge_label = " [label=\"" + escapeLabel(ti->second->getShape().toString()) + "\"]";
-                }
-
-
-
-                dot << "  \"input_" << escapeLabel(inp) << "\" -> \""
-                    << escapeLabel(dst) << "\"" << edge_label << ";\n";
+                auto u = drawing.unit_of[dst];
+                if (!firstEdge(drawn_inputs, id, u)) continue;
+                dot << "  \"input_" << escapeLabel(graph.tensorName(id)) << "\" -> \""
+                    << unitName(u) << "\"" << edgeLabel(id) << ";\n";
             }
         }
 
-        for (const auto& node : graph.getNodes())
+        for (NodeId n = 0; n < nodes.size(); ++n)
         {
-            for (const auto& out : node->getOutputs())
+            auto src = drawing.unit_of[n];
+            for (auto id : graph.nodeOutputs(n))
             {
-                bool is_graph_output = false;
-                for (const auto& go : graph.getOutputs())
-                    if (go == out) { is_graph_output = true; break; }
+                if (id == kNoTensor) continue;
 
-                if (is_graph_output)
+                if (is_graph_output[id])
                 {
-                    std::string edge_label;
-                    if (opts_.show_tensor_shapes)
-                    {
-                        auto ti = tensors.find(out);
-
-                        if (ti != tensors.end())
-                            edge_label = " [label=\"" + escapeLabel(ti->second->getShape().toString()) + "\"]";
-                    }
-
-
-
-                    dot << "  \"" << escapeLabel(node->getName()) << "\" -> "
-                        << "\"output_" << escapeLabel(out) << "\"" << edge_label << ";\n";
+                    if (!firstEdge(drawn_outputs, src, id)) continue;
+                    dot << "  \"" << unitName(src) << "\" -> "
+                        << "\"output_" << escapeLabel(graph.tensorName(id)) << "\"" << edgeLabel(id) << ";\n";
                     continue;
                 }
 
-                auto it = consumers.find(out);
-                if (it == consumers.end()) continue;
-                for (const auto& dst : it->second)
+                for (auto dst : graph.consumersOf(id))
                 {
-                    std::string edge_label;
-                    if (opts_.show_tensor_shapes)
-                    {
-                        auto ti = tensors.find(out);
-
-                        if (ti != tensors.end())
-                            edge_label = " [label=\"" + escapeLabel(ti->second->getShape().toString()) + "\"]";
-                    }
-
-
-
-                    dot << "  \"" << escapeLabel(node->getName()) << "\" -> \""
-                        << escapeLabel(dst) << "\"" << edge_label << ";\n";
+                    auto u = drawing.unit_of[dst];
+                    if (drawing.collapsed() && u == src) continue;
+                    if (!firstEdge(drawn, src, u)) continue;
+                    dot << "  \"" << unitName(src) << "\" -> \""
+                        << unitName(u) << "\"" << edgeLabel(id) << ";\n";
                 }
             }
         }
 
         dot << "}\n";
+    }
+
+    std::string DotExporter::toDot(const Graph& graph) const
+    {
+        std::ostringstream dot;
+        write(graph, dot);
         return dot.str();
     }
 
@@ -237,7 +443,9 @@ namespace tc
         std::ofstream ofs(path);
         if (!ofs)
             throw std::runtime_error("Cannot open output file: " + path.string());
-        ofs << toDot(graph);
+        write(graph, ofs);
+        if (!ofs.flush())
+            throw std::runtime_error("Failed writing DOT file: " + path.string());
     }
 
     void DotExporter::exportToPng(const Graph& graph, const std::filesystem::path& png_path) const
@@ -0,0 +1,357 @@
+#include <gtest/gtest.h>
+#include "backend/codegen.hpp"
+#include "backend/constant_pool.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+
+#include <cstring>
+#include <deque>
+#include <numeric>
+
+using namespace tc;
+using namespace mlir;
+
+
+template <typename OpTy>
+static int countOps(Operation* root)
+{
+    int n = 0;
+    root->walk([&](OpTy) { ++n; });
+    return n;
+}
+
+class ConstantPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        module = ModuleOp::create(loc);
+    }
+
+    // an empty function, e.g. an entry point or a task, the builder at its end
+    func::FuncOp addFunction(const std::string& name)
+    {
+        auto func = func::FuncOp::create(loc, name, builder.getFunctionType({}, {}));
+        func.addEntryBlock();
+        module.push_back(func);
+        builder.setInsertionPointToEnd(&func.getBody().front());
+        return func;
+    }
+
+    // returns `results` from the function the builder is in, keeping them alive through finish()
+    void returnValues(func::FuncOp func, ValueRange results)
+    {
+        func::ReturnOp::create(builder, loc, results);
+        func.setType(builder.getFunctionType({}, TypeRange(results)));
+    }
+
+    // a model buffer holding `values`, alive as long as the test
+    std::span<const uint8_t> buffer(const std::vector<float>& values)
+    {
+        auto& bytes = buffers.emplace_back(values.size() * sizeof(float));
+        std::memcpy(bytes.data(), values.data(), bytes.size());
+        return bytes;
+    }
+
+    static std::vector<float> iota(size_t n)
+    {
+        std::vector<float> values(n);
+        std::iota(values.begin(), values.end(), 1.0f);
+        return values;
+    }
+
+    Value materialize(std::span<const uint8_t> data)
+    {
+        auto type = RankedTensorType::get({static_cast<int64_t>(data.size() / sizeof(float))}, builder.getF32Type());
+        return pool.materialize(builder, loc, type, data);
+    }
+
+    MLIRContext ctx;
+    llvm::LLVMContext llvmCtx;
+    // loads the dialects the pool builds with
+    CodeGen codegen = CodeGen(ctx, llvmCtx);
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+    ConstantPool pool;
+    std::deque<std::vector<uint8_t>> buffers;
+};
+
+TEST_F(ConstantPoolTest, SplatsTakeNoStorage)
+{
+    auto func = addFunction("f");
+    Value small = materialize(buffer(std::vector<float>(4, 2.0f)));
+    Value large = materialize(buffer(std::vector<float>(64, 1.5f)));
+    returnValues(func, {small, large});
+
+    auto constant = small.getDefiningOp<arith::ConstantOp>();
+    ASSERT_TRUE(constant);
+    EXPECT_TRUE(cast<DenseElementsAttr>(constant.getValue()).isSplat());
+
+    auto fill = large.getDefiningOp<linalg::FillOp>();
+    ASSERT_TRUE(fill);
+    EXPECT_TRUE(fill.getDpsInits()[0].getDefiningOp<tensor::EmptyOp>());
+
+    pool.finish(module);
+    EXPECT_TRUE(succeeded(verify(module)));
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 0);
+
+    const auto& stats = pool.stats();
+    EXPECT_EQ(stats.initializers, 2u);
+    EXPECT_EQ(stats.bytes, 68u * sizeof(float));
+    EXPECT_EQ(stats.splats, 2u);
+    EXPECT_EQ(stats.splat_bytes, (3u + 63u) * sizeof(float));
+    EXPECT_EQ(stats.globals, 0u);
+}
+
+TEST_F(ConstantPoolTest, SmallTensorsStayInline)
+{
+    auto func = addFunction("f");
+    Value value = materialize(buffer(iota(ConstantPool::kInlineElements)));
+    returnValues(func, value);
+
+    auto constant = value.getDefiningOp<arith::ConstantOp>();
+    ASSERT_TRUE(constant);
+    auto dense = cast<DenseElementsAttr>(constant.getValue());
+    EXPECT_FALSE(dense.isSplat());
+    EXPECT_EQ(llvm::to_vector(dense.getValues<float>())[3], 4.0f);
+
+    pool.finish(module);
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 0);
+    EXPECT_EQ(pool.stats().initializers, 1u);
+}
+
+TEST_F(ConstantPoolTest, LargeTensorsGoToAlignedGlobals)
+{
+    auto func = addFunction("f");
+    Value value = materialize(buffer(iota(64)));
+    returnValues(func, value);
+
+    auto tensor = value.getDefiningOp<bufferization::ToTensorOp>();
+    ASSERT_TRUE(tensor);
+    EXPECT_TRUE(tensor.getRestrict());
+    EXPECT_FALSE(tensor.getWritable());
+    auto ref = tensor->getOperand(0).getDefiningOp<memref::GetGlobalOp>();
+    ASSERT_TRUE(ref);
+
+    pool.finish(module);
+    EXPECT_TRUE(succeeded(verify(module)));
+
+    auto globals = llvm::to_vector(module.getOps<memref::GlobalOp>());
+    ASSERT_EQ(globals.size(), 1u);
+    auto global = globals.front();
+    EXPECT_EQ(global.getSymName(), ref.getName());
+    EXPECT_TRUE(global.getConstant());
+    EXPECT_TRUE(global.isPrivate());
+    EXPECT_EQ(global.getAlignment(), std::optional<uint64_t>(ConstantPool::kAlignment));
+    EXPECT_EQ(llvm::to_vector(cast<DenseElementsAttr>(*global.getInitialValue()).getValues<float>())[63], 64.0f);
+
+    EXPECT_EQ(pool.stats().globals, 1u);
+    EXPECT_EQ(pool.stats().global_bytes, 64u * sizeof(float));
+}
+
+TEST_F(ConstantPoolTest, EqualInitializersShareAGlobal)
+{
+    auto values = iota(64);
+
+    // two initializers of one model with the same contents, read through one to_tensor
+    auto entry = addFunction("a");
+    Value first  = materialize(buffer(values));
+    Value second = materialize(buffer(values));
+    EXPECT_EQ(first, second);
+    returnValues(entry, first);
+
+    // and a third in another model, in its own function
+    auto other = addFunction("b");
+    Value third = materialize(buffer(values));
+    returnValues(other, third);
+    EXPECT_EQ(third.getParentBlock(), &other.getBody().front());
+
+    pool.finish(module);
+    EXPECT_TRUE(succeeded(verify(module)));
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 1);
+    EXPECT_EQ(countOps<bufferization::ToTensorOp>(module), 2);
+
+    const auto& stats = pool.stats();
+    EXPECT_EQ(stats.initializers, 3u);
+    EXPECT_EQ(stats.duplicates, 2u);
+    EXPECT_EQ(stats.duplicate_bytes, 2u * 64u * sizeof(float));
+    EXPECT_EQ(stats.globals, 1u);
+}
+
+TEST_F(ConstantPoolTest, InitializerReadByTasksCountsOnce)
+{
+    // the same initializer, from the same buffer, materialized by two tasks
+    auto data = buffer(iota(64));
+    auto small = buffer(iota(8));
+    for (auto name : {"task0", "task1"})
+    {
+        auto task = addFunction(name);
+        returnValues(task, {materialize(data), materialize(small)});
+    }
+
+    pool.finish(module);
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 1);
+
+    const auto& stats = pool.stats();
+    EXPECT_EQ(stats.initializers, 2u);
+    EXPECT_EQ(stats.bytes, 72u * sizeof(float));
+    EXPECT_EQ(stats.duplicates, 0u);
+    EXPECT_EQ(stats.unused, 0u);
+}
+
+TEST_F(ConstantPoolTest, FinishDropsOnlyUnusedInitializers)
+{
+    auto func = addFunction("f");
+
+    // e.g. a shape tensor a Reshape folded, and a weight nothing reads
+    (void)materialize(buffer(iota(4)));
+    (void)materialize(buffer(iota(64)));
+    // the builders' own constants aren't the pool's to erase or count
+    auto ownType = RankedTensorType::get({2}, builder.getF32Type());
+    auto own = arith::ConstantOp::create(builder, loc, ownType,
+                                         DenseElementsAttr::get(ownType, llvm::ArrayRef<float>{1.0f, 2.0f}));
+    Value used = materialize(buffer(iota(8)));
+    returnValues(func, used);
+
+    pool.finish(module);
+    EXPECT_TRUE(succeeded(verify(module)));
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 0);
+    EXPECT_EQ(countOps<memref::GetGlobalOp>(module), 0);
+    EXPECT_EQ(countOps<arith::ConstantOp>(module), 2);
+    EXPECT_EQ(own->getBlock(), &func.getBody().front());
+
+    const auto& stats = pool.stats();
+    EXPECT_EQ(stats.initializers, 3u);
+    EXPECT_EQ(stats.unused, 2u);
+    EXPECT_EQ(stats.unused_bytes, 68u * sizeof(float));
+}
+
+TEST_F(ConstantPoolTest, RollbackForgetsDiscardedTasks)
+{
+    auto data = buffer(iota(64));
+    auto entry = addFunction("entry");
+    auto before = pool.checkpoint();
+
+    // what emitTasks() does when a task can't be emitted: its functions are erased, then
+    // the pool rolled back
+    auto task = addFunction("entry_task0");
+    returnValues(task, materialize(data));
+    EXPECT_EQ(pool.stats().initializers, 1u);
+    task.erase();
+    pool.rollback(before);
+
+    EXPECT_EQ(pool.stats().initializers, 0u);
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 0);
+
+    // the sequential fallback materializes it again, counted once
+    builder.setInsertionPointToEnd(&entry.getBody().front());
+    returnValues(entry, materialize(data));
+
+    pool.finish(module);
+    EXPECT_TRUE(succeeded(verify(module)));
+    EXPECT_EQ(countOps<memref::GlobalOp>(module), 1);
+
+    const auto& stats = pool.stats();
+    EXPECT_EQ(stats.initializers, 1u);
+    EXPECT_EQ(stats.duplicates, 0u);
+    EXPECT_EQ(stats.unused, 0u);
+    EXPECT_EQ(stats.globals, 1u);
+}
+
+
+// x -> stem = x + w -> {left = Relu(stem), right = stem * w} -> out = left + right
+static std::shared_ptr<Graph> createSharedWeightDiamond(int64_t n, bool dynamic)
+{
+    auto graph = std::make_shared<Graph>("diamond");
+    auto activation = [&](const std::string& name)
+    {
+        graph->addTensor(std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{{dynamic ? -1 : n}}));
+    };
+    auto node = [&](const std::string& name, OpType op, const std::string& str,
+                    std::vector<std::string> inputs, const std::string& output)
+    {
+        activation(output);
+        graph->addNode(std::make_shared<Node>(name, op, str, std::move(inputs), std::vector<std::string>{output},
+                                              Node::AttributeList{}));
+    };
+
+    activation("x");
+    graph->addInput("x");
+
+    auto w = std::make_shared<Tensor>("w", DataType::FLOAT, TensorShape{{n}});
+    std::vector<uint8_t> raw(n * sizeof(float));
+    for (int64_t i = 0; i < n; ++i)
+    {
+        float v = static_cast<float>(i);
+        std::memcpy(raw.data() + i * sizeof(float), &v, sizeof(float));
+    }
+    w->setRawData(std::move(raw));
+    graph->addTensor(w);
+
+    node("stem",  OpType::Add,  "Add",  {"x", "w"}, "s");
+    node("left",  OpType::Relu, "Relu", {"s"},      "l");
+    node("right", OpType::Mul,  "Mul",  {"s", "w"}, "r");
+    node("join",  OpType::Add,  "Add",  {"l", "r"}, "out");
+    graph->addOutput("out");
+    return graph;
+}
+
+class ConstantPoolCodeGenTest : public ::testing::Test
+{
+protected:
+    MLIRContext ctx;
+    llvm::LLVMContext llvmCtx;
+    CodeGen codegen = CodeGen(ctx, llvmCtx);
+};
+
+TEST_F(ConstantPoolCodeGenTest, WeightReadByTwoTasksIsOneInitializer)
+{
+    auto graph = createSharedWeightDiamond(64, false);
+    CodeGenOptions opts;
+    opts.parallel_branches = true;
+
+    auto module = codegen.buildModule(*graph, opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+    ASSERT_EQ(codegen.taskSplits().size(), 1u);
+    EXPECT_TRUE(codegen.taskSplits().front().emitted);
+
+    EXPECT_EQ(countOps<memref::GlobalOp>(*module), 1);
+    const auto& stats = codegen.constantStats();
+    EXPECT_EQ(stats.initializers, 1u);
+    EXPECT_EQ(stats.duplicates, 0u);
+    EXPECT_EQ(stats.unused, 0u);
+    EXPECT_EQ(stats.globals, 1u);
+}
+
+TEST_F(ConstantPoolCodeGenTest, DiscardedTasksLeaveNoOrphans)
+{
+    // the tensors between tasks are dynamic, emitTasks() gives up after the first task
+    auto graph = createSharedWeightDiamond(64, true);
+    CodeGenOptions opts;
+    opts.parallel_branches = true;
+
+    auto module = codegen.buildModule(*graph, opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+    ASSERT_EQ(codegen.taskSplits().size(), 1u);
+    EXPECT_FALSE(codegen.taskSplits().front().emitted);
+
+    int tasks = 0;
+    module->walk([&](func::FuncOp func) { if (func->hasAttr("tc.task")) ++tasks; });
+    EXPECT_EQ(tasks, 0);
+    EXPECT_EQ(countOps<memref::GlobalOp>(*module), 1);
+
+    const auto& stats = codegen.constantStats();
+    EXPECT_EQ(stats.initializers, 1u);
+    EXPECT_EQ(stats.unused, 0u);
+    EXPECT_EQ(stats.globals, 1u);
+}
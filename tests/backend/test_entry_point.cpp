@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+#include "backend/codegen.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "llvm/IR/LLVMContext.h"
+
+#include <cstring>
+
+using namespace tc;
+using namespace mlir;
+
+
+// net(x : float32[2x3]) -> (y = relu(x), z = exp(x)), x or the results declared dynamic if asked
+static std::shared_ptr<Graph> createTwoOutputs(bool dynamicInput = false, bool dynamicOutputs = false)
+{
+    auto graph = std::make_shared<Graph>("net");
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{dynamicInput ? -1 : 2, 3}}));
+    for (const auto* name : {"y", "z"})
+        graph->addTensor(std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{{dynamicOutputs ? -1 : 2, 3}}));
+
+    graph->addInput("x");
+    graph->addNode(std::make_shared<Node>("relu", OpType::Relu, "Relu", std::vector<std::string>{"x"},
+                                          std::vector<std::string>{"y"}, Node::AttributeList{}));
+    graph->addNode(std::make_shared<Node>("exp", OpType::Exp, "Exp", std::vector<std::string>{"x"},
+                                          std::vector<std::string>{"z"}, Node::AttributeList{}));
+    graph->addOutput("y");
+    graph->addOutput("z");
+    return graph;
+}
+
+class EntryPointTest : public ::testing::Test
+{
+protected:
+    func::FuncOp entryOf(ModuleOp module) { return module.lookupSymbol<func::FuncOp>("net"); }
+
+    std::vector<bufferization::MaterializeInDestinationOp> materializations(func::FuncOp func)
+    {
+        std::vector<bufferization::MaterializeInDestinationOp> ops;
+        func.walk([&](bufferization::MaterializeInDestinationOp op) { ops.push_back(op); });
+        return ops;
+    }
+
+    MLIRContext ctx;
+    llvm::LLVMContext llvmCtx;
+    CodeGen codegen = CodeGen(ctx, llvmCtx);
+};
+
+
+TEST_F(EntryPointTest, ResultsAreReturnedByDefault)
+{
+    auto module = codegen.buildModule(*createTwoOutputs());
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto func = entryOf(*module);
+    ASSERT_TRUE(func);
+    EXPECT_EQ(func.getNumArguments(), 1u);
+    EXPECT_EQ(func.getNumResults(), 2u);
+    EXPECT_TRUE(materializations(func).empty());
+}
+
+TEST_F(EntryPointTest, DestPassingWritesOutputsIntoTrailingArguments)
+{
+    CodeGenOptions opts;
+    opts.dest_passing = true;
+    auto module = codegen.buildModule(*createTwoOutputs(), opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto func = entryOf(*module);
+    ASSERT_TRUE(func);
+    EXPECT_EQ(func.getNumResults(), 0u);
+    ASSERT_EQ(func.getNumArguments(), 3u);
+    EXPECT_TRUE(isa<RankedTensorType>(func.getArgument(0).getType()));
+    auto outType = MemRefType::get({2, 3}, Float32Type::get(&ctx));
+    EXPECT_EQ(func.getArgument(1).getType(), outType);
+    EXPECT_EQ(func.getArgument(2).getType(), outType);
+
+    // one write per output, in output order, into the caller's buffers that alias nothing
+    auto writes = materializations(func);
+    ASSERT_EQ(writes.size(), 2u);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        EXPECT_EQ(writes[i].getDest(), func.getArgument(1 + i));
+        EXPECT_TRUE(writes[i].getRestrict());
+        EXPECT_TRUE(writes[i].getWritable());
+    }
+
+    auto ret = cast<func::ReturnOp>(func.getBody().front().getTerminator());
+    EXPECT_EQ(ret.getNumOperands(), 0u);
+}
+
+TEST_F(EntryPointTest, OutputsThatMayAliasAreNotRestrict)
+{
+    CodeGenOptions opts;
+    opts.dest_passing      = true;
+    opts.outputs_may_alias = true;
+    auto module = codegen.buildModule(*createTwoOutputs(), opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto writes = materializations(entryOf(*module));
+    ASSERT_EQ(writes.size(), 2u);
+    for (auto write : writes)
+        EXPECT_FALSE(write.getRestrict());
+}
+
+TEST_F(EntryPointTest, GivenScheduleIsFollowed)
+{
+    auto graph = createTwoOutputs();
+    CodeGenOptions opts;
+    // exp before relu, the reverse of the model's order
+    opts.schedules.push_back({{graph->nodeId("exp"), graph->nodeId("relu")}});
+
+    auto module = codegen.buildModule(*graph, opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    std::vector<std::string> ops;
+    entryOf(*module).walk([&](Operation* op)
+    {
+        if (isa<math::ExpOp>(op)) ops.push_back("exp");
+        if (isa<linalg::MaxOp>(op)) ops.push_back("relu");
+    });
+    EXPECT_EQ(ops, (std::vector<std::string>{"exp", "relu"}));
+}
+
+TEST_F(EntryPointTest, ScheduleMustMatchTheModels)
+{
+    auto graph = createTwoOutputs();
+    CodeGenOptions opts;
+
+    // one node short
+    opts.schedules.push_back({{graph->nodeId("relu")}});
+    EXPECT_THROW((void)codegen.buildModule(*graph, opts), std::runtime_error);
+
+    // two schedules for one model
+    opts.schedules = {{{0, 1}}, {{0, 1}}};
+    EXPECT_THROW((void)codegen.buildModule(*graph, opts), std::runtime_error);
+}
+
+TEST_F(EntryPointTest, BarePtrNeedsStaticShapes)
+{
+    CodeGenOptions opts;
+    opts.bare_ptr = true;
+
+    auto expectRejected = [&](const Graph& graph, const std::string& what)
+    {
+        try
+        {
+            (void)codegen.buildModule(graph, opts);
+            ADD_FAILURE() << "a dynamic " << what << " was accepted";
+        }
+        catch (const std::runtime_error& e)
+        {
+            EXPECT_NE(std::string(e.what()).find(what), std::string::npos) << e.what();
+        }
+    };
+    expectRejected(*createTwoOutputs(true, false), "input 'x' is dynamic");
+    expectRejected(*createTwoOutputs(false, true), "output 'y' is dynamic");
+}
+
+TEST_F(EntryPointTest, BarePtrTakesOutputsAsArguments)
+{
+    CodeGenOptions opts;
+    opts.bare_ptr = true;
+    auto module = codegen.buildModule(*createTwoOutputs(), opts);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto func = entryOf(*module);
+    EXPECT_EQ(func.getNumArguments(), 3u);
+    EXPECT_EQ(func.getNumResults(), 0u);
+    EXPECT_EQ(materializations(func).size(), 2u);
+}
+
+
+// an entry point and a task function as they reach lowerToLLVM(), bufferized
+static constexpr const char* kBufferizedEntry = R"mlir(
+func.func private @net_task0(%x: memref<4xf32>, %y: memref<4xf32>)
+    attributes {tc.task, tc.task_index = 0 : i64, tc.task_deps = array<i64>} {
+    memref.copy %x, %y : memref<4xf32> to memref<4xf32>
+    return
+}
+func.func @net(%x: memref<4xf32>, %y: memref<4xf32>) {
+    func.call @net_task0(%x, %y) : (memref<4xf32>, memref<4xf32>) -> ()
+    return
+}
+)mlir";
+
+TEST_F(EntryPointTest, OnlyEntryPointsGetACInterface)
+{
+    auto module = parseSourceString<ModuleOp>(kBufferizedEntry, &ctx);
+    ASSERT_TRUE(module);
+    codegen.lowerToLLVM(*module);
+
+    EXPECT_TRUE(module->lookupSymbol<LLVM::LLVMFuncOp>("net"));
+    EXPECT_TRUE(module->lookupSymbol<LLVM::LLVMFuncOp>("_mlir_ciface_net"));
+    EXPECT_FALSE(module->lookupSymbol<LLVM::LLVMFuncOp>("_mlir_ciface_net_task0"));
+}
+
+TEST_F(EntryPointTest, BarePtrDropsTheCInterface)
+{
+    auto module = parseSourceString<ModuleOp>(kBufferizedEntry, &ctx);
+    ASSERT_TRUE(module);
+    CodeGenOptions opts;
+    opts.bare_ptr = true;
+    codegen.lowerToLLVM(*module, opts);
+
+    // the header wraps the plain function itself, which takes one pointer per memref
+    auto net = module->lookupSymbol<LLVM::LLVMFuncOp>("net");
+    ASSERT_TRUE(net);
+    EXPECT_EQ(net.getNumArguments(), 2u);
+    EXPECT_FALSE(module->lookupSymbol<LLVM::LLVMFuncOp>("_mlir_ciface_net"));
+}
+
+
+// name(x : float32[64]) -> x <op> w, w = 0, 1, .., 63 in every model
+static std::shared_ptr<Graph> createWeighted(const std::string& name, OpType op, const std::string& opStr)
+{
+    auto graph = std::make_shared<Graph>(name);
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{64}}));
+    graph->addTensor(std::make_shared<Tensor>("y", DataType::FLOAT, TensorShape{{64}}));
+
+    auto w = std::make_shared<Tensor>("w", DataType::FLOAT, TensorShape{{64}});
+    std::vector<uint8_t> raw(64 * sizeof(float));
+    for (int i = 0; i < 64; ++i)
+    {
+        float v = static_cast<float>(i);
+        std::memcpy(raw.data() + i * sizeof(float), &v, sizeof(float));
+    }
+    w->setRawData(std::move(raw));
+    graph->addTensor(w);
+
+    graph->addInput("x");
+    graph->addNode(std::make_shared<Node>("op", op, opStr, std::vector<std::string>{"x", "w"},
+                                          std::vector<std::string>{"y"}, Node::AttributeList{}));
+    graph->addOutput("y");
+    return graph;
+}
+
+TEST_F(EntryPointTest, ModelsShareTheirInitializers)
+{
+    auto add = createWeighted("add", OpType::Add, "Add");
+    auto mul = createWeighted("mul", OpType::Mul, "Mul");
+    const Graph* graphs[] = {add.get(), mul.get()};
+
+    auto module = codegen.buildModule(graphs);
+    ASSERT_TRUE(succeeded(verify(*module)));
+    EXPECT_TRUE(module->lookupSymbol<func::FuncOp>("add"));
+    EXPECT_TRUE(module->lookupSymbol<func::FuncOp>("mul"));
+
+    int globals = 0;
+    module->walk([&](memref::GlobalOp) { ++globals; });
+    EXPECT_EQ(globals, 1);
+    // one initializer per model, the second equal to the first
+    EXPECT_EQ(codegen.constantStats().initializers, 2u);
+    EXPECT_EQ(codegen.constantStats().duplicates, 1u);
+    EXPECT_EQ(codegen.constantStats().globals, 1u);
+}
+
+TEST_F(EntryPointTest, ModelsNeedDistinctEntryPoints)
+{
+    // both sanitize to the symbol `net_v1`
+    auto first  = createWeighted("net-v1", OpType::Add, "Add");
+    auto second = createWeighted("net.v1", OpType::Mul, "Mul");
+    const Graph* graphs[] = {first.get(), second.get()};
+
+    EXPECT_THROW((void)codegen.buildModule(graphs), std::runtime_error);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "backend/header_emitter.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace tc;
+
+
+static size_t countOf(const std::string& s, const std::string& what)
+{
+    size_t n = 0;
+    for (auto pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + what.size()))
+        ++n;
+    return n;
+}
+
+static bool contains(const std::string& s, const std::string& what)
+{
+    return s.find(what) != std::string::npos;
+}
+
+// net(x : float32[1x3x?x?], mask : uint8[4]) -> (y : float32[1x10], n : int64 scalar)
+static EntryPointDesc makeEntry()
+{
+    EntryPointDesc entry;
+    entry.symbol  = "net";
+    entry.inputs  = {{"x", DataType::FLOAT, {1, 3, -1, -1}}, {"mask", DataType::UINT8, {4}}};
+    entry.outputs = {{"y", DataType::FLOAT, {1, 10}}, {"n", DataType::INT64, {}}};
+    return entry;
+}
+
+static std::string emit(const EntryPointDesc& entry)
+{
+    std::ostringstream os;
+    emitModelHeader(entry, os);
+    return os.str();
+}
+
+
+TEST(HeaderEmitterTest, CIdentifierSanitizesNames)
+{
+    EXPECT_EQ(cIdentifier("resnet-50.v2"), "resnet_50_v2");
+    EXPECT_EQ(cIdentifier("3net"), "_3net");
+    EXPECT_EQ(cIdentifier(""), "_");
+}
+
+TEST(HeaderEmitterTest, TakenEntryPointFallsBackToTheFileName)
+{
+    Graph first("main-graph"), second("main-graph"), third("main graph");
+    std::unordered_set<std::string> taken;
+
+    EXPECT_EQ(entryPointSymbol(first, "models/resnet.onnx", taken), "main_graph");
+    EXPECT_EQ(entryPointSymbol(second, "models/resnet-int8.onnx", taken), "resnet_int8");
+    // the file name is taken by then too
+    EXPECT_THROW((void)entryPointSymbol(third, "other/resnet-int8.onnx", taken), std::runtime_error);
+    EXPECT_EQ(taken.size(), 2u);
+}
+
+TEST(HeaderEmitterTest, DescriptorTypedefsFollowTheTensors)
+{
+    auto header = emit(makeEntry());
+
+    EXPECT_TRUE(contains(header, "#ifndef TC_NET_MODEL_H"));
+    EXPECT_EQ(countOf(header, "#define TC_MODEL_COMMON_DEFINED"), 1u);
+
+    EXPECT_TRUE(contains(header, "/* x : float32[1x3x?x?] */"));
+    EXPECT_TRUE(contains(header, "    float* aligned;\n    int64_t offset;\n    int64_t sizes[4];\n    int64_t strides[4];\n} tc_net_in0_memref;"));
+    EXPECT_TRUE(contains(header, "    uint8_t* aligned;\n    int64_t offset;\n    int64_t sizes[1];\n    int64_t strides[1];\n} tc_net_in1_memref;"));
+    // a scalar has neither sizes nor strides
+    EXPECT_TRUE(contains(header, "    int64_t* aligned;\n    int64_t offset;\n} tc_net_out1_memref;"));
+
+    EXPECT_TRUE(contains(header, "static const int64_t tc_net_input0_dims[4] = {1, 3, -1, -1};"));
+    EXPECT_TRUE(contains(header, "{\"mask\", TC_DTYPE_UINT8, sizeof(uint8_t), 1, tc_net_input1_dims},"));
+    EXPECT_TRUE(contains(header, "{\"n\", TC_DTYPE_INT64, sizeof(int64_t), 0, NULL},"));
+}
+
+TEST(HeaderEmitterTest, ResultsAreReturnedPacked)
+{
+    auto header = emit(makeEntry());
+
+    EXPECT_TRUE(contains(header, "    tc_net_out0_memref out0;\n    tc_net_out1_memref out1;\n} tc_net_results;"));
+    EXPECT_TRUE(contains(header, "void _mlir_ciface_net(tc_net_results* result, tc_net_in0_memref* in0, tc_net_in1_memref* in1);"));
+    EXPECT_TRUE(contains(header, "#define TC_NET_DEST_PASSING 0"));
+
+    EXPECT_TRUE(contains(header, "    _mlir_ciface_net(&result, &in0, &in1);"));
+    EXPECT_TRUE(contains(header, "    outputs[0].data      = result.out0.aligned + result.out0.offset;"));
+    EXPECT_TRUE(contains(header, "    outputs[1].rank      = 0;"));
+    EXPECT_FALSE(contains(header, "_invoke_async"));
+}
+
+TEST(HeaderEmitterTest, OnlyFreshResultsAreTheCallersToFree)
+{
+    auto header = emit(makeEntry());
+
+    // a global, an input, or a result returned twice keeps `allocated` NULL
+    EXPECT_TRUE(contains(header, "returned outputs the caller owns, release with free(); else NULL"));
+    EXPECT_TRUE(contains(header, "    outputs[0].allocated = result.out0.allocated;\n"
+                                 "    if (outputs[0].allocated == (void*)0xdeadbeef ||\n"
+                                 "        outputs[0].allocated == inputs[0].data ||\n"
+                                 "        outputs[0].allocated == inputs[1].data)\n"
+                                 "        outputs[0].allocated = NULL;\n"));
+    EXPECT_TRUE(contains(header, "        outputs[1].allocated == inputs[1].data ||\n"
+                                 "        outputs[1].allocated == (void*)result.out0.allocated)\n"
+                                 "        outputs[1].allocated = NULL;\n"));
+}
+
+TEST(HeaderEmitterTest, DestPassingTakesOutputsAsArguments)
+{
+    auto entry = makeEntry();
+    entry.dest_passing = true;
+    auto header = emit(entry);
+
+    EXPECT_FALSE(contains(header, "tc_net_results"));
+    EXPECT_TRUE(contains(header, "void _mlir_ciface_net(tc_net_in0_memref* in0, tc_net_in1_memref* in1, "
+                                 "tc_net_out0_memref* out0, tc_net_out1_memref* out1);"));
+    EXPECT_TRUE(contains(header, "Outputs must not alias inputs or each other."));
+    EXPECT_TRUE(contains(header, "#define TC_NET_DEST_PASSING 1"));
+
+    // outputs get descriptors over the caller's buffers
+    EXPECT_TRUE(contains(header, "    out0.aligned   = (float*)outputs[0].data;"));
+    EXPECT_TRUE(contains(header, "    out0.strides[0] = out0.strides[1] * out0.sizes[1];"));
+    EXPECT_TRUE(contains(header, "    _mlir_ciface_net(&in0, &in1, &out0, &out1);"));
+
+    entry.outputs_may_alias = true;
+    EXPECT_TRUE(contains(emit(entry), "Outputs may alias inputs."));
+}
+
+TEST(HeaderEmitterTest, BarePtrKeepsADescriptorWrapper)
+{
+    auto entry = makeEntry();
+    entry.inputs[0].dims = {1, 3, 8, 8};
+    entry.dest_passing   = true;
+    entry.bare_ptr       = true;
+    auto header = emit(entry);
+
+    EXPECT_TRUE(contains(header, "void net(float* in0, uint8_t* in1, float* out0, int64_t* out1);"));
+    EXPECT_TRUE(contains(header, "static inline void _mlir_ciface_net(tc_net_in0_memref* in0, tc_net_in1_memref* in1, "
+                                 "tc_net_out0_memref* out0, tc_net_out1_memref* out1)\n{\n"
+                                 "    net(in0->aligned + in0->offset, in1->aligned + in1->offset, "
+                                 "out0->aligned + out0->offset, out1->aligned + out1->offset);\n}"));
+    EXPECT_FALSE(contains(header, "void _mlir_ciface_net(tc_net_in0_memref* in0, tc_net_in1_memref* in1, "
+                                  "tc_net_out0_memref* out0, tc_net_out1_memref* out1);"));
+}
+
+TEST(HeaderEmitterTest, AsyncApiQueuesOnTheRuntime)
+{
+    auto entry = makeEntry();
+    entry.async_api = true;
+    auto header = emit(entry);
+
+    EXPECT_TRUE(contains(header, "#include <stdlib.h>\n\n#include \"runtime/tc_runtime.h\"\n"));
+    EXPECT_TRUE(contains(header, "    tc_buffer  inputs[2];\n    tc_buffer* outputs;\n} tc_net_call;"));
+    EXPECT_TRUE(contains(header, "static inline tc_request* tc_net_invoke_async(const tc_buffer* inputs, tc_buffer* outputs,"));
+    EXPECT_TRUE(contains(header, "    tc_request* req = tc_runtime_submit(tc_net_run_call, call, on_done, user_data);"));
+    EXPECT_TRUE(contains(header, "#define TC_MODEL_INVOKE_ASYNC tc_net_invoke_async"));
+
+    // the async wrapper calls the synchronous one, which must come first
+    EXPECT_LT(header.find("static inline int tc_net_invoke("), header.find("tc_net_run_call"));
+}
+
+TEST(HeaderEmitterTest, NoInputsKeepsArraysNonEmpty)
+{
+    EntryPointDesc entry;
+    entry.symbol    = "gen";
+    entry.outputs   = {{"y", DataType::FLOAT, {2}}};
+    entry.async_api = true;
+    auto header = emit(entry);
+
+    EXPECT_TRUE(contains(header, "#define TC_GEN_NUM_INPUTS   0"));
+    EXPECT_TRUE(contains(header, "void _mlir_ciface_gen(tc_gen_out0_memref* result);"));
+    EXPECT_TRUE(contains(header, "static const tc_tensor_info tc_gen_inputs[1] = {\n    {NULL, TC_DTYPE_FLOAT, 0, 0, NULL},\n};"));
+    EXPECT_TRUE(contains(header, "    tc_buffer  inputs[1];"));
+    EXPECT_TRUE(contains(header, "    _mlir_ciface_gen(&result);"));
+}
+
+TEST(HeaderEmitterTest, SeveralModelsShareOneHeader)
+{
+    auto first = makeEntry();
+    auto second = makeEntry();
+    second.symbol = "head";
+
+    auto path = std::filesystem::temp_directory_path() / "tc_test_models.h";
+    std::vector<EntryPointDesc> entries{first, second};
+    writeModelHeader(entries, path);
+
+    std::ifstream ifs(path);
+    std::string header((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+
+    EXPECT_TRUE(contains(header, "void _mlir_ciface_net("));
+    EXPECT_TRUE(contains(header, "void _mlir_ciface_head("));
+
+    // common types are guarded, each model defines the default macros only if none is set yet,
+    // so the first one stays the default
+    EXPECT_EQ(countOf(header, "#ifndef TC_MODEL_COMMON_DEFINED"), 2u);
+    EXPECT_EQ(countOf(header, "#ifndef TC_MODEL_INVOKE\n"), 2u);
+    EXPECT_LT(header.find("#define TC_MODEL_INVOKE       tc_net_invoke"),
+              header.find("#define TC_MODEL_INVOKE       tc_head_invoke"));
+    EXPECT_TRUE(contains(header, "#define TC_MODEL_NAME         \"head\""));
+}
+
+TEST(HeaderEmitterTest, UnwritablePathThrows)
+{
+    EXPECT_THROW(writeModelHeader(makeEntry(), "/nonexistent_dir/model.h"), std::runtime_error);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "backend/codegen.hpp"
+#include "middle_end/mlir_builders.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "llvm/IR/LLVMContext.h"
+
+using namespace tc;
+using namespace mlir;
+
+// runOptPipeline() on Conv -> Relu -> pool chains, see tilePoolingChains() in codegen.cpp
+class OptPipelineTest : public ::testing::Test
+{
+protected:
+    // test(input 1x3x16x16, weights 8x3x3x3) = pool(relu(conv(input, weights))), 3x3 windows
+    // of stride 2, padded by 1
+    void buildChain(OpType poolType)
+    {
+        auto inputType   = RankedTensorType::get({1, 3, 16, 16}, builder.getF32Type());
+        auto weightsType = RankedTensorType::get({8, 3, 3, 3}, builder.getF32Type());
+
+        module = ModuleOp::create(loc);
+        auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({inputType, weightsType}, {}));
+        func.addEntryBlock();
+        builder.setInsertionPointToStart(&func.getBody().front());
+
+        Value conv = buildConv2dOp(builder, loc, func.getArgument(0), func.getArgument(1), std::nullopt,
+                                   {3, 3}, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1, "NOTSET", &ctx);
+        Value relu = buildReLU(builder, loc, conv, &ctx);
+        Value pool = buildPool2dOp(poolType, builder, loc, relu, {3, 3}, {2, 2}, {1, 1, 1, 1}, {1, 1},
+                                   false, true, "NOTSET", &ctx);
+
+        func.setType(builder.getFunctionType({inputType, weightsType}, {pool.getType()}));
+        ret = func::ReturnOp::create(builder, loc, pool);
+        module.push_back(func);
+        ASSERT_TRUE(succeeded(verify(module)));
+    }
+
+    // every conv and pool sits in the tile loop, which yields the function's result, and
+    // nothing of the conv's full output size is computed outside of it
+    void expectTiled()
+    {
+        CodeGen::runOptPipeline(module, {});
+        ASSERT_TRUE(succeeded(verify(module)));
+
+        EXPECT_TRUE(ret.getOperand(0).getDefiningOp<scf::ForOp>());
+
+        auto convType = RankedTensorType::get({1, 8, 16, 16}, builder.getF32Type());
+        for (auto& op : ret->getBlock()->getOperations())
+        {
+            EXPECT_FALSE(isa<linalg::LinalgOp>(op)) << op.getName().getStringRef().str();
+            for (auto type : op.getResultTypes())
+                EXPECT_NE(type, convType) << op.getName().getStringRef().str();
+        }
+
+        int convs = 0;
+        module.walk([&](linalg::Conv2DNchwFchwOp conv)
+        {
+            ++convs;
+            EXPECT_TRUE(conv->getParentOfType<scf::ForOp>());
+        });
+        EXPECT_EQ(convs, 1);
+
+        int pools = 0;
+        module.walk([&](Operation* op)
+        {
+            if (!isa<linalg::PoolingNchwMaxOp, linalg::PoolingNchwSumOp>(op)) return;
+            ++pools;
+            EXPECT_TRUE(op->getParentOfType<scf::ForOp>());
+        });
+        EXPECT_EQ(pools, 1);
+    }
+
+    MLIRContext ctx;
+    llvm::LLVMContext llvmCtx;
+    // loads the dialects and tiling models the pipeline needs
+    CodeGen codegen = CodeGen(ctx, llvmCtx);
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+    func::ReturnOp ret;
+};
+
+TEST_F(OptPipelineTest, MaxPoolChainIsTiled)
+{
+    buildChain(OpType::MaxPool);
+    expectTiled();
+}
+
+TEST_F(OptPipelineTest, AveragePoolChainIsTiledWithItsDivision)
+{
+    buildChain(OpType::AveragePool);
+    expectTiled();
+
+    // the division is the tile's outermost op, nothing is computed after the loop
+    module.walk([&](linalg::GenericOp generic)
+    {
+        EXPECT_TRUE(generic->getParentOfType<scf::ForOp>());
+    });
+}
+
+TEST_F(OptPipelineTest, ParallelLoopsLeaveChainsWhole)
+{
+    buildChain(OpType::MaxPool);
+
+    CodeGenOptions opts;
+    opts.parallel_loops = true;
+    CodeGen::runOptPipeline(module, opts);
+
+    int loops = 0;
+    module.walk([&](scf::ForOp) { ++loops; });
+    EXPECT_EQ(loops, 0);
+}
@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+#include "backend/codegen.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Async/IR/Async.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+
+#include <algorithm>
+
+using namespace tc;
+using namespace mlir;
+
+
+// x -> stem -> {left, right} -> join -> out, all of n floats, or dynamic ones
+static std::shared_ptr<Graph> createDiamond(int64_t n, bool dynamic)
+{
+    auto graph = std::make_shared<Graph>("diamond");
+    auto node = [&](const std::string& name, OpType op, const std::string& str,
+                    std::vector<std::string> inputs, const std::string& output)
+    {
+        graph->addTensor(std::make_shared<Tensor>(output, DataType::FLOAT, TensorShape{{dynamic ? -1 : n}}));
+        graph->addNode(std::make_shared<Node>(name, op, str, std::move(inputs), std::vector<std::string>{output},
+                                              Node::AttributeList{}));
+    };
+
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{dynamic ? -1 : n}}));
+    graph->addInput("x");
+    node("stem",  OpType::Relu, "Relu", {"x"},      "s");
+    node("left",  OpType::Relu, "Relu", {"s"},      "l");
+    node("right", OpType::Exp,  "Exp",  {"s"},      "r");
+    node("join",  OpType::Add,  "Add",  {"l", "r"}, "out");
+    graph->addOutput("out");
+    return graph;
+}
+
+static std::vector<func::FuncOp> taskFunctions(ModuleOp module)
+{
+    std::vector<func::FuncOp> tasks;
+    for (auto func : module.getOps<func::FuncOp>())
+        if (func->hasAttr("tc.task")) tasks.push_back(func);
+    return tasks;
+}
+
+static std::vector<int64_t> depsOf(func::FuncOp task)
+{
+    auto deps = task->getAttrOfType<DenseI64ArrayAttr>("tc.task_deps").asArrayRef();
+    std::vector<int64_t> sorted(deps.begin(), deps.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+class ParallelBranchesTest : public ::testing::Test
+{
+protected:
+    CodeGenOptions parallel()
+    {
+        CodeGenOptions opts;
+        opts.parallel_branches = true;
+        return opts;
+    }
+
+    MLIRContext ctx;
+    llvm::LLVMContext llvmCtx;
+    CodeGen codegen = CodeGen(ctx, llvmCtx);
+};
+
+
+TEST_F(ParallelBranchesTest, DiamondBecomesFourTasks)
+{
+    auto module = codegen.buildModule(*createDiamond(64, false), parallel());
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    ASSERT_EQ(codegen.taskSplits().size(), 1u);
+    const auto& split = codegen.taskSplits().front();
+    EXPECT_EQ(split.entry, "diamond");
+    EXPECT_EQ(split.tasks, 4u);
+    EXPECT_EQ(split.width, 2u);
+    EXPECT_TRUE(split.emitted);
+
+    auto tasks = taskFunctions(*module);
+    ASSERT_EQ(tasks.size(), 4u);
+    for (size_t t = 0; t < tasks.size(); ++t)
+    {
+        EXPECT_TRUE(tasks[t].isPrivate());
+        EXPECT_EQ(tasks[t]->getAttrOfType<IntegerAttr>("tc.task_index").getInt(), static_cast<int64_t>(t));
+        // results are written into buffers, nothing is returned
+        EXPECT_EQ(tasks[t].getNumResults(), 0u);
+    }
+
+    // the stem runs first, both branches wait for it only, the join for both
+    EXPECT_TRUE(depsOf(tasks[0]).empty());
+    EXPECT_EQ(depsOf(tasks[1]), std::vector<int64_t>{0});
+    EXPECT_EQ(depsOf(tasks[2]), std::vector<int64_t>{0});
+    EXPECT_EQ(depsOf(tasks[3]), (std::vector<int64_t>{1, 2}));
+
+    // the entry calls them in order, and returns what the join wrote
+    auto entry = module->lookupSymbol<func::FuncOp>("diamond");
+    ASSERT_TRUE(entry);
+    std::vector<std::string> callees;
+    entry.walk([&](func::CallOp call) { callees.push_back(call.getCallee().str()); });
+    EXPECT_EQ(callees, (std::vector<std::string>{"diamond_task0", "diamond_task1", "diamond_task2", "diamond_task3"}));
+
+    auto ret = cast<func::ReturnOp>(entry.getBody().front().getTerminator());
+    auto result = ret.getOperand(0).getDefiningOp<bufferization::ToTensorOp>();
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result.getBuffer().getDefiningOp<memref::AllocOp>());
+}
+
+TEST_F(ParallelBranchesTest, DynamicTensorsBetweenTasksFallBackToOneFunction)
+{
+    auto module = codegen.buildModule(*createDiamond(64, true), parallel());
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    ASSERT_EQ(codegen.taskSplits().size(), 1u);
+    EXPECT_EQ(codegen.taskSplits().front().tasks, 4u);
+    EXPECT_FALSE(codegen.taskSplits().front().emitted);
+
+    // emitTasks() undid the first task: no function, call, buffer or read of one is left
+    EXPECT_TRUE(taskFunctions(*module).empty());
+    int leftovers = 0;
+    module->walk([&](Operation* op)
+    {
+        if (isa<func::CallOp, memref::AllocOp, bufferization::ToTensorOp>(op)) ++leftovers;
+    });
+    EXPECT_EQ(leftovers, 0);
+}
+
+TEST_F(ParallelBranchesTest, ChainIsNotSplit)
+{
+    auto graph = std::make_shared<Graph>("chain");
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{64}}));
+    graph->addTensor(std::make_shared<Tensor>("out", DataType::FLOAT, TensorShape{{64}}));
+    graph->addInput("x");
+    graph->addNode(std::make_shared<Node>("r", OpType::Relu, "Relu", std::vector<std::string>{"x"},
+                                          std::vector<std::string>{"out"}, Node::AttributeList{}));
+    graph->addOutput("out");
+
+    auto module = codegen.buildModule(*graph, parallel());
+    ASSERT_TRUE(succeeded(verify(*module)));
+    ASSERT_EQ(codegen.taskSplits().size(), 1u);
+    EXPECT_EQ(codegen.taskSplits().front().width, 1u);
+    EXPECT_FALSE(codegen.taskSplits().front().emitted);
+    EXPECT_TRUE(taskFunctions(*module).empty());
+}
+
+
+// the diamond as buildModule() emits it, after bufferization
+static constexpr const char* kBufferizedDiamond = R"mlir(
+func.func private @d_task0(%x: memref<64xf32>, %s: memref<64xf32>)
+    attributes {tc.task, tc.task_index = 0 : i64, tc.task_deps = array<i64>} { return }
+func.func private @d_task1(%s: memref<64xf32>, %l: memref<64xf32>)
+    attributes {tc.task, tc.task_index = 1 : i64, tc.task_deps = array<i64: 0>} { return }
+func.func private @d_task2(%s: memref<64xf32>, %r: memref<64xf32>)
+    attributes {tc.task, tc.task_index = 2 : i64, tc.task_deps = array<i64: 0>} { return }
+func.func private @d_task3(%l: memref<64xf32>, %r: memref<64xf32>, %out: memref<64xf32>)
+    attributes {tc.task, tc.task_index = 3 : i64, tc.task_deps = array<i64: 1, 2>} { return }
+
+func.func @d(%x: memref<64xf32>) -> memref<64xf32> {
+    %s = memref.alloc() : memref<64xf32>
+    func.call @d_task0(%x, %s) : (memref<64xf32>, memref<64xf32>) -> ()
+    %l = memref.alloc() : memref<64xf32>
+    func.call @d_task1(%s, %l) : (memref<64xf32>, memref<64xf32>) -> ()
+    %r = memref.alloc() : memref<64xf32>
+    func.call @d_task2(%s, %r) : (memref<64xf32>, memref<64xf32>) -> ()
+    %out = memref.alloc() : memref<64xf32>
+    func.call @d_task3(%l, %r, %out) : (memref<64xf32>, memref<64xf32>, memref<64xf32>) -> ()
+    memref.dealloc %s : memref<64xf32>
+    return %out : memref<64xf32>
+}
+)mlir";
+
+TEST_F(ParallelBranchesTest, TaskCallsWaitOnlyForTheirDependencies)
+{
+    auto module = parseSourceString<ModuleOp>(kBufferizedDiamond, &ctx);
+    ASSERT_TRUE(module);
+
+    CodeGen::parallelizeTaskCalls(*module);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto entry = module->lookupSymbol<func::FuncOp>("d");
+    std::vector<async::ExecuteOp> execs;
+    for (auto exec : entry.getBody().front().getOps<async::ExecuteOp>())
+        execs.push_back(exec);
+    ASSERT_EQ(execs.size(), 4u);
+
+    // each launch calls its task, the calls left in the entry itself are none
+    for (size_t t = 0; t < execs.size(); ++t)
+    {
+        auto calls = llvm::to_vector(execs[t].getBodyRegion().getOps<func::CallOp>());
+        ASSERT_EQ(calls.size(), 1u);
+        EXPECT_EQ(calls.front().getCallee(), "d_task" + std::to_string(t));
+    }
+    EXPECT_TRUE(entry.getBody().front().getOps<func::CallOp>().empty());
+
+    auto deps = [](async::ExecuteOp exec) { return llvm::to_vector(exec.getDependencies()); };
+    EXPECT_TRUE(deps(execs[0]).empty());
+    EXPECT_EQ(deps(execs[1]), llvm::SmallVector<Value>{execs[0].getToken()});
+    EXPECT_EQ(deps(execs[2]), llvm::SmallVector<Value>{execs[0].getToken()});
+    EXPECT_EQ(deps(execs[3]), (llvm::SmallVector<Value>{execs[1].getToken(), execs[2].getToken()}));
+
+    // the allocations touch no buffer and don't wait, the dealloc waits for every task
+    // launched before it, so the return has nothing left to wait for
+    std::vector<Value> awaited;
+    Operation* dealloc = nullptr;
+    for (auto& op : entry.getBody().front())
+    {
+        if (auto await = dyn_cast<async::AwaitOp>(op))
+        {
+            EXPECT_FALSE(dealloc);
+            awaited.push_back(await.getOperand());
+        }
+        if (isa<memref::DeallocOp>(op)) dealloc = &op;
+    }
+    ASSERT_TRUE(dealloc);
+    std::vector<Value> tokens;
+    for (auto exec : execs)
+        tokens.push_back(exec.getToken());
+    EXPECT_EQ(awaited, tokens);
+    EXPECT_TRUE(isa<async::AwaitOp>(dealloc->getPrevNode()));
+}
+
+TEST_F(ParallelBranchesTest, ReturnWaitsForTheLastTasks)
+{
+    std::string src = kBufferizedDiamond;
+    auto dealloc = src.find("    memref.dealloc");
+    src.erase(dealloc, src.find('\n', dealloc) + 1 - dealloc);
+
+    auto module = parseSourceString<ModuleOp>(src, &ctx);
+    ASSERT_TRUE(module);
+    CodeGen::parallelizeTaskCalls(*module);
+    ASSERT_TRUE(succeeded(verify(*module)));
+
+    auto entry = module->lookupSymbol<func::FuncOp>("d");
+    auto* ret = entry.getBody().front().getTerminator();
+    int awaits = 0;
+    for (auto* op = ret->getPrevNode(); op && isa<async::AwaitOp>(op); op = op->getPrevNode())
+        ++awaits;
+    EXPECT_EQ(awaits, 4);
+}
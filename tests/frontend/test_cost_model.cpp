@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include "graph/cost_model.hpp"
+
+using namespace tc;
+
+
+static void addTensor(Graph& graph, const std::string& name, std::vector<int64_t> dims, bool constant = false)
+{
+    auto t = std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{dims});
+    if (constant)
+        t->setRawData(std::vector<uint8_t>(t->numElements() * sizeof(float)));
+    graph.addTensor(t);
+}
+
+static const NodeCost& costOf(const Graph& graph, const CostReport& report, const std::string& name)
+{
+    auto id = graph.nodeId(name);
+    for (const auto& c : report.nodes)
+        if (c.node == id) return c;
+    throw std::runtime_error("no cost for " + name);
+}
+
+
+TEST(CostModelTest, ConvWithGroupsStridesAndDilations)
+{
+    // x[1,8,32,32] -> Conv(W[16,4,3,3], B, group 2, stride 2, dilation 2, pad 2) -> y (shape not declared)
+    Graph graph("conv");
+    addTensor(graph, "x", {1, 8, 32, 32});
+    addTensor(graph, "W", {16, 4, 3, 3}, true);
+    addTensor(graph, "B", {16}, true);
+    graph.addInput("x");
+
+    graph.addNode(std::make_shared<Node>("conv", OpType::Conv, "Conv",
+        std::vector<std::string>{"x", "W", "B"}, std::vector<std::string>{"y"},
+        Node::AttributeList{
+            Attribute("group",     AttributeType::INT,  int64_t{2}),
+            Attribute("strides",   AttributeType::INTS, std::vector<int64_t>{2, 2}),
+            Attribute("dilations", AttributeType::INTS, std::vector<int64_t>{2, 2}),
+            Attribute("pads",      AttributeType::INTS, std::vector<int64_t>{2, 2, 2, 2}),
+        }));
+
+    auto report = estimateCost(graph);
+    const auto& c = costOf(graph, report, "conv");
+
+    // out 16 x 16 x 16, (32 + 4 - 5) / 2 + 1 = 16
+    const uint64_t out = 16 * 16 * 16;
+    EXPECT_EQ(c.flops, 2 * out * 4 * 9 + out);
+    EXPECT_EQ(c.weight_bytes, (16 * 4 * 9 + 16) * 4u);
+    EXPECT_EQ(c.activation_bytes, (8 * 32 * 32 + out) * 4u);
+    EXPECT_TRUE(c.exact);
+    EXPECT_EQ(report.inexact_nodes, 0u);
+}
+
+TEST(CostModelTest, PoolingWithCeilMode)
+{
+    // x[1,4,6,6] -> MaxPool(3x3, stride 2, ceil_mode) -> y -> GlobalAveragePool -> z
+    Graph graph("pool");
+    addTensor(graph, "x", {1, 4, 6, 6});
+    graph.addInput("x");
+
+    graph.addNode(std::make_shared<Node>("pool", OpType::MaxPool, "MaxPool",
+        std::vector<std::string>{"x"}, std::vector<std::string>{"y"},
+        Node::AttributeList{
+            Attribute("kernel_shape", AttributeType::INTS, std::vector<int64_t>{3, 3}),
+            Attribute("strides",      AttributeType::INTS, std::vector<int64_t>{2, 2}),
+            Attribute("ceil_mode",    AttributeType::INT,  int64_t{1}),
+        }));
+    graph.addNode(std::make_shared<Node>("gap", OpType::GlobalAveragePool, "GlobalAveragePool",
+        std::vector<std::string>{"y"}, std::vector<std::string>{"z"}));
+
+    auto report = estimateCost(graph);
+
+    // ceil((6 - 3) / 2) + 1 = 3 where floor would give 2
+    const uint64_t pooled = 4 * 3 * 3;
+    EXPECT_EQ(costOf(graph, report, "pool").flops, pooled * 9);
+    EXPECT_EQ(costOf(graph, report, "gap").flops, pooled + 4);
+    EXPECT_EQ(costOf(graph, report, "gap").activation_bytes, (pooled + 4) * 4u);
+    EXPECT_EQ(report.inexact_nodes, 0u);
+}
+
+TEST(CostModelTest, MatMulGemmAndElementwise)
+{
+    // a[2,1,4,8] x b[3,8,5] -> m[2,3,4,5] + bias[5] -> s, and Gemm(g_in^T, g_w^T, g_c) -> g
+    Graph graph("mm");
+    addTensor(graph, "a", {2, 1, 4, 8});
+    addTensor(graph, "b", {3, 8, 5});
+    addTensor(graph, "bias", {5}, true);
+    addTensor(graph, "g_in", {6, 4});
+    addTensor(graph, "g_w", {10, 6}, true);
+    addTensor(graph, "g_c", {10}, true);
+    graph.addInput("a");
+    graph.addInput("b");
+    graph.addInput("g_in");
+
+    graph.addNode(std::make_shared<Node>("mm", OpType::MatMul, "MatMul",
+        std::vector<std::string>{"a", "b"}, std::vector<std::string>{"m"}));
+    graph.addNode(std::make_shared<Node>("add", OpType::Add, "Add",
+        std::vector<std::string>{"m", "bias"}, std::vector<std::string>{"s"}));
+    graph.addNode(std::make_shared<Node>("gemm", OpType::Gemm, "Gemm",
+        std::vector<std::string>{"g_in", "g_w", "g_c"}, std::vector<std::string>{"g"},
+        Node::AttributeList{
+            Attribute("transA", AttributeType::INT,   int64_t{1}),
+            Attribute("transB", AttributeType::INT,   int64_t{1}),
+            Attribute("beta",   AttributeType::FLOAT, 0.5f),
+        }));
+
+    auto report = estimateCost(graph);
+
+    EXPECT_EQ(costOf(graph, report, "mm").flops, 2u * 6 * 4 * 5 * 8);
+    EXPECT_EQ(costOf(graph, report, "mm").activation_bytes, (64 + 120 + 120) * 4u);
+
+    // the inferred [2,3,4,5] flows into the Add
+    EXPECT_EQ(costOf(graph, report, "add").flops, 120u);
+    EXPECT_EQ(costOf(graph, report, "add").weight_bytes, 20u);
+
+    // A' is [4,6], B' is [6,10]: 2*4*10*6 plus the C add and the beta scale
+    EXPECT_EQ(costOf(graph, report, "gemm").flops, 2u * 4 * 10 * 6 + 40 + 40);
+
+    EXPECT_EQ(report.flops, 2u * 6 * 4 * 5 * 8 + 120 + 2 * 4 * 10 * 6 + 80);
+    EXPECT_EQ(report.weight_bytes, (5 + 60 + 10) * 4u);
+    EXPECT_EQ(report.inexact_nodes, 0u);
+}
+
+TEST(CostModelTest, RooflineClassification)
+{
+    // a large square MatMul is compute-bound, a Relu of the same output memory-bound
+    Graph graph("roofline");
+    addTensor(graph, "a", {256, 256});
+    addTensor(graph, "w", {256, 256}, true);
+    graph.addInput("a");
+    graph.addNode(std::make_shared<Node>("mm", OpType::MatMul, "MatMul",
+        std::vector<std::string>{"a", "w"}, std::vector<std::string>{"m"}));
+    graph.addNode(std::make_shared<Node>("relu", OpType::Relu, "Relu",
+        std::vector<std::string>{"m"}, std::vector<std::string>{"r"}));
+    graph.addNode(std::make_shared<Node>("cat", OpType::Concat, "Concat",
+        std::vector<std::string>{"r", "m"}, std::vector<std::string>{"c"},
+        Node::AttributeList{Attribute("axis", AttributeType::INT, int64_t{-1})}));
+    graph.addOutput("c");
+
+    MachineModel machine = machineModelFromString("100,10");
+    EXPECT_DOUBLE_EQ(machine.ridgePoint(), 10.0);
+
+    auto report = estimateCost(graph, machine);
+    const auto& mm   = costOf(graph, report, "mm");
+    const auto& relu = costOf(graph, report, "relu");
+    EXPECT_EQ(mm.bound, Bound::Compute);
+    EXPECT_DOUBLE_EQ(mm.seconds, static_cast<double>(mm.flops) / 100e9);
+    EXPECT_EQ(relu.bound, Bound::Memory);
+    EXPECT_DOUBLE_EQ(relu.seconds, static_cast<double>(relu.bytes()) / 10e9);
+
+    // Concat moves both inputs into a [256, 512] result
+    EXPECT_EQ(costOf(graph, report, "cat").activation_bytes, 4u * 256 * 256 * 4);
+    EXPECT_NE(report.summary(graph).find("MatMul  mm"), std::string::npos);
+
+    EXPECT_THROW((void)machineModelFromString("100"), std::runtime_error);
+    EXPECT_THROW((void)machineModelFromString("x,1"), std::runtime_error);
+}
+
+TEST(CostModelTest, DynamicAndUnknownShapesAreInexact)
+{
+    Graph graph("dynamic");
+    addTensor(graph, "x", {-1, 16});
+    graph.addInput("x");
+    graph.addNode(std::make_shared<Node>("relu", OpType::Relu, "Relu",
+        std::vector<std::string>{"x"}, std::vector<std::string>{"r"}));
+    graph.addNode(std::make_shared<Node>("soft", OpType::Other, "Softmax",
+        std::vector<std::string>{"r"}, std::vector<std::string>{"s"}));
+
+    auto report = estimateCost(graph);
+    EXPECT_EQ(costOf(graph, report, "relu").flops, 16u);
+    EXPECT_FALSE(costOf(graph, report, "relu").exact);
+    EXPECT_EQ(costOf(graph, report, "soft").flops, 0u);
+    EXPECT_FALSE(costOf(graph, report, "soft").exact);
+    EXPECT_EQ(report.inexact_nodes, 2u);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "visualization/dot_exporter.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace tc;
+
+
+static size_t countOf(const std::string& s, const std::string& what)
+{
+    size_t n = 0;
+    for (auto pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + what.size()))
+        ++n;
+    return n;
+}
+
+// x -> blocks x (/block<i>/conv/Conv -> /block<i>/relu/Relu) -> y
+static std::shared_ptr<Graph> createBlockGraph(int blocks)
+{
+    auto graph = std::make_shared<Graph>("blocks");
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{1, 4}}));
+    graph->addTensor(std::make_shared<Tensor>("y", DataType::FLOAT, TensorShape{{1, 4}}));
+    graph->addInput("x");
+    graph->addOutput("y");
+
+    std::string prev = "x";
+    for (int i = 0; i < blocks; ++i)
+    {
+        std::string scope = "/block" + std::to_string(i);
+        std::string mid   = scope + "/c";
+        std::string out   = i + 1 == blocks ? "y" : scope + "/r";
+        graph->addNode(std::make_shared<Node>(scope + "/conv/Conv", OpType::Add, "Add",
+            std::vector<std::string>{prev, prev}, std::vector<std::string>{mid}));
+        graph->addNode(std::make_shared<Node>(scope + "/relu/Relu", OpType::Relu, "Relu",
+            std::vector<std::string>{mid}, std::vector<std::string>{out}));
+        prev = out;
+    }
+    return graph;
+}
+
+
+TEST(DotExporterTest, SmallGraphIsDrawnNodeByNode)
+{
+    auto graph = createBlockGraph(3);
+    auto dot = DotExporter().toDot(*graph);
+
+    EXPECT_EQ(countOf(dot, "fillcolor=\"#A9DFBF\""), 3u);   // Relu
+    EXPECT_NE(dot.find("\"input_x\" -> \"/block0/conv/Conv\""), std::string::npos);
+    EXPECT_NE(dot.find("\"/block2/relu/Relu\" -> \"output_y\""), std::string::npos);
+    EXPECT_EQ(dot.find("scope_"), std::string::npos);
+}
+
+TEST(DotExporterTest, LargeGraphCollapsesScopes)
+{
+    auto graph = createBlockGraph(6);
+
+    DotExporter::Options opts;
+    opts.cluster_threshold = 8;
+    auto dot = DotExporter(opts).toDot(*graph);
+
+    // 12 nodes collapse to one box per block, x is read twice but drawn once
+    EXPECT_EQ(countOf(dot, "(2 nodes)"), 6u);
+    EXPECT_NE(dot.find("Add x1\\lRelu x1\\l"), std::string::npos);
+    EXPECT_EQ(countOf(dot, "\"input_x\" -> \"scope_/block0\""), 1u);
+    EXPECT_EQ(countOf(dot, "\"scope_/block0\" -> \"scope_/block1\""), 1u);
+    EXPECT_EQ(countOf(dot, " -> "), 7u);
+
+    // more blocks than the threshold, the outermost scope level is as far as it goes
+    opts.cluster_threshold = 3;
+    dot = DotExporter(opts).toDot(*graph);
+    EXPECT_EQ(countOf(dot, "(2 nodes)"), 6u);
+}
+
+TEST(DotExporterTest, HeatFromProfile)
+{
+    auto graph = createBlockGraph(2);
+
+    auto path = std::filesystem::temp_directory_path() / "tc_test_profile.txt";
+    {
+        std::ofstream ofs(path);
+        ofs << "# node, ms\n"
+            << "/block0/conv/Conv, 3.0\n"
+            << "/block1/relu/Relu 1\n"
+            << "/block1/relu/Relu,1.0\n"
+            << "not_in_graph,100\n";
+    }
+    auto heat = loadProfile(path, *graph);
+    ASSERT_EQ(heat.size(), 4u);
+    EXPECT_DOUBLE_EQ(heat[graph->nodeId("/block0/conv/Conv")], 3e-3);
+    EXPECT_DOUBLE_EQ(heat[graph->nodeId("/block1/relu/Relu")], 2e-3);
+
+    DotExporter::Options opts;
+    opts.heat = heat;
+    auto dot_path = std::filesystem::temp_directory_path() / "tc_test_heat.dot";
+    DotExporter(opts).exportToFile(*graph, dot_path);
+
+    std::ifstream ifs(dot_path);
+    std::string dot((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_NE(dot.find("|3.000 ms (60.0%)}\", fillcolor=\"#A50F15\""), std::string::npos);
+    EXPECT_NE(dot.find("|0.000 ms (0.0%)}\", fillcolor=\"#FFF5F0\""), std::string::npos);
+
+    {
+        std::ofstream ofs(path);
+        ofs << "unknown 1.0\n";
+    }
+    EXPECT_THROW((void)loadProfile(path, *graph), std::runtime_error);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(dot_path);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "graph/fusion.hpp"
+
+#include <cstring>
+
+using namespace tc;
+
+
+static void addActivation(Graph& graph, const std::string& name, std::vector<int64_t> dims = {2, 8})
+{
+    graph.addTensor(std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{std::move(dims)}));
+}
+
+static void addFloats(Graph& graph, const std::string& name, std::vector<float> values, std::vector<int64_t> dims)
+{
+    auto t = std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{std::move(dims)});
+    std::vector<uint8_t> bytes(values.size() * sizeof(float));
+    std::memcpy(bytes.data(), values.data(), bytes.size());
+    t->setRawData(std::move(bytes));
+    graph.addTensor(t);
+}
+
+static void addOp(Graph& graph, const std::string& name, const std::string& op, std::vector<std::string> inputs,
+                  const std::string& output, Node::AttributeList attrs = {})
+{
+    addActivation(graph, output);
+    graph.addNode(std::make_shared<Node>(name, opTypeFromString(op), op, std::move(inputs),
+                                         std::vector<std::string>{output}, std::move(attrs)));
+}
+
+static Node::AttributeList lastAxis()
+{
+    return {Attribute("axes", AttributeType::INTS, std::vector<int64_t>{-1})};
+}
+
+// the decomposition torch.onnx emits for nn.LayerNorm(8)
+static std::shared_ptr<Graph> decomposedLayerNorm()
+{
+    auto graph = std::make_shared<Graph>("ln");
+    addActivation(*graph, "x");
+    graph->addInput("x");
+    addFloats(*graph, "two", {2.0f}, {});
+    addFloats(*graph, "eps", {1e-6f}, {});
+    addFloats(*graph, "gamma", std::vector<float>(8, 1.5f), {8});
+    addFloats(*graph, "beta", std::vector<float>(8, 0.5f), {8});
+
+    addOp(*graph, "mean", "ReduceMean", {"x"}, "m", lastAxis());
+    addOp(*graph, "sub", "Sub", {"x", "m"}, "d");
+    addOp(*graph, "pow", "Pow", {"d", "two"}, "d2");
+    addOp(*graph, "var", "ReduceMean", {"d2"}, "v", lastAxis());
+    addOp(*graph, "add_eps", "Add", {"v", "eps"}, "ve");
+    addOp(*graph, "sqrt", "Sqrt", {"ve"}, "s");
+    addOp(*graph, "div", "Div", {"d", "s"}, "n");
+    addOp(*graph, "mul", "Mul", {"n", "gamma"}, "ns");
+    addOp(*graph, "add", "Add", {"ns", "beta"}, "y");
+    addOp(*graph, "relu", "Relu", {"y"}, "out");
+    graph->addOutput("out");
+    return graph;
+}
+
+TEST(FusionTest, DecomposedLayerNormBecomesOneNode)
+{
+    auto graph = decomposedLayerNorm();
+    ASSERT_EQ(fuseLayerNorm(graph), 1u);
+
+    ASSERT_EQ(graph->getNodes().size(), 2u);
+    const auto& order = graph->topologicalOrder();
+    ASSERT_EQ(order.size(), 2u);
+
+    const Node& ln = *graph->getNodes()[order[0]];
+    EXPECT_EQ(ln.getOpType(), OpType::LayerNormalization);
+    EXPECT_EQ(ln.getInputs(), (Node::NameList{"x", "gamma", "beta"}));
+    EXPECT_EQ(ln.getOutputs(), (Node::NameList{"y"}));
+    EXPECT_EQ(ln.attributeOr<int64_t>(AttrKey::Axis, 0), -1);
+    EXPECT_FLOAT_EQ(ln.attributeOr<float>(AttrKey::Epsilon, 0.0f), 1e-6f);
+    EXPECT_EQ(graph->getNodes()[order[1]]->getOpType(), OpType::Relu);
+
+    // intermediates and the constants only they read are gone, the parameters stay
+    EXPECT_EQ(graph->findTensor("d"), nullptr);
+    EXPECT_EQ(graph->findTensor("eps"), nullptr);
+    ASSERT_NE(graph->findTensor("gamma"), nullptr);
+    EXPECT_TRUE(graph->findTensor("gamma")->hasValidData());
+    EXPECT_EQ(graph->getInputs(), (std::vector<std::string>{"x"}));
+    EXPECT_EQ(graph->getOutputs(), (std::vector<std::string>{"out"}));
+}
+
+TEST(FusionTest, SharedIntermediateIsLeftAlone)
+{
+    auto graph = decomposedLayerNorm();
+    graph->addOutput("v");  // the variance is needed elsewhere
+
+    auto before = graph.get();
+    EXPECT_EQ(fuseLayerNorm(graph), 0u);
+    EXPECT_EQ(graph.get(), before);
+    EXPECT_EQ(graph->getNodes().size(), 10u);
+}
+
+// x * x for the square, positive axes of a known rank, no scale or bias
+TEST(FusionTest, SquareAsMulAndPositiveAxes)
+{
+    auto graph = std::make_shared<Graph>("ln");
+    addActivation(*graph, "x", {2, 4, 8});
+    graph->addInput("x");
+    addFloats(*graph, "eps", {1e-5f}, {1});
+
+    Node::AttributeList axes{Attribute("axes", AttributeType::INTS, std::vector<int64_t>{2, 1})};
+    addOp(*graph, "mean", "ReduceMean", {"x"}, "m", axes);
+    addOp(*graph, "sub", "Sub", {"x", "m"}, "d");
+    addOp(*graph, "sq", "Mul", {"d", "d"}, "d2");
+    addOp(*graph, "var", "ReduceMean", {"d2"}, "v", axes);
+    addOp(*graph, "add_eps", "Add", {"eps", "v"}, "ve");
+    addOp(*graph, "sqrt", "Sqrt", {"ve"}, "s");
+    addOp(*graph, "div", "Div", {"d", "s"}, "y");
+    graph->addOutput("y");
+
+    ASSERT_EQ(fuseLayerNorm(graph), 1u);
+    ASSERT_EQ(graph->getNodes().size(), 1u);
+
+    const Node& ln = *graph->getNodes()[0];
+    EXPECT_EQ(ln.getOpType(), OpType::LayerNormalization);
+    EXPECT_EQ(ln.getInputs(), (Node::NameList{"x", "", ""}));
+    EXPECT_EQ(ln.attributeOr<int64_t>(AttrKey::Axis, 0), -2);
+    EXPECT_EQ(graph->nodeInputs(0)[1], kNoTensor);
+}
+
+TEST(FusionTest, MulBySigmoidBecomesSwish)
+{
+    auto graph = std::make_shared<Graph>("silu");
+    addActivation(*graph, "x");
+    graph->addInput("x");
+    addOp(*graph, "sig", "Sigmoid", {"x"}, "s");
+    addOp(*graph, "mul", "Mul", {"s", "x"}, "y");
+    graph->addOutput("y");
+
+    ASSERT_EQ(fuseSwish(graph), 1u);
+    ASSERT_EQ(graph->getNodes().size(), 1u);
+
+    const Node& swish = *graph->getNodes()[0];
+    EXPECT_EQ(swish.getOpType(), OpType::Swish);
+    EXPECT_EQ(swish.getName(), "mul");
+    EXPECT_EQ(swish.getInputs(), (Node::NameList{"x"}));
+    EXPECT_EQ(swish.getOutputs(), (Node::NameList{"y"}));
+    EXPECT_EQ(graph->findTensor("s"), nullptr);
+}
+
+TEST(FusionTest, SigmoidWithOtherReadersIsKept)
+{
+    auto graph = std::make_shared<Graph>("gate");
+    addActivation(*graph, "x");
+    addActivation(*graph, "z");
+    graph->addInput("x");
+    graph->addInput("z");
+    addOp(*graph, "sig", "Sigmoid", {"x"}, "s");
+    addOp(*graph, "mul", "Mul", {"x", "s"}, "y");
+    addOp(*graph, "gate", "Mul", {"z", "s"}, "g");
+    graph->addOutput("y");
+    graph->addOutput("g");
+
+    EXPECT_EQ(fuseSwish(graph), 0u);
+    EXPECT_EQ(graph->getNodes().size(), 3u);
+}
@@ -28,7 +28,7 @@ static std::shared_ptr<Graph> createSimpleAddGraph()
     auto node = std::make_shared<Node>("add", OpType::Add, "Add",
                                     std::vector<std::string>{"a", "b"},
                                     std::vector<std::string>{"out"},
-                                    Node::AttributeMap{});
+                                    Node::AttributeList{});
     graph->addNode(node);
     return graph;
 }
@@ -50,14 +50,14 @@ static std::shared_ptr<Graph> createChainGraph()
     auto node1 = std::make_shared<Node>("mul", OpType::Mul, "Mul",
                                         std::vector<std::string>{"a"},
                                         std::vector<std::string>{"t1"},
-                                        Node::AttributeMap{});
+                                        Node::AttributeList{});
     graph->addNode(node1);
 
 
     auto node2 = std::make_shared<Node>("add", OpType::Add, "Add",
                                         std::vector<std::string>{"t1"},
                                         std::vector<std::string>{"out"},
-                                        Node::AttributeMap{});
+                                        Node::AttributeList{});
     graph->addNode(node2);
     return graph;
 }
@@ -91,11 +91,12 @@ TEST(GraphTest, AddAndFindNodes)
     EXPECT_EQ(nodes[1], node2);
 
     auto found = graph->findNode("n1");
-    ASSERT_TRUE(found.has_value());
-    EXPECT_EQ(found.value(), node1);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found, node1.get());
+    EXPECT_EQ(graph->nodeId("n2"), 1u);
 
-    found = graph->findNode("n3");
-    EXPECT_FALSE(found.has_value());
+    EXPECT_EQ(graph->findNode("n3"), nullptr);
+    EXPECT_EQ(graph->nodeId("n3"), kNoNode);
 }
 
 TEST(GraphTest, AddAndFindTensors)
@@ -109,20 +110,18 @@ TEST(GraphTest, AddAndFindTensors)
     const auto& tensors = graph->getTensors();
     ASSERT_EQ(tensors.size(), 2);
 
-    auto it = tensors.find("x");
-    ASSERT_NE(it, tensors.end());
-    EXPECT_EQ(it->second, t1);
+    auto x = graph->tensorId("x");
+    ASSERT_NE(x, kNoTensor);
+    EXPECT_EQ(tensors[x], t1);
+    EXPECT_EQ(graph->tensorName(x), "x");
 
-    it = tensors.find("y");
-    ASSERT_NE(it, tensors.end());
-    EXPECT_EQ(it->second, t2);
+    auto y = graph->tensorId("y");
+    ASSERT_NE(y, kNoTensor);
+    EXPECT_EQ(tensors[y], t2);
 
-    auto found = graph->findTensor("x");
-    ASSERT_TRUE(found.has_value());
-    EXPECT_EQ(found.value(), t1);
-    found = graph->findTensor("z");
-
-    EXPECT_FALSE(found.has_value());
+    EXPECT_EQ(graph->findTensor("x"), t1.get());
+    EXPECT_EQ(graph->findTensor("z"), nullptr);
+    EXPECT_EQ(graph->tensorId("z"), kNoTensor);
 }
 
 TEST(GraphTest, InputsOutputs)
@@ -176,11 +175,11 @@ TEST(GraphTest, TopologicalSortWithDataAvailability)
     auto node1 = std::make_shared<Node>("add1", OpType::Add, "Add",
                                         std::vector<std::string>{"a", "b"},
                                         std::vector<std::string>{"c"},
-                                        Node::AttributeMap{});
+                                        Node::AttributeList{});
     auto node2 = std::make_shared<Node>("add2", OpType::Add, "Add",
                                         std::vector<std::string>{"a", "b"},
                                         std::vector<std::string>{"d"},
-                                        Node::AttributeMap{});
+                                        Node::AttributeList{});
     graph->addNode(node1);
     graph->addNode(node2);
 
@@ -192,6 +191,148 @@ TEST(GraphTest, TopologicalSortWithDataAvailability)
                 (sorted[0] == node2 && sorted[1] == node1));
 }
 
+TEST(GraphTest, NodeEdgesAreInternedIds)
+{
+    auto graph = createChainGraph();
+
+    // t1 is produced by mul and read by add through the same id
+    auto t1 = graph->tensorId("t1");
+    ASSERT_NE(t1, kNoTensor);
+
+    auto mul = graph->nodeId("mul");
+    auto add = graph->nodeId("add");
+    ASSERT_EQ(graph->nodeOutputs(mul).size(), 1);
+    ASSERT_EQ(graph->nodeInputs(add).size(), 1);
+    EXPECT_EQ(graph->nodeOutputs(mul)[0], t1);
+    EXPECT_EQ(graph->nodeInputs(add)[0], t1);
+
+    EXPECT_EQ(graph->getInputIds()[0], graph->tensorId("a"));
+    EXPECT_EQ(graph->getOutputIds()[0], graph->tensorId("out"));
+}
+
+TEST(GraphTest, UndeclaredTensorsAndOmittedInputs)
+{
+    auto graph = std::make_shared<Graph>("optional");
+    graph->addInput("x");
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{4}}));
+
+    // "tmp" has no tensor, the empty name is an omitted optional input
+    graph->addNode(std::make_shared<Node>("relu", OpType::Relu, "Relu",
+                                          std::vector<std::string>{"x"},
+                                          std::vector<std::string>{"tmp"}));
+    graph->addNode(std::make_shared<Node>("clip", OpType::Other, "Clip",
+                                          std::vector<std::string>{"tmp", "", ""},
+                                          std::vector<std::string>{"y"}));
+
+    auto tmp = graph->tensorId("tmp");
+    ASSERT_NE(tmp, kNoTensor);
+    EXPECT_EQ(graph->tensor(tmp), nullptr);
+    EXPECT_EQ(graph->findTensor("tmp"), nullptr);
+
+    auto clip_inputs = graph->nodeInputs(graph->nodeId("clip"));
+    ASSERT_EQ(clip_inputs.size(), 3);
+    EXPECT_EQ(clip_inputs[1], kNoTensor);
+
+    auto order = graph->topologicalOrder();
+    ASSERT_EQ(order.size(), 2);
+    EXPECT_EQ(graph->getNodes()[order[0]]->getName(), "relu");
+    EXPECT_EQ(graph->getNodes()[order[1]]->getName(), "clip");
+
+    // a later declaration fills the slot of the interned name
+    auto decl = std::make_shared<Tensor>("tmp", DataType::FLOAT, TensorShape{{4}});
+    graph->addTensor(decl);
+    EXPECT_EQ(graph->tensorId("tmp"), tmp);
+    EXPECT_EQ(graph->tensor(tmp), decl.get());
+}
+
+TEST(GraphTest, ProducerAndConsumers)
+{
+    auto graph = createChainGraph();
+
+    auto mul = graph->nodeId("mul");
+    auto add = graph->nodeId("add");
+
+    EXPECT_EQ(graph->producerOf(graph->tensorId("a")), kNoNode);
+    EXPECT_EQ(graph->producerOf(graph->tensorId("t1")), mul);
+    EXPECT_EQ(graph->producerOf(graph->tensorId("out")), add);
+
+    auto uses = graph->consumersOf(graph->tensorId("t1"));
+    ASSERT_EQ(uses.size(), 1);
+    EXPECT_EQ(uses[0], add);
+    EXPECT_TRUE(graph->consumersOf(graph->tensorId("out")).empty());
+}
+
+TEST(GraphTest, TopologicalOrderFollowsMutations)
+{
+    auto graph = createChainGraph();
+
+    // appended in dependency order, the cached order is extended in place
+    const auto& order = graph->topologicalOrder();
+    ASSERT_EQ(order.size(), 2);
+    graph->addNode(std::make_shared<Node>("relu", OpType::Relu, "Relu",
+                                          std::vector<std::string>{"out"},
+                                          std::vector<std::string>{"r"}));
+    ASSERT_EQ(graph->topologicalOrder().size(), 3);
+    EXPECT_EQ(graph->topologicalOrder()[2], graph->nodeId("relu"));
+
+    // a producer added after its consumer must move in front of it
+    graph->addNode(std::make_shared<Node>("late_mul", OpType::Mul, "Mul",
+                                          std::vector<std::string>{"p", "p"},
+                                          std::vector<std::string>{"q"}));
+    graph->addNode(std::make_shared<Node>("early", OpType::Relu, "Relu",
+                                          std::vector<std::string>{"a"},
+                                          std::vector<std::string>{"p"}));
+
+    auto sorted = graph->topologicalSort();
+    ASSERT_EQ(sorted.size(), 5);
+
+    auto pos = [&](const std::string& name)
+    {
+        for (size_t i = 0; i < sorted.size(); ++i)
+            if (sorted[i]->getName() == name) return i;
+        return sorted.size();
+    };
+    EXPECT_LT(pos("early"), pos("late_mul"));
+    EXPECT_LT(pos("mul"), pos("add"));
+    EXPECT_LT(pos("add"), pos("relu"));
+}
+
+TEST(GraphTest, ArenaHandlesOutliveGraph)
+{
+    std::shared_ptr<Node>   node;
+    std::weak_ptr<Tensor>   weak_tensor;
+    {
+        Graph graph("arena");
+        auto tensor = graph.createTensor("x", DataType::FLOAT, TensorShape{{2}});
+        graph.addTensor(tensor);
+        weak_tensor = tensor;
+
+        node = graph.createNode("relu", OpType::Relu, "Relu",
+                                std::vector<std::string>{"x"},
+                                std::vector<std::string>{"y"});
+        graph.addNode(node);
+
+        EXPECT_GE(graph.arena().bytesUsed(), sizeof(Node) + sizeof(Tensor));
+        EXPECT_EQ(graph.findNode("relu"), node.get());
+
+        // so are the node's name and attribute lists
+        auto* resource = node->getInputs().get_allocator().resource();
+        EXPECT_NE(resource, std::pmr::get_default_resource());
+        EXPECT_EQ(node->getInputs()[0].get_allocator().resource(), resource);
+        EXPECT_EQ(node->getOutputs().get_allocator().resource(), resource);
+        EXPECT_EQ(node->getAttributes().get_allocator().resource(), resource);
+    }
+
+    // one handle keeps the whole arena, and everything in it, alive
+    EXPECT_EQ(node->getName(), "relu");
+    EXPECT_EQ(node->getInputs()[0], "x");
+    ASSERT_FALSE(weak_tensor.expired());
+    EXPECT_EQ(weak_tensor.lock()->getName(), "x");
+
+    node.reset();
+    EXPECT_TRUE(weak_tensor.expired());
+}
+
 TEST(GraphTest, SummaryDoesNotCrash)
 {
     auto graph = createSimpleAddGraph();
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "frontend/graph_serializer.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace tc;
+
+
+static std::filesystem::path tempGraphPath(const std::string& name)
+{
+    return std::filesystem::temp_directory_path() / ("tc_test_" + name + ".tcg");
+}
+
+// x -> Conv(W, B) -> c -> Clip(min,max omitted) -> y, plus a Constant with a tensor attribute
+static std::shared_ptr<Graph> createConvGraph()
+{
+    auto graph = std::make_shared<Graph>("conv_graph");
+
+    graph->addTensor(std::make_shared<Tensor>("x", DataType::FLOAT, TensorShape{{1, 2, 4, 4}}));
+    graph->addTensor(std::make_shared<Tensor>("y", DataType::FLOAT, TensorShape{{1, 3, -1, 4}}));
+    graph->addInput("x");
+    graph->addOutput("y");
+
+    auto w = std::make_shared<Tensor>("W", DataType::FLOAT, TensorShape{{3, 2, 3, 3}});
+    std::vector<float> w_vals(w->numElements());
+    for (size_t i = 0; i < w_vals.size(); ++i) w_vals[i] = static_cast<float>(i) * 0.5f;
+    std::vector<uint8_t> w_raw(w_vals.size() * sizeof(float));
+    std::memcpy(w_raw.data(), w_vals.data(), w_raw.size());
+    w->setRawData(std::move(w_raw));
+    graph->addTensor(w);
+
+    auto b = std::make_shared<Tensor>("B", DataType::INT64, TensorShape{{3}});
+    b->setRawData(std::vector<uint8_t>(3 * sizeof(int64_t), 0x01));
+    graph->addTensor(b);
+
+    auto value = std::make_shared<Tensor>("value", DataType::INT64, TensorShape{{2}});
+    std::vector<uint8_t> v_raw(2 * sizeof(int64_t));
+    int64_t v_vals[2] = {7, -7};
+    std::memcpy(v_raw.data(), v_vals, v_raw.size());
+    value->setRawData(std::move(v_raw));
+
+    graph->addNode(std::make_shared<Node>("k", OpType::Other, "Constant",
+        std::vector<std::string>{}, std::vector<std::string>{"k_out"},
+        Node::AttributeList{Attribute("value", AttributeType::TENSOR, value)}));
+
+    graph->addNode(std::make_shared<Node>("conv", OpType::Conv, "Conv",
+        std::vector<std::string>{"x", "W", "B"}, std::vector<std::string>{"c"},
+        Node::AttributeList{
+            Attribute("kernel_shape", AttributeType::INTS,    std::vector<int64_t>{3, 3}),
+            Attribute("pads",         AttributeType::INTS,    std::vector<int64_t>{1, 1, 1, 1}),
+            Attribute("group",        AttributeType::INT,     int64_t{1}),
+            Attribute("auto_pad",     AttributeType::STRING,  std::string("NOTSET")),
+            Attribute("scales",       AttributeType::FLOATS,  std::vector<float>{0.25f, 4.0f}),
+            Attribute("tags",         AttributeType::STRINGS, std::vector<std::string>{"a", "NOTSET"}),
+        }));
+
+    graph->addNode(std::make_shared<Node>("clip", OpType::Other, "Clip",
+        std::vector<std::string>{"c", "", ""}, std::vector<std::string>{"y"},
+        Node::AttributeList{Attribute("alpha", AttributeType::FLOAT, 0.5f)}));
+
+    return graph;
+}
+
+TEST(GraphSerializerTest, RoundTrip)
+{
+    auto graph = createConvGraph();
+    auto path  = tempGraphPath("roundtrip");
+    ASSERT_NO_THROW(writeGraphFile(*graph, path));
+    EXPECT_TRUE(isGraphFile(path));
+
+    auto loaded = readGraphFile(path);
+    std::filesystem::remove(path);   // the mapping stays valid
+
+    EXPECT_EQ(loaded->getName(), "conv_graph");
+    EXPECT_EQ(loaded->getInputs(), graph->getInputs());
+    EXPECT_EQ(loaded->getOutputs(), graph->getOutputs());
+
+    // tensor ids survive, names referenced only as edges included
+    ASSERT_EQ(loaded->numTensorIds(), graph->numTensorIds());
+    for (TensorId id = 0; id < graph->numTensorIds(); ++id)
+    {
+        EXPECT_EQ(loaded->tensorName(id), graph->tensorName(id));
+        EXPECT_EQ(loaded->tensor(id) == nullptr, graph->tensor(id) == nullptr);
+    }
+    EXPECT_EQ(loaded->findTensor("c"), nullptr);
+    EXPECT_EQ(loaded->findTensor("y")->getShape().dims, (std::vector<int64_t>{1, 3, -1, 4}));
+
+    // weights are aligned views into the mapped file
+    auto* w = loaded->findTensor("W");
+    ASSERT_NE(w, nullptr);
+    EXPECT_TRUE(w->isDataView());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(w->getRawData().data()) % kGraphFileAlignment, 0u);
+    auto w_vals = w->getDataAs<float>();
+    ASSERT_EQ(w_vals.size(), 54);
+    EXPECT_FLOAT_EQ(w_vals[53], 26.5f);
+    EXPECT_EQ(loaded->findTensor("B")->getDtype(), DataType::INT64);
+
+    ASSERT_EQ(loaded->getNodes().size(), 3);
+    const auto& conv = *loaded->findNode("conv");
+    EXPECT_EQ(conv.getOpType(), OpType::Conv);
+    EXPECT_EQ(conv.getInputs(), (Node::NameList{"x", "W", "B"}));
+    EXPECT_EQ(conv.attributeOr<std::vector<int64_t>>(AttrKey::Pads, {}), (std::vector<int64_t>{1, 1, 1, 1}));
+    EXPECT_EQ(conv.attributeOr<int64_t>(AttrKey::Group, 0), 1);
+    EXPECT_EQ(conv.getAttribute(AttrKey::AutoPad).asString(), "NOTSET");
+    EXPECT_EQ(conv.getAttribute("scales").asFloats(), (std::vector<float>{0.25f, 4.0f}));
+    EXPECT_EQ(conv.getAttribute("tags").asStrings(), (std::vector<std::string>{"a", "NOTSET"}));
+
+    const auto& clip = *loaded->findNode("clip");
+    ASSERT_EQ(clip.getInputs().size(), 3);
+    EXPECT_EQ(clip.getInputs()[1], "");
+    EXPECT_EQ(loaded->nodeInputs(loaded->nodeId("clip"))[1], kNoTensor);
+    EXPECT_FLOAT_EQ(clip.attributeOr<float>(AttrKey::Alpha, 0.0f), 0.5f);
+
+    const auto& value = loaded->findNode("k")->getAttribute(AttrKey::Value).asTensor();
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->getName(), "value");
+    auto v_vals = value->getDataAs<int64_t>();
+    ASSERT_EQ(v_vals.size(), 2);
+    EXPECT_EQ(v_vals[1], -7);
+
+    auto order = loaded->topologicalSort();
+    ASSERT_EQ(order.size(), 3);
+    EXPECT_EQ(order.back()->getName(), "clip");
+}
+
+TEST(GraphSerializerTest, RejectsDamagedFiles)
+{
+    auto path = tempGraphPath("damaged");
+    writeGraphFile(*createConvGraph(), path);
+    auto size = std::filesystem::file_size(path);
+
+    // truncated
+    std::filesystem::resize_file(path, size - 1);
+    EXPECT_THROW((void)readGraphFile(path), std::runtime_error);
+
+    // not a graph file
+    {
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        ofs << std::string(512, 'x');
+    }
+    EXPECT_FALSE(isGraphFile(path));
+    EXPECT_THROW((void)readGraphFile(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+    EXPECT_FALSE(isGraphFile(path));
+}
+
+TEST(GraphSerializerTest, UnsupportedAttributeThrows)
+{
+    Graph graph("with_subgraph");
+    graph.addNode(std::make_shared<Node>("if", OpType::Other, "If",
+        std::vector<std::string>{"cond"}, std::vector<std::string>{"out"},
+        Node::AttributeList{Attribute("then_branch", AttributeType::GRAPH, std::make_shared<Graph>("then"))}));
+
+    auto path = tempGraphPath("subgraph");
+    EXPECT_THROW(writeGraphFile(graph, path), std::runtime_error);
+    std::filesystem::remove(path);
+}
@@ -67,6 +67,37 @@ TEST(NodeTest, Attributes) //TODO - Tensor, Graph attributes
     EXPECT_NE(str.find("kernel_shape"), std::string::npos);
 }
 
+TEST(NodeTest, AttributeKeysAndDefaults)
+{
+    Node node("gemm", OpType::Gemm, "Gemm", {"a", "b"}, {"y"},
+              {Attribute("alpha",  AttributeType::FLOAT, 0.5f),
+               Attribute("transB", AttributeType::INT,   int64_t{1}),
+               Attribute("custom", AttributeType::STRING, std::string("x"))});
+
+    EXPECT_EQ(node.getAttribute("alpha").getKey(), AttrKey::Alpha);
+    EXPECT_EQ(node.getAttribute("custom").getKey(), AttrKey::Other);
+    EXPECT_EQ(attrKeyToString(AttrKey::KernelShape), "kernel_shape");
+
+    EXPECT_FLOAT_EQ(node.attributeOr<float>(AttrKey::Alpha, 1.0f), 0.5f);
+    EXPECT_FLOAT_EQ(node.attributeOr<float>(AttrKey::Beta, 1.0f), 1.0f);
+    EXPECT_EQ(node.attributeOr<int64_t>(AttrKey::TransB, 0), 1);
+    EXPECT_EQ(node.attributeOr<std::vector<int64_t>>(AttrKey::Strides, {1, 1}).size(), 2);
+
+    // present but stored as another type
+    EXPECT_THROW((void)node.attributeOr<int64_t>(AttrKey::Alpha, 0), std::bad_variant_access);
+
+    // names that are not interned are still found by string
+    ASSERT_TRUE(node.hasAttribute("custom"));
+    EXPECT_EQ(node.getAttribute("custom").asString(), "x");
+    EXPECT_FALSE(node.hasAttribute(AttrKey::Axis));
+    EXPECT_THROW((void)node.getAttribute(AttrKey::Axis), std::out_of_range);
+
+    // an attribute already present is kept
+    node.addAttribute(Attribute("alpha", AttributeType::FLOAT, 2.0f));
+    EXPECT_FLOAT_EQ(node.getAttribute(AttrKey::Alpha).asFloat(), 0.5f);
+    EXPECT_EQ(node.getAttributes().size(), 3);
+}
+
 TEST(NodeTest, OpTypeConversion)
 {
     EXPECT_EQ(opTypeFromString("Add"), OpType::Add);
@@ -75,10 +106,17 @@ TEST(NodeTest, OpTypeConversion)
     EXPECT_EQ(opTypeFromString("Gemm"), OpType::Gemm);
     EXPECT_EQ(opTypeFromString("Conv"), OpType::Conv);
     EXPECT_EQ(opTypeFromString("Relu"), OpType::Relu);
+    EXPECT_EQ(opTypeFromString("Softmax"), OpType::Softmax);
+    EXPECT_EQ(opTypeFromString("LogSoftmax"), OpType::LogSoftmax);
+    EXPECT_EQ(opTypeFromString("Gelu"), OpType::Gelu);
+    EXPECT_EQ(opTypeFromString("HardSwish"), OpType::HardSwish);
+    EXPECT_EQ(opTypeFromString("GlobalAveragePool"), OpType::GlobalAveragePool);
     EXPECT_EQ(opTypeFromString("Unknown"), OpType::Other);
     EXPECT_EQ(opTypeFromString(""), OpType::Other);
 
     EXPECT_EQ(opTypeToString(OpType::Add), "Add");
     EXPECT_EQ(opTypeToString(OpType::Relu), "Relu");
+    EXPECT_EQ(opTypeToString(OpType::LogSoftmax), "LogSoftmax");
+    EXPECT_EQ(opTypeToString(OpType::Sigmoid), "Sigmoid");
     EXPECT_EQ(opTypeToString(OpType::Other), "Other");
 }
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include "frontend/onnx_loader.hpp"
@@ -265,3 +266,308 @@ TEST_F(OnnxLoaderTest, LoadWithAttributes)
     const auto& group = convNode->getAttribute("group");
     EXPECT_EQ(group.asInt(), 1);
 }
+
+TEST_F(OnnxLoaderTest, RawDataInitializerIsMappedView)
+{
+    auto model = createSimpleAddModel();
+
+    std::vector<float> vals = {1.0f, 2.0f, 3.0f, 4.0f};
+    auto* init = model.mutable_graph()->add_initializer();
+    init->set_name("W");
+    init->set_data_type(onnx::TensorProto::FLOAT);
+    init->add_dims(2);
+    init->add_dims(2);
+    init->set_raw_data(vals.data(), vals.size() * sizeof(float));
+
+    // typed fields can't be referenced in place and are still decoded
+    auto* typed = model.mutable_graph()->add_initializer();
+    typed->set_name("shape");
+    typed->set_data_type(onnx::TensorProto::INT64);
+    typed->add_dims(2);
+    typed->add_int64_data(1);
+    typed->add_int64_data(-1);
+
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+
+    OnnxLoader loader;
+    auto graph = loader.load(temp_path);
+
+    auto w = graph->findTensor("W");
+    ASSERT_NE(w, nullptr);
+    EXPECT_TRUE(w->isDataView());
+    EXPECT_TRUE(w->hasValidData());
+
+    auto raw = w->getRawData();
+    ASSERT_EQ(raw.size(), vals.size() * sizeof(float));
+    EXPECT_EQ(std::memcmp(raw.data(), vals.data(), raw.size()), 0);
+
+    auto shape = graph->findTensor("shape");
+    ASSERT_NE(shape, nullptr);
+    EXPECT_FALSE(shape->isDataView());
+    auto shape_vals = shape->getDataAs<int64_t>();
+    ASSERT_EQ(shape_vals.size(), 2);
+    EXPECT_EQ(shape_vals[1], -1);
+
+    // the mapping outlives the file and the loader
+    std::filesystem::remove(temp_path);
+    EXPECT_EQ(std::memcmp(w->getRawData().data(), vals.data(), raw.size()), 0);
+}
+
+static void setExternalData(onnx::TensorProto* tp, const std::string& location, int64_t offset, int64_t length)
+{
+    tp->set_data_location(onnx::TensorProto::EXTERNAL);
+
+    auto* loc = tp->add_external_data();
+    loc->set_key("location");
+    loc->set_value(location);
+
+    auto* off = tp->add_external_data();
+    off->set_key("offset");
+    off->set_value(std::to_string(offset));
+
+    auto* len = tp->add_external_data();
+    len->set_key("length");
+    len->set_value(std::to_string(length));
+}
+
+TEST_F(OnnxLoaderTest, ExternalDataInitializer)
+{
+    auto data_path = temp_path.parent_path() / "test_model.weights";
+
+    // two tensors in one data file, the second one at an offset
+    std::vector<float> a = {1.0f, 2.0f};
+    std::vector<float> b = {3.0f, 4.0f, 5.0f};
+    {
+        std::ofstream ofs(data_path, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(a.data()), a.size() * sizeof(float));
+        ofs.write(reinterpret_cast<const char*>(b.data()), b.size() * sizeof(float));
+    }
+
+    auto model = createSimpleAddModel();
+
+    auto* ta = model.mutable_graph()->add_initializer();
+    ta->set_name("A");
+    ta->set_data_type(onnx::TensorProto::FLOAT);
+    ta->add_dims(2);
+    setExternalData(ta, "test_model.weights", 0, 2 * sizeof(float));
+
+    auto* tb = model.mutable_graph()->add_initializer();
+    tb->set_name("B");
+    tb->set_data_type(onnx::TensorProto::FLOAT);
+    tb->add_dims(3);
+    setExternalData(tb, "test_model.weights", 2 * sizeof(float), 3 * sizeof(float));
+
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+
+    OnnxLoader loader;
+    auto graph = loader.load(temp_path);
+    std::filesystem::remove(data_path);
+
+    auto ga = graph->findTensor("A");
+    auto gb = graph->findTensor("B");
+    ASSERT_NE(ga, nullptr);
+    ASSERT_NE(gb, nullptr);
+
+    EXPECT_TRUE(ga->isDataView());
+    EXPECT_TRUE(ga->hasValidData());
+    EXPECT_TRUE(gb->hasValidData());
+
+    auto vals = gb->getDataAs<float>();
+    ASSERT_EQ(vals.size(), 3);
+    EXPECT_FLOAT_EQ(vals[0], 3.0f);
+    EXPECT_FLOAT_EQ(vals[2], 5.0f);
+}
+
+TEST_F(OnnxLoaderTest, ExternalDataErrors)
+{
+    auto data_path = temp_path.parent_path() / "test_model.weights";
+    {
+        std::ofstream ofs(data_path, std::ios::binary);
+        ofs << std::string(8, '\0');
+    }
+
+    auto loadWith = [&](const std::string& location, int64_t offset, int64_t length)
+    {
+        auto model = createSimpleAddModel();
+        auto* t = model.mutable_graph()->add_initializer();
+        t->set_name("W");
+        t->set_data_type(onnx::TensorProto::FLOAT);
+        t->add_dims(2);
+        setExternalData(t, location, offset, length);
+        writeModelToFile(model, temp_path);
+        return OnnxLoader{}.load(temp_path);
+    };
+
+    EXPECT_NO_THROW(loadWith("test_model.weights", 0, 8));
+    EXPECT_THROW(loadWith("missing.weights", 0, 8), std::runtime_error);
+    EXPECT_THROW(loadWith("test_model.weights", 4, 8), std::runtime_error);
+    EXPECT_THROW(loadWith("../test_model.weights", 0, 8), std::runtime_error);
+
+    std::filesystem::remove(data_path);
+}
+
+TEST_F(OnnxLoaderTest, ExternalDataInSubgraphsAndAttributes)
+{
+    auto data_path = temp_path.parent_path() / "test_model.weights";
+    std::vector<float> vals = {1.0f, 2.0f, 3.0f, 4.0f};
+    {
+        std::ofstream ofs(data_path, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(vals.data()), vals.size() * sizeof(float));
+    }
+
+    auto model = createSimpleAddModel();
+
+    // an If whose branch has an external initializer
+    auto* branch_node = model.mutable_graph()->add_node();
+    branch_node->set_op_type("If");
+    branch_node->set_name("if_node");
+    auto* branch_attr = branch_node->add_attribute();
+    branch_attr->set_name("then_branch");
+    branch_attr->set_type(onnx::AttributeProto::GRAPH);
+    auto* branch = branch_attr->mutable_g();
+    branch->set_name("then");
+    auto* init = branch->add_initializer();
+    init->set_name("C");
+    init->set_data_type(onnx::TensorProto::FLOAT);
+    init->add_dims(2);
+    setExternalData(init, "test_model.weights", 2 * sizeof(float), 2 * sizeof(float));
+
+    // a Constant whose value is external
+    auto* constant = model.mutable_graph()->add_node();
+    constant->set_op_type("Constant");
+    constant->set_name("const_node");
+    constant->add_output("k");
+    auto* value = constant->add_attribute();
+    value->set_name("value");
+    value->set_type(onnx::AttributeProto::TENSOR);
+    auto* tp = value->mutable_t();
+    tp->set_name("k");
+    tp->set_data_type(onnx::TensorProto::FLOAT);
+    tp->add_dims(2);
+    setExternalData(tp, "test_model.weights", 0, 2 * sizeof(float));
+
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+    auto graph = OnnxLoader{}.load(temp_path);
+    std::filesystem::remove(data_path);
+
+    const auto& then_branch = graph->findNode("if_node")->getAttribute("then_branch").asGraph();
+    ASSERT_NE(then_branch, nullptr);
+    auto c = then_branch->findTensor("C");
+    ASSERT_NE(c, nullptr);
+    EXPECT_TRUE(c->isDataView());
+    auto c_vals = c->getDataAs<float>();
+    ASSERT_EQ(c_vals.size(), 2);
+    EXPECT_FLOAT_EQ(c_vals[0], 3.0f);
+    EXPECT_FLOAT_EQ(c_vals[1], 4.0f);
+
+    const auto& k = graph->findNode("const_node")->getAttribute("value").asTensor();
+    ASSERT_NE(k, nullptr);
+    auto k_vals = k->getDataAs<float>();
+    ASSERT_EQ(k_vals.size(), 2);
+    EXPECT_FLOAT_EQ(k_vals[0], 1.0f);
+    EXPECT_FLOAT_EQ(k_vals[1], 2.0f);
+}
+
+TEST_F(OnnxLoaderTest, SessionServesInfoAndGraph)
+{
+    auto model = createSimpleAddModel();
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+
+    OnnxSession session(temp_path);
+    EXPECT_EQ(session.info().producer_name, "test");
+    EXPECT_EQ(session.info().graph_name, "test_graph");
+
+    auto graph = session.graph();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(graph->getNodes().size(), 1);
+    EXPECT_EQ(session.graph(), graph);
+}
+
+TEST_F(OnnxLoaderTest, ReadModelInfoSkipsGraph)
+{
+    auto model = createSimpleAddModel();
+
+    auto* init = model.mutable_graph()->add_initializer();
+    init->set_name("W");
+    init->set_data_type(onnx::TensorProto::FLOAT);
+    init->add_dims(1 << 16);
+    init->set_raw_data(std::string(4 << 16, '\0'));
+
+    // fields after the graph are still picked up
+    model.mutable_graph()->set_name("renamed_graph");
+    model.set_model_version(7);
+
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+
+    auto info = OnnxLoader::readModelInfo(temp_path);
+    EXPECT_EQ(info.ir_version, 8);
+    EXPECT_EQ(info.producer_version, "1.0");
+    EXPECT_EQ(info.model_version, 7);
+    EXPECT_EQ(info.graph_name, "renamed_graph");
+
+    // and agrees with a full parse
+    OnnxSession session(temp_path);
+    EXPECT_EQ(session.info().doc_string, info.doc_string);
+    EXPECT_EQ(session.info().graph_name, info.graph_name);
+}
+
+TEST_F(OnnxLoaderTest, TypedFieldInitializers)
+{
+    auto model = createSimpleAddModel();
+
+    // large enough to be decoded in parallel chunks
+    const int64_t big = (int64_t{1} << 20) + 123;
+    auto* table = model.mutable_graph()->add_initializer();
+    table->set_name("table");
+    table->set_data_type(onnx::TensorProto::FLOAT);
+    table->add_dims(big);
+    for (int64_t i = 0; i < big; ++i) table->add_float_data(static_cast<float>(i));
+
+    // narrow types are stored widened in int32_data
+    auto* bytes = model.mutable_graph()->add_initializer();
+    bytes->set_name("bytes");
+    bytes->set_data_type(onnx::TensorProto::INT8);
+    bytes->add_dims(3);
+    bytes->add_int32_data(-1);
+    bytes->add_int32_data(2);
+    bytes->add_int32_data(-128);
+
+    // and halves as their bit patterns
+    auto* halves = model.mutable_graph()->add_initializer();
+    halves->set_name("halves");
+    halves->set_data_type(onnx::TensorProto::FLOAT16);
+    halves->add_dims(2);
+    halves->add_int32_data(0x3C00);  // 1.0
+    halves->add_int32_data(0xC000);  // -2.0
+
+    ASSERT_NO_THROW(writeModelToFile(model, temp_path));
+
+    OnnxLoader loader;
+    auto graph = loader.load(temp_path);
+
+    auto t = graph->findTensor("table");
+    ASSERT_NE(t, nullptr);
+    EXPECT_TRUE(t->hasValidData());
+    auto vals = t->getDataAs<float>();
+    ASSERT_EQ(vals.size(), static_cast<size_t>(big));
+    EXPECT_FLOAT_EQ(vals[0], 0.0f);
+    EXPECT_FLOAT_EQ(vals[300000], 300000.0f);
+    EXPECT_FLOAT_EQ(vals[big - 1], static_cast<float>(big - 1));
+
+    auto b = graph->findTensor("bytes");
+    ASSERT_NE(b, nullptr);
+    EXPECT_TRUE(b->hasValidData());
+    auto b_vals = b->getDataAs<int8_t>();
+    ASSERT_EQ(b_vals.size(), 3);
+    EXPECT_EQ(b_vals[0], -1);
+    EXPECT_EQ(b_vals[2], -128);
+
+    auto h = graph->findTensor("halves");
+    ASSERT_NE(h, nullptr);
+    EXPECT_EQ(h->getDtype(), DataType::FLOAT16);
+    EXPECT_TRUE(h->hasValidData());
+    auto h_vals = h->getDataAs<uint16_t>();
+    ASSERT_EQ(h_vals.size(), 2);
+    EXPECT_EQ(h_vals[0], 0x3C00);
+    EXPECT_EQ(h_vals[1], 0xC000);
+}
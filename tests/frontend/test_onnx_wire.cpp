@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "frontend/onnx_wire.hpp"
+
+#include "onnx.pb.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace tc;
+
+
+
+static std::span<const uint8_t> asBytes(const std::string& s)
+{
+    return {reinterpret_cast<const uint8_t*>(s.data()), s.size()};
+}
+
+static onnx::ModelProto createModelWithInitializers()
+{
+    onnx::ModelProto model;
+    model.set_ir_version(8);
+    model.set_producer_name("test");
+
+    auto* graph = model.mutable_graph();
+    graph->set_name("wire_graph");
+
+    auto* a = graph->add_initializer();
+    a->set_name("a");
+    a->set_data_type(onnx::TensorProto::FLOAT);
+    a->add_dims(3);
+    a->set_raw_data(std::string(12, '\x01'));
+
+    auto* b = graph->add_initializer();
+    b->set_name("b");
+    b->set_data_type(onnx::TensorProto::INT64);
+    b->add_dims(1);
+    b->add_int64_data(42);
+
+    auto* c = graph->add_initializer();
+    c->set_name("c");
+    c->set_data_type(onnx::TensorProto::UINT8);
+    c->add_dims(200);
+    c->set_raw_data(std::string(200, '\x07'));
+
+    auto* node = graph->add_node();
+    node->set_op_type("Add");
+    node->add_input("a");
+    node->add_input("b");
+    node->add_output("y");
+
+    return model;
+}
+
+TEST(OnnxWireTest, SplitsRawDataOut)
+{
+    auto model = createModelWithInitializers();
+    std::string bytes = model.SerializeAsString();
+
+    auto split = splitInitializerData(asBytes(bytes));
+
+    ASSERT_EQ(split.raw_data.size(), 3);
+    EXPECT_EQ(split.raw_data[0].size(), 12);
+    EXPECT_TRUE(split.raw_data[1].empty());
+    EXPECT_EQ(split.raw_data[2].size(), 200);
+
+    // ranges point into the original buffer
+    EXPECT_GE(split.raw_data[2].data(), asBytes(bytes).data());
+    EXPECT_EQ(split.raw_data[2][0], 7);
+
+    EXPECT_LT(split.skeleton.size(), bytes.size() - 200);
+}
+
+TEST(OnnxWireTest, SkeletonParsesToModelWithoutRawData)
+{
+    auto model = createModelWithInitializers();
+    std::string bytes = model.SerializeAsString();
+
+    auto split = splitInitializerData(asBytes(bytes));
+
+    onnx::ModelProto parsed;
+    ASSERT_TRUE(parsed.ParseFromString(split.skeleton));
+
+    for (auto& init : *model.mutable_graph()->mutable_initializer())
+        init.clear_raw_data();
+
+    EXPECT_EQ(parsed.SerializeAsString(), model.SerializeAsString());
+}
+
+TEST(OnnxWireTest, MalformedInputThrows)
+{
+    auto model = createModelWithInitializers();
+    std::string bytes = model.SerializeAsString();
+    bytes.resize(bytes.size() - 5);
+
+    EXPECT_THROW((void)splitInitializerData(asBytes(bytes)), std::runtime_error);
+}
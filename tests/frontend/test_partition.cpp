@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "graph/partition.hpp"
+
+using namespace tc;
+
+
+static void addActivation(Graph& graph, const std::string& name)
+{
+    graph.addTensor(std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{{4}}));
+}
+
+static void addRelu(Graph& graph, const std::string& name, const std::string& input, const std::string& output)
+{
+    addActivation(graph, output);
+    graph.addNode(std::make_shared<Node>(name, OpType::Relu, "Relu", std::vector<std::string>{input},
+                                         std::vector<std::string>{output}, Node::AttributeList{}));
+}
+
+static void addAdd(Graph& graph, const std::string& name, const std::string& a, const std::string& b,
+                   const std::string& output)
+{
+    addActivation(graph, output);
+    graph.addNode(std::make_shared<Node>(name, OpType::Add, "Add", std::vector<std::string>{a, b},
+                                         std::vector<std::string>{output}, Node::AttributeList{}));
+}
+
+// x -> r0 -> r1 -> r2 -> out
+TEST(PartitionTest, ChainIsOneTask)
+{
+    Graph graph("chain");
+    addActivation(graph, "x");
+    graph.addInput("x");
+    addRelu(graph, "r0", "x", "a");
+    addRelu(graph, "r1", "a", "b");
+    addRelu(graph, "r2", "b", "out");
+    graph.addOutput("out");
+
+    auto tasks = partitionTasks(graph, graph.topologicalOrder());
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks.nodes[0].size(), 3u);
+    EXPECT_TRUE(tasks.deps[0].empty());
+    EXPECT_EQ(tasks.width(), 1u);
+}
+
+// x -> stem -> {l0 -> l1, r0 -> r1} -> join
+TEST(PartitionTest, DiamondSplitsAtForkAndJoin)
+{
+    Graph graph("diamond");
+    addActivation(graph, "x");
+    graph.addInput("x");
+    addRelu(graph, "stem", "x", "s");
+    addRelu(graph, "l0", "s", "l0_out");
+    addRelu(graph, "l1", "l0_out", "l1_out");
+    addRelu(graph, "r0", "s", "r0_out");
+    addRelu(graph, "r1", "r0_out", "r1_out");
+    addAdd(graph, "join", "l1_out", "r1_out", "out");
+    graph.addOutput("out");
+
+    auto tasks = partitionTasks(graph, graph.topologicalOrder());
+    ASSERT_EQ(tasks.size(), 4u);
+    EXPECT_EQ(tasks.width(), 2u);
+
+    auto stem = tasks.task_of[graph.nodeId("stem")];
+    auto left = tasks.task_of[graph.nodeId("l0")];
+    auto right = tasks.task_of[graph.nodeId("r0")];
+    auto join = tasks.task_of[graph.nodeId("join")];
+
+    EXPECT_EQ(tasks.task_of[graph.nodeId("l1")], left);
+    EXPECT_EQ(tasks.task_of[graph.nodeId("r1")], right);
+    EXPECT_NE(left, right);
+    EXPECT_EQ(tasks.deps[left], std::vector<TaskId>{stem});
+    EXPECT_EQ(tasks.deps[right], std::vector<TaskId>{stem});
+    EXPECT_EQ(tasks.deps[join].size(), 2u);
+}
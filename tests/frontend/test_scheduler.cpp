@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "graph/scheduler.hpp"
+
+#include <algorithm>
+
+using namespace tc;
+
+
+static void addActivation(Graph& graph, const std::string& name, int64_t elems)
+{
+    graph.addTensor(std::make_shared<Tensor>(name, DataType::FLOAT, TensorShape{{elems}}));
+}
+
+static void addUnary(Graph& graph, const std::string& name, OpType op, const std::string& op_str,
+                     std::vector<std::string> inputs, const std::string& output)
+{
+    graph.addNode(std::make_shared<Node>(name, op, op_str, std::move(inputs),
+                                         std::vector<std::string>{output}, Node::AttributeList{}));
+}
+
+// x -> branches x Relu (1024 floats) -> ReduceSum (1 float) -> Add chain -> out
+// nodes are added branch-stage by branch-stage, as an exporter emitting wide layers would
+static std::shared_ptr<Graph> createWideGraph(int branches)
+{
+    auto graph = std::make_shared<Graph>("wide");
+    addActivation(*graph, "x", 1024);
+    graph->addInput("x");
+
+    for (int i = 0; i < branches; ++i)
+    {
+        addActivation(*graph, "big" + std::to_string(i), 1024);
+        addUnary(*graph, "relu" + std::to_string(i), OpType::Relu, "Relu", {"x"}, "big" + std::to_string(i));
+    }
+    for (int i = 0; i < branches; ++i)
+    {
+        addActivation(*graph, "small" + std::to_string(i), 1);
+        addUnary(*graph, "sum" + std::to_string(i), OpType::Other, "ReduceSum",
+                 {"big" + std::to_string(i)}, "small" + std::to_string(i));
+    }
+
+    std::string acc = "small0";
+    for (int i = 1; i < branches; ++i)
+    {
+        std::string out = i + 1 == branches ? "out" : "acc" + std::to_string(i);
+        addActivation(*graph, out, 1);
+        addUnary(*graph, "add" + std::to_string(i), OpType::Add, "Add", {acc, "small" + std::to_string(i)}, out);
+        acc = out;
+    }
+    graph->addOutput("out");
+    return graph;
+}
+
+// every input is produced before it is read
+static bool isTopological(const Graph& graph, const std::vector<NodeId>& order)
+{
+    std::vector<size_t> position(graph.getNodes().size(), order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        position[order[i]] = i;
+
+    for (auto n : order)
+        for (auto t : graph.nodeInputs(n))
+            if (graph.dependsOnProducer(t) && position[graph.producerOf(t)] >= position[n])
+                return false;
+    return true;
+}
+
+
+TEST(SchedulerTest, PolicyNames)
+{
+    for (auto p : {SchedulePolicy::Kahn, SchedulePolicy::MinMemory, SchedulePolicy::DepthFirst})
+        EXPECT_EQ(schedulePolicyFromString(schedulePolicyToString(p)), p);
+    EXPECT_THROW((void)schedulePolicyFromString("bfs"), std::runtime_error);
+}
+
+TEST(SchedulerTest, PeakActivationBytes)
+{
+    auto graph = createWideGraph(4);
+
+    // Kahn keeps all four 4 KiB activations alive before the first reduction
+    auto kahn = scheduleGraph(*graph, SchedulePolicy::Kahn);
+    EXPECT_EQ(kahn.order, graph->topologicalOrder());
+    EXPECT_EQ(kahn.peak_bytes, 4 * 4096u + 4);
+    EXPECT_EQ(peakActivationBytes(*graph, kahn.order), kahn.peak_bytes);
+
+    // an order that reduces each branch right away
+    std::vector<NodeId> interleaved;
+    for (int i = 0; i < 4; ++i)
+    {
+        interleaved.push_back(graph->nodeId("relu" + std::to_string(i)));
+        interleaved.push_back(graph->nodeId("sum" + std::to_string(i)));
+    }
+    for (int i = 1; i < 4; ++i)
+        interleaved.push_back(graph->nodeId("add" + std::to_string(i)));
+    EXPECT_EQ(peakActivationBytes(*graph, interleaved), 4096u + 4 * 4);
+}
+
+TEST(SchedulerTest, LocalityAndMemoryOrders)
+{
+    auto graph = createWideGraph(8);
+    auto kahn  = scheduleGraph(*graph, SchedulePolicy::Kahn);
+
+    for (auto policy : {SchedulePolicy::MinMemory, SchedulePolicy::DepthFirst})
+    {
+        auto s = scheduleGraph(*graph, policy);
+        ASSERT_EQ(s.order.size(), graph->getNodes().size()) << schedulePolicyToString(policy);
+        EXPECT_TRUE(isTopological(*graph, s.order)) << schedulePolicyToString(policy);
+        EXPECT_LT(s.peak_bytes * 4, kahn.peak_bytes) << schedulePolicyToString(policy);
+    }
+
+    // depth-first runs each reduction right after its Relu
+    auto dfs = scheduleGraph(*graph, SchedulePolicy::DepthFirst);
+    auto relu0 = std::find(dfs.order.begin(), dfs.order.end(), graph->nodeId("relu0"));
+    ASSERT_NE(relu0 + 1, dfs.order.end());
+    EXPECT_EQ(*(relu0 + 1), graph->nodeId("sum0"));
+}
+
+TEST(SchedulerTest, MinMemoryFreesBeforeAllocating)
+{
+    // a -> big (Relu) is ready alongside sum(a) that frees a; the freeing node runs first
+    Graph graph("greedy");
+    addActivation(graph, "x", 16);
+    graph.addInput("x");
+    addActivation(graph, "a", 1024);
+    addActivation(graph, "b", 1024);
+    addActivation(graph, "s", 1);
+    addActivation(graph, "out", 1);
+    addUnary(graph, "make_a", OpType::Relu, "Relu", {"x"}, "a");
+    addUnary(graph, "grow",   OpType::Relu, "Relu", {"x"}, "b");
+    addUnary(graph, "shrink", OpType::Other, "ReduceSum", {"a"}, "s");
+    graph.addNode(std::make_shared<Node>("join", OpType::Add, "Add",
+        std::vector<std::string>{"s", "b"}, std::vector<std::string>{"out"}, Node::AttributeList{}));
+    graph.addOutput("out");
+
+    auto s = scheduleGraph(graph, SchedulePolicy::MinMemory);
+    ASSERT_EQ(s.order.size(), 4u);
+    EXPECT_EQ(s.order[1], graph.nodeId("shrink"));
+    EXPECT_EQ(s.peak_bytes, 4096u + 4 + 4);
+    EXPECT_LT(s.peak_bytes, scheduleGraph(graph, SchedulePolicy::Kahn).peak_bytes);
+}
@@ -102,6 +102,8 @@ TEST(TensorTest, DataTypeSize)
     EXPECT_EQ(Tensor::dataTypeSize(DataType::FLOAT), sizeof(float));
     EXPECT_EQ(Tensor::dataTypeSize(DataType::INT32), sizeof(int32_t));
     EXPECT_EQ(Tensor::dataTypeSize(DataType::INT64), sizeof(int64_t));
+    EXPECT_EQ(Tensor::dataTypeSize(DataType::FLOAT16), 2);
+    EXPECT_EQ(Tensor::dataTypeSize(DataType::BOOL), 1);
     EXPECT_EQ(Tensor::dataTypeSize(DataType::UNDEFINED), 0);
 }
 
@@ -114,3 +116,27 @@ TEST(TensorTest, DataTypeConversion)
     EXPECT_EQ(dataTypeToString(DataType::INT64), "int64");
 }
 
+
+TEST(TensorTest, RawDataView)
+{
+    auto storage = std::make_shared<std::vector<float>>(std::vector<float>{1.0f, 2.0f, 3.0f, 4.0f});
+    std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(storage->data()), storage->size() * sizeof(float));
+
+    Tensor t("w", DataType::FLOAT, TensorShape{{2, 2}});
+    t.setRawDataView(bytes, storage);
+    storage.reset();
+
+    EXPECT_TRUE(t.isDataView());
+    EXPECT_TRUE(t.hasValidData());
+    EXPECT_EQ(t.getRawData().data(), bytes.data());
+
+    // copies share the same bytes and keep them alive
+    Tensor copy = t;
+    auto span = copy.getDataAs<float>();
+    ASSERT_EQ(span.size(), 4);
+    EXPECT_FLOAT_EQ(span[3], 4.0f);
+
+    t.setRawData(std::vector<uint8_t>(4 * sizeof(float)));
+    EXPECT_FALSE(t.isDataView());
+    EXPECT_FLOAT_EQ(copy.getDataAs<float>()[0], 1.0f);
+}
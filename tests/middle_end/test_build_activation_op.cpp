@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "middle_end/mlir_builders.hpp"
+#include "test_dimensions.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+using namespace tc;
+using namespace mlir;
+using namespace tc::test;
+
+class ActivationTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ctx.loadDialect<arith::ArithDialect, linalg::LinalgDialect, math::MathDialect,
+                        tensor::TensorDialect, func::FuncDialect>();
+    }
+
+    // builds op(input) in a function returning it and verifies the module
+    Value build(OpType op, RankedTensorType inputType, bool tanhGelu = false)
+    {
+        module = ModuleOp::create(loc);
+        auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({inputType}, {inputType}));
+        func.addEntryBlock();
+        builder.setInsertionPointToStart(&func.getBody().front());
+
+        Value result = buildActivation(op, builder, loc, func.getArgument(0), 1.0, tanhGelu, &ctx);
+        func::ReturnOp::create(builder, loc, result);
+        module.push_back(func);
+        EXPECT_TRUE(succeeded(verify(module)));
+        return result;
+    }
+
+    template <typename OpTy>
+    static bool bodyHas(linalg::GenericOp generic)
+    {
+        bool found = false;
+        generic.getRegion().walk([&](OpTy) { found = true; });
+        return found;
+    }
+
+    MLIRContext ctx;
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+};
+
+class ActivationParamTest : public ActivationTest, public ::testing::WithParamInterface<OpType> {};
+
+TEST_P(ActivationParamTest, OneParallelGeneric)
+{
+    for (auto shape : std::vector<std::vector<int64_t>>{{}, {7}, {N, 3}, {2, N, 5}})
+    {
+        auto inputType = RankedTensorType::get(shape, builder.getF32Type());
+        Value result = build(GetParam(), inputType);
+        EXPECT_EQ(result.getType(), inputType);
+
+        auto generic = result.getDefiningOp<linalg::GenericOp>();
+        ASSERT_TRUE(generic);
+        EXPECT_EQ(generic.getNumDpsInputs(), 1);
+        EXPECT_EQ(generic.getNumReductionLoops(), 0);
+        EXPECT_EQ(generic.getNumLoops(), static_cast<unsigned>(shape.size()));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ActivationTests,
+    ActivationParamTest,
+    testing::Values(OpType::Sigmoid, OpType::Tanh, OpType::Gelu, OpType::Swish,
+                    OpType::HardSwish, OpType::Erf, OpType::Exp)
+);
+
+TEST_F(ActivationTest, GeluExactOrTanh)
+{
+    auto inputType = RankedTensorType::get({4, 8}, builder.getF16Type());
+
+    auto exact = build(OpType::Gelu, inputType).getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(exact);
+    EXPECT_TRUE(bodyHas<math::ErfOp>(exact));
+    EXPECT_FALSE(bodyHas<math::TanhOp>(exact));
+
+    auto approx = build(OpType::Gelu, inputType, /*tanhGelu=*/true).getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(approx);
+    EXPECT_TRUE(bodyHas<math::TanhOp>(approx));
+    EXPECT_FALSE(bodyHas<math::ErfOp>(approx));
+}
+
+TEST_F(ActivationTest, RejectsIntegers)
+{
+    module = ModuleOp::create(loc);
+    auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({}, {}));
+    func.addEntryBlock();
+    module.push_back(func);
+    builder.setInsertionPointToStart(&func.getBody().front());
+
+    auto ints = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({2, 3}, builder.getI32Type()), ValueRange{});
+    EXPECT_THROW(buildActivation(OpType::Sigmoid, builder, loc, ints, 1.0, false, &ctx), std::runtime_error);
+}
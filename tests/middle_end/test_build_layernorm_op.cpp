@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "middle_end/mlir_builders.hpp"
+#include "test_dimensions.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+using namespace tc;
+using namespace mlir;
+using namespace tc::test;
+
+class LayerNormTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ctx.loadDialect<arith::ArithDialect, linalg::LinalgDialect, math::MathDialect,
+                        tensor::TensorDialect, func::FuncDialect>();
+    }
+
+    // builds layernorm(x, [scale, bias]) in a function returning it and verifies the module
+    Value build(RankedTensorType inputType, std::optional<RankedTensorType> paramType, int64_t axis)
+    {
+        llvm::SmallVector<Type> args{inputType};
+        if (paramType) args.append({*paramType, *paramType});
+
+        module = ModuleOp::create(loc);
+        auto func = func::FuncOp::create(loc, "test", builder.getFunctionType(args, {inputType}));
+        func.addEntryBlock();
+        builder.setInsertionPointToStart(&func.getBody().front());
+
+        std::optional<Value> scale, bias;
+        if (paramType)
+        {
+            scale = func.getArgument(1);
+            bias  = func.getArgument(2);
+        }
+
+        Value result = buildLayerNorm(builder, loc, func.getArgument(0), scale, bias, axis, 1e-5, &ctx);
+        func::ReturnOp::create(builder, loc, result);
+        module.push_back(func);
+        EXPECT_TRUE(succeeded(verify(module)));
+        return result;
+    }
+
+    MLIRContext ctx;
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+};
+
+TEST_F(LayerNormTest, WelfordPassThenFusedAffineOutput)
+{
+    auto inputType = RankedTensorType::get({N, 16, 64}, builder.getF32Type());
+    auto paramType = RankedTensorType::get({64}, builder.getF32Type());
+    Value result = build(inputType, paramType, -1);
+    EXPECT_EQ(result.getType(), inputType);
+
+    // input, mean, 1/stddev, scale and bias in one elementwise pass
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    EXPECT_EQ(normalize.getNumDpsInputs(), 5);
+    EXPECT_EQ(normalize.getNumReductionLoops(), 0);
+
+    // mean comes straight from the single reducing pass, which also yields m2 and the count
+    auto stats = normalize.getDpsInputs()[1].getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(stats->getNumResults(), 3);
+    EXPECT_EQ(stats.getNumDpsInputs(), 1);
+    EXPECT_EQ(stats.getNumReductionLoops(), 1);
+
+    auto statType = cast<RankedTensorType>(stats->getResult(0).getType());
+    EXPECT_EQ(statType.getShape(), llvm::ArrayRef<int64_t>({N, 16}));
+}
+
+TEST_F(LayerNormTest, HalfInputKeepsStatisticsInF32)
+{
+    auto inputType = RankedTensorType::get({4, 8, 32}, builder.getF16Type());
+    auto paramType = RankedTensorType::get({8, 32}, builder.getF16Type());
+    Value result = build(inputType, paramType, 1);
+    EXPECT_EQ(result.getType(), inputType);
+
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    auto stats = normalize.getDpsInputs()[1].getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(stats.getNumReductionLoops(), 2);
+    EXPECT_TRUE(cast<RankedTensorType>(stats->getResult(2).getType()).getElementType().isF32());
+}
+
+TEST_F(LayerNormTest, WithoutScaleAndBias)
+{
+    auto inputType = RankedTensorType::get({3, 5}, builder.getF32Type());
+    Value result = build(inputType, std::nullopt, -1);
+
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    EXPECT_EQ(normalize.getNumDpsInputs(), 3);
+}
+
+TEST_F(LayerNormTest, RejectsParametersWiderThanNormalizedDims)
+{
+    module = ModuleOp::create(loc);
+    auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({}, {}));
+    func.addEntryBlock();
+    module.push_back(func);
+    builder.setInsertionPointToStart(&func.getBody().front());
+
+    auto input = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({2, 3}, builder.getF32Type()), ValueRange{});
+    auto wide  = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({2, 3}, builder.getF32Type()), ValueRange{});
+
+    EXPECT_THROW(buildLayerNorm(builder, loc, input, Value(wide), std::nullopt, -1, 1e-5, &ctx), std::runtime_error);
+    EXPECT_THROW(buildLayerNorm(builder, loc, input, std::nullopt, std::nullopt, 2, 1e-5, &ctx), std::runtime_error);
+}
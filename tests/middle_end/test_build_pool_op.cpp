@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "middle_end/mlir_builders.hpp"
+#include "test_dimensions.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+using namespace tc;
+using namespace mlir;
+using namespace tc::test;
+
+class PoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ctx.loadDialect<arith::ArithDialect, linalg::LinalgDialect, tensor::TensorDialect, func::FuncDialect>();
+    }
+
+    // builds `body(argument)` in a function returning it and verifies the module
+    template <typename Body>
+    Value build(RankedTensorType inputType, Body body)
+    {
+        module = ModuleOp::create(loc);
+        auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({inputType}, {}));
+        func.addEntryBlock();
+        builder.setInsertionPointToStart(&func.getBody().front());
+
+        Value result = body(func.getArgument(0));
+        func.setType(builder.getFunctionType({inputType}, {result.getType()}));
+        func::ReturnOp::create(builder, loc, result);
+        module.push_back(func);
+        EXPECT_TRUE(succeeded(verify(module)));
+        return result;
+    }
+
+    Value pool(OpType op, RankedTensorType inputType, std::vector<int64_t> pads, bool ceilMode, bool countIncludePad)
+    {
+        return build(inputType, [&](Value input)
+        {
+            return buildPool2dOp(op, builder, loc, input, {3, 3}, {2, 2}, pads, {1, 1},
+                                 ceilMode, countIncludePad, "NOTSET", &ctx);
+        });
+    }
+
+    MLIRContext ctx;
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+};
+
+TEST_F(PoolTest, MaxPoolCeilModePadsTheEnd)
+{
+    auto inputType = RankedTensorType::get({1, 3, 6, 6}, builder.getF32Type());
+    Value result = pool(OpType::MaxPool, inputType, {0, 0, 0, 0}, true, false);
+
+    // ceil((6 - 3) / 2) + 1 = 3 windows, the last one reaching a column past the input
+    EXPECT_EQ(cast<RankedTensorType>(result.getType()).getShape(), llvm::ArrayRef<int64_t>({1, 3, 3, 3}));
+
+    auto max = result.getDefiningOp<linalg::PoolingNchwMaxOp>();
+    ASSERT_TRUE(max);
+    auto pad = max.getDpsInputs()[0].getDefiningOp<tensor::PadOp>();
+    ASSERT_TRUE(pad);
+    EXPECT_EQ(pad.getStaticHigh(), llvm::ArrayRef<int64_t>({0, 0, 1, 1}));
+}
+
+TEST_F(PoolTest, UnsignedMaxPoolComparesUnsigned)
+{
+    // uint8 is a signless i8, 200 must beat 100
+    auto inputType = RankedTensorType::get({1, 3, 8, 8}, builder.getI8Type());
+    Value result = build(inputType, [&](Value input)
+    {
+        return buildPool2dOp(OpType::MaxPool, builder, loc, input, {3, 3}, {2, 2}, {1, 1, 1, 1}, {1, 1},
+                             false, false, "NOTSET", &ctx, /*unsignedInts=*/true);
+    });
+    EXPECT_EQ(cast<RankedTensorType>(result.getType()).getShape(), llvm::ArrayRef<int64_t>({1, 3, 4, 4}));
+
+    auto max = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(max);
+    EXPECT_EQ(max.getNumReductionLoops(), 2);
+    bool unsignedMax = false, signedMax = false;
+    max.getRegion().walk([&](Operation* op)
+    {
+        unsignedMax |= isa<arith::MaxUIOp>(op);
+        signedMax   |= isa<arith::MaxSIOp>(op);
+    });
+    EXPECT_TRUE(unsignedMax);
+    EXPECT_FALSE(signedMax);
+
+    // zero is the smallest uint8, for the padding and the initial value
+    auto pad = max.getDpsInputs()[0].getDefiningOp<tensor::PadOp>();
+    ASSERT_TRUE(pad);
+    auto padValue = pad.getConstantPaddingValue().getDefiningOp<arith::ConstantIntOp>();
+    ASSERT_TRUE(padValue);
+    EXPECT_EQ(padValue.value(), 0);
+}
+
+TEST_F(PoolTest, AveragePoolExcludingPadDividesByCounts)
+{
+    auto inputType = RankedTensorType::get({N, 4, 8, 8}, builder.getF16Type());
+    Value result = pool(OpType::AveragePool, inputType, {1, 1, 1, 1}, false, false);
+    EXPECT_EQ(cast<RankedTensorType>(result.getType()).getShape(), llvm::ArrayRef<int64_t>({N, 4, 4, 4}));
+
+    // sums in f32, divided by the per-position counts of a sum pooled plane of ones
+    auto average = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(average);
+    ASSERT_EQ(average.getNumDpsInputs(), 2);
+    auto sum    = average.getDpsInputs()[0].getDefiningOp<linalg::PoolingNchwSumOp>();
+    auto counts = average.getDpsInputs()[1].getDefiningOp<linalg::PoolingNchwSumOp>();
+    ASSERT_TRUE(sum);
+    ASSERT_TRUE(counts);
+    EXPECT_TRUE(cast<RankedTensorType>(sum->getResult(0).getType()).getElementType().isF32());
+    EXPECT_EQ(cast<RankedTensorType>(counts->getResult(0).getType()).getShape(), llvm::ArrayRef<int64_t>({1, 1, 4, 4}));
+}
+
+TEST_F(PoolTest, AveragePoolIncludingPadScalesByWindow)
+{
+    auto inputType = RankedTensorType::get({1, 4, N, N}, builder.getF32Type());
+    Value result = pool(OpType::AveragePool, inputType, {1, 1, 1, 1}, false, true);
+
+    auto average = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(average);
+    EXPECT_EQ(average.getNumDpsInputs(), 1);
+    EXPECT_TRUE(average.getDpsInputs()[0].getDefiningOp<linalg::PoolingNchwSumOp>());
+}
+
+TEST_F(PoolTest, GlobalAveragePoolKeepsSpatialDims)
+{
+    auto inputType = RankedTensorType::get({N, 8, 7, 7}, builder.getF32Type());
+    Value result = build(inputType, [&](Value input) { return buildGlobalAveragePool(builder, loc, input, &ctx); });
+
+    EXPECT_EQ(cast<RankedTensorType>(result.getType()).getShape(), llvm::ArrayRef<int64_t>({N, 8, 1, 1}));
+    EXPECT_TRUE(result.getDefiningOp<tensor::ExpandShapeOp>());
+}
+
+TEST_F(PoolTest, UngroupedConvIsOneNamedOp)
+{
+    // no reshapes around the convolution, so it can be fused into the pooling tiles
+    auto inputType = RankedTensorType::get({1, 3, 16, 16}, builder.getF32Type());
+    Value result = build(inputType, [&](Value input)
+    {
+        auto weights = tensor::EmptyOp::create(builder, loc, llvm::ArrayRef<int64_t>{8, 3, 3, 3}, builder.getF32Type());
+        return buildConv2dOp(builder, loc, input, weights, std::nullopt, {3, 3}, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1, "NOTSET", &ctx);
+    });
+
+    EXPECT_EQ(cast<RankedTensorType>(result.getType()).getShape(), llvm::ArrayRef<int64_t>({1, 8, 16, 16}));
+    EXPECT_TRUE(result.getDefiningOp<linalg::Conv2DNchwFchwOp>());
+}
+
+TEST_F(PoolTest, RejectsBadInputs)
+{
+    module = ModuleOp::create(loc);
+    auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({}, {}));
+    func.addEntryBlock();
+    module.push_back(func);
+    builder.setInsertionPointToStart(&func.getBody().front());
+
+    auto rank3   = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({1, 3, 8}, builder.getF32Type()), ValueRange{});
+    auto ints    = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({1, 3, 8, 8}, builder.getI32Type()), ValueRange{});
+    auto dynamic = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({1, 3, N, 8}, builder.getF32Type()),
+                                           ValueRange{arith::ConstantIndexOp::create(builder, loc, 8)});
+
+    EXPECT_THROW(buildPool2dOp(OpType::MaxPool, builder, loc, rank3, {3, 3}, {1, 1}, {}, {}, false, false, "NOTSET", &ctx), std::runtime_error);
+    EXPECT_THROW(buildPool2dOp(OpType::AveragePool, builder, loc, ints, {3, 3}, {1, 1}, {}, {}, false, false, "NOTSET", &ctx), std::runtime_error);
+    EXPECT_THROW(buildPool2dOp(OpType::MaxPool, builder, loc, dynamic, {3, 3}, {2, 2}, {}, {}, true, false, "NOTSET", &ctx), std::runtime_error);
+    EXPECT_NO_THROW(buildPool2dOp(OpType::MaxPool, builder, loc, ints, {3, 3}, {1, 1}, {}, {}, false, false, "NOTSET", &ctx));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "middle_end/mlir_builders.hpp"
+#include "test_dimensions.hpp"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+
+using namespace tc;
+using namespace mlir;
+using namespace tc::test;
+
+class SoftmaxTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ctx.loadDialect<arith::ArithDialect, linalg::LinalgDialect, math::MathDialect,
+                        tensor::TensorDialect, func::FuncDialect>();
+    }
+
+    // builds softmax(input) in a function returning it and verifies the module
+    Value build(RankedTensorType inputType, int64_t axis, bool logSoftmax)
+    {
+        module = ModuleOp::create(loc);
+        auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({inputType}, {inputType}));
+        func.addEntryBlock();
+        builder.setInsertionPointToStart(&func.getBody().front());
+
+        Value result = buildSoftmax(builder, loc, func.getArgument(0), axis, logSoftmax, &ctx);
+        func::ReturnOp::create(builder, loc, result);
+        module.push_back(func);
+        EXPECT_TRUE(succeeded(verify(module)));
+        return result;
+    }
+
+    MLIRContext ctx;
+    OpBuilder builder = OpBuilder(&ctx);
+    Location loc = UnknownLoc::get(&ctx);
+    ModuleOp module;
+};
+
+// unaryShapes without the scalar, Softmax needs an axis
+static const std::vector<std::vector<int64_t>> softmaxShapes = {
+    {2, 3}, {3}, {N, 3}, {2, N}, {N}, {N, N}, {N, 7, N}
+};
+
+class SoftmaxParamTest : public SoftmaxTest, public ::testing::WithParamInterface<std::vector<int64_t>> {};
+
+TEST_P(SoftmaxParamTest, SinglePassStatistics)
+{
+    auto shape = GetParam();
+    auto inputType = RankedTensorType::get(shape, builder.getF32Type());
+    Value result = build(inputType, -1, false);
+    EXPECT_EQ(result.getType(), inputType);
+
+    // normalizing generic reads the input and both statistics of one reducing generic
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    EXPECT_EQ(normalize.getNumDpsInputs(), 3);
+    EXPECT_EQ(normalize.getNumReductionLoops(), 0);
+
+    auto stats = normalize.getDpsInputs()[1].getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(normalize.getDpsInputs()[2].getDefiningOp(), stats.getOperation());
+    EXPECT_EQ(stats->getNumResults(), 2);
+    EXPECT_EQ(stats.getNumReductionLoops(), 1);
+    EXPECT_EQ(stats.getIteratorTypesArray().back(), utils::IteratorType::reduction);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SoftmaxTests,
+    SoftmaxParamTest,
+    testing::ValuesIn(softmaxShapes)
+);
+
+TEST_F(SoftmaxTest, InnerAxisIsInnermostLoop)
+{
+    auto inputType = RankedTensorType::get({2, N, 5}, builder.getF32Type());
+    Value result = build(inputType, 1, false);
+
+    // the axis maps to the last loop, the other dimensions keep their order
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    auto inMap = normalize.getIndexingMapsArray()[0];
+    EXPECT_EQ(inMap, AffineMap::get(3, 0, {getAffineDimExpr(0, &ctx), getAffineDimExpr(2, &ctx), getAffineDimExpr(1, &ctx)}, &ctx));
+
+    auto stats = normalize.getDpsInputs()[1].getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(stats);
+    auto statType = cast<RankedTensorType>(stats->getResult(0).getType());
+    EXPECT_EQ(statType.getShape(), llvm::ArrayRef<int64_t>({2, 5}));
+}
+
+TEST_F(SoftmaxTest, LogSoftmaxTakesLogOfSum)
+{
+    auto inputType = RankedTensorType::get({4, 8}, builder.getF16Type());
+    Value result = build(inputType, 1, true);
+
+    auto normalize = result.getDefiningOp<linalg::GenericOp>();
+    ASSERT_TRUE(normalize);
+    bool hasLog = false, hasExp = false;
+    normalize.getRegion().walk([&](Operation* op)
+    {
+        hasLog |= isa<math::LogOp>(op);
+        hasExp |= isa<math::ExpOp>(op);
+    });
+    EXPECT_TRUE(hasLog);
+    EXPECT_FALSE(hasExp);
+}
+
+TEST_F(SoftmaxTest, RejectsBadAxisAndIntegers)
+{
+    module = ModuleOp::create(loc);
+    auto func = func::FuncOp::create(loc, "test", builder.getFunctionType({}, {}));
+    func.addEntryBlock();
+    module.push_back(func);
+    builder.setInsertionPointToStart(&func.getBody().front());
+
+    auto floats = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({2, 3}, builder.getF32Type()), ValueRange{});
+    auto ints   = tensor::EmptyOp::create(builder, loc, RankedTensorType::get({2, 3}, builder.getI32Type()), ValueRange{});
+
+    EXPECT_THROW(buildSoftmax(builder, loc, floats, 2, false, &ctx), std::runtime_error);
+    EXPECT_THROW(buildSoftmax(builder, loc, floats, -3, false, &ctx), std::runtime_error);
+    EXPECT_THROW(buildSoftmax(builder, loc, ints, -1, false, &ctx), std::runtime_error);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// the entry points convert-async-to-llvm calls, see src/runtime/async_runtime.cpp
+extern "C"
+{
+    void    mlirAsyncRuntimeAddRef(void* ptr, int64_t count);
+    void    mlirAsyncRuntimeDropRef(void* ptr, int64_t count);
+
+    void*   mlirAsyncRuntimeCreateToken();
+    void*   mlirAsyncRuntimeCreateValue(int64_t size);
+    void*   mlirAsyncRuntimeCreateGroup(int64_t size);
+    int64_t mlirAsyncRuntimeAddTokenToGroup(void* token, void* group);
+
+    bool    mlirAsyncRuntimeIsTokenError(void* token);
+    bool    mlirAsyncRuntimeIsValueError(void* value);
+    bool    mlirAsyncRuntimeIsGroupError(void* group);
+
+    void    mlirAsyncRuntimeEmplaceToken(void* token);
+    void    mlirAsyncRuntimeEmplaceValue(void* value);
+    void    mlirAsyncRuntimeSetTokenError(void* token);
+    void    mlirAsyncRuntimeSetValueError(void* value);
+
+    void    mlirAsyncRuntimeAwaitToken(void* token);
+    void    mlirAsyncRuntimeAwaitValue(void* value);
+    void    mlirAsyncRuntimeAwaitAllInGroup(void* group);
+    void*   mlirAsyncRuntimeGetValueStorage(void* value);
+
+    void    mlirAsyncRuntimeAwaitAllInGroupAndExecute(void* group, void* handle, void (*resume)(void*));
+}
+
+// what a resumed coroutine does here: count itself
+static void countResume(void* handle)
+{
+    static_cast<std::atomic<int>*>(handle)->fetch_add(1);
+}
+
+// tokens and values start with two references, emplacing drops one, the test drops the other
+static void release(void* ptr)
+{
+    mlirAsyncRuntimeDropRef(ptr, 1);
+}
+
+
+TEST(AsyncRuntimeTest, GroupWaitsForEveryToken)
+{
+    constexpr int kTokens = 4;
+    void* group = mlirAsyncRuntimeCreateGroup(kTokens);
+
+    std::vector<void*> tokens;
+    for (int i = 0; i < kTokens; ++i)
+    {
+        tokens.push_back(mlirAsyncRuntimeCreateToken());
+        EXPECT_EQ(mlirAsyncRuntimeAddTokenToGroup(tokens.back(), group), i);
+    }
+
+    std::atomic<int> emplaced{0};
+    std::vector<std::thread> producers;
+    for (auto* token : tokens)
+    {
+        producers.emplace_back([token, &emplaced]
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            emplaced.fetch_add(1);
+            mlirAsyncRuntimeEmplaceToken(token);
+        });
+    }
+
+    mlirAsyncRuntimeAwaitAllInGroup(group);
+    EXPECT_EQ(emplaced.load(), kTokens);
+    EXPECT_FALSE(mlirAsyncRuntimeIsGroupError(group));
+
+    for (auto& t : producers) t.join();
+    for (auto* token : tokens)
+    {
+        EXPECT_FALSE(mlirAsyncRuntimeIsTokenError(token));
+        release(token);
+    }
+    mlirAsyncRuntimeDropRef(group, 1);
+}
+
+TEST(AsyncRuntimeTest, TokenReadyBeforeJoiningCountsAtOnce)
+{
+    void* group = mlirAsyncRuntimeCreateGroup(2);
+
+    void* early = mlirAsyncRuntimeCreateToken();
+    mlirAsyncRuntimeEmplaceToken(early);
+    EXPECT_EQ(mlirAsyncRuntimeAddTokenToGroup(early, group), 0);
+
+    void* late = mlirAsyncRuntimeCreateToken();
+    EXPECT_EQ(mlirAsyncRuntimeAddTokenToGroup(late, group), 1);
+
+    std::atomic<int> resumed{0};
+    mlirAsyncRuntimeAwaitAllInGroupAndExecute(group, &resumed, countResume);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(resumed.load(), 0);
+
+    // the continuation runs on the pool once the last token is ready
+    mlirAsyncRuntimeEmplaceToken(late);
+    while (resumed.load() == 0) std::this_thread::yield();
+    EXPECT_EQ(resumed.load(), 1);
+
+    release(early);
+    release(late);
+    mlirAsyncRuntimeDropRef(group, 1);
+}
+
+TEST(AsyncRuntimeTest, EmptyGroupIsReady)
+{
+    void* group = mlirAsyncRuntimeCreateGroup(0);
+    mlirAsyncRuntimeAwaitAllInGroup(group);
+    EXPECT_FALSE(mlirAsyncRuntimeIsGroupError(group));
+    mlirAsyncRuntimeDropRef(group, 1);
+}
+
+TEST(AsyncRuntimeTest, ErroredTokenFailsTheGroup)
+{
+    void* group = mlirAsyncRuntimeCreateGroup(3);
+    std::vector<void*> tokens;
+    for (int i = 0; i < 3; ++i)
+    {
+        tokens.push_back(mlirAsyncRuntimeCreateToken());
+        mlirAsyncRuntimeAddTokenToGroup(tokens.back(), group);
+    }
+
+    mlirAsyncRuntimeEmplaceToken(tokens[0]);
+    std::thread failing([&] { mlirAsyncRuntimeSetTokenError(tokens[1]); });
+    mlirAsyncRuntimeEmplaceToken(tokens[2]);
+
+    // an error still completes the group, waiters aren't left hanging
+    mlirAsyncRuntimeAwaitAllInGroup(group);
+    failing.join();
+
+    EXPECT_TRUE(mlirAsyncRuntimeIsGroupError(group));
+    EXPECT_FALSE(mlirAsyncRuntimeIsTokenError(tokens[0]));
+    EXPECT_TRUE(mlirAsyncRuntimeIsTokenError(tokens[1]));
+    EXPECT_FALSE(mlirAsyncRuntimeIsTokenError(tokens[2]));
+
+    for (auto* token : tokens) release(token);
+    mlirAsyncRuntimeDropRef(group, 1);
+}
+
+TEST(AsyncRuntimeTest, ValueStorageIsAlignedAndHandedOver)
+{
+    constexpr int kCount = 5;
+    void* value = mlirAsyncRuntimeCreateValue(kCount * sizeof(double));
+
+    auto* storage = mlirAsyncRuntimeGetValueStorage(value);
+    ASSERT_NE(storage, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(storage) % alignof(std::max_align_t), 0u);
+    // the storage stays put, the consumer reads where the producer wrote
+    EXPECT_EQ(mlirAsyncRuntimeGetValueStorage(value), storage);
+
+    std::thread producer([value]
+    {
+        double data[kCount] = {0.5, 1.5, 2.5, 3.5, 4.5};
+        std::memcpy(mlirAsyncRuntimeGetValueStorage(value), data, sizeof(data));
+        mlirAsyncRuntimeEmplaceValue(value);
+    });
+
+    mlirAsyncRuntimeAwaitValue(value);
+    EXPECT_FALSE(mlirAsyncRuntimeIsValueError(value));
+    const auto* result = static_cast<const double*>(storage);
+    for (int i = 0; i < kCount; ++i)
+        EXPECT_EQ(result[i], i + 0.5);
+
+    producer.join();
+    release(value);
+}
+
+TEST(AsyncRuntimeTest, ErroredValueIsReadyWithAnError)
+{
+    void* value = mlirAsyncRuntimeCreateValue(sizeof(float));
+    // an extra reference keeps it alive for a second reader
+    mlirAsyncRuntimeAddRef(value, 1);
+
+    std::thread producer([value] { mlirAsyncRuntimeSetValueError(value); });
+    mlirAsyncRuntimeAwaitValue(value);
+    producer.join();
+
+    EXPECT_TRUE(mlirAsyncRuntimeIsValueError(value));
+    release(value);
+    EXPECT_TRUE(mlirAsyncRuntimeIsValueError(value));
+    release(value);
+}
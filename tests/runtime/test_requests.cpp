@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "runtime/tc_runtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static int returnArg(void* arg)
+{
+    return static_cast<int>(reinterpret_cast<intptr_t>(arg));
+}
+
+static void recordStatus(int status, void* user_data)
+{
+    static_cast<std::atomic<int>*>(user_data)->fetch_add(status);
+}
+
+TEST(RequestTest, WaitReturnsStatus)
+{
+    tc_request* req = tc_runtime_submit(returnArg, reinterpret_cast<void*>(intptr_t{7}), nullptr, nullptr);
+    ASSERT_NE(req, nullptr);
+    EXPECT_EQ(tc_request_wait(req), 7);
+    EXPECT_NE(tc_request_done(req), 0);
+    tc_request_release(req);
+}
+
+TEST(RequestTest, CallbackRunsBeforeDone)
+{
+    std::atomic<int> sum{0};
+    std::vector<tc_request*> reqs;
+    for (intptr_t i = 1; i <= 100; ++i)
+        reqs.push_back(tc_runtime_submit(returnArg, reinterpret_cast<void*>(i), recordStatus, &sum));
+
+    for (auto* req : reqs)
+    {
+        tc_request_wait(req);
+        tc_request_release(req);
+    }
+    EXPECT_EQ(sum.load(), 100 * 101 / 2);
+}
+
+// a handle may be dropped while the request is still queued
+TEST(RequestTest, ReleaseBeforeCompletion)
+{
+    std::atomic<int> sum{0};
+    for (intptr_t i = 0; i < 50; ++i)
+        tc_request_release(tc_runtime_submit(returnArg, reinterpret_cast<void*>(intptr_t{1}), recordStatus, &sum));
+
+    tc_request* last = tc_runtime_submit(returnArg, nullptr, nullptr, nullptr);
+    tc_request_wait(last);
+    tc_request_release(last);
+
+    // requests may finish in any order, wait for the callbacks of the released ones
+    while (sum.load() < 50) std::this_thread::yield();
+    EXPECT_EQ(sum.load(), 50);
+}
+
+extern "C"
+{
+    void* mlirAsyncRuntimeCreateToken();
+    void  mlirAsyncRuntimeEmplaceToken(void* token);
+    void  mlirAsyncRuntimeAwaitToken(void* token);
+    void  mlirAsyncRuntimeDropRef(void* ptr, int64_t count);
+}
+
+static thread_local int tl_request_depth = 0;
+static std::atomic<int> max_request_depth{0};
+
+// what a model compiled with --parallel-branches does: wait for work finishing elsewhere,
+// here on a thread outside the pool so the waiter has nothing of its own to run meanwhile
+static int awaitRuntimeWork(void*)
+{
+    int depth = ++tl_request_depth;
+    int seen  = max_request_depth.load();
+    while (depth > seen && !max_request_depth.compare_exchange_weak(seen, depth)) {}
+
+    void* token = mlirAsyncRuntimeCreateToken();
+    std::thread producer([token]
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        mlirAsyncRuntimeEmplaceToken(token);
+    });
+    mlirAsyncRuntimeAwaitToken(token);
+    producer.join();
+    mlirAsyncRuntimeDropRef(token, 1);
+
+    --tl_request_depth;
+    return 1;
+}
+
+// a request waiting on its own work must not run other requests on its stack
+TEST(RequestTest, WaitingRequestsDoNotNest)
+{
+    std::atomic<int> sum{0};
+    std::vector<tc_request*> reqs;
+    for (int i = 0; i < 64; ++i)
+        reqs.push_back(tc_runtime_submit(awaitRuntimeWork, nullptr, recordStatus, &sum));
+
+    for (auto* req : reqs)
+    {
+        EXPECT_EQ(tc_request_wait(req), 1);
+        tc_request_release(req);
+    }
+    EXPECT_EQ(sum.load(), 64);
+    EXPECT_EQ(max_request_depth.load(), 1);
+}
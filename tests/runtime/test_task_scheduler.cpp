@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "runtime/task_scheduler.hpp"
+
+#include <atomic>
+#include <vector>
+
+using namespace tc;
+
+
+struct Counter
+{
+    TaskScheduler*    scheduler;
+    std::atomic<int>* done;
+    std::atomic<int>* sum;
+    int               value;
+};
+
+static void addValue(void* arg)
+{
+    auto* c = static_cast<Counter*>(arg);
+    c->sum->fetch_add(c->value);
+    c->done->fetch_add(1);
+    c->scheduler->notifyWaiters();
+}
+
+TEST(TaskSchedulerTest, RunsEverySubmittedTask)
+{
+    TaskScheduler scheduler(3);
+    std::atomic<int> done{0}, sum{0};
+
+    std::vector<Counter> counters;
+    for (int i = 1; i <= 1000; ++i)
+        counters.push_back({&scheduler, &done, &sum, i});
+    for (auto& c : counters)
+        scheduler.submit({addValue, &c});
+
+    scheduler.waitUntil([&] { return done.load() == 1000; });
+    EXPECT_EQ(sum.load(), 1000 * 1001 / 2);
+}
+
+// the waiting thread runs the tasks itself
+TEST(TaskSchedulerTest, WorksWithoutWorkers)
+{
+    TaskScheduler scheduler(0);
+    std::atomic<int> done{0}, sum{0};
+
+    Counter a{&scheduler, &done, &sum, 2}, b{&scheduler, &done, &sum, 3};
+    scheduler.submit({addValue, &a});
+    scheduler.submit({addValue, &b});
+
+    scheduler.waitUntil([&] { return done.load() == 2; });
+    EXPECT_EQ(sum.load(), 5);
+}
+
+struct Tree
+{
+    TaskScheduler*    scheduler;
+    std::atomic<int>* leaves;
+    int               depth;
+};
+
+// spawns two subtrees, so most tasks are created on workers and reach others by stealing
+static void spawnTree(void* arg)
+{
+    auto* t = static_cast<Tree*>(arg);
+    if (t->depth == 0)
+    {
+        t->leaves->fetch_add(1);
+        t->scheduler->notifyWaiters();
+        delete t;
+        return;
+    }
+    for (int i = 0; i < 2; ++i)
+        t->scheduler->submit({spawnTree, new Tree{t->scheduler, t->leaves, t->depth - 1}});
+    delete t;
+}
+
+TEST(TaskSchedulerTest, TasksSpawnTasks)
+{
+    TaskScheduler scheduler(4);
+    std::atomic<int> leaves{0};
+
+    scheduler.submit({spawnTree, new Tree{&scheduler, &leaves, 12}});
+    scheduler.waitUntil([&] { return leaves.load() == 1 << 12; });
+    EXPECT_EQ(leaves.load(), 1 << 12);
+}